@@ -0,0 +1,265 @@
+"""Compare benchmark runs written by text_generator_main --results_json.
+
+Each side is a set of repeats (files, directories or globs). Every numeric
+metric is averaged per side and the difference is tested with Welch's t-test,
+so a change is only reported when it is larger than the run-to-run noise:
+
+    python3 compare_results.py --baseline base/*.json --candidate new/*.json
+
+The exit status is 1 when a metric got significantly worse by more than
+--threshold, which lets CI catch performance regressions.
+"""
+
+import argparse
+import glob
+import json
+import logging
+import math
+import os
+import re
+import sys
+from typing import Dict, List, Optional, Tuple
+
+logging.basicConfig(level=logging.INFO, format='%(levelname)s - %(message)s')
+logger = logging.getLogger(__name__)
+
+SCHEMA = 'llm_inference_results'
+SCHEMA_VERSION = 1
+
+# Metrics where a larger value is better; matched against the last path part.
+HIGHER_IS_BETTER = re.compile(
+    r'(tokens_per_sec|tokens_per_joule|ipc|achieved_gbps|accepted_tokens)$')
+# Metrics that describe the workload rather than its performance.
+NEUTRAL = re.compile(
+    r'(^|\.)(count|generated_tokens|decode_steps|proposed_tokens|coverage|'
+    r'prompt_tokens|num_steps|tokens)$')
+# Environment facts that make two runs incomparable when they differ.
+ENVIRONMENT_KEYS = [
+    ('environment', 'kernel_release'),
+    ('environment', 'cpu_model'),
+    ('environment', 'machine'),
+    ('environment', 'affinity'),
+    ('environment', 'transparent_hugepage'),
+    ('environment', 'cgroup', 'memory_max'),
+    ('environment', 'cgroup', 'cpu_max'),
+    ('run', 'model'),
+    ('run', 'num_threads'),
+]
+
+
+def expand_paths(patterns: List[str]) -> List[str]:
+    paths = []
+    for pattern in patterns:
+        if os.path.isdir(pattern):
+            paths.extend(sorted(glob.glob(os.path.join(pattern, '*.json'))))
+        else:
+            matches = sorted(glob.glob(pattern))
+            paths.extend(matches if matches else [pattern])
+    return paths
+
+
+def load_runs(patterns: List[str]) -> List[dict]:
+    runs = []
+    for path in expand_paths(patterns):
+        try:
+            with open(path) as f:
+                run = json.load(f)
+        except (OSError, json.JSONDecodeError) as e:
+            logger.error(f'Skipping {path}: {e}')
+            continue
+        if run.get('schema') != SCHEMA:
+            logger.error(f'Skipping {path}: not a --results_json file')
+            continue
+        if run.get('schema_version') != SCHEMA_VERSION:
+            logger.warning(f'{path} has schema version {run.get("schema_version")}, '
+                           f'expected {SCHEMA_VERSION}')
+        run['_path'] = path
+        runs.append(run)
+    return runs
+
+
+def flatten_numbers(value, prefix: str, out: Dict[str, float]) -> None:
+    """Collects numeric leaves as dotted paths; arrays are skipped."""
+    if isinstance(value, bool):
+        return
+    if isinstance(value, (int, float)):
+        out[prefix] = float(value)
+    elif isinstance(value, dict):
+        for key, child in value.items():
+            flatten_numbers(child, f'{prefix}.{key}' if prefix else key, out)
+
+
+def mean(values: List[float]) -> float:
+    return sum(values) / len(values) if values else 0.0
+
+
+def run_metrics(run: dict) -> Dict[str, float]:
+    metrics: Dict[str, float] = {}
+    # A phase measured several times in one run is averaged within the run.
+    for phase, entries in run.get('phases', {}).items():
+        per_phase: Dict[str, List[float]] = {}
+        for entry in entries:
+            flat: Dict[str, float] = {}
+            flatten_numbers(entry, '', flat)
+            for key, value in flat.items():
+                per_phase.setdefault(key, []).append(value)
+        for key, values in per_phase.items():
+            metrics[f'phases.{phase}.{key}'] = mean(values)
+    flatten_numbers(run.get('decoding', {}), 'decoding', metrics)
+    steps = run.get('decode_steps', [])
+    if steps:
+        metrics['decode_steps.num_steps'] = float(len(steps))
+        for key in steps[0]:
+            values = [step[key] for step in steps if isinstance(step.get(key), (int, float))]
+            metrics[f'decode_steps.mean.{key}'] = mean(values)
+    return metrics
+
+
+def betacf(a: float, b: float, x: float) -> float:
+    """Continued fraction of the incomplete beta function (modified Lentz)."""
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        for numerator in (m * (b - m) * x / ((a + m2 - 1) * (a + m2)),
+                          -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1))):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+
+def regularized_beta(a: float, b: float, x: float) -> float:
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    log_front = (math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) +
+                 a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return math.exp(log_front) * betacf(a, b, x) / a
+    return 1.0 - math.exp(log_front) * betacf(b, a, 1.0 - x) / b
+
+
+def welch_t_test(a: List[float], b: List[float]) -> Optional[float]:
+    """Two-sided p-value of Welch's t-test; None with fewer than 2 repeats."""
+    if len(a) < 2 or len(b) < 2:
+        return None
+    mean_a, mean_b = mean(a), mean(b)
+    var_a = sum((x - mean_a) ** 2 for x in a) / (len(a) - 1)
+    var_b = sum((x - mean_b) ** 2 for x in b) / (len(b) - 1)
+    se2 = var_a / len(a) + var_b / len(b)
+    if se2 == 0.0:
+        return 1.0 if mean_a == mean_b else 0.0
+    t = (mean_b - mean_a) / math.sqrt(se2)
+    df = se2 ** 2 / ((var_a / len(a)) ** 2 / (len(a) - 1) +
+                     (var_b / len(b)) ** 2 / (len(b) - 1))
+    return regularized_beta(df / 2.0, 0.5, df / (df + t * t))
+
+
+def stddev(values: List[float]) -> float:
+    if len(values) < 2:
+        return 0.0
+    m = mean(values)
+    return math.sqrt(sum((x - m) ** 2 for x in values) / (len(values) - 1))
+
+
+def nested_get(run: dict, keys: Tuple[str, ...]):
+    for key in keys:
+        if not isinstance(run, dict):
+            return None
+        run = run.get(key)
+    return run
+
+
+def check_environments(baseline: List[dict], candidate: List[dict]) -> None:
+    for keys in ENVIRONMENT_KEYS:
+        values = {json.dumps(nested_get(run, keys)) for run in baseline + candidate}
+        if len(values) > 1:
+            logger.warning(f'{".".join(keys)} differs between runs: {", ".join(sorted(values))}')
+    governors = {json.dumps(sorted({f.get('governor') for f in run['environment'].get('cpufreq', [])}))
+                 for run in baseline + candidate if 'environment' in run}
+    if len(governors) > 1:
+        logger.warning(f'CPU governors differ between runs: {", ".join(sorted(governors))}')
+
+
+def compare(baseline: List[dict], candidate: List[dict], alpha: float, threshold: float,
+            metric_filter: Optional[re.Pattern], show_all: bool) -> int:
+    base_metrics = [run_metrics(run) for run in baseline]
+    cand_metrics = [run_metrics(run) for run in candidate]
+    names = sorted(set().union(*base_metrics) & set().union(*cand_metrics))
+    if metric_filter:
+        names = [name for name in names if metric_filter.search(name)]
+
+    rows = []
+    regressions = 0
+    for name in names:
+        a = [m[name] for m in base_metrics if name in m]
+        b = [m[name] for m in cand_metrics if name in m]
+        mean_a, mean_b = mean(a), mean(b)
+        change = (mean_b - mean_a) / abs(mean_a) if mean_a != 0 else (0.0 if mean_b == 0 else math.inf)
+        p = welch_t_test(a, b)
+        significant = p is not None and p < alpha and abs(change) >= threshold
+        verdict = ''
+        if significant and not NEUTRAL.search(name):
+            better = (change > 0) == bool(HIGHER_IS_BETTER.search(name.rsplit('.', 1)[-1]))
+            verdict = 'improved' if better else 'REGRESSED'
+            regressions += 0 if better else 1
+        elif significant:
+            verdict = 'changed'
+        if show_all or verdict:
+            rows.append((name, mean_a, stddev(a), mean_b, stddev(b), change, p, verdict))
+
+    print(f'Baseline: {len(baseline)} runs, candidate: {len(candidate)} runs, '
+          f'{len(names)} metrics, alpha={alpha}, threshold={threshold * 100:.1f}%')
+    if len(baseline) < 2 or len(candidate) < 2:
+        print('Note: at least 2 repeats per side are needed for significance tests.')
+    if not rows:
+        print('No significant differences.')
+        return 0
+    width = max(len(row[0]) for row in rows)
+    print(f'{"metric":<{width}} {"baseline":>22} {"candidate":>22} {"change":>9} {"p":>8}  verdict')
+    for name, mean_a, sd_a, mean_b, sd_b, change, p, verdict in rows:
+        p_text = f'{p:.4f}' if p is not None else 'n/a'
+        print(f'{name:<{width}} {mean_a:>12.4g} ± {sd_a:<7.3g} {mean_b:>12.4g} ± {sd_b:<7.3g} '
+              f'{change * 100:>+8.1f}% {p_text:>8}  {verdict}')
+    if regressions:
+        print(f'\n{regressions} metric(s) regressed.')
+    return 1 if regressions else 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--baseline', nargs='+', required=True,
+                        help='Result files, directories or globs of the baseline repeats')
+    parser.add_argument('--candidate', nargs='+', required=True,
+                        help='Result files, directories or globs of the candidate repeats')
+    parser.add_argument('--alpha', type=float, default=0.05,
+                        help='Significance level of the t-test')
+    parser.add_argument('--threshold', type=float, default=0.02,
+                        help='Smallest relative change reported (0.02 = 2%%)')
+    parser.add_argument('--metrics', default=None,
+                        help='Only compare metrics matching this regex, e.g. "decoding|Prefill"')
+    parser.add_argument('--all', action='store_true',
+                        help='List every compared metric, not only significant changes')
+    args = parser.parse_args()
+
+    baseline = load_runs(args.baseline)
+    candidate = load_runs(args.candidate)
+    if not baseline or not candidate:
+        logger.error('Need at least one readable run on each side')
+        return 2
+    check_environments(baseline, candidate)
+    metric_filter = re.compile(args.metrics) if args.metrics else None
+    return compare(baseline, candidate, args.alpha, args.threshold, metric_filter, args.all)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,178 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/batch_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/sampler.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+double ElapsedMs(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+BatchedDecodeScheduler::BatchedDecodeScheduler(
+    tflite::SignatureRunner* decode_runner, KVCache* batch_kv_cache,
+    KVCache* scratch_kv_cache, SlotPrefillFn prefill, TokenSampler sampler,
+    int stop_token_id)
+    : decode_runner_(decode_runner),
+      batch_kv_cache_(batch_kv_cache),
+      scratch_kv_cache_(scratch_kv_cache),
+      prefill_(std::move(prefill)),
+      sampler_(std::move(sampler)),
+      stop_token_id_(stop_token_id),
+      tokens_(decode_runner->input_tensor("tokens")),
+      input_pos_(decode_runner->input_tensor("input_pos")),
+      batch_size_(tokens_->dims->data[0]),
+      kv_cache_max_size_(
+          decode_runner->input_tensor("kv_cache_k_0")->dims->data[1]),
+      slots_(batch_size_) {
+  MINIMAL_CHECK(IsBatchedDecodeSignature(decode_runner));
+  for (int i = 0; i < batch_size_; ++i) {
+    slots_[i].slot = i;
+  }
+}
+
+bool BatchedDecodeScheduler::IsBatchedDecodeSignature(
+    tflite::SignatureRunner* runner) {
+  const TfLiteTensor* tokens = runner->input_tensor("tokens");
+  const TfLiteTensor* input_pos = runner->input_tensor("input_pos");
+  if (tokens == nullptr || input_pos == nullptr || tokens->dims->size < 1) {
+    return false;
+  }
+  int batch_size = tokens->dims->data[0];
+  return batch_size > 1 && input_pos->dims->size >= 1 &&
+         input_pos->dims->data[0] == batch_size;
+}
+
+void BatchedDecodeScheduler::Submit(GenerationRequest request) {
+  queue_.push_back(std::move(request));
+}
+
+void BatchedDecodeScheduler::CopyIntoSlot(int slot, int num_positions) {
+  for (const auto& [name, scratch] : *scratch_kv_cache_) {
+    auto it = batch_kv_cache_->find(name);
+    MINIMAL_CHECK(it != batch_kv_cache_->end());
+    auto& batch = it->second;
+    const size_t slot_stride = batch.size() / batch_size_;
+    MINIMAL_CHECK(slot_stride == scratch.size());
+    const size_t position_stride = scratch.size() / kv_cache_max_size_;
+    std::memcpy(batch.data() + slot * slot_stride, scratch.data(),
+                num_positions * position_stride * sizeof(float));
+  }
+}
+
+void BatchedDecodeScheduler::Admit() {
+  for (BatchSession& session : slots_) {
+    if (queue_.empty()) {
+      return;
+    }
+    if (session.request_id >= 0) {
+      continue;
+    }
+    GenerationRequest request = std::move(queue_.front());
+    queue_.pop_front();
+    MINIMAL_CHECK(!request.prompt_tokens.empty());
+
+    auto prefill_start = std::chrono::steady_clock::now();
+    int num_prefilled = prefill_(request.prompt_tokens);
+    MINIMAL_CHECK(num_prefilled < static_cast<int>(request.prompt_tokens.size()));
+    CopyIntoSlot(session.slot, num_prefilled);
+    stats_.total_prefill_time_ms += ElapsedMs(prefill_start);
+
+    session.request_id = request.id;
+    session.next_token = request.prompt_tokens[num_prefilled];
+    session.next_position = num_prefilled;
+    session.remaining = std::min(request.max_new_tokens,
+                                 kv_cache_max_size_ - (num_prefilled + 1));
+    session.output_tokens.clear();
+    session.admitted = prefill_start;
+    session.time_to_first_token_ms = 0.0;
+  }
+}
+
+void BatchedDecodeScheduler::Run(
+    const std::function<void(const BatchSession&)>& on_finish) {
+  auto run_start = std::chrono::steady_clock::now();
+  Admit();
+
+  while (true) {
+    int num_active = 0;
+    for (int i = 0; i < batch_size_; ++i) {
+      const BatchSession& session = slots_[i];
+      bool active = session.request_id >= 0;
+      tokens_->data.i32[i] = active ? session.next_token : 0;
+      input_pos_->data.i32[i] = active ? session.next_position : 0;
+      num_active += active ? 1 : 0;
+    }
+    if (num_active == 0) {
+      break;
+    }
+
+    auto invoke_start = std::chrono::steady_clock::now();
+    MINIMAL_CHECK(decode_runner_->Invoke() == kTfLiteOk);
+    stats_.total_invoke_time_ms += ElapsedMs(invoke_start);
+
+    // Logits are [B, 1, vocab]; row i belongs to slot i.
+    auto sampling_start = std::chrono::steady_clock::now();
+    const TfLiteTensor* logits = decode_runner_->output_tensor("logits");
+    const int vocab_size = Sampler::VocabSize(logits);
+    for (BatchSession& session : slots_) {
+      if (session.request_id < 0) {
+        continue;
+      }
+      int token = sampler_(Sampler::LogitsRow(logits, session.slot), vocab_size);
+      if (session.output_tokens.empty()) {
+        session.time_to_first_token_ms = ElapsedMs(session.admitted);
+      }
+      session.next_position++;
+      bool finished = token == stop_token_id_;
+      if (!finished) {
+        session.output_tokens.push_back(token);
+        session.next_token = token;
+        ++stats_.num_tokens;
+        finished = --session.remaining <= 0;
+      }
+      if (finished) {
+        on_finish(session);
+        ++stats_.num_completed;
+        session.request_id = -1;
+      }
+    }
+    stats_.total_sampling_time_ms += ElapsedMs(sampling_start);
+    ++stats_.num_steps;
+    stats_.active_slot_steps += num_active;
+
+    Admit();
+  }
+  stats_.total_time_ms = ElapsedMs(run_start);
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,127 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_BATCH_SCHEDULER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_BATCH_SCHEDULER_H_
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/speculative_decoder.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace ai_edge_torch::examples {
+
+// One prompt waiting to be generated.
+struct GenerationRequest {
+  int id = 0;
+  std::vector<int> prompt_tokens;
+  int max_new_tokens = 0;
+};
+
+// A request that occupies a batch slot.
+struct BatchSession {
+  int request_id = -1;
+  int slot = -1;
+  // Token to feed at `next_position` in the next batched step.
+  int next_token = 0;
+  int next_position = 0;
+  int remaining = 0;
+  std::vector<int> output_tokens;
+  std::chrono::steady_clock::time_point admitted;
+  double time_to_first_token_ms = 0.0;
+};
+
+// Prefills all but the last prompt token into the batch-1 scratch KV cache
+// and returns how many positions were written.
+using SlotPrefillFn = std::function<int(const std::vector<int>& prompt_tokens)>;
+
+// Packs the next token of several sessions into one decode invocation.
+//
+// Requires a decode signature exported with a batch dimension: `tokens` of
+// shape [B, 1], a per-row `input_pos` of shape [B], and KV caches laid out as
+// [B, S, ...] so each row is one slot. Every `Invoke()` streams the weights
+// once for all B rows, so aggregate tokens/s grows with the number of active
+// slots while a single-sequence decode stays bandwidth bound.
+//
+// Sessions are admitted and retired continuously: whenever a slot frees up
+// (stop token, token budget, or full cache) the next queued request is
+// prefilled through the batch-1 prefill signature into the scratch KV cache,
+// and its rows are copied into the freed slot. Idle slots are fed a dummy
+// token at position 0; whatever they write is overwritten on admission.
+class BatchedDecodeScheduler {
+ public:
+  struct Stats {
+    int num_steps = 0;
+    int num_tokens = 0;
+    int num_completed = 0;
+    // Sum over steps of active slots, for average occupancy.
+    long long active_slot_steps = 0;
+    double total_invoke_time_ms = 0.0;
+    double total_sampling_time_ms = 0.0;
+    double total_prefill_time_ms = 0.0;
+    double total_time_ms = 0.0;
+  };
+
+  // `batch_kv_cache` is bound to `decode_runner`; `scratch_kv_cache` is the
+  // batch-1 cache written by `prefill`.
+  BatchedDecodeScheduler(tflite::SignatureRunner* decode_runner,
+                         KVCache* batch_kv_cache, KVCache* scratch_kv_cache,
+                         SlotPrefillFn prefill, TokenSampler sampler,
+                         int stop_token_id);
+
+  // Returns false if the signature does not have per-row positions.
+  static bool IsBatchedDecodeSignature(tflite::SignatureRunner* runner);
+
+  void Submit(GenerationRequest request);
+
+  // Runs until every submitted request has finished. `on_finish` is called
+  // with each retired session.
+  void Run(const std::function<void(const BatchSession&)>& on_finish);
+
+  int batch_size() const { return batch_size_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  // Moves queued requests into free slots.
+  void Admit();
+  // Copies the first `num_positions` positions of the scratch cache into
+  // `slot` of the batched cache.
+  void CopyIntoSlot(int slot, int num_positions);
+
+  tflite::SignatureRunner* decode_runner_;
+  KVCache* batch_kv_cache_;
+  KVCache* scratch_kv_cache_;
+  SlotPrefillFn prefill_;
+  TokenSampler sampler_;
+  const int stop_token_id_;
+
+  TfLiteTensor* tokens_;
+  TfLiteTensor* input_pos_;
+  int batch_size_;
+  int kv_cache_max_size_;
+
+  std::deque<GenerationRequest> queue_;
+  // Indexed by slot; request_id < 0 marks a free slot.
+  std::vector<BatchSession> slots_;
+  Stats stats_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_BATCH_SCHEDULER_H_
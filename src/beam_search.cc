@@ -0,0 +1,394 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/beam_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/sampler.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+int CommonPrefixLength(const std::vector<int>& a, const std::vector<int>& b) {
+  size_t n = std::min(a.size(), b.size());
+  size_t i = 0;
+  while (i < n && a[i] == b[i]) {
+    ++i;
+  }
+  return static_cast<int>(i);
+}
+
+}  // namespace
+
+// ------------------------
+// BatchedBeamBackend
+// ------------------------
+BatchedBeamBackend::BatchedBeamBackend(tflite::SignatureRunner* decode_runner,
+                                       KVCache* batch_kv_cache,
+                                       const KVCache& prefix_kv_cache,
+                                       int prefix_length)
+    : decode_runner_(decode_runner),
+      batch_kv_cache_(batch_kv_cache),
+      batch_size_(decode_runner->input_tensor("tokens")->dims->data[0]),
+      kv_cache_max_size_(
+          decode_runner->input_tensor("kv_cache_k_0")->dims->data[1]) {
+  // Broadcast the prompt prefix into every slot once.
+  for (const auto& [name, prefix] : prefix_kv_cache) {
+    auto it = batch_kv_cache_->find(name);
+    MINIMAL_CHECK(it != batch_kv_cache_->end());
+    const size_t slot_stride = it->second.size() / batch_size_;
+    MINIMAL_CHECK(slot_stride == prefix.size());
+    const size_t row = prefix.size() / kv_cache_max_size_;
+    for (int slot = 0; slot < batch_size_; ++slot) {
+      std::memcpy(it->second.data() + slot * slot_stride, prefix.data(),
+                  prefix_length * row * sizeof(float));
+    }
+  }
+}
+
+bool BatchedBeamBackend::IsCompatible(tflite::SignatureRunner* runner) {
+  const TfLiteTensor* tokens = runner->input_tensor("tokens");
+  return tokens != nullptr && tokens->dims->size >= 1 &&
+         tokens->dims->data[0] > 1;
+}
+
+int BatchedBeamBackend::vocab_size() const {
+  return Sampler::VocabSize(decode_runner_->output_tensor("logits"));
+}
+
+void BatchedBeamBackend::Step(const std::vector<int>& slots,
+                              const std::vector<int>& tokens, int position,
+                              std::vector<const float*>* logits) {
+  TfLiteTensor* input = decode_runner_->input_tensor("tokens");
+  TfLiteTensor* input_pos = decode_runner_->input_tensor("input_pos");
+  // Idle slots get a dummy token; the rows they write are never attended to
+  // because a slot is always overwritten before it is reused.
+  std::memset(input->data.i32, 0, input->bytes);
+  for (size_t i = 0; i < slots.size(); ++i) {
+    input->data.i32[slots[i]] = tokens[i];
+  }
+  // Beams advance in lockstep, so a shared [1] or per-row [B] input_pos both
+  // work.
+  for (int i = 0; i < input_pos->dims->data[0]; ++i) {
+    input_pos->data.i32[i] = position;
+  }
+  MINIMAL_CHECK(decode_runner_->Invoke() == kTfLiteOk);
+
+  const TfLiteTensor* output = decode_runner_->output_tensor("logits");
+  logits->clear();
+  for (int slot : slots) {
+    logits->push_back(Sampler::LogitsRow(output, slot));
+  }
+}
+
+void BatchedBeamBackend::CopySlot(int src, int dst, int from_position,
+                                  int to_position) {
+  if (src == dst || to_position <= from_position) {
+    return;
+  }
+  for (auto& [name, cache] : *batch_kv_cache_) {
+    const size_t slot_stride = cache.size() / batch_size_;
+    const size_t row = slot_stride / kv_cache_max_size_;
+    std::memcpy(cache.data() + dst * slot_stride + from_position * row,
+                cache.data() + src * slot_stride + from_position * row,
+                (to_position - from_position) * row * sizeof(float));
+  }
+}
+
+// ------------------------
+// SharedPrefixBeamBackend
+// ------------------------
+SharedPrefixBeamBackend::SharedPrefixBeamBackend(
+    tflite::SignatureRunner* decode_runner, KVCache* kv_cache,
+    int prefix_length, int max_beams)
+    : decode_runner_(decode_runner),
+      kv_cache_(kv_cache),
+      prefix_length_(prefix_length),
+      max_beams_(max_beams),
+      kv_cache_max_size_(
+          decode_runner->input_tensor("kv_cache_k_0")->dims->data[1]),
+      suffix_(max_beams,
+              std::vector<std::vector<float>>(kv_cache->size())),
+      logits_(max_beams) {}
+
+size_t SharedPrefixBeamBackend::RowSize(
+    const std::vector<float, AlignedAllocator<float>>& cache) const {
+  return cache.size() / kv_cache_max_size_;
+}
+
+int SharedPrefixBeamBackend::vocab_size() const {
+  return Sampler::VocabSize(decode_runner_->output_tensor("logits"));
+}
+
+void SharedPrefixBeamBackend::Step(const std::vector<int>& slots,
+                                   const std::vector<int>& tokens,
+                                   int position,
+                                   std::vector<const float*>* logits) {
+  TfLiteTensor* input = decode_runner_->input_tensor("tokens");
+  TfLiteTensor* input_pos = decode_runner_->input_tensor("input_pos");
+  const int num_rows = position - prefix_length_;
+
+  logits->clear();
+  for (size_t i = 0; i < slots.size(); ++i) {
+    const int slot = slots[i];
+    std::vector<std::vector<float>>& suffix = suffix_[slot];
+
+    // Swap this beam's private rows in unless they are already resident.
+    if (slot != resident_slot_) {
+      size_t layer = 0;
+      for (auto& [name, cache] : *kv_cache_) {
+        const size_t row = RowSize(cache);
+        MINIMAL_CHECK(suffix[layer].size() == num_rows * row);
+        std::memcpy(cache.data() + prefix_length_ * row, suffix[layer].data(),
+                    num_rows * row * sizeof(float));
+        ++layer;
+      }
+    }
+
+    input->data.i32[0] = tokens[i];
+    input_pos->data.i32[0] = position;
+    MINIMAL_CHECK(decode_runner_->Invoke() == kTfLiteOk);
+    resident_slot_ = slot;
+
+    // Keep the row just written as part of this beam's private suffix.
+    size_t layer = 0;
+    for (auto& [name, cache] : *kv_cache_) {
+      const size_t row = RowSize(cache);
+      const float* written = cache.data() + position * row;
+      suffix[layer].resize(num_rows * row);
+      suffix[layer].insert(suffix[layer].end(), written, written + row);
+      ++layer;
+    }
+
+    const TfLiteTensor* output = decode_runner_->output_tensor("logits");
+    logits_[slot].assign(output->data.f,
+                         output->data.f + Sampler::VocabSize(output));
+    logits->push_back(logits_[slot].data());
+  }
+}
+
+void SharedPrefixBeamBackend::CopySlot(int src, int dst, int from_position,
+                                       int to_position) {
+  if (src == dst) {
+    return;
+  }
+  size_t layer = 0;
+  for (auto& [name, cache] : *kv_cache_) {
+    const size_t row = RowSize(cache);
+    const size_t from = (from_position - prefix_length_) * row;
+    const size_t to = (to_position - prefix_length_) * row;
+    std::vector<float>& dst_rows = suffix_[dst][layer];
+    const std::vector<float>& src_rows = suffix_[src][layer];
+    dst_rows.resize(to);
+    if (to > from) {
+      std::memcpy(dst_rows.data() + from, src_rows.data() + from,
+                  (to - from) * sizeof(float));
+    }
+    ++layer;
+  }
+  if (dst == resident_slot_) {
+    resident_slot_ = -1;
+  }
+}
+
+// ------------------------
+// BeamSearch
+// ------------------------
+BeamSearch::BeamSearch(BeamDecodeBackend* backend, BeamSearchOptions options)
+    : backend_(backend), options_(options) {
+  options_.num_beams = std::max(1, std::min(options_.num_beams,
+                                            backend_->max_beams()));
+  options_.num_return_sequences =
+      std::max(1, std::min(options_.num_return_sequences, options_.num_beams));
+}
+
+void BeamSearch::ScoreRow(const float* logits, float base, float* out) const {
+  const int vocab_size = backend_->vocab_size();
+  float max_logit = *std::max_element(logits, logits + vocab_size);
+  float sum_exp = 0.0f;
+  for (int i = 0; i < vocab_size; ++i) {
+    sum_exp += std::exp(logits[i] - max_logit);
+  }
+  const float offset = base - max_logit - std::log(sum_exp);
+  for (int i = 0; i < vocab_size; ++i) {
+    out[i] = logits[i] + offset;
+  }
+}
+
+std::vector<Hypothesis> BeamSearch::Run(int pending_token, int start_position) {
+  const int vocab_size = backend_->vocab_size();
+  const int num_beams = options_.num_beams;
+
+  // Tokens fed into each slot, from start_position on.
+  std::vector<std::vector<int>> slot_history(backend_->max_beams());
+
+  // Beam search starts from the single prompt; n-best sampling forks it into
+  // independent samples right away.
+  std::vector<Beam> beams;
+  for (int i = 0; i < (options_.sample ? num_beams : 1); ++i) {
+    beams.push_back({i, {}, 0.0f});
+  }
+
+  std::vector<Hypothesis> finished;
+  std::vector<int> slots;
+  std::vector<int> feed;
+  std::vector<const float*> logits;
+  int position = start_position;
+
+  for (int step = 0; step < options_.max_new_tokens && !beams.empty(); ++step) {
+    slots.clear();
+    feed.clear();
+    for (const Beam& beam : beams) {
+      slots.push_back(beam.slot);
+      feed.push_back(beam.tokens.empty() ? pending_token : beam.tokens.back());
+    }
+    backend_->Step(slots, feed, position, &logits);
+    for (size_t i = 0; i < slots.size(); ++i) {
+      slot_history[slots[i]].resize(position - start_position);
+      slot_history[slots[i]].push_back(feed[i]);
+    }
+    ++num_steps_;
+    ++position;
+    const bool last_step = step + 1 == options_.max_new_tokens;
+
+    // Children as (parent index, token, log_prob), best first.
+    struct Child {
+      int parent;
+      int token;
+      float log_prob;
+    };
+    std::vector<Child> children;
+
+    if (options_.sample) {
+      scores_.resize(vocab_size);
+      for (size_t i = 0; i < beams.size(); ++i) {
+        int token = Sampler::TemperatureTopKTopPSampler(
+            logits[i], vocab_size, options_.temperature, 85, 0.9f);
+        ScoreRow(logits[i], beams[i].log_prob, scores_.data());
+        children.push_back({static_cast<int>(i), token, scores_[token]});
+      }
+    } else {
+      // Score every (beam, token) pair into one buffer, then keep the global
+      // top 2k: enough that k survive even if some end in the stop token.
+      const size_t num_candidates = beams.size() * vocab_size;
+      scores_.resize(num_candidates);
+      for (size_t i = 0; i < beams.size(); ++i) {
+        ScoreRow(logits[i], beams[i].log_prob, scores_.data() + i * vocab_size);
+      }
+      const size_t keep = std::min<size_t>(2 * num_beams, num_candidates);
+      using Entry = std::pair<float, size_t>;
+      std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> top;
+      for (size_t i = 0; i < num_candidates; ++i) {
+        if (top.size() < keep) {
+          top.emplace(scores_[i], i);
+        } else if (scores_[i] > top.top().first) {
+          top.pop();
+          top.emplace(scores_[i], i);
+        }
+      }
+      std::vector<Entry> best;
+      while (!top.empty()) {
+        best.push_back(top.top());
+        top.pop();
+      }
+      for (auto it = best.rbegin(); it != best.rend(); ++it) {
+        children.push_back({static_cast<int>(it->second / vocab_size),
+                            static_cast<int>(it->second % vocab_size),
+                            it->first});
+      }
+    }
+
+    // Retire finished children; the rest become the next beams.
+    std::vector<Beam> next;
+    std::vector<bool> slot_claimed(backend_->max_beams(), false);
+    std::vector<const Child*> unplaced;
+    for (const Child& child : children) {
+      const Beam& parent = beams[child.parent];
+      if (child.token == options_.stop_token_id || last_step) {
+        Hypothesis hypothesis{parent.tokens, child.log_prob, 0.0f};
+        if (child.token != options_.stop_token_id) {
+          hypothesis.tokens.push_back(child.token);
+        }
+        finished.push_back(std::move(hypothesis));
+        continue;
+      }
+      if (static_cast<int>(next.size() + unplaced.size()) >= num_beams) {
+        continue;
+      }
+      if (!slot_claimed[parent.slot]) {
+        // The first child continues in its parent's slot without copying.
+        slot_claimed[parent.slot] = true;
+        Beam beam{parent.slot, parent.tokens, child.log_prob};
+        beam.tokens.push_back(child.token);
+        next.push_back(std::move(beam));
+      } else {
+        unplaced.push_back(&child);
+      }
+    }
+
+    // Siblings move into slots nobody claimed, copying only divergent rows.
+    int free_slot = 0;
+    for (const Child* child : unplaced) {
+      while (slot_claimed[free_slot]) {
+        ++free_slot;
+      }
+      const Beam& parent = beams[child->parent];
+      const int shared = CommonPrefixLength(slot_history[parent.slot],
+                                            slot_history[free_slot]);
+      backend_->CopySlot(parent.slot, free_slot, start_position + shared,
+                         position);
+      num_copied_positions_ += position - (start_position + shared);
+      slot_history[free_slot] = slot_history[parent.slot];
+      slot_claimed[free_slot] = true;
+
+      Beam beam{free_slot, parent.tokens, child->log_prob};
+      beam.tokens.push_back(child->token);
+      next.push_back(std::move(beam));
+    }
+    beams = std::move(next);
+
+    if (!options_.sample &&
+        static_cast<int>(finished.size()) >= num_beams) {
+      break;
+    }
+  }
+
+  for (Hypothesis& hypothesis : finished) {
+    float length = std::max<size_t>(1, hypothesis.tokens.size());
+    hypothesis.score =
+        hypothesis.log_prob / std::pow(length, options_.length_penalty);
+  }
+  std::sort(finished.begin(), finished.end(),
+            [](const Hypothesis& a, const Hypothesis& b) {
+              return a.score > b.score;
+            });
+  if (static_cast<int>(finished.size()) > options_.num_return_sequences) {
+    finished.resize(options_.num_return_sequences);
+  }
+  return finished;
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,171 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_BEAM_SEARCH_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_BEAM_SEARCH_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/speculative_decoder.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace ai_edge_torch::examples {
+
+// Runs decode steps for a set of beams that all sit at the same position.
+//
+// Each beam lives in a slot with its own view of the KV cache. All slots
+// share the prompt prefix written by prefill; only positions generated after
+// it can differ between slots.
+class BeamDecodeBackend {
+ public:
+  virtual ~BeamDecodeBackend() = default;
+
+  virtual int max_beams() const = 0;
+  virtual int vocab_size() const = 0;
+
+  // Feeds `tokens[i]` at `position` for beam slot `slots[i]` and fills
+  // `logits` with one row per entry of `slots`. Rows stay valid until the
+  // next call.
+  virtual void Step(const std::vector<int>& slots,
+                    const std::vector<int>& tokens, int position,
+                    std::vector<const float*>* logits) = 0;
+
+  // Makes positions [from_position, to_position) of slot `dst` equal to
+  // those of slot `src`. Callers pass the first position where the two slots
+  // diverge, so shared positions are never copied.
+  virtual void CopySlot(int src, int dst, int from_position,
+                        int to_position) = 0;
+};
+
+// Beam slots are rows of a decode signature exported with a batch
+// dimension: one Invoke() advances every beam and weights are read once.
+class BatchedBeamBackend : public BeamDecodeBackend {
+ public:
+  // `prefix_kv_cache` is the batch-1 cache holding the prefilled prompt; its
+  // first `prefix_length` positions are broadcast into every slot.
+  BatchedBeamBackend(tflite::SignatureRunner* decode_runner,
+                     KVCache* batch_kv_cache, const KVCache& prefix_kv_cache,
+                     int prefix_length);
+
+  int max_beams() const override { return batch_size_; }
+  int vocab_size() const override;
+  void Step(const std::vector<int>& slots, const std::vector<int>& tokens,
+            int position, std::vector<const float*>* logits) override;
+  void CopySlot(int src, int dst, int from_position, int to_position) override;
+
+  // True if `runner` takes a batch of single tokens ([B, 1], B > 1).
+  static bool IsCompatible(tflite::SignatureRunner* runner);
+
+ private:
+  tflite::SignatureRunner* decode_runner_;
+  KVCache* batch_kv_cache_;
+  int batch_size_;
+  int kv_cache_max_size_;
+};
+
+// Fallback for models without a batched decode signature. The prompt prefix
+// stays in the single KV cache bound to the decode runner, which every beam
+// shares. Each beam keeps only its generated rows privately and swaps them
+// in before its own Invoke(), so memory grows with generated length rather
+// than with a full cache per beam.
+class SharedPrefixBeamBackend : public BeamDecodeBackend {
+ public:
+  SharedPrefixBeamBackend(tflite::SignatureRunner* decode_runner,
+                          KVCache* kv_cache, int prefix_length, int max_beams);
+
+  int max_beams() const override { return max_beams_; }
+  int vocab_size() const override;
+  void Step(const std::vector<int>& slots, const std::vector<int>& tokens,
+            int position, std::vector<const float*>* logits) override;
+  void CopySlot(int src, int dst, int from_position, int to_position) override;
+
+ private:
+  // Floats per position of one cache tensor.
+  size_t RowSize(const std::vector<float, AlignedAllocator<float>>& cache) const;
+
+  tflite::SignatureRunner* decode_runner_;
+  KVCache* kv_cache_;
+  const int prefix_length_;
+  const int max_beams_;
+  int kv_cache_max_size_;
+  // Slot whose rows are currently in the bound cache, or -1.
+  int resident_slot_ = -1;
+  // suffix_[slot][layer]: rows for positions >= prefix_length_, in KV cache
+  // iteration order.
+  std::vector<std::vector<std::vector<float>>> suffix_;
+  std::vector<std::vector<float>> logits_;
+};
+
+struct BeamSearchOptions {
+  int num_beams = 4;
+  int num_return_sequences = 4;
+  int max_new_tokens = 32;
+  int stop_token_id = -1;
+  // Scores are log_prob / length^length_penalty.
+  float length_penalty = 1.0f;
+  // If true, every beam samples independently instead of keeping the global
+  // top-k (parallel n-best sampling).
+  bool sample = false;
+  float temperature = 0.9f;
+};
+
+struct Hypothesis {
+  std::vector<int> tokens;
+  float log_prob = 0.0f;
+  float score = 0.0f;
+};
+
+// Beam search and n-best sampling over a BeamDecodeBackend.
+//
+// Per step, the candidate scores of all live beams are written into one
+// contiguous [beams x vocab] buffer (log-softmax plus the parent score) and
+// the global top-k is selected in a single pass. Surviving children keep
+// their parent's slot when possible; the others take over the slots of
+// dropped beams and copy only the positions where the histories differ.
+class BeamSearch {
+ public:
+  BeamSearch(BeamDecodeBackend* backend, BeamSearchOptions options);
+
+  // `pending_token` is the last prompt token, not yet fed, at
+  // `start_position`. Returns up to num_return_sequences hypotheses, best
+  // first.
+  std::vector<Hypothesis> Run(int pending_token, int start_position);
+
+  int num_steps() const { return num_steps_; }
+  // Positions copied between slots, summed over all layers' reorders.
+  long long num_copied_positions() const { return num_copied_positions_; }
+
+ private:
+  struct Beam {
+    int slot;
+    std::vector<int> tokens;
+    float log_prob;
+  };
+
+  // Writes log-softmax(logits) + `base` into `out`.
+  void ScoreRow(const float* logits, float base, float* out) const;
+
+  BeamDecodeBackend* backend_;
+  BeamSearchOptions options_;
+  int num_steps_ = 0;
+  long long num_copied_positions_ = 0;
+  std::vector<float> scores_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_BEAM_SEARCH_H_
@@ -0,0 +1,309 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+
+#include <dirent.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// Without cpu_capacity, cores whose cpufreq maximum is within this fraction
+// of a faster core's belong to its cluster. Favoured x86 cores (Turbo Boost
+// Max 3.0, preferred cores) run a few bins above the rest, while real
+// big.LITTLE clusters differ by far more.
+constexpr double kClusterFrequencyTolerance = 0.15;
+
+}  // namespace
+
+std::vector<int> CpuTopology::all_cpus() const {
+  std::vector<int> cpus;
+  for (const CpuCluster& cluster : clusters) {
+    cpus.insert(cpus.end(), cluster.cpus.begin(), cluster.cpus.end());
+  }
+  std::sort(cpus.begin(), cpus.end());
+  return cpus;
+}
+
+std::vector<int> CpuTopology::performance_cpus() const {
+  if (!heterogeneous()) {
+    return all_cpus();
+  }
+  std::vector<int> cpus;
+  for (size_t i = 0; i + 1 < clusters.size(); ++i) {
+    cpus.insert(cpus.end(), clusters[i].cpus.begin(), clusters[i].cpus.end());
+  }
+  std::sort(cpus.begin(), cpus.end());
+  return cpus;
+}
+
+std::vector<int> CpuTopology::efficiency_cpus() const {
+  return heterogeneous() ? clusters.back().cpus : all_cpus();
+}
+
+void CpuTopology::Print(std::ostream& out) const {
+  out << "CPU topology: " << clusters.size() << " cluster(s)";
+  for (const CpuCluster& cluster : clusters) {
+    out << " [cpus " << FormatCpuList(cluster.cpus) << ", capacity "
+        << cluster.capacity;
+    if (cluster.max_khz > 0) {
+      out << ", " << cluster.max_khz / 1000 << " MHz";
+    }
+    out << "]";
+  }
+  out << "\n";
+}
+
+CpuTopology DiscoverCpuTopology(const std::string& cpu_root) {
+  struct Core {
+    int cpu;
+    int64_t capacity;
+    int64_t max_khz;
+  };
+  std::vector<Core> cores;
+  bool has_capacity = false;
+  for (int cpu : GetThreadAffinity(0)) {
+    const std::string dir = cpu_root + "/cpu" + std::to_string(cpu);
+    const int64_t capacity = ReadSysfsInt(dir + "/cpu_capacity");
+    has_capacity |= capacity > 0;
+    cores.push_back({cpu, capacity > 0 ? capacity : 1024,
+                     ReadSysfsInt(dir + "/cpufreq/cpuinfo_max_freq")});
+  }
+  // Fastest first, so each cluster starts at its highest frequency.
+  std::stable_sort(cores.begin(), cores.end(), [](const Core& a, const Core& b) {
+    return a.capacity != b.capacity ? a.capacity > b.capacity
+                                    : a.max_khz > b.max_khz;
+  });
+
+  CpuTopology topology;
+  for (const Core& core : cores) {
+    CpuCluster* cluster =
+        topology.clusters.empty() ? nullptr : &topology.clusters.back();
+    bool same = false;
+    if (cluster != nullptr) {
+      if (has_capacity) {
+        same = core.capacity == cluster->capacity;
+      } else if (core.max_khz <= 0 || cluster->max_khz <= 0) {
+        same = core.max_khz <= 0 && cluster->max_khz <= 0;
+      } else {
+        same = core.max_khz >=
+               cluster->max_khz * (1.0 - kClusterFrequencyTolerance);
+      }
+    }
+    if (!same) {
+      topology.clusters.push_back({{}, core.capacity, core.max_khz});
+      cluster = &topology.clusters.back();
+    }
+    cluster->cpus.push_back(core.cpu);
+  }
+  for (CpuCluster& cluster : topology.clusters) {
+    std::sort(cluster.cpus.begin(), cluster.cpus.end());
+  }
+  return topology;
+}
+
+const char* ThreadPlacementName(ThreadPlacement placement) {
+  switch (placement) {
+    case ThreadPlacement::kNone:
+      return "none";
+    case ThreadPlacement::kPerformance:
+      return "performance";
+    case ThreadPlacement::kEfficiency:
+      return "efficiency";
+  }
+  return "unknown";
+}
+
+bool ParseThreadPlacement(std::string_view name, ThreadPlacement* placement) {
+  for (ThreadPlacement candidate :
+       {ThreadPlacement::kNone, ThreadPlacement::kPerformance,
+        ThreadPlacement::kEfficiency}) {
+    if (name == ThreadPlacementName(candidate)) {
+      *placement = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+PlacementPlan PlanThreadPlacement(const CpuTopology& topology,
+                                  ThreadPlacement placement) {
+  PlacementPlan plan;
+  switch (placement) {
+    case ThreadPlacement::kNone:
+      break;
+    case ThreadPlacement::kPerformance:
+      plan.compute_cpus = topology.performance_cpus();
+      plan.auxiliary_cpus = topology.efficiency_cpus();
+      break;
+    case ThreadPlacement::kEfficiency:
+      plan.compute_cpus = topology.efficiency_cpus();
+      plan.auxiliary_cpus = topology.efficiency_cpus();
+      break;
+  }
+  return plan;
+}
+
+bool SetThreadAffinity(pid_t tid, const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return !cpus.empty() && sched_setaffinity(tid, sizeof(set), &set) == 0;
+}
+
+std::vector<int> GetThreadAffinity(pid_t tid) {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(tid, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+std::vector<std::string> CpuFreqPolicyDirs(const std::vector<int>& cpus,
+                                           const std::string& cpu_root) {
+  std::vector<std::string> policies;
+  for (int cpu : cpus) {
+    const std::string dir =
+        cpu_root + "/cpu" + std::to_string(cpu) + "/cpufreq";
+    char resolved[PATH_MAX];
+    if (realpath(dir.c_str(), resolved) == nullptr) {
+      continue;  // No cpufreq on this CPU.
+    }
+    if (std::find(policies.begin(), policies.end(), resolved) ==
+        policies.end()) {
+      policies.push_back(resolved);
+    }
+  }
+  return policies;
+}
+
+CpuFreqReader::CpuFreqReader(const std::vector<int>& cpus,
+                             const std::string& cpu_root) {
+  for (int cpu : cpus) {
+    ProcFile file(cpu_root + "/cpu" + std::to_string(cpu) +
+                  "/cpufreq/scaling_cur_freq");
+    if (file.is_open()) {
+      files_.push_back(std::move(file));
+    }
+  }
+}
+
+int64_t CpuFreqReader::AverageKhz() {
+  int64_t sum = 0;
+  int count = 0;
+  for (ProcFile& file : files_) {
+    int64_t khz = ParseInt(file.Read());
+    if (khz > 0) {
+      sum += khz;
+      ++count;
+    }
+  }
+  return count > 0 ? sum / count : -1;
+}
+
+std::vector<pid_t> ListThreadIds() {
+  std::vector<pid_t> tids;
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return tids;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      tids.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+    }
+  }
+  closedir(dir);
+  std::sort(tids.begin(), tids.end());
+  return tids;
+}
+
+ScopedThreadAffinity::ScopedThreadAffinity(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+  saved_ = GetThreadAffinity(0);
+  active_ = SetThreadAffinity(0, cpus);
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity() {
+  if (active_) {
+    SetThreadAffinity(0, saved_);
+  }
+}
+
+std::string FormatCpuList(const std::vector<int>& cpus) {
+  std::string out;
+  for (size_t i = 0; i < cpus.size();) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+      ++j;
+    }
+    if (!out.empty()) {
+      out += ",";
+    }
+    out += std::to_string(cpus[i]);
+    if (j > i) {
+      out += "-" + std::to_string(cpus[j]);
+    }
+    i = j + 1;
+  }
+  return out;
+}
+
+std::vector<int> ParseCpuList(std::string_view text) {
+  std::vector<int> cpus;
+  while (!text.empty()) {
+    size_t comma = text.find(',');
+    std::string_view entry = text.substr(0, comma);
+    text = comma == std::string_view::npos ? std::string_view()
+                                           : text.substr(comma + 1);
+    size_t dash = entry.find('-');
+    int64_t first = ParseInt(entry.substr(0, dash));
+    int64_t last = dash == std::string_view::npos
+                       ? first
+                       : ParseInt(entry.substr(dash + 1));
+    for (int64_t cpu = first; cpu >= 0 && cpu <= last; ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+}  // namespace ai_edge_torch::examples
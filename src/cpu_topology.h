@@ -0,0 +1,137 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_CPU_TOPOLOGY_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_CPU_TOPOLOGY_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+// Core clusters of a heterogeneous (big.LITTLE / DynamIQ) CPU.
+//
+// Cores are grouped by their scheduler capacity (cpu_capacity, 1024 for the
+// biggest core) where the kernel exposes it, and otherwise by cpufreq
+// maximum, merging frequencies within 15% so that favoured turbo cores of an
+// x86 part stay with the rest. Machines with neither form a single cluster.
+// Only CPUs in this process's affinity mask are listed, so an outer taskset
+// or cpuset still applies.
+struct CpuCluster {
+  std::vector<int> cpus;
+  int64_t capacity = 1024;
+  int64_t max_khz = -1;  // -1 without cpufreq.
+};
+
+struct CpuTopology {
+  // Fastest first.
+  std::vector<CpuCluster> clusters;
+
+  bool heterogeneous() const { return clusters.size() > 1; }
+  std::vector<int> all_cpus() const;
+  // Every cluster but the slowest; all CPUs on a homogeneous machine.
+  std::vector<int> performance_cpus() const;
+  // The slowest cluster; all CPUs on a homogeneous machine.
+  std::vector<int> efficiency_cpus() const;
+
+  void Print(std::ostream& out) const;
+};
+
+// `cpu_root` is normally /sys/devices/system/cpu; tests can point it at a
+// fake tree.
+CpuTopology DiscoverCpuTopology(
+    const std::string& cpu_root = "/sys/devices/system/cpu");
+
+// Where compute and auxiliary threads run.
+//
+//   kNone:        leave placement to the scheduler (and any taskset).
+//   kPerformance: the interpreter and its worker pool on the performance
+//                 cores, the tokenizer, sampler and I/O threads on the
+//                 efficiency cores.
+//   kEfficiency:  everything on the efficiency cores, for power runs.
+enum class ThreadPlacement { kNone, kPerformance, kEfficiency };
+
+const char* ThreadPlacementName(ThreadPlacement placement);
+// Accepts "none", "performance" and "efficiency".
+bool ParseThreadPlacement(std::string_view name, ThreadPlacement* placement);
+
+struct PlacementPlan {
+  std::vector<int> compute_cpus;    // Empty for kNone.
+  std::vector<int> auxiliary_cpus;  // Empty for kNone.
+};
+
+PlacementPlan PlanThreadPlacement(const CpuTopology& topology,
+                                  ThreadPlacement placement);
+
+// Affinity of thread `tid` (0 for the calling thread). Threads inherit the
+// mask of the thread that creates them.
+bool SetThreadAffinity(pid_t tid, const std::vector<int>& cpus);
+std::vector<int> GetThreadAffinity(pid_t tid);
+
+// Ids of this process's threads, from /proc/self/task.
+std::vector<pid_t> ListThreadIds();
+
+// Moves the calling thread to `cpus` for the lifetime of the object, so that
+// threads started inside the scope inherit that mask. An empty set is a
+// no-op.
+class ScopedThreadAffinity {
+ public:
+  explicit ScopedThreadAffinity(const std::vector<int>& cpus);
+  ~ScopedThreadAffinity();
+
+  ScopedThreadAffinity(const ScopedThreadAffinity&) = delete;
+  ScopedThreadAffinity& operator=(const ScopedThreadAffinity&) = delete;
+
+ private:
+  std::vector<int> saved_;
+  bool active_ = false;
+};
+
+// The cpufreq policy directories of `cpus`, each once: CPUs sharing a policy
+// link to the same one. CPUs without cpufreq are skipped.
+std::vector<std::string> CpuFreqPolicyDirs(
+    const std::vector<int>& cpus,
+    const std::string& cpu_root = "/sys/devices/system/cpu");
+
+// Current cpufreq frequency of a set of CPUs, re-read from kept-open
+// scaling_cur_freq files. CPUs without cpufreq are skipped.
+class CpuFreqReader {
+ public:
+  explicit CpuFreqReader(const std::vector<int>& cpus,
+                         const std::string& cpu_root = "/sys/devices/system/cpu");
+
+  bool available() const { return !files_.empty(); }
+  // Mean over the CPUs in kHz, or -1 if none can be read.
+  int64_t AverageKhz();
+
+ private:
+  std::vector<ProcFile> files_;
+};
+
+// "0-3,6".
+std::string FormatCpuList(const std::vector<int>& cpus);
+// The inverse, for sysfs cpulist files. Malformed entries are skipped.
+std::vector<int> ParseCpuList(std::string_view text);
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_CPU_TOPOLOGY_H_
@@ -0,0 +1,237 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/energy_meter.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// hwmon channels are numbered from 1; drivers rarely expose more than this.
+constexpr int kMaxHwmonChannels = 16;
+
+std::vector<std::string> ListDir(const std::string& path) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return names;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+bool Readable(const std::string& path) {
+  std::string contents;
+  return ReadFileToString(path, &contents) && ParseInt(contents, -1) >= 0;
+}
+
+// RAPL zones: packages and their DRAM subzones, or the platform (psys) zone
+// alone, which already covers both.
+std::vector<EnergySource> FindRapl(const std::string& root) {
+  std::vector<EnergySource> sources;
+  std::vector<EnergySource> psys;
+  const std::string powercap = root + "/class/powercap";
+  for (const std::string& zone : ListDir(powercap)) {
+    if (zone.rfind("intel-rapl:", 0) != 0) {
+      continue;
+    }
+    const std::string dir = powercap + "/" + zone;
+    const std::string name = ReadSysfsValue(dir + "/name");
+    const bool top_level = std::count(zone.begin(), zone.end(), ':') == 1;
+    if (!Readable(dir + "/energy_uj") ||
+        !(top_level ? name.rfind("package", 0) == 0 || name == "psys"
+                    : name == "dram")) {
+      continue;
+    }
+    std::string range;
+    ReadFileToString(dir + "/max_energy_range_uj", &range);
+    EnergySource source{EnergySource::Kind::kRapl, name, dir + "/energy_uj",
+                        "", std::max<int64_t>(0, ParseInt(range, 0))};
+    (name == "psys" ? psys : sources).push_back(std::move(source));
+  }
+  return sources.empty() ? psys : sources;
+}
+
+std::vector<EnergySource> FindHwmon(const std::string& root,
+                                    EnergySource::Kind kind) {
+  std::vector<EnergySource> sources;
+  const std::string prefix =
+      kind == EnergySource::Kind::kHwmonEnergy ? "energy" : "power";
+  const std::string hwmon = root + "/class/hwmon";
+  for (const std::string& chip : ListDir(hwmon)) {
+    const std::string dir = hwmon + "/" + chip;
+    const std::string chip_name = ReadSysfsValue(dir + "/name");
+    for (int channel = 1; channel <= kMaxHwmonChannels; ++channel) {
+      const std::string base = dir + "/" + prefix + std::to_string(channel);
+      if (!Readable(base + "_input")) {
+        continue;
+      }
+      std::string label = ReadSysfsValue(base + "_label");
+      if (label.empty()) {
+        label = prefix + std::to_string(channel);
+      }
+      sources.push_back({kind, (chip_name.empty() ? chip : chip_name) + "/" +
+                                   label,
+                         base + "_input", "", 0});
+    }
+  }
+  return sources;
+}
+
+std::vector<EnergySource> FindBatteries(const std::string& root) {
+  std::vector<EnergySource> sources;
+  const std::string power_supply = root + "/class/power_supply";
+  for (const std::string& supply : ListDir(power_supply)) {
+    const std::string dir = power_supply + "/" + supply;
+    if (ReadSysfsValue(dir + "/type") != "Battery") {
+      continue;
+    }
+    if (Readable(dir + "/power_now")) {
+      sources.push_back({EnergySource::Kind::kBattery, supply,
+                         dir + "/power_now", "", 0});
+    } else if (Readable(dir + "/voltage_now")) {
+      // current_now is negative while discharging on some drivers.
+      std::string current;
+      if (ReadFileToString(dir + "/current_now", &current) &&
+          ParseInt(current, 0) != 0) {
+        sources.push_back({EnergySource::Kind::kBattery, supply,
+                           dir + "/voltage_now", dir + "/current_now", 0});
+      }
+    }
+  }
+  return sources;
+}
+
+}  // namespace
+
+EnergyMeter::EnergyMeter(const std::string& sysfs_root) {
+  sources_ = FindRapl(sysfs_root);
+  if (sources_.empty()) {
+    sources_ = FindHwmon(sysfs_root, EnergySource::Kind::kHwmonEnergy);
+  }
+  if (sources_.empty()) {
+    sources_ = FindHwmon(sysfs_root, EnergySource::Kind::kHwmonPower);
+  }
+  if (sources_.empty()) {
+    sources_ = FindBatteries(sysfs_root);
+  }
+  for (const EnergySource& source : sources_) {
+    files_.emplace_back(source.path);
+    current_files_.emplace_back(source.current_path.empty()
+                                    ? ProcFile()
+                                    : ProcFile(source.current_path));
+  }
+  last_raw_.assign(sources_.size(), -1);
+  total_uj_.assign(sources_.size(), 0.0);
+  Read();
+}
+
+std::string EnergyMeter::Describe() const {
+  if (sources_.empty()) {
+    return "none";
+  }
+  static constexpr const char* kKindNames[] = {"RAPL", "hwmon energy",
+                                               "hwmon power", "battery"};
+  std::string description = kKindNames[static_cast<int>(sources_[0].kind)];
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    description += (i == 0 ? " " : ", ") + sources_[i].name;
+  }
+  return description;
+}
+
+int64_t EnergyMeter::Sample(size_t i) {
+  const int64_t value = ParseInt(files_[i].Read());
+  if (value < 0 || !current_files_[i].is_open()) {
+    return value;
+  }
+  // uV * uA = pW.
+  const int64_t current = std::llabs(ParseInt(current_files_[i].Read(), 0));
+  return static_cast<int64_t>(static_cast<double>(value) * current / 1e6);
+}
+
+void EnergyMeter::Read(Snapshot* snapshot) {
+  const Clock::time_point now = Clock::now();
+  const double elapsed_s =
+      std::chrono::duration<double>(now - last_time_).count();
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    const int64_t raw = Sample(i);
+    if (raw < 0) {
+      continue;
+    }
+    const int64_t last = last_raw_[i];
+    if (last >= 0) {
+      if (sources_[i].kind == EnergySource::Kind::kRapl ||
+          sources_[i].kind == EnergySource::Kind::kHwmonEnergy) {
+        int64_t delta = raw - last;
+        if (delta < 0 && sources_[i].range_uj > 0) {
+          delta += sources_[i].range_uj;
+        }
+        total_uj_[i] += std::max<int64_t>(0, delta);
+      } else {
+        // Trapezoid over the interval; uW * s = uJ.
+        total_uj_[i] += 0.5 * static_cast<double>(raw + last) * elapsed_s;
+      }
+    }
+    last_raw_[i] = raw;
+  }
+  last_time_ = now;
+  snapshot->time = now;
+  snapshot->energy_uj = total_uj_;
+}
+
+EnergyMeter::Snapshot EnergyMeter::Read() {
+  Snapshot snapshot;
+  Read(&snapshot);
+  return snapshot;
+}
+
+EnergyMeter::Stats EnergyMeter::Diff(const Snapshot& start,
+                                     const Snapshot& end) const {
+  Stats stats;
+  if (sources_.empty() || start.energy_uj.size() != sources_.size() ||
+      end.energy_uj.size() != sources_.size()) {
+    return stats;
+  }
+  double energy_uj = 0.0;
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    energy_uj += end.energy_uj[i] - start.energy_uj[i];
+  }
+  stats.valid = true;
+  stats.wall_ms =
+      std::chrono::duration<double, std::milli>(end.time - start.time).count();
+  stats.joules = energy_uj / 1e6;
+  stats.average_watts =
+      stats.wall_ms > 0 ? stats.joules / (stats.wall_ms / 1000.0) : 0.0;
+  return stats;
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,102 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_ENERGY_METER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_ENERGY_METER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+// One energy counter or power rail found under the sysfs root.
+struct EnergySource {
+  enum class Kind {
+    kRapl,         // powercap energy_uj, wraps at max_energy_range_uj.
+    kHwmonEnergy,  // hwmon energyN_input in uJ.
+    kHwmonPower,   // hwmon powerN_input in uW.
+    kBattery,      // power_supply power_now in uW, or voltage_now * current_now.
+  };
+  Kind kind;
+  std::string name;
+  std::string path;
+  // current_now of a battery without power_now; `path` is then voltage_now.
+  std::string current_path;
+  int64_t range_uj = 0;
+};
+
+// Energy drawn by the package, SoC rails or battery, read from sysfs.
+//
+// Only the most accurate kind of source found is used, so nothing is counted
+// twice: RAPL package (plus DRAM) zones, else hwmon energy counters, else
+// hwmon power rails, else discharging batteries. Power readings are
+// integrated at every Read(), so for the last two kinds energy is as accurate
+// as reads are frequent; reading at every token boundary is enough for the
+// millisecond update rate of typical current sensors. Like HardwareCounters,
+// the meter sees the whole machine, not just this process.
+class EnergyMeter {
+ public:
+  // Cumulative energy of every source in uJ since construction.
+  struct Snapshot {
+    std::chrono::steady_clock::time_point time;
+    std::vector<double> energy_uj;
+  };
+
+  struct Stats {
+    bool valid = false;
+    double wall_ms = 0;
+    double joules = 0;
+    double average_watts = 0;
+  };
+
+  // `sysfs_root` is normally /sys; tests can point it at a fake tree.
+  explicit EnergyMeter(const std::string& sysfs_root = "/sys");
+
+  EnergyMeter(const EnergyMeter&) = delete;
+  EnergyMeter& operator=(const EnergyMeter&) = delete;
+
+  bool available() const { return !sources_.empty(); }
+  const std::vector<EnergySource>& sources() const { return sources_; }
+  // e.g. "RAPL package-0, dram".
+  std::string Describe() const;
+
+  // Not thread-safe; read from one thread.
+  void Read(Snapshot* snapshot);
+  Snapshot Read();
+
+  Stats Diff(const Snapshot& start, const Snapshot& end) const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  // Raw counter in uJ or power in uW of source `i`; -1 on error.
+  int64_t Sample(size_t i);
+
+  std::vector<EnergySource> sources_;
+  std::vector<ProcFile> files_;
+  std::vector<ProcFile> current_files_;
+  // Per source: last raw reading and running total.
+  std::vector<int64_t> last_raw_;
+  std::vector<double> total_uj_;
+  Clock::time_point last_time_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_ENERGY_METER_H_
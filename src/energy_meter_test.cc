@@ -0,0 +1,156 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks EnergyMeter's choice of source and its accounting on fake sysfs
+// trees: RAPL zones, counter wraparound, hwmon power rails and batteries.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "ai_edge_torch/generative/examples/cpp/energy_meter.h"
+#include "ai_edge_torch/generative/examples/cpp/fake_sysfs.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+constexpr char kPowercap[] = "class/powercap/";
+
+bool Near(double value, double expected, double tolerance) {
+  return std::fabs(value - expected) <= tolerance;
+}
+
+void WriteRaplZone(FakeSysfs& sysfs, const std::string& zone,
+                   const std::string& name, long long energy_uj,
+                   long long range_uj) {
+  const std::string dir = kPowercap + zone;
+  sysfs.Write(dir + "/name", name);
+  sysfs.Write(dir + "/energy_uj", energy_uj);
+  sysfs.Write(dir + "/max_energy_range_uj", range_uj);
+}
+
+void TestRaplPrefersPackageAndDram() {
+  FakeSysfs sysfs;
+  WriteRaplZone(sysfs, "intel-rapl:0", "package-0", 1000, 262143328850);
+  WriteRaplZone(sysfs, "intel-rapl:0:0", "dram", 500, 65712999613);
+  WriteRaplZone(sysfs, "intel-rapl:0:1", "core", 700, 262143328850);
+  // psys already covers the package and DRAM; counting it too would double
+  // the energy.
+  WriteRaplZone(sysfs, "intel-rapl:1", "psys", 9000, 262143328850);
+  // A lower-priority source that must be ignored.
+  sysfs.Write("class/hwmon/hwmon0/power1_input", 5000000);
+
+  EnergyMeter meter(sysfs.root());
+  SYSFS_EXPECT(meter.sources().size() == 2);
+  SYSFS_EXPECT(meter.Describe() == "RAPL package-0, dram");
+
+  const EnergyMeter::Snapshot start = meter.Read();
+  WriteRaplZone(sysfs, "intel-rapl:0", "package-0", 4000, 262143328850);
+  WriteRaplZone(sysfs, "intel-rapl:0:0", "dram", 1500, 65712999613);
+  WriteRaplZone(sysfs, "intel-rapl:1", "psys", 90000, 262143328850);
+  const EnergyMeter::Stats stats = meter.Diff(start, meter.Read());
+  SYSFS_EXPECT(stats.valid);
+  // 3000 uJ of package plus 1000 uJ of DRAM.
+  SYSFS_EXPECT(Near(stats.joules, 0.004, 1e-9));
+}
+
+void TestRaplPsysOnly() {
+  FakeSysfs sysfs;
+  WriteRaplZone(sysfs, "intel-rapl:0", "psys", 1000, 262143328850);
+  EnergyMeter meter(sysfs.root());
+  SYSFS_EXPECT(meter.sources().size() == 1);
+  SYSFS_EXPECT(meter.Describe() == "RAPL psys");
+}
+
+void TestRaplWraparound() {
+  FakeSysfs sysfs;
+  WriteRaplZone(sysfs, "intel-rapl:0", "package-0", 999000, 1000000);
+  EnergyMeter meter(sysfs.root());
+  const EnergyMeter::Snapshot start = meter.Read();
+  // Wrapped past max_energy_range_uj: 1000 uJ to the top, 1000 uJ after.
+  sysfs.Write(std::string(kPowercap) + "intel-rapl:0/energy_uj", 1000);
+  const EnergyMeter::Stats stats = meter.Diff(start, meter.Read());
+  SYSFS_EXPECT(stats.valid);
+  SYSFS_EXPECT(Near(stats.joules, 0.002, 1e-9));
+}
+
+void TestHwmonPowerTrapezoid() {
+  FakeSysfs sysfs;
+  sysfs.Write("class/hwmon/hwmon0/name", "ina3221");
+  sysfs.Write("class/hwmon/hwmon0/power1_label", "VDD_CPU");
+  sysfs.Write("class/hwmon/hwmon0/power1_input", 2000000);
+
+  EnergyMeter meter(sysfs.root());
+  SYSFS_EXPECT(meter.Describe() == "hwmon power ina3221/VDD_CPU");
+  const EnergyMeter::Snapshot start = meter.Read();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  sysfs.Write("class/hwmon/hwmon0/power1_input", 4000000);
+  const EnergyMeter::Stats stats = meter.Diff(start, meter.Read());
+  SYSFS_EXPECT(stats.valid);
+  // A linear ramp from 2 W to 4 W averages 3 W.
+  SYSFS_EXPECT(Near(stats.average_watts, 3.0, 0.01));
+  SYSFS_EXPECT(Near(stats.joules, 3.0 * stats.wall_ms / 1000.0, 1e-6));
+}
+
+void TestBatteryFallback() {
+  FakeSysfs sysfs;
+  // Mains supplies are not batteries.
+  sysfs.Write("class/power_supply/AC/type", "Mains");
+  sysfs.Write("class/power_supply/AC/power_now", 30000000);
+  // No power_now: 12 V at 0.5 A, negative while discharging.
+  sysfs.Write("class/power_supply/BAT0/type", "Battery");
+  sysfs.Write("class/power_supply/BAT0/voltage_now", 12000000);
+  sysfs.Write("class/power_supply/BAT0/current_now", -500000);
+
+  EnergyMeter meter(sysfs.root());
+  SYSFS_EXPECT(meter.sources().size() == 1);
+  SYSFS_EXPECT(meter.Describe() == "battery BAT0");
+  const EnergyMeter::Snapshot start = meter.Read();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const EnergyMeter::Stats stats = meter.Diff(start, meter.Read());
+  SYSFS_EXPECT(stats.valid);
+  SYSFS_EXPECT(Near(stats.average_watts, 6.0, 0.01));
+}
+
+void TestNoSources() {
+  FakeSysfs sysfs;
+  sysfs.Write("class/power_supply/AC/type", "Mains");
+  EnergyMeter meter(sysfs.root());
+  SYSFS_EXPECT(!meter.available());
+  SYSFS_EXPECT(meter.Describe() == "none");
+  SYSFS_EXPECT(!meter.Diff(meter.Read(), meter.Read()).valid);
+}
+
+}  // namespace
+}  // namespace ai_edge_torch::examples
+
+int main() {
+  using namespace ai_edge_torch::examples;  // NOLINT
+  TestRaplPrefersPackageAndDram();
+  TestRaplPsysOnly();
+  TestRaplWraparound();
+  TestHwmonPowerTrapezoid();
+  TestBatteryFallback();
+  TestNoSources();
+  if (ExpectationFailures() != 0) {
+    std::cerr << ExpectationFailures() << " expectation(s) failed"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "PASSED" << std::endl;
+  return 0;
+}
@@ -0,0 +1,471 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// Binary layout, host byte order (little-endian on every supported target):
+//
+//   file      := "TFEP" u32:version u32:num_subgraphs subgraph*
+//   subgraph  := i32:index str:name u32:num_tensors tensor*
+//                u32:num_nodes node*
+//   tensor    := i32:id u8:allocation str:data_type ints:shape u64:bytes
+//                u64:address i32:first_use i32:last_use
+//   node      := i32:step i32:node_index str:op u8:delegated ints:inputs
+//                ints:outputs ints:intermediates ints:temporaries
+//   str       := u32:length byte*
+//   ints      := u32:count i32*
+//
+// used_by_steps is not stored; the reader recomputes it from the nodes.
+constexpr char kMagic[4] = {'T', 'F', 'E', 'P'};
+constexpr uint32_t kVersion = 1;
+
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(std::ofstream* out) : out_(out) {}
+
+  template <typename T>
+  void Pod(T value) {
+    out_->write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void Str(const std::string& value) {
+    Pod(static_cast<uint32_t>(value.size()));
+    out_->write(value.data(), value.size());
+  }
+  void Ints(const std::vector<int32_t>& values) {
+    Pod(static_cast<uint32_t>(values.size()));
+    out_->write(reinterpret_cast<const char*>(values.data()),
+                values.size() * sizeof(int32_t));
+  }
+
+ private:
+  std::ofstream* out_;
+};
+
+// Bounds-checked reader over the whole file; once a read fails every later
+// read fails too, so callers check ok() once per record.
+class BinaryReader {
+ public:
+  explicit BinaryReader(std::string_view data) : data_(data) {}
+
+  bool ok() const { return ok_; }
+
+  template <typename T>
+  T Pod() {
+    T value{};
+    if (Take(sizeof(T))) {
+      std::memcpy(&value, data_.data() + pos_ - sizeof(T), sizeof(T));
+    }
+    return value;
+  }
+  std::string Str() {
+    const uint32_t size = Pod<uint32_t>();
+    if (!Take(size)) {
+      return "";
+    }
+    return std::string(data_.substr(pos_ - size, size));
+  }
+  std::vector<int32_t> Ints() {
+    const uint32_t count = Pod<uint32_t>();
+    std::vector<int32_t> values;
+    if (!Take(static_cast<uint64_t>(count) * sizeof(int32_t))) {
+      return values;
+    }
+    values.resize(count);
+    if (count > 0) {
+      std::memcpy(values.data(),
+                  data_.data() + pos_ - count * sizeof(int32_t),
+                  count * sizeof(int32_t));
+    }
+    return values;
+  }
+  // Rejects counts that cannot fit in the rest of the file before the
+  // caller reserves memory for them.
+  uint32_t Count(size_t min_record_bytes) {
+    const uint32_t count = Pod<uint32_t>();
+    if (ok_ && static_cast<uint64_t>(count) * min_record_bytes >
+                   data_.size() - pos_) {
+      ok_ = false;
+    }
+    return ok_ ? count : 0;
+  }
+
+ private:
+  bool Take(uint64_t bytes) {
+    if (!ok_ || bytes > data_.size() - pos_) {
+      ok_ = false;
+      return false;
+    }
+    pos_ += bytes;
+    return true;
+  }
+
+  std::string_view data_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+std::string HexAddress(uint64_t address) {
+  char buffer[24];
+  std::snprintf(buffer, sizeof(buffer), "0x%" PRIx64, address);
+  return buffer;
+}
+
+std::string ShapeString(const std::vector<int32_t>& shape) {
+  std::string result = "[";
+  for (size_t i = 0; i < shape.size(); ++i) {
+    result += (i > 0 ? ", " : "") + std::to_string(shape[i]);
+  }
+  return result + "]";
+}
+
+void WriteInts(JsonWriter* json, std::string_view key,
+               const std::vector<int32_t>& values) {
+  json->Key(key);
+  json->BeginArray();
+  for (int32_t value : values) {
+    json->Int(value);
+  }
+  json->EndArray();
+}
+
+// Node indices (not steps) that use `tensor`, as the text logs listed them.
+std::vector<int32_t> UsedByNodes(const SubgraphPlan& subgraph,
+                                 const PlanTensor& tensor) {
+  std::vector<int32_t> nodes;
+  for (int32_t step : tensor.used_by_steps) {
+    nodes.push_back(subgraph.nodes[step].node_index);
+  }
+  return nodes;
+}
+
+void WriteTensor(JsonWriter* json, const SubgraphPlan& subgraph,
+                 const PlanTensor& tensor) {
+  json->BeginObject();
+  json->Field("tensor_id", tensor.id);
+  json->Field("address", tensor.address);
+  json->Field("address_hex", HexAddress(tensor.address));
+  json->Field("size", tensor.bytes);
+  json->Field("data_type", tensor.data_type);
+  json->Field("shape", ShapeString(tensor.shape));
+  json->Field("usage_count", static_cast<int>(tensor.used_by_steps.size()));
+  WriteInts(json, "used_by_nodes", UsedByNodes(subgraph, tensor));
+  json->Field("first_use", tensor.first_use);
+  json->Field("last_use", tensor.last_use);
+  json->EndObject();
+}
+
+void WriteReportData(JsonWriter* json, const SubgraphPlan& subgraph) {
+  std::map<std::string, std::vector<const PlanTensor*>> by_type;
+  std::map<uint64_t, std::vector<const PlanTensor*>> by_address;
+  uint64_t total_size = 0;
+  for (const PlanTensor& tensor : subgraph.tensors) {
+    by_type[TensorAllocationName(tensor.allocation)].push_back(&tensor);
+    if (tensor.address != 0 && tensor.bytes > 0) {
+      by_address[tensor.address].push_back(&tensor);
+    }
+    total_size += tensor.bytes;
+  }
+
+  json->Key("report_data");
+  json->BeginObject();
+
+  json->Key("summary");
+  json->BeginObject();
+  json->Field("total_tensors", static_cast<int>(subgraph.tensors.size()));
+  json->Field("total_size", total_size);
+  json->Key("allocation_types");
+  json->BeginObject();
+  for (const auto& [type, tensors] : by_type) {
+    uint64_t type_size = 0;
+    for (const PlanTensor* tensor : tensors) {
+      type_size += tensor->bytes;
+    }
+    json->Key(type);
+    json->BeginObject();
+    json->Field("count", static_cast<int>(tensors.size()));
+    json->Field("total_size", type_size);
+    json->Field("percentage",
+                total_size > 0 ? 100.0 * type_size / total_size : 0.0);
+    json->EndObject();
+  }
+  json->EndObject();
+  json->EndObject();
+
+  // Arena planning reuses memory between tensors with disjoint lifetimes.
+  json->Key("shared_memory_groups");
+  json->BeginArray();
+  for (const auto& [address, tensors] : by_address) {
+    if (tensors.size() < 2) {
+      continue;
+    }
+    json->BeginObject();
+    json->Field("address", address);
+    json->Field("address_hex", HexAddress(address));
+    json->Key("tensors");
+    json->BeginArray();
+    for (const PlanTensor* tensor : tensors) {
+      json->BeginObject();
+      json->Field("tensor_id", tensor->id);
+      json->Field("size", tensor->bytes);
+      json->EndObject();
+    }
+    json->EndArray();
+    json->EndObject();
+  }
+  json->EndArray();
+
+  json->Key("tensors_by_type");
+  json->BeginObject();
+  for (const auto& [type, tensors] : by_type) {
+    json->Key(type);
+    json->BeginArray();
+    for (const PlanTensor* tensor : tensors) {
+      WriteTensor(json, subgraph, *tensor);
+    }
+    json->EndArray();
+  }
+  json->EndObject();
+
+  json->EndObject();
+}
+
+void WriteSubgraph(JsonWriter* json, const SubgraphPlan& subgraph) {
+  json->Field("subgraph_index", subgraph.index);
+  json->Field("subgraph_name", subgraph.name);
+  WriteReportData(json, subgraph);
+
+  json->Key("execution_plan");
+  json->BeginArray();
+  for (const PlanNode& node : subgraph.nodes) {
+    json->BeginObject();
+    json->Field("step", node.step);
+    json->Field("node_idx", node.node_index);
+    json->Field("operator", node.op);
+    json->Field("delegated", node.delegated);
+    WriteInts(json, "inputs", node.inputs);
+    WriteInts(json, "outputs", node.outputs);
+    WriteInts(json, "intermediates", node.intermediates);
+    WriteInts(json, "temporaries", node.temporaries);
+    json->EndObject();
+  }
+  json->EndArray();
+
+  json->Key("tensor_usage");
+  json->BeginObject();
+  for (const PlanTensor& tensor : subgraph.tensors) {
+    if (tensor.used_by_steps.empty()) {
+      continue;
+    }
+    json->Key(std::to_string(tensor.id));
+    json->BeginObject();
+    json->Field("first_use", tensor.first_use);
+    json->Field("last_use", tensor.last_use);
+    WriteInts(json, "used_by_nodes", UsedByNodes(subgraph, tensor));
+    json->EndObject();
+  }
+  json->EndObject();
+}
+
+}  // namespace
+
+const char* TensorAllocationName(TensorAllocation allocation) {
+  switch (allocation) {
+    case TensorAllocation::kNone:
+      return "None";
+    case TensorAllocation::kMmap:
+      return "Mmap";
+    case TensorAllocation::kArenaRw:
+      return "Arena RW";
+    case TensorAllocation::kArenaRwPersistent:
+      return "Arena RW Persistent";
+    case TensorAllocation::kDynamic:
+      return "Dynamic";
+    case TensorAllocation::kPersistentRo:
+      return "Persistent RO";
+    case TensorAllocation::kCustom:
+      return "Custom";
+    case TensorAllocation::kOther:
+      break;
+  }
+  return "Other";
+}
+
+void ComputeTensorLifetimes(SubgraphPlan* subgraph) {
+  for (PlanTensor& tensor : subgraph->tensors) {
+    tensor.first_use = tensor.last_use = -1;
+    tensor.used_by_steps.clear();
+  }
+  const int32_t num_tensors = static_cast<int32_t>(subgraph->tensors.size());
+  for (size_t step = 0; step < subgraph->nodes.size(); ++step) {
+    const PlanNode& node = subgraph->nodes[step];
+    for (const auto* ids : {&node.inputs, &node.outputs, &node.intermediates,
+                            &node.temporaries}) {
+      for (int32_t id : *ids) {
+        if (id < 0 || id >= num_tensors) {
+          continue;
+        }
+        PlanTensor& tensor = subgraph->tensors[id];
+        const int32_t s = static_cast<int32_t>(step);
+        // A node may list the same tensor twice; record the step once.
+        if (tensor.used_by_steps.empty() || tensor.used_by_steps.back() != s) {
+          tensor.used_by_steps.push_back(s);
+        }
+        if (tensor.first_use < 0) {
+          tensor.first_use = s;
+        }
+        tensor.last_use = s;
+      }
+    }
+  }
+}
+
+bool WriteExecutionPlanJson(const ExecutionPlan& plan, int primary,
+                            const std::string& path) {
+  std::ofstream out(path);
+  if (!out.is_open() || plan.subgraphs.empty()) {
+    return false;
+  }
+  if (primary < 0 || primary >= static_cast<int>(plan.subgraphs.size())) {
+    primary = 0;
+  }
+  JsonWriter json(&out);
+  json.BeginObject();
+  WriteSubgraph(&json, plan.subgraphs[primary]);
+  json.Key("subgraphs");
+  json.BeginArray();
+  for (const SubgraphPlan& subgraph : plan.subgraphs) {
+    json.BeginObject();
+    WriteSubgraph(&json, subgraph);
+    json.EndObject();
+  }
+  json.EndArray();
+  json.EndObject();
+  out << "\n";
+  return out.good();
+}
+
+bool WriteExecutionPlanBinary(const ExecutionPlan& plan,
+                              const std::string& path) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out.is_open()) {
+    return false;
+  }
+  BinaryWriter writer(&out);
+  out.write(kMagic, sizeof(kMagic));
+  writer.Pod(kVersion);
+  writer.Pod(static_cast<uint32_t>(plan.subgraphs.size()));
+  for (const SubgraphPlan& subgraph : plan.subgraphs) {
+    writer.Pod(subgraph.index);
+    writer.Str(subgraph.name);
+    writer.Pod(static_cast<uint32_t>(subgraph.tensors.size()));
+    for (const PlanTensor& tensor : subgraph.tensors) {
+      writer.Pod(tensor.id);
+      writer.Pod(static_cast<uint8_t>(tensor.allocation));
+      writer.Str(tensor.data_type);
+      writer.Ints(tensor.shape);
+      writer.Pod(tensor.bytes);
+      writer.Pod(tensor.address);
+      writer.Pod(tensor.first_use);
+      writer.Pod(tensor.last_use);
+    }
+    writer.Pod(static_cast<uint32_t>(subgraph.nodes.size()));
+    for (const PlanNode& node : subgraph.nodes) {
+      writer.Pod(node.step);
+      writer.Pod(node.node_index);
+      writer.Str(node.op);
+      writer.Pod(static_cast<uint8_t>(node.delegated));
+      writer.Ints(node.inputs);
+      writer.Ints(node.outputs);
+      writer.Ints(node.intermediates);
+      writer.Ints(node.temporaries);
+    }
+  }
+  return out.good();
+}
+
+bool ReadExecutionPlanBinary(const std::string& path, ExecutionPlan* plan) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  const std::string data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(kMagic) ||
+      std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+  BinaryReader reader(std::string_view(data).substr(sizeof(kMagic)));
+  if (reader.Pod<uint32_t>() != kVersion) {
+    return false;
+  }
+
+  // Smallest encodings of each record, used to reject corrupt counts.
+  constexpr size_t kMinSubgraph = 16, kMinTensor = 37, kMinNode = 29;
+  plan->subgraphs.clear();
+  const uint32_t num_subgraphs = reader.Count(kMinSubgraph);
+  for (uint32_t i = 0; i < num_subgraphs && reader.ok(); ++i) {
+    SubgraphPlan& subgraph = plan->subgraphs.emplace_back();
+    subgraph.index = reader.Pod<int32_t>();
+    subgraph.name = reader.Str();
+    subgraph.tensors.resize(reader.Count(kMinTensor));
+    for (PlanTensor& tensor : subgraph.tensors) {
+      tensor.id = reader.Pod<int32_t>();
+      const uint8_t allocation = reader.Pod<uint8_t>();
+      tensor.allocation =
+          allocation < static_cast<uint8_t>(TensorAllocation::kOther)
+              ? static_cast<TensorAllocation>(allocation)
+              : TensorAllocation::kOther;
+      tensor.data_type = reader.Str();
+      tensor.shape = reader.Ints();
+      tensor.bytes = reader.Pod<uint64_t>();
+      tensor.address = reader.Pod<uint64_t>();
+      tensor.first_use = reader.Pod<int32_t>();
+      tensor.last_use = reader.Pod<int32_t>();
+    }
+    subgraph.nodes.resize(reader.Count(kMinNode));
+    for (PlanNode& node : subgraph.nodes) {
+      node.step = reader.Pod<int32_t>();
+      node.node_index = reader.Pod<int32_t>();
+      node.op = reader.Str();
+      node.delegated = reader.Pod<uint8_t>() != 0;
+      node.inputs = reader.Ints();
+      node.outputs = reader.Ints();
+      node.intermediates = reader.Ints();
+      node.temporaries = reader.Ints();
+    }
+    if (reader.ok()) {
+      ComputeTensorLifetimes(&subgraph);
+    }
+  }
+  return reader.ok();
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,101 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_EXECUTION_PLAN_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_EXECUTION_PLAN_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// Structured form of the interpreter's execution plans and tensor layout.
+//
+// This header has no TFLite dependency so that offline tools can read a dump
+// without linking the runtime; execution_plan_capture.h fills it from a live
+// interpreter.
+
+// Mirrors TfLiteAllocationType; kept separate so the file format does not
+// change if the TFLite enum does.
+enum class TensorAllocation : uint8_t {
+  kNone = 0,
+  kMmap,               // Read-only weights in the mapped model file.
+  kArenaRw,            // Activations; may share memory with other tensors.
+  kArenaRwPersistent,  // Arena memory that lives across invocations.
+  kDynamic,
+  kPersistentRo,
+  kCustom,             // Externally bound buffers such as the KV cache.
+  kOther,
+};
+
+const char* TensorAllocationName(TensorAllocation allocation);
+
+struct PlanTensor {
+  int32_t id = 0;
+  TensorAllocation allocation = TensorAllocation::kNone;
+  std::string data_type;
+  std::vector<int32_t> shape;
+  uint64_t bytes = 0;
+  uint64_t address = 0;  // Data pointer at dump time; 0 if unallocated.
+  // Execution steps (positions in the plan) that read or write the tensor;
+  // -1 if no node in the plan uses it.
+  int32_t first_use = -1;
+  int32_t last_use = -1;
+  std::vector<int32_t> used_by_steps;
+};
+
+struct PlanNode {
+  int32_t step = 0;        // Position in execution_plan().
+  int32_t node_index = 0;  // Index into the subgraph's nodes.
+  std::string op;          // Builtin op name, custom name or delegate name.
+  bool delegated = false;  // A delegate kernel covering a partition.
+  std::vector<int32_t> inputs;
+  std::vector<int32_t> outputs;
+  std::vector<int32_t> intermediates;
+  std::vector<int32_t> temporaries;
+};
+
+struct SubgraphPlan {
+  int32_t index = 0;
+  std::string name;
+  std::vector<PlanTensor> tensors;  // Indexed by tensor id.
+  std::vector<PlanNode> nodes;      // In execution order.
+};
+
+struct ExecutionPlan {
+  std::vector<SubgraphPlan> subgraphs;
+};
+
+// Fills first_use, last_use and used_by_steps of every tensor from the
+// node lists. Optional (-1) tensor ids are skipped.
+void ComputeTensorLifetimes(SubgraphPlan* subgraph);
+
+// JSON readable by log_execution_plan/tensor_data_parser.py. The top-level
+// "report_data", "execution_plan" and "tensor_usage" describe subgraph
+// `primary`; "subgraphs" holds the same data for every subgraph. Returns
+// false on I/O error.
+bool WriteExecutionPlanJson(const ExecutionPlan& plan, int primary,
+                            const std::string& path);
+
+// Compact binary form (see execution_plan.cc for the layout). Returns false
+// on I/O error or, when reading, on a malformed or foreign file.
+bool WriteExecutionPlanBinary(const ExecutionPlan& plan,
+                              const std::string& path);
+bool ReadExecutionPlanBinary(const std::string& path, ExecutionPlan* plan);
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_EXECUTION_PLAN_H_
@@ -0,0 +1,114 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/execution_plan_capture.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+TensorAllocation ToAllocation(TfLiteAllocationType type) {
+  switch (type) {
+    case kTfLiteMemNone:
+      return TensorAllocation::kNone;
+    case kTfLiteMmapRo:
+      return TensorAllocation::kMmap;
+    case kTfLiteArenaRw:
+      return TensorAllocation::kArenaRw;
+    case kTfLiteArenaRwPersistent:
+      return TensorAllocation::kArenaRwPersistent;
+    case kTfLiteDynamic:
+      return TensorAllocation::kDynamic;
+    case kTfLitePersistentRo:
+      return TensorAllocation::kPersistentRo;
+    case kTfLiteCustom:
+      return TensorAllocation::kCustom;
+    default:
+      return TensorAllocation::kOther;
+  }
+}
+
+std::vector<int32_t> ToVector(const TfLiteIntArray* array) {
+  if (array == nullptr) {
+    return {};
+  }
+  return std::vector<int32_t>(array->data, array->data + array->size);
+}
+
+std::string OpName(const TfLiteRegistration& registration) {
+  if (registration.builtin_code == kTfLiteBuiltinDelegate ||
+      registration.builtin_code == kTfLiteBuiltinCustom) {
+    return registration.custom_name != nullptr ? registration.custom_name
+                                               : "CUSTOM";
+  }
+  return tflite::EnumNameBuiltinOperator(
+      static_cast<tflite::BuiltinOperator>(registration.builtin_code));
+}
+
+}  // namespace
+
+ExecutionPlan CaptureExecutionPlan(tflite::Interpreter* interpreter) {
+  ExecutionPlan plan;
+  for (size_t s = 0; s < interpreter->subgraphs_size(); ++s) {
+    tflite::Subgraph* source = interpreter->subgraph(static_cast<int>(s));
+    SubgraphPlan& subgraph = plan.subgraphs.emplace_back();
+    subgraph.index = static_cast<int32_t>(s);
+    subgraph.name = source->GetName();
+
+    subgraph.tensors.resize(source->tensors_size());
+    for (size_t t = 0; t < source->tensors_size(); ++t) {
+      const TfLiteTensor* tensor = source->tensor(static_cast<int>(t));
+      PlanTensor& out = subgraph.tensors[t];
+      out.id = static_cast<int32_t>(t);
+      out.allocation = ToAllocation(tensor->allocation_type);
+      out.data_type = TfLiteTypeGetName(tensor->type);
+      out.shape = ToVector(tensor->dims);
+      out.bytes = tensor->bytes;
+      out.address = reinterpret_cast<uintptr_t>(tensor->data.raw);
+    }
+
+    const std::vector<int>& execution_plan = source->execution_plan();
+    for (size_t step = 0; step < execution_plan.size(); ++step) {
+      const auto* node_and_reg =
+          source->node_and_registration(execution_plan[step]);
+      if (node_and_reg == nullptr) {
+        continue;
+      }
+      const TfLiteNode& node = node_and_reg->first;
+      PlanNode& out = subgraph.nodes.emplace_back();
+      out.step = static_cast<int32_t>(subgraph.nodes.size() - 1);
+      out.node_index = execution_plan[step];
+      out.op = OpName(node_and_reg->second);
+      out.delegated = node.delegate != nullptr;
+      out.inputs = ToVector(node.inputs);
+      out.outputs = ToVector(node.outputs);
+      out.intermediates = ToVector(node.intermediates);
+      out.temporaries = ToVector(node.temporaries);
+    }
+    ComputeTensorLifetimes(&subgraph);
+  }
+  return plan;
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,31 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_EXECUTION_PLAN_CAPTURE_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_EXECUTION_PLAN_CAPTURE_H_
+
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace ai_edge_torch::examples {
+
+// Walks execution_plan() of every subgraph of `interpreter`. Call it after
+// delegates are applied and the signature runners have allocated their
+// tensors, so that delegate partitions and arena addresses are final.
+ExecutionPlan CaptureExecutionPlan(tflite::Interpreter* interpreter);
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_EXECUTION_PLAN_CAPTURE_H_
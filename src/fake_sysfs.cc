@@ -0,0 +1,97 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/fake_sysfs.h"
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+int g_failures = 0;
+
+int RemoveEntry(const char* path, const struct stat*, int, struct FTW*) {
+  return remove(path);
+}
+
+}  // namespace
+
+FakeSysfs::FakeSysfs() {
+  const char* tmpdir = std::getenv("TEST_TMPDIR");
+  std::string pattern =
+      std::string(tmpdir != nullptr ? tmpdir : "/tmp") + "/fake_sysfs.XXXXXX";
+  if (mkdtemp(pattern.data()) == nullptr) {
+    std::cerr << "Error: cannot create " << pattern << std::endl;
+    std::exit(1);
+  }
+  root_ = pattern;
+}
+
+FakeSysfs::~FakeSysfs() {
+  nftw(root_.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void FakeSysfs::MakeParents(const std::string& path) {
+  for (size_t slash = path.find('/'); slash != std::string::npos;
+       slash = path.find('/', slash + 1)) {
+    mkdir((root_ + "/" + path.substr(0, slash)).c_str(), 0755);
+  }
+}
+
+void FakeSysfs::Write(const std::string& path, const std::string& value) {
+  MakeParents(path);
+  std::ofstream file(root_ + "/" + path, std::ios::trunc);
+  file << value << "\n";
+}
+
+void FakeSysfs::Write(const std::string& path, long long value) {
+  Write(path, std::to_string(value));
+}
+
+std::string FakeSysfs::Read(const std::string& path) const {
+  return ReadSysfsValue(root_ + "/" + path);
+}
+
+void FakeSysfs::Symlink(const std::string& target, const std::string& path) {
+  MakeParents(path);
+  if (symlink(target.c_str(), (root_ + "/" + path).c_str()) != 0) {
+    std::cerr << "Error: cannot link " << path << std::endl;
+    std::exit(1);
+  }
+}
+
+bool Expect(bool condition, const char* expression, const char* file,
+            int line) {
+  if (!condition) {
+    ++g_failures;
+    std::cerr << file << ":" << line << ": expected " << expression
+              << std::endl;
+  }
+  return condition;
+}
+
+int ExpectationFailures() { return g_failures; }
+
+}  // namespace ai_edge_torch::examples
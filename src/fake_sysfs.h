@@ -0,0 +1,62 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_FAKE_SYSFS_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_FAKE_SYSFS_H_
+
+#include <string>
+
+namespace ai_edge_torch::examples {
+
+// A sysfs tree of regular files in a temporary directory, removed on
+// destruction. Pass root() as the `sysfs_root` of the class under test.
+class FakeSysfs {
+ public:
+  FakeSysfs();
+  ~FakeSysfs();
+
+  FakeSysfs(const FakeSysfs&) = delete;
+  FakeSysfs& operator=(const FakeSysfs&) = delete;
+
+  const std::string& root() const { return root_; }
+
+  // `path` is relative to the root; missing directories are created.
+  void Write(const std::string& path, const std::string& value);
+  void Write(const std::string& path, long long value);
+  // Contents without the trailing newline, or "" if missing.
+  std::string Read(const std::string& path) const;
+  // Creates `path` as a symlink to `target`, as sysfs does for cpufreq
+  // policies.
+  void Symlink(const std::string& target, const std::string& path);
+
+ private:
+  void MakeParents(const std::string& path);
+
+  std::string root_;
+};
+
+// Reports a failed expectation on stderr and counts it; main() returns
+// ExpectationFailures() != 0.
+bool Expect(bool condition, const char* expression, const char* file,
+            int line);
+int ExpectationFailures();
+
+#define SYSFS_EXPECT(condition)                                      \
+  ::ai_edge_torch::examples::Expect((condition), #condition, __FILE__, \
+                                    __LINE__)
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_FAKE_SYSFS_H_
@@ -0,0 +1,427 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/hw_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+struct EventSpec {
+  HardwareCounters::Event event;
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr uint64_t CacheConfig(uint64_t cache, uint64_t op, uint64_t result) {
+  return cache | (op << 8) | (result << 16);
+}
+
+// Arm architectural event BUS_ACCESS; no generic perf equivalent.
+constexpr uint64_t kArmBusAccess = 0x19;
+
+int OpenCounter(uint32_t type, uint64_t config, int group_fd, bool inherit,
+                bool exclude_kernel) {
+  struct perf_event_attr pe;
+  std::memset(&pe, 0, sizeof(pe));
+  pe.type = type;
+  pe.size = sizeof(pe);
+  pe.config = config;
+  pe.disabled = group_fd == -1 ? 1 : 0;
+  pe.inherit = inherit ? 1 : 0;
+  pe.exclude_kernel = exclude_kernel ? 1 : 0;
+  pe.exclude_hv = 1;
+  pe.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                   PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, &pe, /*pid=*/0, /*cpu=*/-1, group_fd, 0));
+}
+
+// Line size of the outermost cache level sysfs lists for cpu0.
+size_t ReadCacheLineSize() {
+  size_t line_size = 64;
+  for (int index = 0; index < 8; ++index) {
+    std::string contents;
+    if (!ReadFileToString("/sys/devices/system/cpu/cpu0/cache/index" +
+                              std::to_string(index) + "/coherency_line_size",
+                          &contents)) {
+      break;
+    }
+    int64_t value = ParseInt(contents);
+    if (value > 0) {
+      line_size = static_cast<size_t>(value);
+    }
+  }
+  return line_size;
+}
+
+}  // namespace
+
+const char* HardwareCounters::EventName(Event event) {
+  switch (event) {
+    case kCycles:
+      return "cycles";
+    case kInstructions:
+      return "instructions";
+    case kStalledCyclesBackend:
+      return "stalled_cycles_backend";
+    case kLlcLoads:
+      return "llc_loads";
+    case kLlcMisses:
+      return "llc_misses";
+    case kL1dMisses:
+      return "l1d_misses";
+    case kDtlbMisses:
+      return "dtlb_misses";
+    case kBusAccesses:
+      return "bus_accesses";
+    default:
+      return "unknown";
+  }
+}
+
+HardwareCounters::HardwareCounters() {
+  std::fill(std::begin(group_of_), std::end(group_of_), -1);
+  cache_line_size_ = ReadCacheLineSize();
+
+  // Inherited group reads need a 4.13+ kernel, and perf_event_paranoid >= 2
+  // only allows user-space counting; settle both with one probe.
+  bool inherit = false;
+  bool exclude_kernel = false;
+  bool opened = false;
+  for (bool try_inherit : {true, false}) {
+    for (bool try_exclude_kernel : {false, true}) {
+      int fd = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1,
+                           try_inherit, try_exclude_kernel);
+      if (fd != -1) {
+        close(fd);
+        inherit = try_inherit;
+        exclude_kernel = try_exclude_kernel;
+        opened = true;
+        break;
+      }
+    }
+    if (opened) {
+      break;
+    }
+  }
+  if (!opened) {
+    std::cerr << "Warning: hardware perf events unavailable ("
+              << std::strerror(errno) << "); hardware counters disabled."
+              << std::endl;
+    return;
+  }
+  inherited_ = inherit;
+
+  const std::vector<std::vector<EventSpec>> layout = {
+      {
+          {kCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+          {kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+          {kStalledCyclesBackend, PERF_TYPE_HARDWARE,
+           PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+      },
+      {
+          {kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+          {kLlcLoads, PERF_TYPE_HW_CACHE,
+           CacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                       PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+          {kLlcMisses, PERF_TYPE_HW_CACHE,
+           CacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+          {kL1dMisses, PERF_TYPE_HW_CACHE,
+           CacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+      },
+      {
+          {kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+          {kDtlbMisses, PERF_TYPE_HW_CACHE,
+           CacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                       PERF_COUNT_HW_CACHE_RESULT_MISS)},
+#if defined(__aarch64__) || defined(__arm__)
+          {kBusAccesses, PERF_TYPE_RAW, kArmBusAccess},
+#endif
+      },
+  };
+
+  for (const std::vector<EventSpec>& specs : layout) {
+    Group group;
+    std::fill(std::begin(group.slot), std::end(group.slot), -1);
+    for (const EventSpec& spec : specs) {
+      // A member the PMU cannot schedule alongside the rest of the group
+      // fails here rather than leaving the whole group idle.
+      int fd = OpenCounter(spec.type, spec.config, group.leader_fd, inherit,
+                           exclude_kernel);
+      if (fd == -1) {
+        continue;
+      }
+      if (group.leader_fd == -1) {
+        group.leader_fd = fd;
+      } else {
+        group.member_fds.push_back(fd);
+      }
+      group.slot[spec.event] = group.num_events++;
+    }
+    if (group.leader_fd == -1) {
+      continue;
+    }
+    const int index = static_cast<int>(groups_.size());
+    for (int event = 0; event < kNumEvents; ++event) {
+      if (group.slot[event] >= 0 && group_of_[event] < 0) {
+        group_of_[event] = index;
+      }
+    }
+    ioctl(group.leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group.leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    groups_.push_back(std::move(group));
+  }
+}
+
+HardwareCounters::~HardwareCounters() {
+  for (Group& group : groups_) {
+    for (int fd : group.member_fds) {
+      close(fd);
+    }
+    close(group.leader_fd);
+  }
+}
+
+void HardwareCounters::Read(Snapshot* snapshot) const {
+  snapshot->groups.resize(groups_.size());
+  // PERF_FORMAT_GROUP layout: { nr, time_enabled, time_running, value[nr] }.
+  uint64_t buffer[3 + kNumEvents];
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    const Group& group = groups_[g];
+    Snapshot::Group& out = snapshot->groups[g];
+    out.values.resize(group.num_events);
+    ssize_t bytes = read(group.leader_fd, buffer, sizeof(buffer));
+    out.valid = bytes >= static_cast<ssize_t>(3 * sizeof(uint64_t));
+    if (!out.valid) {
+      continue;
+    }
+    out.time_enabled = buffer[1];
+    out.time_running = buffer[2];
+    const uint64_t nr = std::min<uint64_t>(buffer[0], group.num_events);
+    for (uint64_t i = 0; i < nr; ++i) {
+      out.values[i] = buffer[3 + i];
+    }
+  }
+}
+
+HardwareCounters::Snapshot HardwareCounters::Read() const {
+  Snapshot snapshot;
+  Read(&snapshot);
+  return snapshot;
+}
+
+double HardwareCounters::Delta(const Snapshot& start, const Snapshot& end,
+                               Event event) const {
+  const int g = group_of_[event];
+  if (g < 0 || static_cast<size_t>(g) >= start.groups.size() ||
+      static_cast<size_t>(g) >= end.groups.size()) {
+    return -1;
+  }
+  const Snapshot::Group& a = start.groups[g];
+  const Snapshot::Group& b = end.groups[g];
+  if (!a.valid || !b.valid) {
+    return -1;
+  }
+  const int slot = groups_[g].slot[event];
+  const uint64_t running = b.time_running - a.time_running;
+  if (running == 0) {
+    return -1;  // The group never got a counter during the interval.
+  }
+  const double enabled = static_cast<double>(b.time_enabled - a.time_enabled);
+  return static_cast<double>(b.values[slot] - a.values[slot]) * enabled /
+         running;
+}
+
+double HardwareCounters::Ratio(const Snapshot& start, const Snapshot& end,
+                               Event numerator, Event denominator) const {
+  const int g = group_of_[numerator];
+  if (g < 0 || static_cast<size_t>(g) >= start.groups.size() ||
+      static_cast<size_t>(g) >= end.groups.size()) {
+    return -1;
+  }
+  const int num_slot = groups_[g].slot[numerator];
+  const int den_slot = groups_[g].slot[denominator];
+  if (den_slot < 0) {
+    // Not co-scheduled; fall back to the scaled counts.
+    const double num = Delta(start, end, numerator);
+    const double den = Delta(start, end, denominator);
+    return num >= 0 && den > 0 ? num / den : -1;
+  }
+  const Snapshot::Group& a = start.groups[g];
+  const Snapshot::Group& b = end.groups[g];
+  if (!a.valid || !b.valid) {
+    return -1;
+  }
+  const uint64_t den = b.values[den_slot] - a.values[den_slot];
+  if (den == 0) {
+    return -1;
+  }
+  return static_cast<double>(b.values[num_slot] - a.values[num_slot]) / den;
+}
+
+HardwareCounters::Stats HardwareCounters::Diff(const Snapshot& start,
+                                               const Snapshot& end,
+                                               double wall_ms) const {
+  Stats stats;
+  stats.wall_ms = wall_ms;
+  if (groups_.empty()) {
+    return stats;
+  }
+  stats.coverage = 1.0;
+  for (size_t g = 0; g < groups_.size() && g < start.groups.size() &&
+                     g < end.groups.size();
+       ++g) {
+    if (!start.groups[g].valid || !end.groups[g].valid) {
+      continue;
+    }
+    const uint64_t enabled =
+        end.groups[g].time_enabled - start.groups[g].time_enabled;
+    const uint64_t running =
+        end.groups[g].time_running - start.groups[g].time_running;
+    if (enabled > 0) {
+      stats.coverage =
+          std::min(stats.coverage, static_cast<double>(running) / enabled);
+    }
+  }
+  for (int event = 0; event < kNumEvents; ++event) {
+    stats.counts[event] = Delta(start, end, static_cast<Event>(event));
+    if (stats.counts[event] >= 0) {
+      stats.valid = true;
+    }
+  }
+
+  auto per_kilo_instruction = [&](Event event) {
+    const double ratio = Ratio(start, end, event, kInstructions);
+    return ratio >= 0 ? 1000.0 * ratio : -1.0;
+  };
+  stats.ipc = Ratio(start, end, kInstructions, kCycles);
+  stats.backend_stall_fraction =
+      Ratio(start, end, kStalledCyclesBackend, kCycles);
+  stats.llc_mpki = per_kilo_instruction(kLlcMisses);
+  stats.llc_miss_ratio = Ratio(start, end, kLlcMisses, kLlcLoads);
+  stats.l1d_mpki = per_kilo_instruction(kL1dMisses);
+  stats.dtlb_mpki = per_kilo_instruction(kDtlbMisses);
+  stats.bus_accesses_pki = per_kilo_instruction(kBusAccesses);
+
+  // Arm bus accesses are line-sized refills and write-backs beyond the
+  // core's own caches, the closest per-process proxy when LLC events are
+  // not exposed.
+  const double refills = stats.counts[kLlcMisses] >= 0
+                              ? stats.counts[kLlcMisses]
+                              : stats.counts[kBusAccesses];
+  if (refills >= 0) {
+    stats.memory_bytes = refills * cache_line_size_;
+    if (wall_ms > 0) {
+      stats.achieved_gbps = stats.memory_bytes / (wall_ms * 1e6);
+    }
+  }
+  return stats;
+}
+
+double MeasurePeakReadBandwidth(int num_threads, size_t bytes_per_thread,
+                                int repetitions) {
+  num_threads = std::max(1, num_threads);
+  const size_t words = std::max<size_t>(1, bytes_per_thread / sizeof(uint64_t));
+  std::vector<std::vector<uint64_t>> buffers(num_threads);
+  std::atomic<uint64_t> sink{0};
+
+  auto run_threads = [&](auto&& body) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back(body, t);
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  };
+
+  // Each thread touches its own buffer first so the pages land on its node.
+  run_threads([&](int t) {
+    buffers[t].resize(words);
+    for (size_t i = 0; i < words; ++i) {
+      buffers[t][i] = i;
+    }
+  });
+
+  double best_gbps = 0;
+  for (int rep = 0; rep < repetitions; ++rep) {
+    auto start = std::chrono::steady_clock::now();
+    run_threads([&](int t) {
+      const uint64_t* data = buffers[t].data();
+      // Independent accumulators keep the loop load-bound, not add-bound.
+      uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+      size_t i = 0;
+      for (; i + 4 <= words; i += 4) {
+        s0 += data[i];
+        s1 += data[i + 1];
+        s2 += data[i + 2];
+        s3 += data[i + 3];
+      }
+      for (; i < words; ++i) {
+        s0 += data[i];
+      }
+      sink += s0 + s1 + s2 + s3;
+    });
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    if (seconds > 0) {
+      best_gbps = std::max(best_gbps, static_cast<double>(num_threads) *
+                                          words * sizeof(uint64_t) / seconds /
+                                          1e9);
+    }
+  }
+  return best_gbps;
+}
+
+const char* ClassifyBound(const HardwareCounters::Stats& stats,
+                          double peak_gbps, double bound_fraction) {
+  if (!stats.valid) {
+    return "unknown";
+  }
+  if (stats.achieved_gbps >= 0 && peak_gbps > 0 &&
+      stats.achieved_gbps >= bound_fraction * peak_gbps) {
+    return "bandwidth-bound";
+  }
+  if (stats.backend_stall_fraction >= 0.5) {
+    return "memory-latency-bound";
+  }
+  if (stats.ipc >= 0 || stats.achieved_gbps >= 0) {
+    return "compute-bound";
+  }
+  return "unknown";
+}
+
+}  // namespace ai_edge_torch::examples
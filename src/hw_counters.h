@@ -0,0 +1,148 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_HW_COUNTERS_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_HW_COUNTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// Grouped hardware counters for the whole process, read atomically at phase
+// boundaries.
+//
+// Events whose ratio is reported share a perf_event group, so the PMU
+// schedules them together and each group carries its own denominator:
+//
+//   core:   cycles, instructions, backend-stall cycles
+//   cache:  instructions, LLC loads, LLC misses, L1D read misses
+//   memory: instructions, dTLB read misses, bus accesses (Arm PMUs only)
+//
+// Groups are small enough to fit the four to six programmable counters of
+// common cores; when they still do not fit, the kernel multiplexes whole
+// groups and counts are scaled by time_enabled / time_running. Events the
+// PMU does not expose are left out of their group. Like Instrumentation,
+// construct this before the delegate creates its threads so the groups are
+// inherited by them.
+class HardwareCounters {
+ public:
+  enum Event {
+    kCycles = 0,
+    kInstructions,
+    kStalledCyclesBackend,
+    kLlcLoads,
+    kLlcMisses,
+    kL1dMisses,
+    kDtlbMisses,
+    kBusAccesses,
+    kNumEvents,
+  };
+
+  static const char* EventName(Event event);
+
+  // Raw group reads; only meaningful to Diff() on the same object.
+  struct Snapshot {
+    struct Group {
+      bool valid = false;  // False if the read failed; Diff() skips it.
+      uint64_t time_enabled = 0;
+      uint64_t time_running = 0;
+      std::vector<uint64_t> values;
+    };
+    std::vector<Group> groups;
+  };
+
+  struct Stats {
+    bool valid = false;
+    double wall_ms = 0;
+    // Multiplex-scaled counts; -1 if the event is unavailable.
+    double counts[kNumEvents] = {-1, -1, -1, -1, -1, -1, -1, -1};
+    // Lowest time_running / time_enabled over the groups (1 = no
+    // multiplexing).
+    double coverage = 0;
+
+    // Derived from events of the same group; -1 if unavailable.
+    double ipc = -1;
+    double backend_stall_fraction = -1;  // Of cycles.
+    double llc_mpki = -1;                // Misses per 1000 instructions.
+    double llc_miss_ratio = -1;          // Of LLC loads.
+    double l1d_mpki = -1;
+    double dtlb_mpki = -1;
+    double bus_accesses_pki = -1;
+
+    // LLC misses (or bus accesses if the LLC events are missing) times the
+    // cache line size, over wall time. Counts both demand and prefetch
+    // refills, so it approximates DRAM read traffic of this process.
+    double memory_bytes = -1;
+    double achieved_gbps = -1;
+  };
+
+  HardwareCounters();
+  ~HardwareCounters();
+
+  HardwareCounters(const HardwareCounters&) = delete;
+  HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+  bool available() const { return !groups_.empty(); }
+  bool has_event(Event event) const { return group_of_[event] >= 0; }
+  bool inherited() const { return inherited_; }
+  size_t cache_line_size() const { return cache_line_size_; }
+
+  // One read() per group; no allocation after the first call with a given
+  // snapshot.
+  void Read(Snapshot* snapshot) const;
+  Snapshot Read() const;
+
+  Stats Diff(const Snapshot& start, const Snapshot& end, double wall_ms) const;
+
+ private:
+  struct Group {
+    int leader_fd = -1;
+    std::vector<int> member_fds;
+    int num_events = 0;
+    int slot[kNumEvents];  // Position in the group read, or -1.
+  };
+
+  // Counts of `numerator` per `denominator`, from their common group so
+  // multiplexing cancels out; -1 if either is missing.
+  double Ratio(const Snapshot& start, const Snapshot& end, Event numerator,
+               Event denominator) const;
+  double Delta(const Snapshot& start, const Snapshot& end, Event event) const;
+
+  std::vector<Group> groups_;
+  // First group holding each event, or -1; instructions appear in several.
+  int group_of_[kNumEvents];
+  bool inherited_ = false;
+  size_t cache_line_size_ = 64;
+};
+
+// Sustained read bandwidth of this machine in GB/s: `num_threads` threads
+// each stream over their own `bytes_per_thread` buffer (first-touched by the
+// thread), best of `repetitions`. Takes a few hundred milliseconds.
+double MeasurePeakReadBandwidth(int num_threads,
+                                size_t bytes_per_thread = 64 << 20,
+                                int repetitions = 5);
+
+// "bandwidth-bound" when achieved bandwidth is at least `bound_fraction` of
+// `peak_gbps`, "memory-latency-bound" when the backend stalls most cycles
+// without saturating bandwidth, else "compute-bound"; "unknown" without the
+// needed counters.
+const char* ClassifyBound(const HardwareCounters::Stats& stats,
+                          double peak_gbps, double bound_fraction = 0.6);
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_HW_COUNTERS_H_
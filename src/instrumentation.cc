@@ -0,0 +1,241 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/instrumentation.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+int OpenCounter(uint32_t type, uint64_t config, int group_fd, bool inherit) {
+  struct perf_event_attr pe;
+  std::memset(&pe, 0, sizeof(pe));
+  pe.type = type;
+  pe.size = sizeof(pe);
+  pe.config = config;
+  pe.disabled = group_fd == -1 ? 1 : 0;
+  pe.inherit = inherit ? 1 : 0;
+  pe.exclude_hv = 1;
+  pe.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, &pe, /*pid=*/0, /*cpu=*/-1, group_fd, 0));
+}
+
+}  // namespace
+
+Instrumentation::Instrumentation(size_t capacity)
+    : ring_(capacity > 0 ? capacity : 1) {
+  // Inherited group reads need a 4.13+ kernel; older ones reject the
+  // combination, in which case only the calling thread is counted.
+  for (bool inherit : {true, false}) {
+    group_fd_ = OpenCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, -1,
+                            inherit);
+    if (group_fd_ != -1) {
+      inherited_ = inherit;
+      break;
+    }
+  }
+  if (group_fd_ == -1) {
+    std::cerr << "Warning: perf_event_open failed (" << std::strerror(errno)
+              << "); per-step counters disabled." << std::endl;
+    return;
+  }
+  slot_[kTaskClockNs] = num_members_++;
+
+  struct Member {
+    Counter counter;
+    uint32_t type;
+    uint64_t config;
+  };
+  const Member members[] = {
+      {kContextSwitches, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+      {kMajorFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ},
+      {kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  };
+  for (const Member& member : members) {
+    int fd = OpenCounter(member.type, member.config, group_fd_, inherited_);
+    if (fd == -1) {
+      continue;
+    }
+    member_fds_.push_back(fd);
+    slot_[member.counter] = num_members_++;
+  }
+
+  ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+Instrumentation::~Instrumentation() {
+  for (int fd : member_fds_) {
+    close(fd);
+  }
+  if (group_fd_ != -1) {
+    close(group_fd_);
+  }
+}
+
+int Instrumentation::RegisterPhase(const std::string& name) {
+  phase_names_.push_back(name);
+  return static_cast<int>(phase_names_.size()) - 1;
+}
+
+void Instrumentation::ReadGroup(uint64_t* values) const {
+  if (group_fd_ == -1) {
+    return;
+  }
+  // PERF_FORMAT_GROUP layout: { nr, value[nr] }.
+  uint64_t buffer[1 + kNumCounters];
+  ssize_t bytes = read(group_fd_, buffer, sizeof(buffer));
+  if (bytes < static_cast<ssize_t>(sizeof(uint64_t))) {
+    return;
+  }
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    if (slot_[counter] >= 0 &&
+        static_cast<uint64_t>(slot_[counter]) < buffer[0]) {
+      values[counter] = buffer[1 + slot_[counter]];
+    }
+  }
+}
+
+void Instrumentation::Begin(int phase, uint32_t index) {
+  const uint64_t t0 = NowNs();
+  open_.phase = phase;
+  open_.index = index;
+  ReadGroup(open_.counters);
+  is_open_ = true;
+  open_.start_ns = NowNs();
+  overhead_ns_ += open_.start_ns - t0;
+}
+
+void Instrumentation::End() {
+  const uint64_t t0 = NowNs();
+  if (!is_open_) {
+    return;
+  }
+  uint64_t values[kNumCounters] = {};
+  ReadGroup(values);
+
+  Sample& sample = ring_[num_recorded_ % ring_.size()];
+  sample.phase = open_.phase;
+  sample.index = open_.index;
+  sample.start_ns = open_.start_ns;
+  sample.wall_ns = t0 - open_.start_ns;
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    sample.counters[counter] = values[counter] - open_.counters[counter];
+  }
+  ++num_recorded_;
+  measured_ns_ += sample.wall_ns;
+  is_open_ = false;
+  overhead_ns_ += NowNs() - t0;
+}
+
+size_t Instrumentation::size() const {
+  return num_recorded_ < ring_.size() ? num_recorded_ : ring_.size();
+}
+
+const Instrumentation::Sample& Instrumentation::sample(size_t i) const {
+  const uint64_t first = num_recorded_ - size();
+  return ring_[(first + i) % ring_.size()];
+}
+
+uint64_t Instrumentation::dropped() const { return num_recorded_ - size(); }
+
+double Instrumentation::overhead_fraction() const {
+  return measured_ns_ > 0 ? static_cast<double>(overhead_ns_) / measured_ns_
+                          : 0.0;
+}
+
+void Instrumentation::PrintSummary(std::ostream& out) const {
+  struct Totals {
+    uint64_t count = 0;
+    uint64_t wall_ns = 0;
+    uint64_t counters[kNumCounters] = {};
+  };
+  std::vector<Totals> totals(phase_names_.size());
+  for (size_t i = 0; i < size(); ++i) {
+    const Sample& s = sample(i);
+    if (s.phase < 0 || s.phase >= static_cast<int>(totals.size())) {
+      continue;
+    }
+    Totals& t = totals[s.phase];
+    ++t.count;
+    t.wall_ns += s.wall_ns;
+    for (int counter = 0; counter < kNumCounters; ++counter) {
+      t.counters[counter] += s.counters[counter];
+    }
+  }
+
+  for (size_t phase = 0; phase < totals.size(); ++phase) {
+    const Totals& t = totals[phase];
+    if (t.count == 0) {
+      continue;
+    }
+    const double n = static_cast<double>(t.count);
+    out << "\n=== Per-Step Counters for Phase: " << phase_names_[phase]
+        << " ===\n";
+    out << "Number of measurements: " << t.count << "\n";
+    out << "Average wall clock time: " << t.wall_ns / n / 1e6 << " ms\n";
+    if (has_counter(kTaskClockNs)) {
+      out << "Average CPU time (all threads): "
+          << t.counters[kTaskClockNs] / n / 1e6 << " ms\n";
+      if (t.wall_ns > 0) {
+        out << "CPU utilization: "
+            << 100.0 * t.counters[kTaskClockNs] / t.wall_ns << "%\n";
+      }
+    }
+    if (has_counter(kContextSwitches)) {
+      out << "Average context switches: " << t.counters[kContextSwitches] / n
+          << "\n";
+    }
+    if (has_counter(kMajorFaults)) {
+      out << "Average major faults: " << t.counters[kMajorFaults] / n << "\n";
+    }
+    if (has_counter(kInstructions)) {
+      out << "Average instructions: " << t.counters[kInstructions] / n << "\n";
+    }
+  }
+
+  out << "\n[METRICS] Instrumentation Overhead         : "
+      << 100.0 * overhead_fraction() << " % of measured time"
+      << (inherited_ ? "" : " (counters cover the main thread only)") << "\n";
+  if (dropped() > 0) {
+    out << "[METRICS] Instrumentation Samples Dropped  : " << dropped() << "\n";
+  }
+  if (overhead_fraction() > 0.01) {
+    std::cerr << "Warning: instrumentation overhead above 1% of step time."
+              << std::endl;
+  }
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,107 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_INSTRUMENTATION_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_INSTRUMENTATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// Low-overhead counters for short, frequent phases such as one decode step.
+//
+// A single perf_event group is opened at construction for the whole process
+// (pid 0, any CPU, inherited by threads created afterwards, so construct it
+// before the delegate spins up its thread pool). Each phase boundary costs
+// one read() of the group plus a vDSO clock read; nothing is allocated and
+// no string is built on the hot path. Samples go into a preallocated ring
+// keyed by integer phase ids registered up front.
+class Instrumentation {
+ public:
+  enum Counter {
+    kTaskClockNs = 0,   // CPU time of all threads.
+    kContextSwitches,
+    kMajorFaults,
+    kInstructions,      // Hardware counter; missing on many VMs.
+    kNumCounters,
+  };
+
+  struct Sample {
+    int phase = -1;
+    uint32_t index = 0;
+    uint64_t start_ns = 0;  // CLOCK_MONOTONIC.
+    uint64_t wall_ns = 0;
+    uint64_t counters[kNumCounters] = {};
+  };
+
+  // `capacity` samples are kept; older ones are overwritten.
+  explicit Instrumentation(size_t capacity = 8192);
+  ~Instrumentation();
+
+  Instrumentation(const Instrumentation&) = delete;
+  Instrumentation& operator=(const Instrumentation&) = delete;
+
+  // Call during setup, not per step.
+  int RegisterPhase(const std::string& name);
+  const std::string& phase_name(int phase) const { return phase_names_[phase]; }
+
+  // Starts `phase` for item `index` (token, round, ...). A phase that was
+  // begun but never ended is discarded.
+  void Begin(int phase, uint32_t index);
+  // Closes the current phase and records its sample.
+  void End();
+
+  bool has_counter(Counter counter) const { return slot_[counter] >= 0; }
+  bool inherited() const { return inherited_; }
+
+  // Samples in chronological order; `i` < size().
+  size_t size() const;
+  const Sample& sample(size_t i) const;
+  // Samples lost to ring wrap-around.
+  uint64_t dropped() const;
+
+  // Time spent inside Begin()/End() as a fraction of the measured wall time.
+  double overhead_fraction() const;
+
+  // Per-phase averages plus the instrumentation overhead.
+  void PrintSummary(std::ostream& out) const;
+
+ private:
+  // Reads the whole group with one read() into `values`, indexed by Counter.
+  void ReadGroup(uint64_t* values) const;
+
+  int group_fd_ = -1;
+  std::vector<int> member_fds_;
+  int slot_[kNumCounters] = {-1, -1, -1, -1};
+  int num_members_ = 0;
+  bool inherited_ = false;
+
+  std::vector<std::string> phase_names_;
+  std::vector<Sample> ring_;
+  uint64_t num_recorded_ = 0;
+
+  Sample open_;
+  bool is_open_ = false;
+  uint64_t overhead_ns_ = 0;
+  uint64_t measured_ns_ = 0;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_INSTRUMENTATION_H_
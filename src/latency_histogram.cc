@@ -0,0 +1,149 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+
+namespace ai_edge_torch::examples {
+
+LatencyHistogram::LatencyHistogram(int num_slowest)
+    : buckets_(kSubBuckets +
+               (kMaxExponent - kSubBucketBits + 1) * kSubBuckets),
+      num_slowest_(num_slowest) {}
+
+int LatencyHistogram::BucketIndex(uint64_t value_us) {
+  if (value_us < static_cast<uint64_t>(kSubBuckets)) {
+    return static_cast<int>(value_us);
+  }
+  const uint64_t max_value = (uint64_t{1} << (kMaxExponent + 1)) - 1;
+  value_us = std::min(value_us, max_value);
+  int exponent = 63 - __builtin_clzll(value_us);
+  int shift = exponent - kSubBucketBits;
+  int sub = static_cast<int>(value_us >> shift) - kSubBuckets;
+  return kSubBuckets + shift * kSubBuckets + sub;
+}
+
+double LatencyHistogram::BucketMidpointUs(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int shift = (index - kSubBuckets) / kSubBuckets;
+  int sub = (index - kSubBuckets) % kSubBuckets;
+  double low = static_cast<double>(uint64_t(kSubBuckets + sub) << shift);
+  double width = static_cast<double>(uint64_t{1} << shift);
+  return low + (width - 1) / 2.0;
+}
+
+void LatencyHistogram::Record(double value_ms) {
+  value_ms = std::max(0.0, value_ms);
+  ++buckets_[BucketIndex(static_cast<uint64_t>(std::llround(value_ms * 1000)))];
+
+  if (count_ == 0) {
+    min_ms_ = max_ms_ = value_ms;
+  } else {
+    min_ms_ = std::min(min_ms_, value_ms);
+    max_ms_ = std::max(max_ms_, value_ms);
+    sum_abs_delta_ms_ += std::fabs(value_ms - last_ms_);
+  }
+  last_ms_ = value_ms;
+  sum_ms_ += value_ms;
+  sum_sq_ms_ += value_ms * value_ms;
+
+  using Entry = std::pair<double, uint64_t>;
+  if (static_cast<int>(slowest_.size()) < num_slowest_) {
+    slowest_.emplace_back(value_ms, count_);
+    std::push_heap(slowest_.begin(), slowest_.end(), std::greater<Entry>());
+  } else if (num_slowest_ > 0 && value_ms > slowest_.front().first) {
+    std::pop_heap(slowest_.begin(), slowest_.end(), std::greater<Entry>());
+    slowest_.back() = {value_ms, count_};
+    std::push_heap(slowest_.begin(), slowest_.end(), std::greater<Entry>());
+  }
+  ++count_;
+}
+
+double LatencyHistogram::stddev_ms() const {
+  if (count_ < 2) {
+    return 0.0;
+  }
+  double mean = sum_ms_ / count_;
+  return std::sqrt(std::max(0.0, sum_sq_ms_ / count_ - mean * mean));
+}
+
+double LatencyHistogram::jitter_ms() const {
+  return count_ > 1 ? sum_abs_delta_ms_ / (count_ - 1) : 0.0;
+}
+
+double LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0.0;
+  }
+  percentile = std::clamp(percentile, 0.0, 100.0);
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * count_));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      double value_ms = BucketMidpointUs(static_cast<int>(i)) / 1000.0;
+      return std::clamp(value_ms, min_ms_, max_ms_);
+    }
+  }
+  return max_ms_;
+}
+
+std::vector<std::pair<uint64_t, double>> LatencyHistogram::Slowest() const {
+  std::vector<std::pair<double, uint64_t>> sorted = slowest_;
+  std::sort(sorted.begin(), sorted.end(),
+            std::greater<std::pair<double, uint64_t>>());
+  std::vector<std::pair<uint64_t, double>> result;
+  for (const auto& [value_ms, index] : sorted) {
+    result.emplace_back(index, value_ms);
+  }
+  return result;
+}
+
+void LatencyHistogram::WriteJson(JsonWriter* json) const {
+  json->BeginObject();
+  json->Field("count", count_);
+  json->Field("min_ms", min_ms());
+  json->Field("mean_ms", mean_ms());
+  json->Field("stddev_ms", stddev_ms());
+  json->Field("p50_ms", Percentile(50));
+  json->Field("p90_ms", Percentile(90));
+  json->Field("p99_ms", Percentile(99));
+  json->Field("p999_ms", Percentile(99.9));
+  json->Field("max_ms", max_ms());
+  json->Field("jitter_ms", jitter_ms());
+  json->Key("slowest");
+  json->BeginArray();
+  for (const auto& [index, value_ms] : Slowest()) {
+    json->BeginObject();
+    json->Field("index", index);
+    json->Field("ms", value_ms);
+    json->EndObject();
+  }
+  json->EndArray();
+  json->EndObject();
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,80 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_LATENCY_HISTOGRAM_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_LATENCY_HISTOGRAM_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+
+namespace ai_edge_torch::examples {
+
+// Log-linear latency histogram in the style of HdrHistogram.
+//
+// Values are recorded in microseconds. Each power-of-two range is split into
+// kSubBuckets linear buckets, so any percentile is within 1/kSubBuckets
+// (about 3%) of the true value at a fixed memory cost, however many samples
+// are recorded. Min, max, mean and standard deviation are exact.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // Covers 1 us .. 2^38 us (~76 hours).
+  static constexpr int kMaxExponent = 38;
+
+  // Keeps the `num_slowest` largest samples with their sample index.
+  explicit LatencyHistogram(int num_slowest = 5);
+
+  void Record(double value_ms);
+
+  uint64_t count() const { return count_; }
+  double min_ms() const { return count_ > 0 ? min_ms_ : 0.0; }
+  double max_ms() const { return count_ > 0 ? max_ms_ : 0.0; }
+  double mean_ms() const { return count_ > 0 ? sum_ms_ / count_ : 0.0; }
+  double stddev_ms() const;
+  // Mean absolute difference between consecutive samples.
+  double jitter_ms() const;
+  // Value at `percentile` in [0, 100], in ms.
+  double Percentile(double percentile) const;
+  // (sample index, value in ms), slowest first.
+  std::vector<std::pair<uint64_t, double>> Slowest() const;
+
+  // Writes count, min/mean/max, p50/p90/p99/p999, jitter and the slowest
+  // samples as one JSON object.
+  void WriteJson(JsonWriter* json) const;
+
+ private:
+  static int BucketIndex(uint64_t value_us);
+  static double BucketMidpointUs(int index);
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_ = 0;
+  double sum_ms_ = 0.0;
+  double sum_sq_ms_ = 0.0;
+  double min_ms_ = 0.0;
+  double max_ms_ = 0.0;
+  double last_ms_ = 0.0;
+  double sum_abs_delta_ms_ = 0.0;
+  const int num_slowest_;
+  // Min-heap on value holding the slowest samples.
+  std::vector<std::pair<double, uint64_t>> slowest_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_LATENCY_HISTOGRAM_H_
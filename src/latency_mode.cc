@@ -0,0 +1,282 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/latency_mode.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// struct sched_attr from linux/sched/types.h, which glibc does not export.
+struct SchedAttr {
+  uint32_t size;
+  uint32_t sched_policy;
+  uint64_t sched_flags;
+  int32_t sched_nice;
+  uint32_t sched_priority;
+  uint64_t sched_runtime;
+  uint64_t sched_deadline;
+  uint64_t sched_period;
+  uint32_t sched_util_min;
+  uint32_t sched_util_max;
+};
+
+constexpr uint64_t kSchedFlagKeepPolicy = 0x08;
+constexpr uint64_t kSchedFlagKeepParams = 0x10;
+constexpr uint64_t kSchedFlagUtilClampMin = 0x20;
+
+int GetSchedAttr(pid_t tid, SchedAttr* attr) {
+#ifdef SYS_sched_getattr
+  std::memset(attr, 0, sizeof(*attr));
+  return static_cast<int>(
+      syscall(SYS_sched_getattr, tid, attr, sizeof(*attr), 0));
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int SetUtilClampMin(pid_t tid, uint32_t util_min) {
+#ifdef SYS_sched_setattr
+  SchedAttr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.sched_flags =
+      kSchedFlagKeepPolicy | kSchedFlagKeepParams | kSchedFlagUtilClampMin;
+  attr.sched_util_min = util_min;
+  return static_cast<int>(syscall(SYS_sched_setattr, tid, &attr, 0));
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+}  // namespace
+
+bool ParseLatencyModes(std::string_view modes, LatencyOptions* options,
+                       std::string* error) {
+  while (!modes.empty()) {
+    size_t comma = modes.find(',');
+    std::string_view mode = modes.substr(0, comma);
+    modes = comma == std::string_view::npos ? std::string_view()
+                                            : modes.substr(comma + 1);
+    if (mode == "fifo") {
+      options->policy = LatencyOptions::Policy::kFifo;
+    } else if (mode == "rr") {
+      options->policy = LatencyOptions::Policy::kRoundRobin;
+    } else if (mode == "nice") {
+      options->set_nice = true;
+    } else if (mode == "uclamp") {
+      options->set_uclamp_min = true;
+    } else if (mode == "freq") {
+      if (options->min_freq_khz == 0) {
+        options->min_freq_khz = -1;
+      }
+    } else if (mode == "dma") {
+      options->hold_dma_latency = true;
+    } else if (mode != "off" && !mode.empty()) {
+      *error = std::string(mode);
+      return false;
+    }
+  }
+  return true;
+}
+
+LatencyGuard::LatencyGuard(LatencyOptions options)
+    : options_(std::move(options)) {}
+
+LatencyGuard::~LatencyGuard() { Release(); }
+
+void LatencyGuard::Warn(const std::string& what, int error) {
+  if (std::find(warned_.begin(), warned_.end(), what) != warned_.end()) {
+    return;
+  }
+  warned_.push_back(what);
+  std::cerr << "Warning: latency mode could not " << what << ": "
+            << std::strerror(error) << std::endl;
+}
+
+bool LatencyGuard::Engage() {
+  if (engaged_) {
+    return true;
+  }
+  threads_changed_ = 0;
+  for (pid_t tid : tids_) {
+    ApplyThread(tid);
+  }
+  if (options_.min_freq_khz != 0) {
+    HoldFrequency();
+  }
+  if (options_.hold_dma_latency) {
+    dma_latency_fd_ = open("/dev/cpu_dma_latency", O_WRONLY | O_CLOEXEC);
+    const int32_t zero_us = 0;
+    if (dma_latency_fd_ < 0 ||
+        write(dma_latency_fd_, &zero_us, sizeof(zero_us)) !=
+            sizeof(zero_us)) {
+      Warn("hold /dev/cpu_dma_latency", errno);
+      if (dma_latency_fd_ >= 0) {
+        close(dma_latency_fd_);
+        dma_latency_fd_ = -1;
+      }
+    }
+  }
+  floors_held_ = static_cast<int>(floors_.size());
+  dma_latency_held_ = dma_latency_fd_ >= 0;
+  engaged_ = threads_changed_ > 0 || floors_held_ > 0 || dma_latency_held_;
+  return engaged_;
+}
+
+void LatencyGuard::ApplyThread(pid_t tid) {
+  SavedThread saved{tid, sched_getscheduler(tid), 0, 0, -1};
+  if (saved.policy < 0) {
+    return;  // The thread has exited.
+  }
+  sched_param param{};
+  sched_getparam(tid, &param);
+  saved.priority = param.sched_priority;
+  errno = 0;
+  saved.nice = getpriority(PRIO_PROCESS, tid);
+  SchedAttr attr;
+  if (GetSchedAttr(tid, &attr) == 0 &&
+      attr.size >= offsetof(SchedAttr, sched_util_max)) {
+    saved.uclamp_min = static_cast<int>(attr.sched_util_min);
+  }
+
+  bool changed = false;
+  if (options_.policy != LatencyOptions::Policy::kDefault) {
+    sched_param rt{};
+    rt.sched_priority = options_.rt_priority;
+    int policy = options_.policy == LatencyOptions::Policy::kFifo ? SCHED_FIFO
+                                                                  : SCHED_RR;
+    if (sched_setscheduler(tid, policy, &rt) == 0) {
+      changed = true;
+    } else if (errno != ESRCH) {
+      Warn(std::string("set ") + (policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR"),
+           errno);
+    }
+  }
+  if (options_.set_nice) {
+    if (setpriority(PRIO_PROCESS, tid, options_.nice) == 0) {
+      changed = true;
+    } else if (errno != ESRCH) {
+      Warn("lower the nice value", errno);
+    }
+  }
+  if (options_.set_uclamp_min) {
+    if (SetUtilClampMin(tid, static_cast<uint32_t>(options_.uclamp_min)) == 0) {
+      changed = true;
+    } else if (errno != ESRCH) {
+      Warn("set uclamp util_min", errno);
+    }
+  }
+  if (changed) {
+    saved_threads_.push_back(saved);
+    ++threads_changed_;
+  }
+}
+
+void LatencyGuard::HoldFrequency() {
+  for (const std::string& dir : CpuFreqPolicyDirs(cpus_, options_.cpu_root)) {
+    SysfsOverride floor;
+    if (!floor.Open(dir + "/scaling_min_freq")) {
+      continue;
+    }
+    std::string target = std::to_string(options_.min_freq_khz);
+    if (options_.min_freq_khz < 0) {
+      target = ReadSysfsValue(dir + "/scaling_max_freq");
+      if (target.empty()) {
+        continue;
+      }
+    }
+    // Also restored from the exit and signal paths while held.
+    if (!floor.Write(target)) {
+      Warn("raise scaling_min_freq", errno);
+      continue;
+    }
+    floors_.push_back(std::move(floor));
+  }
+}
+
+void LatencyGuard::Release() {
+  if (!engaged_) {
+    return;
+  }
+  for (const SavedThread& saved : saved_threads_) {
+    sched_param param{};
+    param.sched_priority = saved.priority;
+    sched_setscheduler(saved.tid, saved.policy, &param);
+    if (options_.set_nice) {
+      setpriority(PRIO_PROCESS, saved.tid, saved.nice);
+    }
+    if (options_.set_uclamp_min && saved.uclamp_min >= 0) {
+      SetUtilClampMin(saved.tid, static_cast<uint32_t>(saved.uclamp_min));
+    }
+  }
+  saved_threads_.clear();
+
+  floors_.clear();  // Restores each scaling_min_freq.
+
+  if (dma_latency_fd_ >= 0) {
+    close(dma_latency_fd_);  // Closing drops the PM QoS request.
+    dma_latency_fd_ = -1;
+  }
+  engaged_ = false;
+}
+
+void LatencyGuard::PrintSummary(std::ostream& out) const {
+  out << "[INFO] Latency mode:";
+  if (options_.policy != LatencyOptions::Policy::kDefault) {
+    out << (options_.policy == LatencyOptions::Policy::kFifo ? " SCHED_FIFO"
+                                                             : " SCHED_RR")
+        << " priority " << options_.rt_priority;
+  }
+  if (options_.set_nice) {
+    out << " nice " << options_.nice;
+  }
+  if (options_.set_uclamp_min) {
+    out << " uclamp_min " << options_.uclamp_min;
+  }
+  out << " on " << threads_changed_ << "/" << tids_.size() << " threads";
+  if (options_.min_freq_khz != 0) {
+    out << ", frequency floor on " << floors_held_ << " cpufreq policies";
+  }
+  if (options_.hold_dma_latency) {
+    out << ", cpu_dma_latency "
+        << (dma_latency_held_ ? "held at 0 us" : "not held");
+  }
+  out << "\n";
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,115 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_LATENCY_MODE_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_LATENCY_MODE_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+// What latency mode changes while it is engaged.
+struct LatencyOptions {
+  enum class Policy { kDefault, kFifo, kRoundRobin };
+
+  Policy policy = Policy::kDefault;
+  int rt_priority = 10;       // For kFifo and kRoundRobin.
+  bool set_nice = false;
+  int nice = -10;
+  bool set_uclamp_min = false;
+  int uclamp_min = 1024;      // 0..1024, via sched_setattr.
+  // Floor written to scaling_min_freq of the CPUs' cpufreq policies: 0
+  // leaves the governor alone, -1 uses each policy's scaling_max_freq.
+  int64_t min_freq_khz = 0;
+  // Holds a 0 us request on /dev/cpu_dma_latency, keeping CPUs out of deep
+  // idle states between tokens.
+  bool hold_dma_latency = false;
+  std::string cpu_root = "/sys/devices/system/cpu";
+};
+
+// Parses a comma-separated list of "fifo", "rr", "nice", "uclamp", "freq"
+// and "dma" ("off" or empty for none) into `options`. Returns false and
+// names the bad entry in `error` otherwise.
+bool ParseLatencyModes(std::string_view modes, LatencyOptions* options,
+                       std::string* error);
+
+// Applies LatencyOptions to a set of threads and CPUs and undoes it.
+//
+// Engage() saves each thread's scheduling policy, priority, nice value and
+// utilization clamp, and each cpufreq policy's scaling_min_freq, before
+// changing them; Release() puts them back. Settings that fail (usually for
+// lack of CAP_SYS_NICE or root) are skipped with one warning each. The
+// frequency floor outlives the process, so it is also restored from exit()
+// and from SIGINT, SIGTERM and SIGHUP handlers; scheduling attributes and
+// the PM QoS request end with the threads and file descriptor anyway.
+class LatencyGuard {
+ public:
+  explicit LatencyGuard(LatencyOptions options);
+  ~LatencyGuard();
+
+  LatencyGuard(const LatencyGuard&) = delete;
+  LatencyGuard& operator=(const LatencyGuard&) = delete;
+
+  // Takes effect at the next Engage().
+  void SetThreads(std::vector<pid_t> tids) { tids_ = std::move(tids); }
+  void SetCpus(std::vector<int> cpus) { cpus_ = std::move(cpus); }
+
+  // Returns true if at least one setting was applied.
+  bool Engage();
+  void Release();
+  bool engaged() const { return engaged_; }
+
+  // One line describing what the last Engage() applied; still valid after
+  // Release().
+  void PrintSummary(std::ostream& out) const;
+
+ private:
+  struct SavedThread {
+    pid_t tid;
+    int policy;
+    int priority;
+    int nice;
+    int uclamp_min;  // -1 if unknown.
+  };
+
+  void ApplyThread(pid_t tid);
+  void HoldFrequency();
+  void Warn(const std::string& what, int error);
+
+  LatencyOptions options_;
+  std::vector<pid_t> tids_;
+  std::vector<int> cpus_;
+  bool engaged_ = false;
+  std::vector<SavedThread> saved_threads_;
+  std::vector<SysfsOverride> floors_;
+  int dma_latency_fd_ = -1;
+  int threads_changed_ = 0;
+  int floors_held_ = 0;
+  bool dma_latency_held_ = false;
+  std::vector<std::string> warned_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_LATENCY_MODE_H_
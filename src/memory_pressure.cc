@@ -0,0 +1,315 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/memory_pressure.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+constexpr int kMaxStage = kNumPressureStages - 1;
+
+double Ms(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+std::string Percent(double ratio) {
+  return std::to_string(static_cast<int>(ratio * 100.0 + 0.5)) + "%";
+}
+
+// Opens a PSI trigger ("some <stall> <window>") on `path`, or returns -1.
+int OpenPsiTrigger(const std::string& path, int64_t stall_us,
+                   int64_t window_us) {
+  int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  const std::string trigger =
+      "some " + std::to_string(stall_us) + " " + std::to_string(window_us);
+  // The kernel expects the terminating NUL as part of the write.
+  if (write(fd, trigger.c_str(), trigger.size() + 1) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+const char* PressureStageName(PressureStage stage) {
+  switch (stage) {
+    case PressureStage::kNormal:
+      return "normal";
+    case PressureStage::kShrinkCaches:
+      return "shrink_caches";
+    case PressureStage::kDropIdleArenas:
+      return "drop_idle_arenas";
+    case PressureStage::kLowerPrefetch:
+      return "lower_prefetch";
+    case PressureStage::kCapContext:
+      return "cap_context";
+    case PressureStage::kRefuseSessions:
+      return "refuse_sessions";
+  }
+  return "unknown";
+}
+
+MemoryPressureController::MemoryPressureController(
+    MemoryPressureOptions options)
+    : options_(std::move(options)) {
+  if (options_.cgroup_dir.empty()) {
+    options_.cgroup_dir = CurrentCgroupDir();
+  }
+}
+
+MemoryPressureController::~MemoryPressureController() {
+  Stop();
+  for (int fd : {psi_fd_, events_fd_}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+int64_t MemoryPressureController::ReadLimit() {
+  int64_t limit = -1;
+  for (ProcFile* file : {&max_, &high_}) {
+    // "max" parses as no number, i.e. unlimited.
+    int64_t value = ParseInt(file->Read());
+    if (value > 0 && (limit < 0 || value < limit)) {
+      limit = value;
+    }
+  }
+  return limit;
+}
+
+bool MemoryPressureController::Start() {
+  const std::string& dir = options_.cgroup_dir;
+  std::vector<std::string> watched;
+  if (!dir.empty()) {
+    current_ = ProcFile(dir + "/memory.current");
+    max_ = ProcFile(dir + "/memory.max");
+    high_ = ProcFile(dir + "/memory.high");
+    const int64_t limit = ReadLimit();
+    if (current_.is_open() && limit > 0) {
+      watched.push_back("memory.current of " + dir + " (limit " +
+                        std::to_string(limit / (1024 * 1024)) + " MiB)");
+    }
+    events_fd_ = open((dir + "/memory.events").c_str(), O_RDONLY | O_CLOEXEC);
+    if (events_fd_ >= 0) {
+      watched.push_back("memory.events");
+    }
+  }
+  for (const std::string& path :
+       {dir.empty() ? std::string() : dir + "/memory.pressure",
+        std::string("/proc/pressure/memory")}) {
+    if (!path.empty() && psi_fd_ < 0) {
+      psi_fd_ = OpenPsiTrigger(path, options_.psi_stall_us,
+                               options_.psi_window_us);
+      if (psi_fd_ >= 0) {
+        watched.push_back("PSI trigger on " + path);
+      }
+    }
+  }
+  for (const std::string& item : watched) {
+    description_ += (description_.empty() ? "" : ", ") + item;
+  }
+  if (psi_fd_ < 0 && ReadLimit() <= 0) {
+    return false;
+  }
+  start_ = stage_since_ = Clock::now();
+  thread_ = std::thread(&MemoryPressureController::Run, this);
+  return true;
+}
+
+void MemoryPressureController::Stop() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void MemoryPressureController::SetTarget(int target, std::string reason) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_ = target;
+  reason_ = std::move(reason);
+}
+
+void MemoryPressureController::Run() {
+  std::vector<pollfd> fds;
+  for (int fd : {psi_fd_, events_fd_}) {
+    if (fd >= 0) {
+      fds.push_back({fd, POLLPRI, 0});
+    }
+  }
+  std::string events;
+  std::string pending_event;
+  int64_t last_high = -1, last_max = -1;
+  int target = 0;
+  Clock::time_point last_change = Clock::now();
+  Clock::time_point last_escalation = last_change - std::chrono::hours(1);
+
+  while (!stop_) {
+    poll(fds.data(), fds.size(), options_.poll_interval_ms);
+    std::string event;
+    for (pollfd& fd : fds) {
+      if (fd.revents == 0) {
+        continue;
+      }
+      if (fd.fd == psi_fd_) {
+        event = "PSI memory stall";
+      }
+      fd.revents = 0;
+    }
+    if (events_fd_ >= 0) {
+      // Re-reading also re-arms the POLLPRI notification.
+      char buffer[512];
+      ssize_t n = pread(events_fd_, buffer, sizeof(buffer) - 1, 0);
+      events.assign(buffer, n > 0 ? n : 0);
+      int64_t high = ParseSpaceField(events, "high", 0);
+      int64_t max = ParseSpaceField(events, "max", 0);
+      if (last_high >= 0 && (high > last_high || max > last_max)) {
+        event = "memory.events high +" + std::to_string(high - last_high) +
+                ", max +" + std::to_string(max - last_max);
+      }
+      last_high = high;
+      last_max = max;
+    }
+
+    const int64_t current = ParseInt(current_.Read());
+    const int64_t limit = ReadLimit();
+    double ratio = -1.0;
+    int ratio_stage = 0;
+    if (current >= 0 && limit > 0) {
+      ratio = static_cast<double>(current) / limit;
+      if (ratio >= options_.first_stage_ratio) {
+        ratio_stage = std::min(
+            kMaxStage, 1 + static_cast<int>((ratio - options_.first_stage_ratio) /
+                                            options_.stage_step_ratio));
+      }
+    }
+    const std::string usage =
+        ratio < 0 ? std::string()
+                  : "memory.current " + Percent(ratio) + " of " +
+                        std::to_string(limit / (1024 * 1024)) + " MiB";
+
+    const Clock::time_point now = Clock::now();
+    if (!event.empty()) {
+      // An event inside the escalation interval is kept, not dropped.
+      pending_event = event;
+      last_change = now;
+    }
+    if (!pending_event.empty() && target < kMaxStage &&
+        now - last_escalation >=
+            std::chrono::milliseconds(options_.escalate_interval_ms)) {
+      target = std::max(target + 1, ratio_stage);
+      last_change = last_escalation = now;
+      SetTarget(target, usage.empty() ? pending_event
+                                      : pending_event + ", " + usage);
+      pending_event.clear();
+    } else if (ratio_stage > target) {
+      target = ratio_stage;
+      last_change = last_escalation = now;
+      SetTarget(target, usage);
+    } else if (target > 0 &&
+               now - last_change >=
+                   std::chrono::milliseconds(options_.cooldown_ms) &&
+               (ratio < 0 ||
+                ratio < options_.first_stage_ratio +
+                            (target - 1) * options_.stage_step_ratio -
+                            options_.hysteresis_ratio)) {
+      --target;
+      last_change = now;
+      pending_event.clear();
+      SetTarget(target, usage.empty() ? "no stall for " +
+                                            std::to_string(options_.cooldown_ms) +
+                                            " ms"
+                                      : "recovered, " + usage);
+    }
+  }
+}
+
+PressureStage MemoryPressureController::Poll(const StageAction& action) {
+  int target;
+  std::string reason;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    target = target_;
+    reason = reason_;
+  }
+  int stage = static_cast<int>(applied_);
+  if (stage == target) {
+    return applied_;
+  }
+  const Clock::time_point now = Clock::now();
+  stage_ms_[stage] += Ms(now - stage_since_);
+  stage_since_ = now;
+  const PressureStage from = applied_;
+  // Entering stage s applies s; leaving it undoes s.
+  while (stage < target) {
+    action(static_cast<PressureStage>(++stage), true);
+  }
+  while (stage > target) {
+    action(static_cast<PressureStage>(stage--), false);
+  }
+  applied_ = static_cast<PressureStage>(stage);
+  peak_ = std::max(peak_, applied_);
+  transitions_.push_back({Ms(now - start_), from, applied_, reason});
+  std::cerr << "[MEMORY] " << PressureStageName(from) << " -> "
+            << PressureStageName(applied_) << ": " << reason << std::endl;
+  return applied_;
+}
+
+void MemoryPressureController::PrintSummary(std::ostream& out) const {
+  double stage_ms[kNumPressureStages];
+  std::copy(std::begin(stage_ms_), std::end(stage_ms_), stage_ms);
+  stage_ms[static_cast<int>(applied_)] += Ms(Clock::now() - stage_since_);
+  out << std::fixed << std::setprecision(1);
+  out << "[MEMORY] Pressure stages: peak " << PressureStageName(peak_) << ", "
+      << transitions_.size() << " transitions; time in";
+  for (int s = 0; s < kNumPressureStages; ++s) {
+    if (stage_ms[s] > 0.0) {
+      out << " " << PressureStageName(static_cast<PressureStage>(s)) << " "
+          << stage_ms[s] << " ms";
+    }
+  }
+  out << "\n";
+  for (const Transition& transition : transitions_) {
+    out << "  " << std::setw(10) << transition.time_ms << " ms  "
+        << PressureStageName(transition.from) << " -> "
+        << PressureStageName(transition.to) << " (" << transition.reason
+        << ")\n";
+  }
+  out << std::defaultfloat;
+}
+
+}  // namespace ai_edge_torch::examples
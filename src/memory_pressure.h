@@ -0,0 +1,149 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_MEMORY_PRESSURE_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_MEMORY_PRESSURE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+// Degradation stages, mildest first. Each stage keeps the actions of the
+// ones before it.
+enum class PressureStage {
+  kNormal = 0,
+  kShrinkCaches,    // Release unused KV cache pages and spare caches.
+  kDropIdleArenas,  // Free the activation arenas of idle signatures.
+  kLowerPrefetch,   // Stop prefetching weights.
+  kCapContext,      // Let generations grow only a few more tokens.
+  kRefuseSessions,  // Turn away new requests.
+};
+constexpr int kNumPressureStages = 6;
+
+const char* PressureStageName(PressureStage stage);
+
+struct MemoryPressureOptions {
+  // cgroup v2 directory to watch; empty for this process's own cgroup.
+  std::string cgroup_dir;
+  // memory.current as a fraction of the lower of memory.max and memory.high
+  // that enters stage 1; every further stage starts `stage_step_ratio`
+  // higher.
+  double first_stage_ratio = 0.80;
+  double stage_step_ratio = 0.04;
+  // A stage is left once usage is this far below where it starts and no
+  // event arrived for `cooldown_ms`.
+  double hysteresis_ratio = 0.05;
+  int cooldown_ms = 3000;
+  // PSI trigger: `psi_stall_us` of "some" memory stall within
+  // `psi_window_us`. Unprivileged triggers need a window that is a multiple
+  // of 2 s.
+  int64_t psi_stall_us = 200000;
+  int64_t psi_window_us = 2000000;
+  // A PSI trigger or a new memory.events high/max count moves one stage up,
+  // at most once per this interval, so the last stage has time to work.
+  int escalate_interval_ms = 500;
+  // memory.current is re-read at least this often.
+  int poll_interval_ms = 100;
+};
+
+// Watches cgroup v2 memory usage, memory.events and a PSI trigger from a
+// background thread and picks a degradation stage.
+//
+// The monitor thread only decides; the caller applies stages from its own
+// thread with Poll(), at points where the interpreter and caches are not in
+// use (token boundaries). Stages are entered and left one at a time, in
+// order, and every transition is logged to stderr with its reason.
+class MemoryPressureController {
+ public:
+  // Applies (`entering`) or undoes the action of one stage.
+  using StageAction = std::function<void(PressureStage stage, bool entering)>;
+
+  explicit MemoryPressureController(MemoryPressureOptions options);
+  ~MemoryPressureController();
+
+  MemoryPressureController(const MemoryPressureController&) = delete;
+  MemoryPressureController& operator=(const MemoryPressureController&) =
+      delete;
+
+  // Returns false if there is neither a memory limit nor a PSI trigger to
+  // watch.
+  bool Start();
+  void Stop();
+
+  // Moves the applied stage to the monitor's target, calling `action` for
+  // every stage passed. Returns the stage now applied.
+  PressureStage Poll(const StageAction& action);
+  PressureStage stage() const { return applied_; }
+
+  // What is watched, e.g. "memory.current of /sys/fs/cgroup/llm (limit 1024
+  // MiB), memory.events, PSI trigger on memory.pressure".
+  const std::string& description() const { return description_; }
+
+  // Peak stage, transitions and the time spent in each stage.
+  void PrintSummary(std::ostream& out) const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Transition {
+    double time_ms;
+    PressureStage from;
+    PressureStage to;
+    std::string reason;
+  };
+
+  void Run();
+  // Lower of memory.max and memory.high in bytes, or -1 if unlimited.
+  int64_t ReadLimit();
+  void SetTarget(int target, std::string reason);
+
+  MemoryPressureOptions options_;
+  std::string description_;
+  int psi_fd_ = -1;
+  int events_fd_ = -1;
+  ProcFile current_;
+  ProcFile max_;
+  ProcFile high_;
+
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+
+  // Written by the monitor thread.
+  mutable std::mutex mutex_;
+  int target_ = 0;
+  std::string reason_;
+
+  // Main-thread state.
+  PressureStage applied_ = PressureStage::kNormal;
+  PressureStage peak_ = PressureStage::kNormal;
+  Clock::time_point start_;
+  Clock::time_point stage_since_;
+  double stage_ms_[kNumPressureStages] = {};
+  std::vector<Transition> transitions_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_MEMORY_PRESSURE_H_
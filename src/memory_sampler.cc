@@ -0,0 +1,157 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/memory_sampler.h"
+
+#include <time.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+uint64_t ToUs(const struct timespec& ts) {
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000ull + ts.tv_nsec / 1000;
+}
+
+}  // namespace
+
+MemorySampler::MemorySampler(int interval_us)
+    : interval_us_(interval_us > 0 ? interval_us : 1000),
+      status_("/proc/self/status"),
+      stat_("/proc/self/stat") {
+  std::string cgroup_dir = CurrentCgroupDir();
+  if (!cgroup_dir.empty()) {
+    cgroup_current_ = ProcFile(cgroup_dir + "/memory.current");
+    cgroup_stat_ = ProcFile(cgroup_dir + "/memory.stat");
+  }
+  // Enough for a few minutes at 1 kHz without reallocating.
+  samples_.reserve(1 << 18);
+}
+
+MemorySampler::~MemorySampler() { Stop(); }
+
+int MemorySampler::RegisterPhase(const std::string& name) {
+  phase_names_.push_back(name);
+  return static_cast<int>(phase_names_.size()) - 1;
+}
+
+void MemorySampler::SetPhase(int phase, int token) {
+  tag_.store((static_cast<uint64_t>(static_cast<uint32_t>(phase)) << 32) |
+                 static_cast<uint32_t>(token),
+             std::memory_order_relaxed);
+}
+
+void MemorySampler::SetToken(int token) {
+  uint64_t tag = tag_.load(std::memory_order_relaxed);
+  tag_.store((tag & 0xFFFFFFFF00000000ull) | static_cast<uint32_t>(token),
+             std::memory_order_relaxed);
+}
+
+void MemorySampler::Start() {
+  if (!thread_.joinable()) {
+    stop_.store(false);
+    thread_ = std::thread(&MemorySampler::Run, this);
+  }
+}
+
+void MemorySampler::Stop() {
+  if (thread_.joinable()) {
+    stop_.store(true);
+    thread_.join();
+  }
+}
+
+void MemorySampler::TakeSample(uint64_t time_us) {
+  Sample sample;
+  sample.time_us = time_us;
+  uint64_t tag = tag_.load(std::memory_order_relaxed);
+  sample.phase = static_cast<int32_t>(tag >> 32);
+  sample.token = static_cast<int32_t>(tag & 0xFFFFFFFF);
+
+  std::string_view status = status_.Read();
+  sample.vm_rss_kb = ParseColonField(status, "VmRSS");
+  sample.rss_anon_kb = ParseColonField(status, "RssAnon");
+  sample.rss_file_kb = ParseColonField(status, "RssFile");
+  sample.vm_swap_kb = ParseColonField(status, "VmSwap");
+  std::string_view stat = stat_.Read();
+  sample.minor_faults = ParseStatField(stat, 10);
+  sample.major_faults = ParseStatField(stat, 12);
+
+  if (cgroup_current_.is_open()) {
+    sample.cgroup_current_bytes = ParseInt(cgroup_current_.Read());
+  }
+  if (cgroup_stat_.is_open()) {
+    std::string_view memory_stat = cgroup_stat_.Read();
+    sample.cgroup_anon_bytes = ParseSpaceField(memory_stat, "anon");
+    sample.cgroup_file_bytes = ParseSpaceField(memory_stat, "file");
+    sample.cgroup_major_faults = ParseSpaceField(memory_stat, "pgmajfault");
+  }
+  samples_.push_back(sample);
+}
+
+void MemorySampler::Run() {
+  struct timespec start, next;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  next = start;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    TakeSample(ToUs(now) - ToUs(start));
+
+    next.tv_nsec += static_cast<long>(interval_us_) * 1000;
+    while (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      ++next.tv_sec;
+    }
+    // If sampling fell behind, skip the missed deadlines instead of bursting.
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (ToUs(next) < ToUs(now)) {
+      next = now;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+  }
+}
+
+bool MemorySampler::WriteCsv(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    return false;
+  }
+  out << "time_us,phase,token,vm_rss_kb,rss_anon_kb,rss_file_kb,vm_swap_kb,"
+         "minor_faults,major_faults,cgroup_current_bytes,cgroup_anon_bytes,"
+         "cgroup_file_bytes,cgroup_major_faults\n";
+  for (const Sample& s : samples_) {
+    const std::string phase =
+        (s.phase >= 0 && s.phase < static_cast<int>(phase_names_.size()))
+            ? phase_names_[s.phase]
+            : "";
+    out << s.time_us << "," << phase << "," << s.token << "," << s.vm_rss_kb
+        << "," << s.rss_anon_kb << "," << s.rss_file_kb << "," << s.vm_swap_kb
+        << "," << s.minor_faults << "," << s.major_faults << ","
+        << s.cgroup_current_bytes << "," << s.cgroup_anon_bytes << ","
+        << s.cgroup_file_bytes << "," << s.cgroup_major_faults << "\n";
+  }
+  return out.good();
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,95 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_MEMORY_SAMPLER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_MEMORY_SAMPLER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+// Samples process and cgroup memory state from a background thread.
+//
+// Files are opened once and re-read with pread(); the thread sleeps on an
+// absolute deadline so the interval does not drift with sampling cost. Each
+// sample carries the phase and token index the main thread last published,
+// so faults can be attributed to prefill or to an individual decode step.
+class MemorySampler {
+ public:
+  struct Sample {
+    uint64_t time_us = 0;  // Since the sampler started.
+    int phase = -1;
+    int token = -1;
+    int64_t vm_rss_kb = -1;
+    int64_t rss_anon_kb = -1;
+    int64_t rss_file_kb = -1;
+    int64_t vm_swap_kb = -1;
+    int64_t minor_faults = -1;
+    int64_t major_faults = -1;
+    // cgroup v2; -1 when unavailable.
+    int64_t cgroup_current_bytes = -1;
+    int64_t cgroup_anon_bytes = -1;
+    int64_t cgroup_file_bytes = -1;
+    int64_t cgroup_major_faults = -1;
+  };
+
+  explicit MemorySampler(int interval_us);
+  ~MemorySampler();
+
+  MemorySampler(const MemorySampler&) = delete;
+  MemorySampler& operator=(const MemorySampler&) = delete;
+
+  // Register phases before Start().
+  int RegisterPhase(const std::string& name);
+
+  void Start();
+  void Stop();
+
+  // Published by the main thread; picked up by the next sample.
+  void SetPhase(int phase, int token = -1);
+  void SetToken(int token);
+
+  const std::vector<Sample>& samples() const { return samples_; }
+  // Call after Stop(). Returns false on I/O error.
+  bool WriteCsv(const std::string& path) const;
+
+ private:
+  void Run();
+  void TakeSample(uint64_t time_us);
+
+  const int interval_us_;
+  std::vector<std::string> phase_names_;
+  // Phase in the upper 32 bits, token index in the lower 32.
+  std::atomic<uint64_t> tag_{~uint64_t{0}};
+  std::atomic<bool> stop_{false};
+
+  ProcFile status_;
+  ProcFile stat_;
+  ProcFile cgroup_current_;
+  ProcFile cgroup_stat_;
+
+  std::vector<Sample> samples_;
+  std::thread thread_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_MEMORY_SAMPLER_H_
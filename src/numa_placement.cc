@@ -0,0 +1,302 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/numa_placement.h"
+
+#include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// Node masks are passed to the kernel as bitmaps of this many bits.
+constexpr int kMaxNodes = 1024;
+constexpr int kBitsPerWord = 8 * sizeof(unsigned long);
+
+struct NodeMask {
+  unsigned long words[kMaxNodes / kBitsPerWord] = {};
+  // The kernel drops the last bit of maxnode, hence the + 1.
+  unsigned long maxnode = kMaxNodes + 1;
+};
+
+NodeMask MakeNodeMask(const std::vector<int>& nodes) {
+  NodeMask mask;
+  for (int node : nodes) {
+    if (node >= 0 && node < kMaxNodes) {
+      mask.words[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+    }
+  }
+  return mask;
+}
+
+int KernelMode(NumaPolicy policy) {
+  switch (policy) {
+    case NumaPolicy::kBind:
+      return MPOL_BIND;
+    case NumaPolicy::kInterleave:
+      return MPOL_INTERLEAVE;
+    case NumaPolicy::kNone:
+      break;
+  }
+  return MPOL_DEFAULT;
+}
+
+size_t PageSize() { return static_cast<size_t>(sysconf(_SC_PAGESIZE)); }
+
+}  // namespace
+
+const NumaNode* NumaTopology::Find(int id) const {
+  for (const NumaNode& node : nodes) {
+    if (node.id == id) {
+      return &node;
+    }
+  }
+  return nullptr;
+}
+
+int NumaTopology::NodeOfCpu(int cpu) const {
+  for (const NumaNode& node : nodes) {
+    if (std::binary_search(node.cpus.begin(), node.cpus.end(), cpu)) {
+      return node.id;
+    }
+  }
+  return -1;
+}
+
+std::vector<int> NumaTopology::node_ids() const {
+  std::vector<int> ids;
+  for (const NumaNode& node : nodes) {
+    ids.push_back(node.id);
+  }
+  return ids;
+}
+
+void NumaTopology::Print(std::ostream& out) const {
+  out << "NUMA topology: " << nodes.size() << " node(s)";
+  for (const NumaNode& node : nodes) {
+    out << " [node" << node.id << ": cpus "
+        << (node.cpus.empty() ? "none" : FormatCpuList(node.cpus));
+    if (node.total_bytes > 0) {
+      out << std::fixed << std::setprecision(1) << ", "
+          << node.free_bytes / (1024.0 * 1024.0 * 1024.0) << "/"
+          << node.total_bytes / (1024.0 * 1024.0 * 1024.0) << " GiB free"
+          << std::defaultfloat;
+    }
+    out << "]";
+  }
+  out << "\n";
+}
+
+NumaTopology DiscoverNumaTopology(const std::string& node_root) {
+  NumaTopology topology;
+  const std::vector<int> allowed = GetThreadAffinity(0);
+  std::string contents;
+  if (!ReadFileToString(node_root + "/has_memory", &contents)) {
+    topology.nodes.push_back({0, allowed, -1, -1});
+    return topology;
+  }
+  for (int id : ParseCpuList(contents)) {
+    NumaNode& node = topology.nodes.emplace_back();
+    node.id = id;
+    const std::string dir = node_root + "/node" + std::to_string(id);
+    if (ReadFileToString(dir + "/cpulist", &contents)) {
+      for (int cpu : ParseCpuList(contents)) {
+        if (std::binary_search(allowed.begin(), allowed.end(), cpu)) {
+          node.cpus.push_back(cpu);
+        }
+      }
+    }
+    if (ReadFileToString(dir + "/meminfo", &contents)) {
+      // Lines read "Node <id> MemTotal:   <kB> kB".
+      const std::string prefix = "Node " + std::to_string(id) + " ";
+      int64_t total_kb = ParseColonField(contents, prefix + "MemTotal");
+      int64_t free_kb = ParseColonField(contents, prefix + "MemFree");
+      node.total_bytes = total_kb < 0 ? -1 : total_kb * 1024;
+      node.free_bytes = free_kb < 0 ? -1 : free_kb * 1024;
+    }
+  }
+  if (topology.nodes.empty()) {
+    topology.nodes.push_back({0, allowed, -1, -1});
+  }
+  return topology;
+}
+
+const char* NumaPolicyName(NumaPolicy policy) {
+  switch (policy) {
+    case NumaPolicy::kNone:
+      return "none";
+    case NumaPolicy::kBind:
+      return "bind";
+    case NumaPolicy::kInterleave:
+      return "interleave";
+  }
+  return "unknown";
+}
+
+bool ParseNumaPolicy(std::string_view name, NumaPolicy* policy) {
+  if (name == "none") {
+    *policy = NumaPolicy::kNone;
+  } else if (name == "bind") {
+    *policy = NumaPolicy::kBind;
+  } else if (name == "interleave") {
+    *policy = NumaPolicy::kInterleave;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool SetMemoryPolicy(NumaPolicy policy, const std::vector<int>& nodes) {
+  if (policy == NumaPolicy::kNone) {
+    return syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0) == 0;
+  }
+  NodeMask mask = MakeNodeMask(nodes);
+  return syscall(SYS_set_mempolicy, KernelMode(policy), mask.words,
+                 mask.maxnode) == 0;
+}
+
+bool BindMemory(const void* addr, size_t bytes, NumaPolicy policy,
+                const std::vector<int>& nodes) {
+  if (bytes == 0) {
+    return true;
+  }
+  const uintptr_t page = PageSize();
+  uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + bytes + page - 1) &
+                  ~(page - 1);
+  NodeMask mask = MakeNodeMask(nodes);
+  const bool use_mask = policy != NumaPolicy::kNone;
+  return syscall(SYS_mbind, begin, end - begin, KernelMode(policy),
+                 use_mask ? mask.words : nullptr, use_mask ? mask.maxnode : 0,
+                 MPOL_MF_MOVE) == 0;
+}
+
+std::map<int, size_t> SamplePageNodes(const void* addr, size_t bytes,
+                                      size_t max_samples) {
+  std::map<int, size_t> pages;
+  if (bytes == 0 || max_samples == 0) {
+    return pages;
+  }
+  const uintptr_t page = PageSize();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+  const size_t num_pages =
+      (reinterpret_cast<uintptr_t>(addr) + bytes - begin + page - 1) / page;
+  const size_t samples = std::min(num_pages, max_samples);
+  std::vector<void*> addresses(samples);
+  for (size_t i = 0; i < samples; ++i) {
+    addresses[i] =
+        reinterpret_cast<void*>(begin + i * num_pages / samples * page);
+  }
+  // With no target nodes, move_pages() only reports where each page is.
+  std::vector<int> status(samples, -1);
+  if (syscall(SYS_move_pages, 0, samples, addresses.data(), nullptr,
+              status.data(), 0) != 0) {
+    return pages;
+  }
+  for (int node : status) {
+    if (node >= 0) {
+      ++pages[node];
+    }
+  }
+  return pages;
+}
+
+std::string FormatPageNodes(const std::map<int, size_t>& pages) {
+  size_t total = 0;
+  for (const auto& [node, count] : pages) {
+    total += count;
+  }
+  if (total == 0) {
+    return "not resident";
+  }
+  std::ostringstream out;
+  for (const auto& [node, count] : pages) {
+    if (out.tellp() > 0) {
+      out << ", ";
+    }
+    out << "node" << node << " " << (100 * count + total / 2) / total << "%";
+  }
+  return out.str();
+}
+
+std::unique_ptr<NumaBuffer> NumaBuffer::FromFile(const std::string& path,
+                                                 NumaPolicy policy,
+                                                 const std::vector<int>& nodes,
+                                                 std::string* error) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+    *error = path + ": " + (fd < 0 ? strerror(errno) : "empty or unreadable");
+    if (fd >= 0) {
+      close(fd);
+    }
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    *error = std::string("mmap: ") + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  std::unique_ptr<NumaBuffer> buffer(new NumaBuffer(data, size));
+  // The policy has to be in place before the copy faults the pages in.
+  if (policy != NumaPolicy::kNone && !BindMemory(data, size, policy, nodes)) {
+    *error = std::string("mbind: ") + strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  char* out = static_cast<char*>(data);
+  for (size_t done = 0; done < size;) {
+    ssize_t n = pread(fd, out + done, size - done, static_cast<off_t>(done));
+    if (n <= 0) {
+      *error = path + ": short read";
+      close(fd);
+      return nullptr;
+    }
+    done += static_cast<size_t>(n);
+  }
+  // The page-cache copy is not used again; let it go instead of holding the
+  // model in memory twice.
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+  mprotect(data, size, PROT_READ);
+  return buffer;
+}
+
+NumaBuffer::~NumaBuffer() { munmap(data_, size_); }
+
+}  // namespace ai_edge_torch::examples
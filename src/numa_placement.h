@@ -0,0 +1,114 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_NUMA_PLACEMENT_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_NUMA_PLACEMENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;  // Restricted to this process's affinity mask.
+  int64_t total_bytes = -1;
+  int64_t free_bytes = -1;
+};
+
+struct NumaTopology {
+  // Nodes with memory, by id.
+  std::vector<NumaNode> nodes;
+
+  bool multi_node() const { return nodes.size() > 1; }
+  const NumaNode* Find(int id) const;
+  // Node of `cpu`, or -1.
+  int NodeOfCpu(int cpu) const;
+  std::vector<int> node_ids() const;
+
+  void Print(std::ostream& out) const;
+};
+
+// `node_root` is normally /sys/devices/system/node; tests can point it at a
+// fake tree. Machines without it (or kernels without NUMA) report one node
+// holding every CPU in the affinity mask.
+NumaTopology DiscoverNumaTopology(
+    const std::string& node_root = "/sys/devices/system/node");
+
+// Where memory and compute threads go on a multi-socket machine.
+//
+//   kNone:       first touch decides, threads roam.
+//   kBind:       the interpreter and its workers run on one node's CPUs and
+//                allocate only from that node's memory.
+//   kInterleave: pages are spread round-robin over every node, so decode
+//                draws on the bandwidth of all memory controllers.
+enum class NumaPolicy { kNone, kBind, kInterleave };
+
+const char* NumaPolicyName(NumaPolicy policy);
+// Accepts "none", "bind" and "interleave".
+bool ParseNumaPolicy(std::string_view name, NumaPolicy* policy);
+
+// set_mempolicy() for the calling thread and the threads it creates later.
+// kNone restores the default local policy. Returns false with errno set.
+bool SetMemoryPolicy(NumaPolicy policy, const std::vector<int>& nodes);
+
+// mbind() on the pages covering [addr, addr + bytes), moving pages that are
+// already resident. Private and anonymous mappings only; the kernel ignores
+// policies on shared file mappings. Returns false with errno set.
+bool BindMemory(const void* addr, size_t bytes, NumaPolicy policy,
+                const std::vector<int>& nodes);
+
+// Resident pages per node for up to `max_samples` pages spread evenly over
+// the range, from move_pages(2). Pages not yet faulted in are left out.
+std::map<int, size_t> SamplePageNodes(const void* addr, size_t bytes,
+                                      size_t max_samples = 4096);
+
+// "node0 48%, node1 52%"; "not resident" for an empty map.
+std::string FormatPageNodes(const std::map<int, size_t>& pages);
+
+// A read-only private copy of a file, placed by a NUMA policy before it is
+// populated. Replaces the shared page-cache mapping of the model, whose
+// pages stay wherever an earlier reader faulted them in.
+class NumaBuffer {
+ public:
+  // Returns nullptr and sets `error` if the file cannot be read or mapped.
+  static std::unique_ptr<NumaBuffer> FromFile(const std::string& path,
+                                              NumaPolicy policy,
+                                              const std::vector<int>& nodes,
+                                              std::string* error);
+  ~NumaBuffer();
+
+  NumaBuffer(const NumaBuffer&) = delete;
+  NumaBuffer& operator=(const NumaBuffer&) = delete;
+
+  const char* data() const { return static_cast<const char*>(data_); }
+  size_t size() const { return size_; }
+
+ private:
+  NumaBuffer(void* data, size_t size) : data_(data), size_(size) {}
+
+  void* data_;
+  size_t size_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_NUMA_PLACEMENT_H_
@@ -0,0 +1,218 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/op_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+uint64_t NodeKey(int phase, int subgraph, int node) {
+  return (static_cast<uint64_t>(phase) << 48) |
+         (static_cast<uint64_t>(subgraph & 0xFFFF) << 32) |
+         static_cast<uint32_t>(node);
+}
+
+}  // namespace
+
+OpProfiler::OpProfiler(tflite::Interpreter* interpreter)
+    : interpreter_(interpreter), phases_{"default"} {}
+
+void OpProfiler::SetPhase(const std::string& phase) {
+  auto it = std::find(phases_.begin(), phases_.end(), phase);
+  if (it == phases_.end()) {
+    phases_.push_back(phase);
+    it = phases_.end() - 1;
+  }
+  phase_ = static_cast<int>(it - phases_.begin());
+}
+
+bool OpProfiler::IsDelegateNode(int subgraph, int node) const {
+  if (subgraph < 0 ||
+      subgraph >= static_cast<int>(interpreter_->subgraphs_size())) {
+    return false;
+  }
+  const auto* node_and_reg =
+      interpreter_->subgraph(subgraph)->node_and_registration(node);
+  return node_and_reg != nullptr &&
+         node_and_reg->second.builtin_code == kTfLiteBuiltinDelegate;
+}
+
+uint32_t OpProfiler::BeginEvent(const char* tag, EventType event_type,
+                                int64_t event_metadata1,
+                                int64_t event_metadata2) {
+  // Only node invocations are aggregated; for them metadata1 is the node
+  // index and metadata2 the subgraph index.
+  if (event_type != EventType::OPERATOR_INVOKE_EVENT) {
+    return 0;
+  }
+  open_.push_back({tag, static_cast<int>(event_metadata2),
+                   static_cast<int>(event_metadata1),
+                   std::chrono::steady_clock::now()});
+  return static_cast<uint32_t>(open_.size());
+}
+
+void OpProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == 0 || event_handle > open_.size()) {
+    return;
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const OpenEvent& event = open_[event_handle - 1];
+  const double elapsed_us =
+      std::chrono::duration<double, std::micro>(end - event.start).count();
+
+  auto [it, inserted] =
+      nodes_.try_emplace(NodeKey(phase_, event.subgraph, event.node));
+  NodeStats& stats = it->second;
+  if (inserted) {
+    stats.op_name = event.tag != nullptr ? event.tag : "UNKNOWN";
+    stats.phase = phase_;
+    stats.subgraph = event.subgraph;
+    stats.node = event.node;
+    stats.delegated = IsDelegateNode(event.subgraph, event.node);
+    stats.min_us = elapsed_us;
+    stats.max_us = elapsed_us;
+  }
+  ++stats.invocations;
+  stats.total_us += elapsed_us;
+  stats.min_us = std::min(stats.min_us, elapsed_us);
+  stats.max_us = std::max(stats.max_us, elapsed_us);
+  open_.resize(event_handle - 1);
+}
+
+std::vector<OpProfiler::NodeStats> OpProfiler::SortedNodes() const {
+  std::vector<NodeStats> nodes;
+  nodes.reserve(nodes_.size());
+  for (const auto& [key, stats] : nodes_) {
+    nodes.push_back(stats);
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NodeStats& a, const NodeStats& b) {
+              return a.total_us > b.total_us;
+            });
+  return nodes;
+}
+
+void OpProfiler::PrintReport(std::ostream& out, int top_n) const {
+  const std::vector<NodeStats> nodes = SortedNodes();
+
+  for (size_t phase = 0; phase < phases_.size(); ++phase) {
+    struct OpTotals {
+      int num_nodes = 0;
+      uint64_t invocations = 0;
+      double total_us = 0.0;
+    };
+    // Keyed by (delegated, op name) so partitions and fallbacks stay apart.
+    std::map<std::pair<bool, std::string>, OpTotals> ops;
+    double phase_us = 0.0, delegated_us = 0.0;
+    int num_delegated = 0, num_fallback = 0;
+    for (const NodeStats& node : nodes) {
+      if (node.phase != static_cast<int>(phase)) {
+        continue;
+      }
+      OpTotals& totals = ops[{node.delegated, node.op_name}];
+      ++totals.num_nodes;
+      totals.invocations += node.invocations;
+      totals.total_us += node.total_us;
+      phase_us += node.total_us;
+      if (node.delegated) {
+        delegated_us += node.total_us;
+        ++num_delegated;
+      } else {
+        ++num_fallback;
+      }
+    }
+    if (phase_us <= 0.0) {
+      continue;
+    }
+
+    std::vector<std::pair<std::pair<bool, std::string>, OpTotals>> sorted(
+        ops.begin(), ops.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+      return a.second.total_us > b.second.total_us;
+    });
+
+    out << "\n=== Operator Profile for Phase: " << phases_[phase] << " ===\n";
+    out << "Delegated nodes: " << num_delegated << " ("
+        << 100.0 * delegated_us / phase_us << "% of op time), "
+        << "CPU fallback nodes: " << num_fallback << " ("
+        << 100.0 * (phase_us - delegated_us) / phase_us << "% of op time)\n";
+    out << std::left << std::setw(36) << "Op" << std::setw(10) << "Kind"
+        << std::right << std::setw(8) << "Nodes" << std::setw(12) << "Invokes"
+        << std::setw(14) << "Total ms" << std::setw(10) << "%" << std::setw(14)
+        << "Avg us" << "\n";
+    for (const auto& [op, totals] : sorted) {
+      out << std::left << std::setw(36) << op.second << std::setw(10)
+          << (op.first ? "delegate" : "fallback") << std::right
+          << std::setw(8) << totals.num_nodes << std::setw(12)
+          << totals.invocations << std::setw(14) << std::fixed
+          << std::setprecision(3) << totals.total_us / 1000.0 << std::setw(10)
+          << std::setprecision(2) << 100.0 * totals.total_us / phase_us
+          << std::setw(14) << std::setprecision(1)
+          << totals.total_us / totals.invocations << "\n";
+    }
+
+    out << "\nTop " << top_n << " nodes:\n";
+    int printed = 0;
+    for (const NodeStats& node : nodes) {
+      if (node.phase != static_cast<int>(phase)) {
+        continue;
+      }
+      if (printed++ >= top_n) {
+        break;
+      }
+      out << "  subgraph " << node.subgraph << " node " << std::setw(5)
+          << node.node << "  " << std::left << std::setw(32) << node.op_name
+          << std::right << (node.delegated ? " delegate" : " fallback")
+          << std::setw(12) << std::setprecision(3) << node.total_us / 1000.0
+          << " ms" << std::setw(10) << std::setprecision(2)
+          << 100.0 * node.total_us / phase_us << "%\n";
+    }
+    out << std::defaultfloat << std::setprecision(6);
+  }
+}
+
+bool OpProfiler::WriteCsv(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    return false;
+  }
+  out << "phase,subgraph,node,op,delegated,invocations,total_us,avg_us,"
+         "min_us,max_us\n";
+  for (const NodeStats& node : SortedNodes()) {
+    out << phases_[node.phase] << "," << node.subgraph << "," << node.node
+        << "," << node.op_name << "," << (node.delegated ? 1 : 0) << ","
+        << node.invocations << "," << node.total_us << ","
+        << node.total_us / node.invocations << "," << node.min_us << ","
+        << node.max_us << "\n";
+  }
+  return out.good();
+}
+
+}  // namespace ai_edge_torch::examples
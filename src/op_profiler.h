@@ -0,0 +1,90 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_OP_PROFILER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_OP_PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace ai_edge_torch::examples {
+
+// Aggregates per-node operator latency reported by the TFLite runtime.
+//
+// Attach with interpreter->SetProfiler(). Every node Invoke() of every
+// subgraph is timed and accumulated under the current phase label ("prefill",
+// "decode", ...), so repeated decode steps fold into one row per node. A
+// delegated node (one XNNPACK partition) is reported as a single node; every
+// other node is a CPU fallback op running on the builtin kernels.
+class OpProfiler : public tflite::Profiler {
+ public:
+  struct NodeStats {
+    std::string op_name;
+    int phase = 0;
+    int subgraph = 0;
+    int node = 0;
+    bool delegated = false;
+    uint64_t invocations = 0;
+    double total_us = 0.0;
+    double min_us = 0.0;
+    double max_us = 0.0;
+  };
+
+  explicit OpProfiler(tflite::Interpreter* interpreter);
+
+  // Events recorded from now on are attributed to `phase`.
+  void SetPhase(const std::string& phase);
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+  void EndEvent(uint32_t event_handle) override;
+
+  // Per-phase op-type table, delegated vs. fallback split and the `top_n`
+  // slowest nodes.
+  void PrintReport(std::ostream& out, int top_n) const;
+  // One row per (phase, subgraph, node). Returns false on I/O error.
+  bool WriteCsv(const std::string& path) const;
+
+  std::vector<NodeStats> SortedNodes() const;
+
+ private:
+  struct OpenEvent {
+    const char* tag;
+    int subgraph;
+    int node;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  bool IsDelegateNode(int subgraph, int node) const;
+
+  tflite::Interpreter* interpreter_;
+  std::vector<std::string> phases_;
+  int phase_ = 0;
+  // Events still open; handles are indices into this stack.
+  std::vector<OpenEvent> open_;
+  std::unordered_map<uint64_t, NodeStats> nodes_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_OP_PROFILER_H_
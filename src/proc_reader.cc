@@ -0,0 +1,347 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// Returns the line that starts with `key` followed by `separator`.
+std::string_view FindLine(std::string_view text, std::string_view key,
+                          char separator) {
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    std::string_view line = text.substr(pos, end - pos);
+    if (line.size() > key.size() && line.compare(0, key.size(), key) == 0 &&
+        line[key.size()] == separator) {
+      return line.substr(key.size() + 1);
+    }
+    pos = end + 1;
+  }
+  return {};
+}
+
+// Saved values of written SysfsOverrides, in a form the exit and signal
+// paths can restore: fixed storage, no allocation.
+struct RestoreSlot {
+  std::atomic<int> state{0};
+  int fd;
+  char value[32];
+  size_t length;
+};
+constexpr int kSlotFree = 0;
+constexpr int kSlotClaimed = 1;  // Being filled, or being restored.
+constexpr int kSlotArmed = 2;
+constexpr int kMaxRestoreSlots = 64;
+RestoreSlot g_restore_slots[kMaxRestoreSlots];
+
+const int kRestoreSignals[] = {SIGINT, SIGTERM, SIGHUP};
+struct sigaction g_previous_actions[3];
+std::atomic<bool> g_handlers_installed{false};
+
+// Async-signal-safe.
+bool WriteRaw(int fd, const char* value, size_t length) {
+  if (pwrite(fd, value, length, 0) < 0) {
+    return false;
+  }
+  (void)ftruncate(fd, static_cast<off_t>(length));
+  return true;
+}
+
+void RestoreAll() {
+  for (RestoreSlot& slot : g_restore_slots) {
+    int expected = kSlotArmed;
+    // Left claimed: the process is on its way out.
+    if (slot.state.compare_exchange_strong(expected, kSlotClaimed)) {
+      WriteRaw(slot.fd, slot.value, slot.length);
+    }
+  }
+}
+
+void RestoreAllAndReraise(int signal_number) {
+  RestoreAll();
+  for (int i = 0; i < 3; ++i) {
+    if (kRestoreSignals[i] == signal_number) {
+      sigaction(signal_number, &g_previous_actions[i], nullptr);
+    }
+  }
+  raise(signal_number);
+}
+
+void InstallRestoreHandlers() {
+  if (g_handlers_installed.exchange(true)) {
+    return;
+  }
+  std::atexit(RestoreAll);
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = RestoreAllAndReraise;
+  sigemptyset(&action.sa_mask);
+  for (int i = 0; i < 3; ++i) {
+    sigaction(kRestoreSignals[i], &action, &g_previous_actions[i]);
+  }
+}
+
+// Returns the armed slot, or -1 if the table is full or `value` too long.
+int ArmRestoreSlot(int fd, const std::string& value) {
+  if (value.size() >= sizeof(RestoreSlot::value)) {
+    return -1;
+  }
+  InstallRestoreHandlers();
+  for (int i = 0; i < kMaxRestoreSlots; ++i) {
+    RestoreSlot& slot = g_restore_slots[i];
+    int expected = kSlotFree;
+    if (slot.state.compare_exchange_strong(expected, kSlotClaimed)) {
+      slot.fd = fd;
+      std::memcpy(slot.value, value.data(), value.size());
+      slot.length = value.size();
+      slot.state.store(kSlotArmed);
+      return i;
+    }
+  }
+  return -1;
+}
+
+void DisarmRestoreSlot(int index) {
+  int expected = kSlotArmed;
+  g_restore_slots[index].state.compare_exchange_strong(expected, kSlotFree);
+}
+
+}  // namespace
+
+ProcFile::ProcFile(const std::string& path)
+    : path_(path), fd_(open(path.c_str(), O_RDONLY | O_CLOEXEC)) {
+  buffer_.resize(4096);
+}
+
+ProcFile::~ProcFile() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+ProcFile::ProcFile(ProcFile&& other) noexcept
+    : path_(std::move(other.path_)),
+      fd_(std::exchange(other.fd_, -1)),
+      buffer_(std::move(other.buffer_)) {}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept {
+  if (this != &other) {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    path_ = std::move(other.path_);
+    fd_ = std::exchange(other.fd_, -1);
+    buffer_ = std::move(other.buffer_);
+  }
+  return *this;
+}
+
+std::string_view ProcFile::Read() {
+  if (fd_ < 0) {
+    return {};
+  }
+  // Grow until the whole file fits; proc files have no stable size.
+  while (true) {
+    ssize_t bytes = pread(fd_, buffer_.data(), buffer_.size(), 0);
+    if (bytes < 0) {
+      return {};
+    }
+    if (static_cast<size_t>(bytes) < buffer_.size()) {
+      return std::string_view(buffer_.data(), bytes);
+    }
+    buffer_.resize(buffer_.size() * 2);
+  }
+}
+
+bool ReadFileToString(const std::string& path, std::string* contents) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  *contents = buffer.str();
+  return true;
+}
+
+std::string ReadSysfsValue(const std::string& path) {
+  std::string contents;
+  if (!ReadFileToString(path, &contents)) {
+    return "";
+  }
+  contents.erase(contents.find_last_not_of(" \n") + 1);
+  return contents;
+}
+
+int64_t ReadSysfsInt(const std::string& path) {
+  std::string contents;
+  return ReadFileToString(path, &contents) ? ParseInt(contents) : -1;
+}
+
+SysfsOverride::~SysfsOverride() {
+  Restore();
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+SysfsOverride::SysfsOverride(SysfsOverride&& other) noexcept
+    : path_(std::move(other.path_)),
+      saved_(std::move(other.saved_)),
+      fd_(std::exchange(other.fd_, -1)),
+      slot_(std::exchange(other.slot_, -1)),
+      written_(std::exchange(other.written_, false)) {}
+
+SysfsOverride& SysfsOverride::operator=(SysfsOverride&& other) noexcept {
+  if (this != &other) {
+    Restore();
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+    path_ = std::move(other.path_);
+    saved_ = std::move(other.saved_);
+    fd_ = std::exchange(other.fd_, -1);
+    slot_ = std::exchange(other.slot_, -1);
+    written_ = std::exchange(other.written_, false);
+  }
+  return *this;
+}
+
+bool SysfsOverride::Open(const std::string& path) {
+  std::string contents;
+  if (!ReadFileToString(path, &contents)) {
+    return false;
+  }
+  contents.erase(contents.find_last_not_of(" \n") + 1);
+  path_ = path;
+  saved_ = std::move(contents);
+  return true;
+}
+
+bool SysfsOverride::Write(const std::string& value) {
+  if (fd_ < 0) {
+    fd_ = open(path_.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      return false;
+    }
+  }
+  // Armed before the write, so that no signal can leave it unrestored.
+  if (slot_ < 0) {
+    slot_ = ArmRestoreSlot(fd_, saved_);
+  }
+  if (!WriteRaw(fd_, value.data(), value.size())) {
+    const int error = errno;
+    if (!written_ && slot_ >= 0) {
+      DisarmRestoreSlot(slot_);
+      slot_ = -1;
+    }
+    errno = error;
+    return false;
+  }
+  written_ = true;
+  return true;
+}
+
+void SysfsOverride::Restore() {
+  if (slot_ >= 0) {
+    DisarmRestoreSlot(slot_);
+    slot_ = -1;
+  }
+  if (written_) {
+    WriteRaw(fd_, saved_.data(), saved_.size());
+    written_ = false;
+  }
+}
+
+int64_t ParseColonField(std::string_view text, std::string_view key,
+                        int64_t fallback) {
+  std::string_view value = FindLine(text, key, ':');
+  return value.empty() ? fallback : ParseInt(value, fallback);
+}
+
+int64_t ParseSpaceField(std::string_view text, std::string_view key,
+                        int64_t fallback) {
+  std::string_view value = FindLine(text, key, ' ');
+  return value.empty() ? fallback : ParseInt(value, fallback);
+}
+
+int64_t ParseInt(std::string_view text, int64_t fallback) {
+  size_t pos = text.find_first_not_of(" \t");
+  if (pos == std::string_view::npos) {
+    return fallback;
+  }
+  std::string digits(text.substr(pos, 24));
+  char* end = nullptr;
+  long long value = std::strtoll(digits.c_str(), &end, 10);
+  return end == digits.c_str() ? fallback : value;
+}
+
+int64_t ParseStatField(std::string_view stat, int field, int64_t fallback) {
+  // The command name may contain spaces, so counting starts after its ')'.
+  size_t pos = stat.rfind(')');
+  if (field < 3 || pos == std::string_view::npos) {
+    return fallback;
+  }
+  // Field 3 (state) starts two characters after ')'.
+  pos += 2;
+  for (int i = 3; i < field; ++i) {
+    pos = stat.find(' ', pos);
+    if (pos == std::string_view::npos) {
+      return fallback;
+    }
+    ++pos;
+  }
+  return pos < stat.size() ? ParseInt(stat.substr(pos, 24), fallback)
+                           : fallback;
+}
+
+std::string CurrentCgroupDir() {
+  std::string contents;
+  if (!ReadFileToString("/proc/self/cgroup", &contents)) {
+    return "";
+  }
+  // The unified hierarchy is the "0::<path>" line.
+  std::string_view path = FindLine(contents, "0:", ':');
+  if (path.empty()) {
+    return "";
+  }
+  std::string dir = "/sys/fs/cgroup" + std::string(path);
+  if (!dir.empty() && dir.back() == '/') {
+    dir.pop_back();
+  }
+  return dir;
+}
+
+}  // namespace ai_edge_torch::examples
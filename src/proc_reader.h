@@ -0,0 +1,119 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_PROC_READER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_PROC_READER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ai_edge_torch::examples {
+
+// A /proc or sysfs file kept open and re-read with pread(), so repeated
+// sampling costs one syscall and no allocation.
+class ProcFile {
+ public:
+  ProcFile() = default;
+  explicit ProcFile(const std::string& path);
+  ~ProcFile();
+
+  ProcFile(ProcFile&& other) noexcept;
+  ProcFile& operator=(ProcFile&& other) noexcept;
+  ProcFile(const ProcFile&) = delete;
+  ProcFile& operator=(const ProcFile&) = delete;
+
+  bool is_open() const { return fd_ >= 0; }
+  const std::string& path() const { return path_; }
+
+  // Returns the current contents, or an empty view on error. The view stays
+  // valid until the next Read().
+  std::string_view Read();
+
+ private:
+  std::string path_;
+  int fd_ = -1;
+  std::string buffer_;
+};
+
+// Reads a whole small file. Returns false if it cannot be opened.
+bool ReadFileToString(const std::string& path, std::string* contents);
+
+// Reads a one-value sysfs file without its trailing newline, or "" on error.
+std::string ReadSysfsValue(const std::string& path);
+// Reads a sysfs file holding an integer, or -1 on error.
+int64_t ReadSysfsInt(const std::string& path);
+
+// A sysfs attribute (cpufreq limits, say) changed by this process and put
+// back afterwards. Such settings outlive the process, so while a value is
+// written the saved one is also restored from exit() and from SIGINT,
+// SIGTERM and SIGHUP handlers; Restore() and the destructor put it back
+// otherwise. Up to 64 attributes are covered by the handlers at a time.
+// Writes also truncate, which only matters for regular files such as a fake
+// sysfs tree.
+class SysfsOverride {
+ public:
+  SysfsOverride() = default;
+  ~SysfsOverride();
+
+  SysfsOverride(SysfsOverride&& other) noexcept;
+  SysfsOverride& operator=(SysfsOverride&& other) noexcept;
+  SysfsOverride(const SysfsOverride&) = delete;
+  SysfsOverride& operator=(const SysfsOverride&) = delete;
+
+  // Saves the current value of `path`. Returns false if it cannot be read.
+  bool Open(const std::string& path);
+  // Writes `value`, opening the attribute for writing on first use. Returns
+  // false with errno set on error.
+  bool Write(const std::string& value);
+  // Writes the saved value back if Write() changed it.
+  void Restore();
+
+  const std::string& path() const { return path_; }
+  const std::string& saved() const { return saved_; }
+  bool written() const { return written_; }
+
+ private:
+  std::string path_;
+  std::string saved_;
+  int fd_ = -1;
+  // Index in the table the exit and signal paths restore from, -1 if none.
+  int slot_ = -1;
+  bool written_ = false;
+};
+
+// Parses "<key>: <number> ..." lines such as /proc/self/status. Returns
+// `fallback` if `key` is missing.
+int64_t ParseColonField(std::string_view text, std::string_view key,
+                        int64_t fallback = -1);
+
+// Parses "<key> <number>" lines such as cgroup memory.stat.
+int64_t ParseSpaceField(std::string_view text, std::string_view key,
+                        int64_t fallback = -1);
+
+// Parses a file holding a single integer (memory.current, sysfs values).
+int64_t ParseInt(std::string_view text, int64_t fallback = -1);
+
+// Returns field `field` of a /proc/<pid>/stat line, numbered from 1 as in
+// proc(5). Only fields after the command name (field 3 onwards) are numeric.
+int64_t ParseStatField(std::string_view stat, int field, int64_t fallback = -1);
+
+// Directory of this process's cgroup v2 ("/sys/fs/cgroup/<path>"), or "" if
+// the process is not in a unified hierarchy.
+std::string CurrentCgroupDir();
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_PROC_READER_H_
@@ -0,0 +1,323 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/request_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+
+namespace ai_edge_torch::examples {
+
+RequestScheduler::RequestScheduler(SessionBackend* backend,
+                                   std::vector<RequestClass> classes,
+                                   TokenSampler sampler, int stop_token_id,
+                                   Options options)
+    : backend_(backend),
+      classes_(std::move(classes)),
+      sampler_(std::move(sampler)),
+      stop_token_id_(stop_token_id),
+      options_(options),
+      class_stats_(classes_.size()) {
+  options_.max_sessions = std::max(1, options_.max_sessions);
+  options_.quantum_tokens = std::max(1, options_.quantum_tokens);
+  if (options_.prefill_chunk <= 0 ||
+      options_.prefill_chunk > backend_->max_prefill_tokens()) {
+    options_.prefill_chunk = backend_->max_prefill_tokens();
+  }
+  MINIMAL_CHECK(options_.prefill_chunk > 0);
+}
+
+void RequestScheduler::Submit(ServingRequest request) {
+  MINIMAL_CHECK(!request.prompt_tokens.empty());
+  MINIMAL_CHECK(static_cast<int>(request.prompt_tokens.size()) <
+                backend_->kv_cache_max_size());
+  MINIMAL_CHECK(request.class_index >= 0 &&
+                request.class_index < static_cast<int>(classes_.size()));
+  ++class_stats_[request.class_index].submitted;
+  auto it = std::upper_bound(pending_.begin(), pending_.end(), request,
+                             [](const ServingRequest& a,
+                                const ServingRequest& b) {
+                               return a.arrival_ms < b.arrival_ms;
+                             });
+  pending_.insert(it, std::move(request));
+}
+
+double RequestScheduler::NowMs() const {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start_)
+      .count();
+}
+
+void RequestScheduler::Admit(double now_ms) {
+  while (!pending_.empty() && pending_.front().arrival_ms <= now_ms) {
+    waiting_.push_back(std::move(pending_.front()));
+    pending_.pop_front();
+  }
+  if (!accepting_) {
+    for (const ServingRequest& request : waiting_) {
+      ++class_stats_[request.class_index].refused;
+      ++stats_.refused;
+    }
+    waiting_.clear();
+    return;
+  }
+  // Higher classes first, each in arrival order.
+  std::stable_sort(waiting_.begin(), waiting_.end(),
+                   [&](const ServingRequest& a, const ServingRequest& b) {
+                     return classes_[a.class_index].priority >
+                            classes_[b.class_index].priority;
+                   });
+  for (auto it = waiting_.begin(); it != waiting_.end();) {
+    const int priority = classes_[it->class_index].priority;
+    int occupied = 0;
+    for (const auto& session : sessions_) {
+      occupied += classes_[session->class_index].priority >= priority ? 1 : 0;
+    }
+    if (occupied >= options_.max_sessions) {
+      ++it;
+      continue;
+    }
+    auto session = std::make_unique<ServingSession>();
+    session->request_id = it->id;
+    session->class_index = it->class_index;
+    session->prompt_tokens = std::move(it->prompt_tokens);
+    const int prompt_size = static_cast<int>(session->prompt_tokens.size());
+    session->next_token = session->prompt_tokens.back();
+    session->next_position = prompt_size - 1;
+    session->remaining = std::min(
+        it->max_new_tokens, backend_->kv_cache_max_size() - prompt_size);
+    if (token_cap_ >= 0) {
+      session->remaining = std::min(session->remaining, token_cap_);
+    }
+    if (!free_caches_.empty()) {
+      session->kv_cache = std::move(free_caches_.back());
+      free_caches_.pop_back();
+    } else {
+      session->kv_cache = backend_->NewKVCache();
+    }
+    session->arrival_ms = it->arrival_ms;
+    session->admitted_ms = now_ms;
+    class_stats_[it->class_index].queue.Record(now_ms - it->arrival_ms);
+    sessions_.push_back(std::move(session));
+    it = waiting_.erase(it);
+  }
+}
+
+double RequestScheduler::NextDeadline(const ServingSession& session) const {
+  const RequestClass& request_class = classes_[session.class_index];
+  if (session.first_token_ms < 0) {
+    return request_class.ttft_deadline_ms > 0
+               ? session.arrival_ms + request_class.ttft_deadline_ms
+               : std::numeric_limits<double>::infinity();
+  }
+  return request_class.token_deadline_ms > 0
+             ? session.last_token_ms + request_class.token_deadline_ms
+             : std::numeric_limits<double>::infinity();
+}
+
+size_t RequestScheduler::ReleaseIdleCaches() {
+  size_t bytes = 0;
+  for (const KVCache& cache : free_caches_) {
+    for (const auto& [name, buffer] : cache) {
+      bytes += buffer.size() * sizeof(float);
+    }
+  }
+  free_caches_.clear();
+  free_caches_.shrink_to_fit();
+  return bytes;
+}
+
+void RequestScheduler::CapNewTokens(int max_new_tokens) {
+  token_cap_ = max_new_tokens;
+  if (max_new_tokens < 0) {
+    return;
+  }
+  for (const auto& session : sessions_) {
+    session->remaining = std::min(session->remaining, max_new_tokens);
+  }
+}
+
+bool RequestScheduler::Outranks(const ServingSession& a,
+                                const ServingSession& b) const {
+  const int priority_a = classes_[a.class_index].priority;
+  const int priority_b = classes_[b.class_index].priority;
+  if (priority_a != priority_b) {
+    return priority_a > priority_b;
+  }
+  return NextDeadline(a) < NextDeadline(b);
+}
+
+bool RequestScheduler::Step(ServingSession* session) {
+  if (!session->prefilled()) {
+    const int count = std::min(
+        options_.prefill_chunk,
+        static_cast<int>(session->prompt_tokens.size()) - 1 -
+            session->num_prefilled);
+    backend_->Prefill(session->prompt_tokens.data() + session->num_prefilled,
+                      count, session->num_prefilled);
+    session->num_prefilled += count;
+    ++stats_.prefill_chunks;
+    return false;
+  }
+
+  int vocab_size = 0;
+  const float* logits =
+      backend_->Decode(session->next_token, session->next_position, &vocab_size);
+  const int token = sampler_(logits, vocab_size);
+  ++stats_.decode_steps;
+
+  ClassStats& class_stats = class_stats_[session->class_index];
+  const double now_ms = NowMs();
+  const double deadline_ms = NextDeadline(*session);
+  if (deadline_ms < std::numeric_limits<double>::infinity()) {
+    ++class_stats.deadlines;
+    class_stats.deadline_misses += now_ms > deadline_ms ? 1 : 0;
+  }
+  if (session->first_token_ms < 0) {
+    session->first_token_ms = now_ms;
+    class_stats.ttft.Record(now_ms - session->arrival_ms);
+  } else {
+    class_stats.token.Record(now_ms - session->last_token_ms);
+  }
+  session->last_token_ms = now_ms;
+  session->next_position++;
+  if (token == stop_token_id_) {
+    return true;
+  }
+  session->output_tokens.push_back(token);
+  session->next_token = token;
+  ++class_stats.tokens;
+  return --session->remaining <= 0;
+}
+
+void RequestScheduler::Run(
+    const std::function<void(const ServingSession&)>& on_finish) {
+  start_ = Clock::now();
+  ServingSession* current = nullptr;
+  int slice = 0;
+  while (!pending_.empty() || !waiting_.empty() || !sessions_.empty()) {
+    if (step_hook_) {
+      step_hook_();
+    }
+    const double now_ms = NowMs();
+    Admit(now_ms);
+    if (sessions_.empty()) {
+      if (!pending_.empty()) {
+        const double wait_ms = pending_.front().arrival_ms - now_ms;
+        std::this_thread::sleep_for(
+            std::chrono::duration<double, std::milli>(wait_ms));
+        stats_.idle_ms += std::max(0.0, wait_ms);
+      }
+      continue;
+    }
+
+    ServingSession* next = nullptr;
+    for (const auto& session : sessions_) {
+      if (next == nullptr || Outranks(*session, *next) ||
+          (!Outranks(*next, *session) && session->last_run < next->last_run)) {
+        next = session.get();
+      }
+    }
+    if (current != nullptr && next != current) {
+      if (slice < options_.quantum_tokens && !Outranks(*next, *current)) {
+        next = current;
+      } else if (slice < options_.quantum_tokens) {
+        ++current->preemptions;
+        ++class_stats_[current->class_index].preemptions;
+        ++stats_.preemptions;
+      }
+    }
+    if (next != current) {
+      current = next;
+      slice = 0;
+    }
+    if (bound_request_ != current->request_id) {
+      backend_->Bind(&current->kv_cache);
+      bound_request_ = current->request_id;
+      ++stats_.switches;
+    }
+    current->last_run = round_++;
+    ++slice;
+
+    if (Step(current)) {
+      ClassStats& class_stats = class_stats_[current->class_index];
+      ++class_stats.completed;
+      class_stats.total.Record(current->last_token_ms - current->arrival_ms);
+      on_finish(*current);
+      free_caches_.push_back(std::move(current->kv_cache));
+      sessions_.erase(std::find_if(
+          sessions_.begin(), sessions_.end(),
+          [&](const auto& session) { return session.get() == current; }));
+      current = nullptr;
+      bound_request_ = -1;
+    }
+  }
+  stats_.total_time_ms = NowMs();
+}
+
+void RequestScheduler::PrintReport(std::ostream& out) const {
+  int completed = 0;
+  for (const ClassStats& class_stats : class_stats_) {
+    completed += class_stats.completed;
+  }
+  out << std::fixed << std::setprecision(1);
+  out << "[SERVE] " << completed << " requests in " << stats_.total_time_ms
+      << " ms (idle " << stats_.idle_ms << " ms): " << stats_.prefill_chunks
+      << " prefill chunks, " << stats_.decode_steps << " decode steps, "
+      << stats_.switches << " session switches, " << stats_.preemptions
+      << " preemptions";
+  if (stats_.refused > 0) {
+    out << ", " << stats_.refused << " refused";
+  }
+  out << "\n";
+  out << "  " << std::left << std::setw(12) << "class" << std::right
+      << std::setw(5) << "prio" << std::setw(6) << "done" << std::setw(8)
+      << "tokens" << std::setw(11) << "queue p50" << std::setw(10)
+      << "TTFT p50" << std::setw(10) << "TTFT p99" << std::setw(11)
+      << "token p50" << std::setw(11) << "token p99" << std::setw(13)
+      << "missed" << std::setw(11) << "preempted" << "\n";
+  for (size_t i = 0; i < classes_.size(); ++i) {
+    const ClassStats& class_stats = class_stats_[i];
+    if (class_stats.submitted == 0) {
+      continue;
+    }
+    out << "  " << std::left << std::setw(12) << classes_[i].name << std::right
+        << std::setw(5) << classes_[i].priority << std::setw(6)
+        << class_stats.completed << std::setw(8) << class_stats.tokens
+        << std::setw(11) << class_stats.queue.Percentile(50) << std::setw(10)
+        << class_stats.ttft.Percentile(50) << std::setw(10)
+        << class_stats.ttft.Percentile(99) << std::setw(11)
+        << class_stats.token.Percentile(50) << std::setw(11)
+        << class_stats.token.Percentile(99) << std::setw(13)
+        << (std::to_string(class_stats.deadline_misses) + "/" +
+            std::to_string(class_stats.deadlines))
+        << std::setw(11) << class_stats.preemptions << "\n";
+  }
+  out << "  (latencies in ms; missed counts first tokens and token gaps past "
+         "their class deadline)\n";
+  out << std::defaultfloat;
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,225 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_REQUEST_SCHEDULER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_REQUEST_SCHEDULER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/latency_histogram.h"
+#include "ai_edge_torch/generative/examples/cpp/speculative_decoder.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+
+namespace ai_edge_torch::examples {
+
+// Priority and latency targets shared by a class of requests.
+struct RequestClass {
+  std::string name;
+  // Higher runs first; a runnable session is never passed over for one of
+  // lower priority.
+  int priority = 0;
+  // Targets for the first token after arrival and for the gap between later
+  // tokens; 0 means none. Among equal priorities the earliest deadline runs
+  // first.
+  double ttft_deadline_ms = 0.0;
+  double token_deadline_ms = 0.0;
+};
+
+// One prompt arriving `arrival_ms` after RequestScheduler::Run() starts.
+struct ServingRequest {
+  int id = 0;
+  int class_index = 0;
+  double arrival_ms = 0.0;
+  std::vector<int> prompt_tokens;
+  int max_new_tokens = 0;
+};
+
+// Runs prefill chunks and decode steps on behalf of the scheduler. Each
+// session owns a KV cache; Bind() points the model at one of them, which is
+// all it takes to switch sessions at a token boundary.
+class SessionBackend {
+ public:
+  virtual ~SessionBackend() = default;
+
+  virtual KVCache NewKVCache() = 0;
+  virtual void Bind(KVCache* kv_cache) = 0;
+
+  // Longest chunk Prefill() accepts.
+  virtual int max_prefill_tokens() const = 0;
+  virtual int kv_cache_max_size() const = 0;
+
+  // Writes `count` tokens at positions [start_position, start_position +
+  // count) into the bound cache.
+  virtual void Prefill(const int* tokens, int count, int start_position) = 0;
+  // Feeds `token` at `position` and returns the logits row, valid until the
+  // next call.
+  virtual const float* Decode(int token, int position, int* vocab_size) = 0;
+};
+
+struct ServingSession {
+  int request_id = -1;
+  int class_index = 0;
+  std::vector<int> prompt_tokens;
+  // Prompt tokens already in the KV cache. All but the last are prefilled;
+  // the last is fed to the first decode step.
+  int num_prefilled = 0;
+  int next_token = 0;
+  int next_position = 0;
+  int remaining = 0;
+  std::vector<int> output_tokens;
+  KVCache kv_cache;
+  // Offsets from the start of Run(), in ms.
+  double arrival_ms = 0.0;
+  double admitted_ms = 0.0;
+  double first_token_ms = -1.0;
+  double last_token_ms = 0.0;
+  int preemptions = 0;
+  // Scheduling round of the last slice, for round-robin among equals.
+  long long last_run = -1;
+
+  bool prefilled() const {
+    return num_prefilled + 1 >= static_cast<int>(prompt_tokens.size());
+  }
+};
+
+// Time-slices prefill chunks and decode steps of many sessions on one model.
+//
+// At every token boundary the scheduler picks the runnable session with the
+// highest class priority, then the earliest deadline, then the one that ran
+// least recently. The running session keeps the model for up to
+// `quantum_tokens` steps unless a session with a higher priority or an
+// earlier deadline becomes runnable, in which case it is preempted: its
+// next_token, next_position and KV cache stay in its session and it resumes
+// where it stopped. Long prompts are prefilled in chunks of `prefill_chunk`
+// tokens, each chunk one step, so a background prompt delays an interactive
+// token by one chunk at most.
+//
+// Sessions keep their KV cache until they finish. At most `max_sessions`
+// sessions of a given priority or higher are admitted at once, so higher
+// classes never wait for a slot held by a lower one; caches are reused
+// across sessions.
+class RequestScheduler {
+ public:
+  struct Options {
+    int max_sessions = 4;
+    int prefill_chunk = 64;
+    int quantum_tokens = 4;
+  };
+
+  struct ClassStats {
+    int submitted = 0;
+    int completed = 0;
+    int refused = 0;
+    int tokens = 0;
+    int preemptions = 0;
+    // Deadlines checked and missed, over first tokens and token gaps.
+    int deadlines = 0;
+    int deadline_misses = 0;
+    LatencyHistogram queue;  // Arrival to admission.
+    LatencyHistogram ttft;   // Arrival to first token.
+    LatencyHistogram token;  // Between tokens, including time preempted.
+    LatencyHistogram total;  // Arrival to last token.
+  };
+
+  struct Stats {
+    int prefill_chunks = 0;
+    int decode_steps = 0;
+    int switches = 0;
+    int preemptions = 0;
+    int refused = 0;
+    double idle_ms = 0.0;
+    double total_time_ms = 0.0;
+  };
+
+  RequestScheduler(SessionBackend* backend, std::vector<RequestClass> classes,
+                   TokenSampler sampler, int stop_token_id, Options options);
+
+  // Prompts must be shorter than the KV cache.
+  void Submit(ServingRequest request);
+
+  // Runs until every submitted request has finished, sleeping while nothing
+  // has arrived. `on_finish` is called with each finished session.
+  void Run(const std::function<void(const ServingSession&)>& on_finish);
+
+  // Degradation hooks for memory pressure; safe to call from the step hook.
+  //
+  // Frees the KV caches kept for reuse and returns the bytes released.
+  size_t ReleaseIdleCaches();
+  // Lets running and later sessions generate at most `max_new_tokens` more
+  // tokens; a negative value lifts the cap for later sessions.
+  void CapNewTokens(int max_new_tokens);
+  // While closed, requests that have not been admitted are refused.
+  void SetAccepting(bool accepting) { accepting_ = accepting; }
+
+  // Called before every step, at a token boundary.
+  void SetStepHook(std::function<void()> hook) { step_hook_ = std::move(hook); }
+
+  const Stats& stats() const { return stats_; }
+  const std::vector<RequestClass>& classes() const { return classes_; }
+  const std::vector<ClassStats>& class_stats() const { return class_stats_; }
+
+  // One [SERVE] table row per class: queueing, TTFT and inter-token
+  // percentiles, deadline misses and preemptions.
+  void PrintReport(std::ostream& out) const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  double NowMs() const;
+  // Moves arrived requests into sessions while there is room.
+  void Admit(double now_ms);
+  // Deadline of the session's next token, or +inf.
+  double NextDeadline(const ServingSession& session) const;
+  // True if `a` has a higher priority than `b`, or the same priority and an
+  // earlier deadline. Such a session preempts `b` mid-quantum.
+  bool Outranks(const ServingSession& a, const ServingSession& b) const;
+  // Runs one prefill chunk or decode step of `session`. Returns true when
+  // the session has finished.
+  bool Step(ServingSession* session);
+
+  SessionBackend* backend_;
+  std::vector<RequestClass> classes_;
+  TokenSampler sampler_;
+  const int stop_token_id_;
+  Options options_;
+
+  Clock::time_point start_;
+  // Not yet arrived, by arrival time; then arrived but not admitted.
+  std::deque<ServingRequest> pending_;
+  std::vector<ServingRequest> waiting_;
+  std::vector<std::unique_ptr<ServingSession>> sessions_;
+  std::vector<KVCache> free_caches_;
+  // Request whose cache the backend is bound to, or -1.
+  int bound_request_ = -1;
+  long long round_ = 0;
+  bool accepting_ = true;
+  int token_cap_ = -1;
+  std::function<void()> step_hook_;
+
+  Stats stats_;
+  std::vector<ClassStats> class_stats_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_REQUEST_SCHEDULER_H_
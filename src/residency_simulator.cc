@@ -0,0 +1,466 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/residency_simulator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+// State and statistics shared by every policy.
+class Residency {
+ public:
+  Residency(uint32_t num_blocks, uint32_t capacity, SimulationResult* result)
+      : capacity_(capacity),
+        resident_(num_blocks, 0),
+        dirty_(num_blocks, 0),
+        prefetched_(num_blocks, 0),
+        result_(result) {}
+
+  bool resident(uint32_t block) const { return resident_[block]; }
+  bool full() const { return size_ >= capacity_; }
+  uint32_t capacity() const { return capacity_; }
+
+  void Insert(uint32_t block, bool prefetch) {
+    resident_[block] = 1;
+    prefetched_[block] = prefetch;
+    ++size_;
+  }
+  void Touch(uint32_t block, bool write) {
+    prefetched_[block] = 0;
+    if (write) {
+      dirty_[block] = 1;
+    }
+  }
+  void Evict(uint32_t block) {
+    if (dirty_[block]) {
+      ++result_->dirty_evictions;
+    }
+    if (prefetched_[block]) {
+      ++result_->wasted_prefetches;
+    }
+    resident_[block] = dirty_[block] = prefetched_[block] = 0;
+    --size_;
+  }
+
+ private:
+  const uint32_t capacity_;
+  uint32_t size_ = 0;
+  std::vector<uint8_t> resident_;
+  std::vector<uint8_t> dirty_;
+  std::vector<uint8_t> prefetched_;
+  SimulationResult* result_;
+};
+
+// Recency list threaded through per-block arrays; index num_blocks is the
+// sentinel, its next is the most recently used block.
+class LruCache {
+ public:
+  static constexpr bool kNeedsNextUse = false;
+
+  LruCache(uint32_t num_blocks, uint32_t capacity, SimulationResult* result)
+      : state_(num_blocks, capacity, result),
+        sentinel_(num_blocks),
+        prev_(num_blocks + 1, num_blocks),
+        next_(num_blocks + 1, num_blocks) {}
+
+  bool Access(uint32_t block, bool write, uint64_t /*next_use*/) {
+    const bool hit = state_.resident(block);
+    if (hit) {
+      Unlink(block);
+    } else {
+      Load(block, /*prefetch=*/false);
+    }
+    PushFront(block);
+    state_.Touch(block, write);
+    return hit;
+  }
+
+  // Returns true if the block had to be read.
+  bool Prefetch(uint32_t block) {
+    if (state_.resident(block)) {
+      Unlink(block);
+      PushFront(block);
+      return false;
+    }
+    Load(block, /*prefetch=*/true);
+    PushFront(block);
+    return true;
+  }
+
+ private:
+  void Load(uint32_t block, bool prefetch) {
+    if (state_.full()) {
+      const uint32_t victim = prev_[sentinel_];
+      Unlink(victim);
+      state_.Evict(victim);
+    }
+    state_.Insert(block, prefetch);
+  }
+  void Unlink(uint32_t block) {
+    next_[prev_[block]] = next_[block];
+    prev_[next_[block]] = prev_[block];
+  }
+  void PushFront(uint32_t block) {
+    prev_[block] = sentinel_;
+    next_[block] = next_[sentinel_];
+    prev_[next_[sentinel_]] = block;
+    next_[sentinel_] = block;
+  }
+
+  Residency state_;
+  const uint32_t sentinel_;
+  std::vector<uint32_t> prev_;
+  std::vector<uint32_t> next_;
+};
+
+// Second-chance replacement over a fixed ring of frames.
+class ClockCache {
+ public:
+  static constexpr bool kNeedsNextUse = false;
+
+  ClockCache(uint32_t num_blocks, uint32_t capacity, SimulationResult* result)
+      : state_(num_blocks, capacity, result), referenced_(num_blocks, 0) {
+    frames_.reserve(std::min(capacity, num_blocks));
+  }
+
+  bool Access(uint32_t block, bool write, uint64_t /*next_use*/) {
+    const bool hit = state_.resident(block);
+    if (!hit) {
+      if (frames_.size() < state_.capacity()) {
+        frames_.push_back(block);
+      } else {
+        while (referenced_[frames_[hand_]]) {
+          referenced_[frames_[hand_]] = 0;
+          hand_ = (hand_ + 1) % frames_.size();
+        }
+        state_.Evict(frames_[hand_]);
+        frames_[hand_] = block;
+        hand_ = (hand_ + 1) % frames_.size();
+      }
+      state_.Insert(block, /*prefetch=*/false);
+    }
+    referenced_[block] = 1;
+    state_.Touch(block, write);
+    return hit;
+  }
+
+ private:
+  Residency state_;
+  std::vector<uint8_t> referenced_;
+  std::vector<uint32_t> frames_;
+  size_t hand_ = 0;
+};
+
+// Optimal offline replacement. A max-heap keyed by next use holds stale
+// entries that are skipped on eviction and dropped by periodic rebuilds.
+class BeladyCache {
+ public:
+  static constexpr bool kNeedsNextUse = true;
+
+  BeladyCache(uint32_t num_blocks, uint32_t capacity, SimulationResult* result)
+      : state_(num_blocks, capacity, result),
+        next_use_(num_blocks, kNever),
+        slot_(num_blocks, 0),
+        can_evict_(capacity < num_blocks) {}
+
+  bool Access(uint32_t block, bool write, uint64_t next_use) {
+    const bool hit = state_.resident(block);
+    if (!hit) {
+      if (state_.full()) {
+        EvictFurthest();
+      }
+      state_.Insert(block, /*prefetch=*/false);
+      slot_[block] = static_cast<uint32_t>(residents_.size());
+      residents_.push_back(block);
+    }
+    next_use_[block] = next_use;
+    // With room for every block nothing is ever evicted; skip the heap.
+    if (can_evict_) {
+      heap_.emplace_back(next_use, block);
+      std::push_heap(heap_.begin(), heap_.end());
+      if (heap_.size() > 4 * static_cast<size_t>(state_.capacity()) + 4096) {
+        Rebuild();
+      }
+    }
+    state_.Touch(block, write);
+    return hit;
+  }
+
+ private:
+  void EvictFurthest() {
+    while (!heap_.empty()) {
+      const auto [use, block] = heap_.front();
+      std::pop_heap(heap_.begin(), heap_.end());
+      heap_.pop_back();
+      if (state_.resident(block) && next_use_[block] == use) {
+        const uint32_t last = residents_.back();
+        residents_[slot_[block]] = last;
+        slot_[last] = slot_[block];
+        residents_.pop_back();
+        state_.Evict(block);
+        return;
+      }
+    }
+  }
+  void Rebuild() {
+    heap_.clear();
+    for (uint32_t block : residents_) {
+      heap_.emplace_back(next_use_[block], block);
+    }
+    std::make_heap(heap_.begin(), heap_.end());
+  }
+
+  Residency state_;
+  std::vector<uint64_t> next_use_;
+  std::vector<uint32_t> slot_;
+  std::vector<uint32_t> residents_;
+  std::vector<std::pair<uint64_t, uint32_t>> heap_;
+  const bool can_evict_;
+};
+
+// Pass 0 is prefill (possibly empty); passes 1..decode_steps are decode.
+class Replay {
+ public:
+  explicit Replay(const ReplayTrace& trace) : trace_(trace) {}
+
+  int num_passes() const { return 1 + trace_.decode_steps; }
+  const BlockTrace& pass(int p) const {
+    return p == 0 ? trace_.prefill : trace_.decode;
+  }
+  uint64_t offset(int p) const {
+    return p == 0 ? 0
+                  : trace_.prefill.refs.size() +
+                        (p - 1) * static_cast<uint64_t>(trace_.decode.refs.size());
+  }
+
+  // Time of the next reference to `block` after position `i` of pass `p`.
+  uint64_t NextUse(int p, size_t i, uint32_t block) const {
+    const int64_t next = pass(p).next_in_pass[i];
+    if (next >= 0) {
+      return offset(p) + next;
+    }
+    if (p + 1 < num_passes() && trace_.decode.first_position[block] >= 0) {
+      return offset(p + 1) + trace_.decode.first_position[block];
+    }
+    return kNever;
+  }
+
+  // Maps a node number counted over all passes to (pass, node).
+  std::pair<int, size_t> Locate(uint64_t global_node) const {
+    const size_t prefill_nodes = trace_.prefill.num_nodes();
+    if (global_node < prefill_nodes) {
+      return {0, global_node};
+    }
+    const size_t decode_nodes = std::max<size_t>(trace_.decode.num_nodes(), 1);
+    global_node -= prefill_nodes;
+    return {1 + static_cast<int>(global_node / decode_nodes),
+            global_node % decode_nodes};
+  }
+  uint64_t total_nodes() const {
+    return trace_.prefill.num_nodes() +
+           static_cast<uint64_t>(trace_.decode_steps) *
+               trace_.decode.num_nodes();
+  }
+
+ private:
+  const ReplayTrace& trace_;
+};
+
+template <typename Cache>
+void Run(const ReplayTrace& trace, int prefetch_depth, Cache* cache,
+         SimulationResult* result) {
+  const Replay replay(trace);
+  uint64_t global_node = 0;
+  uint64_t prefetch_cursor = 1;
+  for (int p = 0; p < replay.num_passes(); ++p) {
+    const BlockTrace& pass = replay.pass(p);
+    const bool decoding = p > 0;
+    for (size_t n = 0; n < pass.num_nodes(); ++n, ++global_node) {
+      if constexpr (std::is_same_v<Cache, LruCache>) {
+        // Keep the blocks of the next `prefetch_depth` nodes in flight.
+        const uint64_t target = std::min(global_node + prefetch_depth,
+                                         replay.total_nodes() - 1);
+        for (prefetch_cursor = std::max(prefetch_cursor, global_node + 1);
+             prefetch_depth > 0 && prefetch_cursor <= target;
+             ++prefetch_cursor) {
+          const auto [ahead_pass, ahead_node] = replay.Locate(prefetch_cursor);
+          const BlockTrace& ahead = replay.pass(ahead_pass);
+          for (uint32_t i = ahead.node_starts[ahead_node];
+               i < ahead.node_starts[ahead_node + 1]; ++i) {
+            if (cache->Prefetch(ahead.refs[i] & ~kWriteBit)) {
+              ++result->prefetches;
+              result->decode_prefetches += decoding;
+            }
+          }
+        }
+      }
+      for (uint32_t i = pass.node_starts[n]; i < pass.node_starts[n + 1]; ++i) {
+        const uint32_t block = pass.refs[i] & ~kWriteBit;
+        const bool write = (pass.refs[i] & kWriteBit) != 0;
+        uint64_t next_use = 0;
+        if constexpr (Cache::kNeedsNextUse) {
+          next_use = replay.NextUse(p, i, block);
+        }
+        ++result->references;
+        if (!cache->Access(block, write, next_use)) {
+          ++result->faults;
+          result->decode_faults += decoding;
+        }
+      }
+    }
+  }
+}
+
+void FillPassIndex(uint32_t num_blocks, BlockTrace* pass) {
+  std::vector<int64_t> seen(num_blocks, -1);
+  pass->next_in_pass.assign(pass->refs.size(), -1);
+  for (size_t i = pass->refs.size(); i-- > 0;) {
+    const uint32_t block = pass->refs[i] & ~kWriteBit;
+    pass->next_in_pass[i] = seen[block];
+    seen[block] = static_cast<int64_t>(i);
+  }
+  pass->first_position = std::move(seen);
+}
+
+}  // namespace
+
+const char* ResidencyPolicyName(ResidencyPolicy policy) {
+  switch (policy) {
+    case ResidencyPolicy::kLru:
+      return "lru";
+    case ResidencyPolicy::kClock:
+      return "clock";
+    case ResidencyPolicy::kBelady:
+      return "belady";
+    case ResidencyPolicy::kPlanPrefetch:
+      return "prefetch";
+  }
+  return "unknown";
+}
+
+bool ParseResidencyPolicy(std::string_view name, ResidencyPolicy* policy) {
+  for (ResidencyPolicy candidate :
+       {ResidencyPolicy::kLru, ResidencyPolicy::kClock, ResidencyPolicy::kBelady,
+        ResidencyPolicy::kPlanPrefetch}) {
+    if (name == ResidencyPolicyName(candidate)) {
+      *policy = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+ReplayTrace BuildReplayTrace(const SubgraphPlan* prefill,
+                             const SubgraphPlan& decode, uint64_t block_size,
+                             bool weights_only, int decode_steps) {
+  ReplayTrace trace;
+  trace.block_size = block_size;
+  trace.decode_steps = decode_steps;
+
+  std::unordered_map<uint64_t, uint32_t> block_ids;
+  auto build = [&](const SubgraphPlan& subgraph, BlockTrace* pass) {
+    auto touch = [&](int32_t id, bool write) {
+      if (id < 0 || id >= static_cast<int32_t>(subgraph.tensors.size())) {
+        return;
+      }
+      const PlanTensor& tensor = subgraph.tensors[id];
+      if (tensor.bytes == 0 || tensor.address == 0 ||
+          (weights_only && tensor.allocation != TensorAllocation::kMmap)) {
+        return;
+      }
+      const uint64_t first = tensor.address / block_size;
+      const uint64_t last = (tensor.address + tensor.bytes - 1) / block_size;
+      for (uint64_t b = first; b <= last; ++b) {
+        const uint32_t dense =
+            block_ids.try_emplace(b, static_cast<uint32_t>(block_ids.size()))
+                .first->second;
+        pass->refs.push_back(write ? (dense | kWriteBit) : dense);
+      }
+    };
+    for (const PlanNode& node : subgraph.nodes) {
+      pass->node_starts.push_back(static_cast<uint32_t>(pass->refs.size()));
+      for (int32_t id : node.inputs) {
+        touch(id, false);
+      }
+      for (const auto* ids : {&node.intermediates, &node.temporaries,
+                              &node.outputs}) {
+        for (int32_t id : *ids) {
+          touch(id, true);
+        }
+      }
+    }
+    pass->node_starts.push_back(static_cast<uint32_t>(pass->refs.size()));
+  };
+
+  if (prefill != nullptr) {
+    build(*prefill, &trace.prefill);
+  }
+  build(decode, &trace.decode);
+  trace.num_blocks = static_cast<uint32_t>(block_ids.size());
+  FillPassIndex(trace.num_blocks, &trace.prefill);
+  FillPassIndex(trace.num_blocks, &trace.decode);
+  return trace;
+}
+
+SimulationResult SimulateResidency(const ReplayTrace& trace,
+                                   const SimulationConfig& config) {
+  SimulationResult result;
+  result.config = config;
+  result.block_size = trace.block_size;
+  const uint32_t capacity = static_cast<uint32_t>(std::clamp<uint64_t>(
+      config.budget_bytes / trace.block_size, 1,
+      std::numeric_limits<uint32_t>::max()));
+
+  switch (config.policy) {
+    case ResidencyPolicy::kLru: {
+      LruCache cache(trace.num_blocks, capacity, &result);
+      Run(trace, /*prefetch_depth=*/0, &cache, &result);
+      break;
+    }
+    case ResidencyPolicy::kPlanPrefetch: {
+      LruCache cache(trace.num_blocks, capacity, &result);
+      Run(trace, config.prefetch_depth, &cache, &result);
+      break;
+    }
+    case ResidencyPolicy::kClock: {
+      ClockCache cache(trace.num_blocks, capacity, &result);
+      Run(trace, 0, &cache, &result);
+      break;
+    }
+    case ResidencyPolicy::kBelady: {
+      BeladyCache cache(trace.num_blocks, capacity, &result);
+      Run(trace, 0, &cache, &result);
+      break;
+    }
+  }
+  result.read_bytes = (result.faults + result.prefetches) * trace.block_size;
+  result.written_bytes = result.dirty_evictions * trace.block_size;
+  return result;
+}
+
+}  // namespace ai_edge_torch::examples
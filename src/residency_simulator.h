@@ -0,0 +1,105 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_RESIDENCY_SIMULATOR_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_RESIDENCY_SIMULATOR_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+
+namespace ai_edge_torch::examples {
+
+// Replays an execution-plan dump block by block against a fixed RAM budget
+// to compare page-residency policies offline.
+//
+// The replay is one prefill pass followed by `decode_steps` passes over the
+// decode subgraph. Every tensor a node reads or writes touches the blocks
+// spanning [address, address + bytes). Tensors are identified by address, so
+// weights shared between subgraphs map to the same blocks.
+
+enum class ResidencyPolicy {
+  kLru,
+  kClock,
+  kBelady,        // Evicts the block reused furthest in the future (optimal).
+  kPlanPrefetch,  // LRU plus prefetch of the next nodes' blocks.
+};
+
+const char* ResidencyPolicyName(ResidencyPolicy policy);
+// Accepts "lru", "clock", "belady" and "prefetch".
+bool ParseResidencyPolicy(std::string_view name, ResidencyPolicy* policy);
+
+// Block references of one pass over a subgraph.
+struct BlockTrace {
+  // Dense block ids in access order; the top bit marks a write.
+  std::vector<uint32_t> refs;
+  // refs[node_starts[n], node_starts[n + 1]) belong to plan step n.
+  std::vector<uint32_t> node_starts;
+  // Next position of the same block in this pass, or -1.
+  std::vector<int64_t> next_in_pass;
+  // First position of each block in this pass, or -1; indexed by block id.
+  std::vector<int64_t> first_position;
+
+  size_t num_nodes() const {
+    return node_starts.empty() ? 0 : node_starts.size() - 1;
+  }
+};
+
+struct ReplayTrace {
+  uint64_t block_size = 0;
+  uint32_t num_blocks = 0;  // Distinct blocks over both passes.
+  BlockTrace prefill;       // Empty if no prefill subgraph was given.
+  BlockTrace decode;
+  int decode_steps = 0;
+};
+
+constexpr uint32_t kWriteBit = 0x80000000u;
+
+// Builds the block reference strings. With `weights_only`, only read-only
+// (mmap) tensors are paged, which models weight residency with the
+// activation arena pinned. `prefill` may be null.
+ReplayTrace BuildReplayTrace(const SubgraphPlan* prefill,
+                             const SubgraphPlan& decode, uint64_t block_size,
+                             bool weights_only, int decode_steps);
+
+struct SimulationConfig {
+  ResidencyPolicy policy = ResidencyPolicy::kLru;
+  uint64_t budget_bytes = 0;
+  int prefetch_depth = 4;  // Nodes ahead, for kPlanPrefetch.
+};
+
+struct SimulationResult {
+  SimulationConfig config;
+  uint64_t block_size = 0;
+  uint64_t references = 0;
+  uint64_t faults = 0;         // Demand misses over the whole replay.
+  uint64_t decode_faults = 0;  // Demand misses during decode passes.
+  uint64_t prefetches = 0;     // Blocks read ahead of use.
+  uint64_t decode_prefetches = 0;
+  uint64_t wasted_prefetches = 0;  // Prefetched, then evicted unused.
+  uint64_t dirty_evictions = 0;
+  uint64_t read_bytes = 0;
+  uint64_t written_bytes = 0;
+};
+
+SimulationResult SimulateResidency(const ReplayTrace& trace,
+                                   const SimulationConfig& config);
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_RESIDENCY_SIMULATOR_H_
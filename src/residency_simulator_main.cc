@@ -0,0 +1,273 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Offline replay of a --dump_execution_plan binary dump against RAM budgets,
+// block sizes and residency policies. Every combination is simulated on a
+// worker pool and reported as demand faults and projected I/O per token.
+//
+//   residency_simulator --plan=out/plan.bin --budgets_mb=512,1024,2048
+//       --block_sizes_kb=4,64,2048 --decode_steps=128
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+#include "ai_edge_torch/generative/examples/cpp/residency_simulator.h"
+
+ABSL_FLAG(std::string, plan, "", "Binary execution plan written by --dump_execution_plan.");
+ABSL_FLAG(std::string, decode_subgraph, "decode",
+          "Name or index of the subgraph replayed once per decode step.");
+ABSL_FLAG(std::string, prefill_subgraph, "",
+          "Name or index of the subgraph replayed once before decoding; empty to skip.");
+ABSL_FLAG(int, decode_steps, 128, "Number of decode passes to replay.");
+ABSL_FLAG(std::vector<std::string>, policies,
+          std::vector<std::string>({"lru", "clock", "belady", "prefetch"}),
+          "Residency policies to compare: lru, clock, belady, prefetch.");
+ABSL_FLAG(std::vector<std::string>, budgets_mb,
+          std::vector<std::string>({"512", "1024", "2048"}), "RAM budgets in MiB.");
+ABSL_FLAG(std::vector<std::string>, block_sizes_kb,
+          std::vector<std::string>({"4", "64", "2048"}), "Paging block sizes in whole KiB.");
+ABSL_FLAG(int, prefetch_depth, 4, "Nodes read ahead by the prefetch policy.");
+ABSL_FLAG(bool, weights_only, true,
+          "Page only read-only (mmap) weight tensors; activations stay resident.");
+ABSL_FLAG(double, storage_mbps, 200.0, "Storage read bandwidth used to project I/O time.");
+ABSL_FLAG(int, threads, 0, "Worker threads; 0 uses every hardware thread.");
+ABSL_FLAG(std::string, csv, "", "If set, also writes the results as CSV.");
+
+namespace {
+
+using ai_edge_torch::examples::BuildReplayTrace;
+using ai_edge_torch::examples::ExecutionPlan;
+using ai_edge_torch::examples::ParseResidencyPolicy;
+using ai_edge_torch::examples::ReadExecutionPlanBinary;
+using ai_edge_torch::examples::ReplayTrace;
+using ai_edge_torch::examples::ResidencyPolicy;
+using ai_edge_torch::examples::ResidencyPolicyName;
+using ai_edge_torch::examples::SimulateResidency;
+using ai_edge_torch::examples::SimulationConfig;
+using ai_edge_torch::examples::SimulationResult;
+using ai_edge_torch::examples::SubgraphPlan;
+
+const SubgraphPlan* FindSubgraph(const ExecutionPlan& plan, const std::string& key) {
+  for (const SubgraphPlan& subgraph : plan.subgraphs) {
+    if (subgraph.name == key) {
+      return &subgraph;
+    }
+  }
+  char* end = nullptr;
+  long index = std::strtol(key.c_str(), &end, 10);
+  if (!key.empty() && *end == '\0' && index >= 0 &&
+      index < static_cast<long>(plan.subgraphs.size())) {
+    return &plan.subgraphs[index];
+  }
+  return nullptr;
+}
+
+std::vector<double> ParsePositive(const std::vector<std::string>& values, const char* flag) {
+  std::vector<double> result;
+  for (const std::string& value : values) {
+    char* end = nullptr;
+    double parsed = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || parsed <= 0) {
+      std::cerr << "Invalid value '" << value << "' for --" << flag << std::endl;
+      std::exit(1);
+    }
+    result.push_back(parsed);
+  }
+  return result;
+}
+
+// Block sizes are whole KiB: a fraction could truncate to a 0-byte block.
+std::vector<uint64_t> ParseKib(const std::vector<std::string>& values, const char* flag) {
+  std::vector<uint64_t> result;
+  for (const std::string& value : values) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || value[0] == '-' || *end != '\0' || parsed == 0 ||
+        parsed > (std::numeric_limits<uint64_t>::max() >> 10)) {
+      std::cerr << "Invalid value '" << value << "' for --" << flag
+                << "; expected a positive whole number of KiB" << std::endl;
+      std::exit(1);
+    }
+    result.push_back(parsed);
+  }
+  return result;
+}
+
+// Runs `count` jobs on `num_threads` workers.
+template <typename Job>
+void ParallelFor(size_t count, int num_threads, const Job& job) {
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&]() {
+      for (size_t i = next++; i < count; i = next++) {
+        job(i);
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::ParseCommandLine(argc, argv);
+
+  ExecutionPlan plan;
+  if (!ReadExecutionPlanBinary(absl::GetFlag(FLAGS_plan), &plan)) {
+    std::cerr << "Failed to read execution plan '" << absl::GetFlag(FLAGS_plan) << "'" << std::endl;
+    return 1;
+  }
+  const SubgraphPlan* decode = FindSubgraph(plan, absl::GetFlag(FLAGS_decode_subgraph));
+  if (decode == nullptr) {
+    std::cerr << "No subgraph '" << absl::GetFlag(FLAGS_decode_subgraph) << "' in the plan; have:";
+    for (const SubgraphPlan& subgraph : plan.subgraphs) {
+      std::cerr << " " << subgraph.index << ":" << subgraph.name;
+    }
+    std::cerr << std::endl;
+    return 1;
+  }
+  const SubgraphPlan* prefill = nullptr;
+  if (!absl::GetFlag(FLAGS_prefill_subgraph).empty()) {
+    prefill = FindSubgraph(plan, absl::GetFlag(FLAGS_prefill_subgraph));
+    if (prefill == nullptr) {
+      std::cerr << "No subgraph '" << absl::GetFlag(FLAGS_prefill_subgraph) << "' in the plan"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<ResidencyPolicy> policies;
+  for (const std::string& name : absl::GetFlag(FLAGS_policies)) {
+    ResidencyPolicy policy;
+    if (!ParseResidencyPolicy(name, &policy)) {
+      std::cerr << "Unknown policy '" << name << "'" << std::endl;
+      return 1;
+    }
+    policies.push_back(policy);
+  }
+  const std::vector<double> budgets_mb =
+      ParsePositive(absl::GetFlag(FLAGS_budgets_mb), "budgets_mb");
+  const std::vector<uint64_t> block_sizes_kb =
+      ParseKib(absl::GetFlag(FLAGS_block_sizes_kb), "block_sizes_kb");
+  const int decode_steps = std::max(0, absl::GetFlag(FLAGS_decode_steps));
+  int num_threads = absl::GetFlag(FLAGS_threads);
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // One reference string per block size, shared read-only by its configs.
+  std::vector<ReplayTrace> traces(block_sizes_kb.size());
+  ParallelFor(traces.size(), num_threads, [&](size_t i) {
+    traces[i] = BuildReplayTrace(prefill, *decode,
+                                 block_sizes_kb[i] * 1024,
+                                 absl::GetFlag(FLAGS_weights_only), decode_steps);
+  });
+
+  struct Job {
+    size_t trace;
+    SimulationConfig config;
+  };
+  std::vector<Job> jobs;
+  for (size_t t = 0; t < traces.size(); ++t) {
+    for (double budget_mb : budgets_mb) {
+      for (ResidencyPolicy policy : policies) {
+        SimulationConfig config;
+        config.policy = policy;
+        config.budget_bytes = static_cast<uint64_t>(budget_mb * 1024 * 1024);
+        config.prefetch_depth = absl::GetFlag(FLAGS_prefetch_depth);
+        jobs.push_back({t, config});
+      }
+    }
+  }
+  std::vector<SimulationResult> results(jobs.size());
+  auto start = std::chrono::steady_clock::now();
+  ParallelFor(jobs.size(), num_threads, [&](size_t i) {
+    results[i] = SimulateResidency(traces[jobs[i].trace], jobs[i].config);
+  });
+  double elapsed_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "Decode subgraph " << decode->index << " (" << decode->name << "): "
+            << decode->nodes.size() << " nodes";
+  if (prefill != nullptr) {
+    std::cout << ", prefill subgraph " << prefill->index << " (" << prefill->name
+              << "): " << prefill->nodes.size() << " nodes";
+  }
+  std::cout << ", " << decode_steps << " decode steps\n";
+  for (const ReplayTrace& trace : traces) {
+    std::cout << "Block size " << trace.block_size / 1024 << " KiB: " << trace.num_blocks
+              << " distinct blocks ("
+              << trace.num_blocks * static_cast<double>(trace.block_size) / (1 << 20)
+              << " MiB), " << trace.decode.refs.size() << " references per decode step\n";
+  }
+
+  const double storage_bytes_per_ms = absl::GetFlag(FLAGS_storage_mbps) * 1e6 / 1e3;
+  const double tokens = std::max(1, decode_steps);
+  std::cout << "\n"
+            << std::left << std::setw(10) << "policy" << std::right << std::setw(11)
+            << "budget_MiB" << std::setw(10) << "block_KiB" << std::setw(14) << "faults"
+            << std::setw(14) << "faults/token" << std::setw(12) << "prefetched"
+            << std::setw(10) << "wasted" << std::setw(14) << "read_MiB/tok"
+            << std::setw(14) << "io_ms/token" << "\n";
+  for (const SimulationResult& r : results) {
+    const double decode_read =
+        (r.decode_faults + r.decode_prefetches) * static_cast<double>(r.block_size);
+    std::cout << std::left << std::setw(10) << ResidencyPolicyName(r.config.policy)
+              << std::right << std::fixed << std::setprecision(0) << std::setw(11)
+              << r.config.budget_bytes / double(1 << 20) << std::setw(10)
+              << r.block_size / 1024.0 << std::setw(14) << r.faults << std::setprecision(1)
+              << std::setw(14) << r.decode_faults / tokens << std::setw(12) << r.prefetches
+              << std::setw(10) << r.wasted_prefetches << std::setw(14)
+              << decode_read / tokens / (1 << 20) << std::setw(14)
+              << decode_read / tokens / storage_bytes_per_ms << "\n";
+  }
+  std::cout.unsetf(std::ios::floatfield);
+  std::cout << "\nSimulated " << results.size() << " configurations on " << num_threads
+            << " threads in " << elapsed_s << " s\n";
+
+  if (!absl::GetFlag(FLAGS_csv).empty()) {
+    std::ofstream csv(absl::GetFlag(FLAGS_csv));
+    csv << "policy,budget_bytes,block_size,references,faults,decode_faults,prefetches,"
+           "decode_prefetches,wasted_prefetches,dirty_evictions,read_bytes,written_bytes\n";
+    for (const SimulationResult& r : results) {
+      csv << ResidencyPolicyName(r.config.policy) << "," << r.config.budget_bytes << ","
+          << r.block_size << "," << r.references << "," << r.faults << "," << r.decode_faults
+          << "," << r.prefetches << "," << r.decode_prefetches << "," << r.wasted_prefetches
+          << "," << r.dirty_evictions << "," << r.read_bytes << "," << r.written_bytes << "\n";
+    }
+    if (!csv.good()) {
+      std::cerr << "Warning: failed to write " << absl::GetFlag(FLAGS_csv) << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
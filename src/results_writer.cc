@@ -0,0 +1,240 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/results_writer.h"
+
+#include <sched.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+std::string Trim(std::string_view text) {
+  size_t begin = text.find_first_not_of(" \t\n");
+  if (begin == std::string_view::npos) {
+    return "";
+  }
+  size_t end = text.find_last_not_of(" \t\n");
+  return std::string(text.substr(begin, end - begin + 1));
+}
+
+// Trimmed contents of a one-line control file, or "" if it is missing.
+std::string ReadTrimmed(const std::string& path) {
+  std::string contents;
+  return ReadFileToString(path, &contents) ? Trim(contents) : "";
+}
+
+// Value of the first "<key><whitespace>: <value>" line of /proc/cpuinfo.
+std::string CpuInfoField(std::string_view cpuinfo, std::string_view key) {
+  size_t pos = 0;
+  while (pos < cpuinfo.size()) {
+    size_t end = cpuinfo.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = cpuinfo.size();
+    }
+    std::string_view line = cpuinfo.substr(pos, end - pos);
+    size_t colon = line.find(':');
+    if (colon != std::string_view::npos &&
+        Trim(line.substr(0, colon)) == key) {
+      return Trim(line.substr(colon + 1));
+    }
+    pos = end + 1;
+  }
+  return "";
+}
+
+std::string CpuModel() {
+  std::string cpuinfo;
+  if (!ReadFileToString("/proc/cpuinfo", &cpuinfo)) {
+    return "";
+  }
+  std::string model = CpuInfoField(cpuinfo, "model name");
+  if (model.empty()) {
+    model = CpuInfoField(cpuinfo, "Hardware");
+  }
+  if (model.empty()) {
+    // Arm kernels only list the MIDR fields.
+    std::string implementer = CpuInfoField(cpuinfo, "CPU implementer");
+    std::string part = CpuInfoField(cpuinfo, "CPU part");
+    if (!implementer.empty()) {
+      model = "implementer " + implementer + " part " + part;
+    }
+  }
+  return model;
+}
+
+// "always [madvise] never" -> "madvise".
+std::string SelectedMode(const std::string& text) {
+  size_t open = text.find('[');
+  size_t close = text.find(']', open);
+  if (open == std::string::npos || close == std::string::npos) {
+    return text;
+  }
+  return text.substr(open + 1, close - open - 1);
+}
+
+std::string UtcTimestamp() {
+  std::time_t now = std::time(nullptr);
+  std::tm utc;
+  gmtime_r(&now, &utc);
+  char buffer[32];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+  return buffer;
+}
+
+void WriteOptionalInt(JsonWriter* json, std::string_view key, int64_t value) {
+  json->Key(key);
+  if (value >= 0) {
+    json->Int(value);
+  } else {
+    json->Null();
+  }
+}
+
+}  // namespace
+
+RunEnvironment CollectRunEnvironment() {
+  RunEnvironment env;
+
+  char hostname[256] = {};
+  if (gethostname(hostname, sizeof(hostname) - 1) == 0) {
+    env.hostname = hostname;
+  }
+  struct utsname name;
+  if (uname(&name) == 0) {
+    env.kernel_release = name.release;
+    env.kernel_version = name.version;
+    env.machine = name.machine;
+  }
+  env.cpu_model = CpuModel();
+  env.online_cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        env.affinity.push_back(cpu);
+      }
+    }
+  }
+  for (int cpu : env.affinity) {
+    const std::string dir =
+        "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/";
+    RunEnvironment::CpuFreq freq;
+    freq.cpu = cpu;
+    freq.governor = ReadTrimmed(dir + "scaling_governor");
+    freq.min_khz = ParseInt(ReadTrimmed(dir + "scaling_min_freq"));
+    freq.max_khz = ParseInt(ReadTrimmed(dir + "scaling_max_freq"));
+    freq.cur_khz = ParseInt(ReadTrimmed(dir + "scaling_cur_freq"));
+    env.cpufreq.push_back(freq);
+  }
+
+  std::string meminfo;
+  if (ReadFileToString("/proc/meminfo", &meminfo)) {
+    env.mem_total_kb = ParseColonField(meminfo, "MemTotal");
+    env.swap_total_kb = ParseColonField(meminfo, "SwapTotal");
+  }
+  env.transparent_hugepage = SelectedMode(
+      ReadTrimmed("/sys/kernel/mm/transparent_hugepage/enabled"));
+
+  env.cgroup = CurrentCgroupDir();
+  if (!env.cgroup.empty()) {
+    env.cgroup_memory_max = ReadTrimmed(env.cgroup + "/memory.max");
+    env.cgroup_memory_high = ReadTrimmed(env.cgroup + "/memory.high");
+    env.cgroup_swap_max = ReadTrimmed(env.cgroup + "/memory.swap.max");
+    env.cgroup_cpu_max = ReadTrimmed(env.cgroup + "/cpu.max");
+    env.cgroup_cpuset = ReadTrimmed(env.cgroup + "/cpuset.cpus.effective");
+  }
+  return env;
+}
+
+void WriteRunEnvironment(const RunEnvironment& env, JsonWriter* json) {
+  json->BeginObject();
+  json->Field("hostname", env.hostname);
+  json->Field("kernel_release", env.kernel_release);
+  json->Field("kernel_version", env.kernel_version);
+  json->Field("machine", env.machine);
+  json->Field("cpu_model", env.cpu_model);
+  json->Field("online_cpus", env.online_cpus);
+  json->Key("affinity");
+  json->BeginArray();
+  for (int cpu : env.affinity) {
+    json->Int(cpu);
+  }
+  json->EndArray();
+  json->Key("cpufreq");
+  json->BeginArray();
+  for (const RunEnvironment::CpuFreq& freq : env.cpufreq) {
+    json->BeginObject();
+    json->Field("cpu", freq.cpu);
+    json->Field("governor", freq.governor);
+    WriteOptionalInt(json, "min_khz", freq.min_khz);
+    WriteOptionalInt(json, "max_khz", freq.max_khz);
+    WriteOptionalInt(json, "cur_khz", freq.cur_khz);
+    json->EndObject();
+  }
+  json->EndArray();
+  WriteOptionalInt(json, "mem_total_kb", env.mem_total_kb);
+  WriteOptionalInt(json, "swap_total_kb", env.swap_total_kb);
+  json->Field("transparent_hugepage", env.transparent_hugepage);
+  json->Key("cgroup");
+  json->BeginObject();
+  json->Field("path", env.cgroup);
+  json->Field("memory_max", env.cgroup_memory_max);
+  json->Field("memory_high", env.cgroup_memory_high);
+  json->Field("swap_max", env.cgroup_swap_max);
+  json->Field("cpu_max", env.cgroup_cpu_max);
+  json->Field("cpuset", env.cgroup_cpuset);
+  json->EndObject();
+  json->EndObject();
+}
+
+ResultsWriter::ResultsWriter(const std::string& path,
+                             const RunEnvironment& environment)
+    : out_(path), json_(&out_) {
+  if (!out_.is_open()) {
+    return;
+  }
+  json_.BeginObject();
+  json_.Field("schema", "llm_inference_results");
+  json_.Field("schema_version", kResultsSchemaVersion);
+  json_.Field("timestamp", UtcTimestamp());
+  json_.Key("environment");
+  WriteRunEnvironment(environment, &json_);
+}
+
+bool ResultsWriter::Close() {
+  if (!out_.is_open() || closed_) {
+    return false;
+  }
+  closed_ = true;
+  json_.EndObject();
+  out_ << "\n";
+  out_.close();
+  return !out_.fail();
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,101 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_RESULTS_WRITER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_RESULTS_WRITER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+
+namespace ai_edge_torch::examples {
+
+// Machine-readable results of one benchmark run, compared across runs by
+// evaluation/compare_results.py.
+//
+// The file is a single JSON object:
+//
+//   {"schema": "llm_inference_results", "schema_version": 1,
+//    "timestamp": ..., "environment": {...}, <sections added by the caller>}
+//
+// Bump kResultsSchemaVersion when a field is renamed or changes meaning;
+// adding fields does not need a bump.
+inline constexpr int kResultsSchemaVersion = 1;
+
+// Facts about the machine that change benchmark results.
+struct RunEnvironment {
+  std::string hostname;
+  std::string kernel_release;  // uname -r
+  std::string kernel_version;  // uname -v
+  std::string machine;         // uname -m
+  std::string cpu_model;
+  int online_cpus = 0;
+  std::vector<int> affinity;  // CPUs this process may run on.
+
+  struct CpuFreq {
+    int cpu = 0;
+    std::string governor;  // Empty without cpufreq.
+    int64_t min_khz = -1;
+    int64_t max_khz = -1;
+    int64_t cur_khz = -1;
+  };
+  std::vector<CpuFreq> cpufreq;  // One entry per CPU in `affinity`.
+
+  int64_t mem_total_kb = -1;
+  int64_t swap_total_kb = -1;
+  std::string transparent_hugepage;  // Selected mode, e.g. "madvise".
+
+  // cgroup v2 limits as written in the control files ("max" if unlimited);
+  // empty outside a unified hierarchy.
+  std::string cgroup;
+  std::string cgroup_memory_max;
+  std::string cgroup_memory_high;
+  std::string cgroup_swap_max;
+  std::string cgroup_cpu_max;
+  std::string cgroup_cpuset;
+};
+
+RunEnvironment CollectRunEnvironment();
+
+void WriteRunEnvironment(const RunEnvironment& environment, JsonWriter* json);
+
+// Opens `path` and writes the header fields; the caller adds its sections
+// through json() and calls Close(). All methods are no-ops if the file could
+// not be opened.
+class ResultsWriter {
+ public:
+  ResultsWriter(const std::string& path, const RunEnvironment& environment);
+
+  ResultsWriter(const ResultsWriter&) = delete;
+  ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+  bool is_open() const { return out_.is_open(); }
+  JsonWriter* json() { return &json_; }
+
+  // Ends the top-level object. Returns false on I/O error.
+  bool Close();
+
+ private:
+  std::ofstream out_;
+  JsonWriter json_;
+  bool closed_ = false;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_RESULTS_WRITER_H_
@@ -0,0 +1,209 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// ------------------------
+// Greedy Sampler
+// ------------------------
+int Sampler::GreedySampler(const float* logits, int vocab_size) {
+  float max_value = -std::numeric_limits<float>::infinity();
+  int max_index = 0;
+
+  for (int i = 0; i < vocab_size; ++i) {
+    if (logits[i] > max_value) {
+      max_value = logits[i];
+      max_index = i;
+    }
+  }
+  return max_index;
+}
+
+// ------------------------
+// Top-K Sampler
+// ------------------------
+int Sampler::TopKSampler(const float* logits, int vocab_size, int k) {
+  std::vector<std::pair<float, int>> sorted_logits;
+  sorted_logits.reserve(vocab_size);
+
+  for (int i = 0; i < vocab_size; ++i) {
+    sorted_logits.emplace_back(logits[i], i);
+  }
+
+  // Partial sort to get the top k elements
+  if (k < vocab_size) {
+    std::partial_sort(sorted_logits.begin(), sorted_logits.begin() + k,
+                      sorted_logits.end(),
+                      std::greater<std::pair<float, int>>());
+    sorted_logits.resize(k);
+  } else {
+    // If k >= vocab_size, no need to cut
+    std::sort(sorted_logits.begin(), sorted_logits.end(),
+              std::greater<std::pair<float, int>>());
+  }
+
+  // Compute normalized probabilities
+  float sum_probs = 0.0f;
+  for (auto& pair : sorted_logits) {
+    sum_probs += std::exp(pair.first);
+  }
+  std::vector<float> probabilities;
+  probabilities.reserve(sorted_logits.size());
+  for (auto& pair : sorted_logits) {
+    probabilities.push_back(std::exp(pair.first) / sum_probs);
+  }
+
+  // Multinomial sampling
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::discrete_distribution<> dist(probabilities.begin(), probabilities.end());
+
+  return sorted_logits[dist(gen)].second;
+}
+
+// ------------------------
+// Top-P (Nucleus) Sampler
+// ------------------------
+int Sampler::TopPSampler(const float* logits, int vocab_size, float p) {
+  std::vector<std::pair<float, int>> sorted_logits;
+  sorted_logits.reserve(vocab_size);
+
+  for (int i = 0; i < vocab_size; ++i) {
+    sorted_logits.emplace_back(logits[i], i);
+  }
+
+  // Sort descending by logit value
+  std::sort(sorted_logits.begin(), sorted_logits.end(),
+            std::greater<std::pair<float, int>>());
+
+  // Apply softmax to get probabilities
+  std::vector<float> probabilities(vocab_size);
+  float sum_exp = 0.0f;
+  for (int i = 0; i < vocab_size; ++i) {
+    float val = std::exp(sorted_logits[i].first);
+    probabilities[i] = val;
+    sum_exp += val;
+  }
+  for (int i = 0; i < vocab_size; ++i) {
+    probabilities[i] /= sum_exp;
+  }
+
+  // Find the cutoff index where cumulative probability exceeds p
+  float cumulative_prob = 0.0f;
+  int cutoff_index = vocab_size - 1;
+  for (int i = 0; i < vocab_size; ++i) {
+    cumulative_prob += probabilities[i];
+    if (cumulative_prob > p) {
+      cutoff_index = i;
+      break;
+    }
+  }
+
+  // Resize vectors to [0..cutoff_index]
+  float new_sum = 0.0f;
+  for (int i = 0; i <= cutoff_index; ++i) {
+    new_sum += probabilities[i];
+  }
+  for (int i = 0; i <= cutoff_index; ++i) {
+    probabilities[i] /= new_sum;
+  }
+
+  probabilities.resize(cutoff_index + 1);
+  sorted_logits.resize(cutoff_index + 1);
+
+  // Multinomial sampling
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::discrete_distribution<> dist(probabilities.begin(), probabilities.end());
+  return sorted_logits[dist(gen)].second;
+}
+
+// ------------------------
+// Temperature + Top-K + Top-P Sampler
+// ------------------------
+int Sampler::TemperatureTopKTopPSampler(const float* logits, int vocab_size,
+                                        float temperature, int k, float p) {
+  std::vector<std::pair<float, int>> sorted_logits;
+  sorted_logits.reserve(vocab_size);
+
+  // 1) Apply Temperature
+  std::vector<float> scaled_logits(vocab_size);
+  for (int i = 0; i < vocab_size; ++i) {
+    scaled_logits[i] = logits[i] / temperature;
+  }
+
+  // 2) Softmax over scaled logits
+  float max_logit = *std::max_element(scaled_logits.begin(), scaled_logits.end());
+  float sum_exp = 0.0f;
+  for (int i = 0; i < vocab_size; ++i) {
+    scaled_logits[i] = std::exp(scaled_logits[i] - max_logit);
+    sum_exp += scaled_logits[i];
+  }
+  for (int i = 0; i < vocab_size; ++i) {
+    scaled_logits[i] /= sum_exp;
+    // Keep index-value pairs for sorting
+    sorted_logits.emplace_back(scaled_logits[i], i);
+  }
+
+  // 3) Sort descending by probability
+  std::sort(sorted_logits.begin(), sorted_logits.end(),
+            std::greater<std::pair<float, int>>());
+
+  // 4) Top-K filter
+  int top_k = std::min(k, vocab_size);
+  sorted_logits.resize(top_k);
+
+  // 5) Top-P filter within top-k
+  float cumulative_prob = 0.0f;
+  int cutoff_index = top_k - 1;
+  for (int i = 0; i < top_k; ++i) {
+    cumulative_prob += sorted_logits[i].first;
+    if (cumulative_prob > p) {
+      cutoff_index = i;
+      break;
+    }
+  }
+  sorted_logits.resize(cutoff_index + 1);
+
+  // 6) Renormalize final probabilities
+  float new_sum = 0.0f;
+  for (auto& pair : sorted_logits) {
+    new_sum += pair.first;
+  }
+
+  std::vector<float> final_probs;
+  final_probs.reserve(sorted_logits.size());
+  for (auto& pair : sorted_logits) {
+    final_probs.push_back(pair.first / new_sum);
+  }
+
+  // 7) Multinomial sampling
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::discrete_distribution<> dist(final_probs.begin(), final_probs.end());
+  return sorted_logits[dist(gen)].second;
+}
+
+}  // namespace ai_edge_torch::examples
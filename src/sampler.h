@@ -0,0 +1,66 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_SAMPLER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_SAMPLER_H_
+
+#include "tensorflow/lite/interpreter.h"
+
+namespace ai_edge_torch::examples {
+
+// Provides various sampling methods (Greedy, Top-K, Top-P, etc.).
+//
+// Every sampler takes one row of logits of length `vocab_size`. The
+// `TfLiteTensor` overloads sample from the first row of a [1, T, vocab]
+// logits tensor, which is what the decode signature produces. Multi-token
+// signatures (e.g. speculative verification) pass `LogitsRow()` instead.
+class Sampler {
+ public:
+  static int GreedySampler(const float* logits, int vocab_size);
+  static int TopKSampler(const float* logits, int vocab_size, int k);
+  static int TopPSampler(const float* logits, int vocab_size, float p);
+  static int TemperatureTopKTopPSampler(const float* logits, int vocab_size,
+                                        float temperature, int k, float p);
+
+  static int GreedySampler(const TfLiteTensor* logits) {
+    return GreedySampler(logits->data.f, VocabSize(logits));
+  }
+  static int TopKSampler(const TfLiteTensor* logits, int k) {
+    return TopKSampler(logits->data.f, VocabSize(logits), k);
+  }
+  static int TopPSampler(const TfLiteTensor* logits, float p) {
+    return TopPSampler(logits->data.f, VocabSize(logits), p);
+  }
+  static int TemperatureTopKTopPSampler(const TfLiteTensor* logits,
+                                        float temperature, int k, float p) {
+    return TemperatureTopKTopPSampler(logits->data.f, VocabSize(logits),
+                                      temperature, k, p);
+  }
+
+  // Size of the innermost (vocabulary) dimension of a logits tensor.
+  static int VocabSize(const TfLiteTensor* logits) {
+    return logits->dims->data[logits->dims->size - 1];
+  }
+
+  // Pointer to the logits of sequence position `row` in a [1, T, vocab]
+  // logits tensor.
+  static const float* LogitsRow(const TfLiteTensor* logits, int row) {
+    return logits->data.f + static_cast<size_t>(row) * VocabSize(logits);
+  }
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_SAMPLER_H_
@@ -0,0 +1,260 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/speculative_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/sampler.h"
+#include "ai_edge_torch/generative/examples/cpp/trace_writer.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+double ElapsedMs(const std::chrono::high_resolution_clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+DraftModelProposer::DraftModelProposer(tflite::SignatureRunner* decode_runner,
+                                       std::vector<int> prefilled_tokens,
+                                       int kv_cache_max_size,
+                                       TokenSampler sampler)
+    : decode_runner_(decode_runner),
+      input_(decode_runner->input_tensor("tokens")),
+      input_pos_(decode_runner->input_tensor("input_pos")),
+      tokens_(std::move(prefilled_tokens)),
+      kv_cache_max_size_(kv_cache_max_size),
+      sampler_(std::move(sampler)) {}
+
+const float* DraftModelProposer::Feed(int token) {
+  input_->data.i32[0] = token;
+  input_pos_->data.i32[0] = static_cast<int>(tokens_.size());
+  MINIMAL_CHECK(decode_runner_->Invoke() == kTfLiteOk);
+  ++num_invocations_;
+  tokens_.push_back(token);
+  return decode_runner_->output_tensor("logits")->data.f;
+}
+
+std::vector<int> DraftModelProposer::Propose(const std::vector<int>& context,
+                                             int max_tokens) {
+  if (context.empty() || max_tokens <= 0) {
+    return {};
+  }
+
+  // Roll back to the longest prefix the draft cache agrees with. The pending
+  // token is always re-fed because its logits are needed for the first guess.
+  size_t matched = 0;
+  while (matched < tokens_.size() && matched < context.size() &&
+         tokens_[matched] == context[matched]) {
+    ++matched;
+  }
+  matched = std::min(matched, context.size() - 1);
+  tokens_.resize(matched);
+
+  // The last draft token is never fed, so the window ends at
+  // context.size() + max_tokens - 2.
+  max_tokens = std::min<int>(
+      max_tokens, kv_cache_max_size_ - static_cast<int>(context.size()) + 1);
+  if (max_tokens <= 0) {
+    return {};
+  }
+
+  const float* logits = nullptr;
+  for (size_t i = matched; i < context.size(); ++i) {
+    logits = Feed(context[i]);
+  }
+
+  const int vocab_size =
+      Sampler::VocabSize(decode_runner_->output_tensor("logits"));
+  std::vector<int> proposals;
+  proposals.reserve(max_tokens);
+  for (int i = 0; i < max_tokens; ++i) {
+    proposals.push_back(sampler_(logits, vocab_size));
+    if (i + 1 < max_tokens) {
+      logits = Feed(proposals.back());
+    }
+  }
+  return proposals;
+}
+
+PromptLookupProposer::PromptLookupProposer(int min_ngram, int max_ngram)
+    : min_ngram_(std::max(1, min_ngram)),
+      max_ngram_(std::max(std::max(1, min_ngram), max_ngram)),
+      index_(max_ngram_ + 1) {}
+
+uint64_t PromptLookupProposer::HashNgram(const int* tokens, int n) {
+  // 64-bit FNV-1a over the token ids.
+  uint64_t hash = 14695981039346656037ull;
+  for (int i = 0; i < n; ++i) {
+    hash ^= static_cast<uint32_t>(tokens[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+void PromptLookupProposer::Extend(const std::vector<int>& context) {
+  // Only n-grams followed by at least one token can seed a proposal, so the
+  // n-gram ending at the last (pending) token is indexed on the next call.
+  if (context.size() < indexed_) {
+    // The context is not a continuation of what was indexed; start over.
+    for (auto& index : index_) {
+      index.clear();
+    }
+    indexed_ = 0;
+  }
+  for (; indexed_ + 1 < context.size(); ++indexed_) {
+    const int end = static_cast<int>(indexed_);
+    for (int n = min_ngram_; n <= max_ngram_ && n <= end + 1; ++n) {
+      index_[n][HashNgram(&context[end - n + 1], n)] = end;
+    }
+  }
+}
+
+std::vector<int> PromptLookupProposer::Propose(const std::vector<int>& context,
+                                               int max_tokens) {
+  if (context.empty() || max_tokens <= 0) {
+    return {};
+  }
+  Extend(context);
+
+  const int last = static_cast<int>(context.size()) - 1;
+  for (int n = std::min(max_ngram_, last + 1); n >= min_ngram_; --n) {
+    const int* suffix = &context[last - n + 1];
+    auto it = index_[n].find(HashNgram(suffix, n));
+    if (it == index_[n].end()) {
+      continue;
+    }
+    const int end = it->second;
+    // Guard against hash collisions.
+    if (!std::equal(suffix, suffix + n, &context[end - n + 1])) {
+      continue;
+    }
+    const int available = last - end;
+    std::vector<int> proposals(
+        context.begin() + end + 1,
+        context.begin() + end + 1 + std::min(max_tokens, available));
+    ++num_hits_;
+    return proposals;
+  }
+  return {};
+}
+
+SpeculativeDecoder::SpeculativeDecoder(tflite::SignatureRunner* decode_runner,
+                                       tflite::SignatureRunner* verify_runner,
+                                       DraftProposer* proposer,
+                                       TokenSampler sampler,
+                                       int num_draft_tokens,
+                                       int kv_cache_max_size)
+    : decode_runner_(decode_runner),
+      verify_runner_(verify_runner),
+      proposer_(proposer),
+      sampler_(std::move(sampler)),
+      num_draft_tokens_(num_draft_tokens),
+      kv_cache_max_size_(kv_cache_max_size),
+      verify_width_(verify_runner->input_tensor("input_pos")->dims->data[0]) {}
+
+SpeculativeStep SpeculativeDecoder::DecodeSingle(int token, int position) {
+  SpeculativeStep step;
+  auto inference_start = std::chrono::high_resolution_clock::now();
+  {
+    ScopedTraceSpan span("Decode_Invoke", "decode");
+    decode_runner_->input_tensor("tokens")->data.i32[0] = token;
+    decode_runner_->input_tensor("input_pos")->data.i32[0] = position;
+    MINIMAL_CHECK(decode_runner_->Invoke() == kTfLiteOk);
+  }
+  step.verify_time_ms = ElapsedMs(inference_start);
+
+  auto sampling_start = std::chrono::high_resolution_clock::now();
+  const TfLiteTensor* logits = decode_runner_->output_tensor("logits");
+  step.tokens.push_back(sampler_(logits->data.f, Sampler::VocabSize(logits)));
+  step.sampling_time_ms = ElapsedMs(sampling_start);
+  return step;
+}
+
+SpeculativeStep SpeculativeDecoder::Step(const std::vector<int>& context,
+                                         int next_position,
+                                         int max_new_tokens) {
+  const int pending_token = context.back();
+
+  // The verify signature always writes `verify_width_` consecutive KV
+  // positions, so the whole window must fit inside the cache.
+  int num_draft = std::min({num_draft_tokens_, max_new_tokens - 1,
+                            verify_width_ - 1});
+  if (num_draft <= 0 || next_position + verify_width_ > kv_cache_max_size_) {
+    return DecodeSingle(pending_token, next_position);
+  }
+
+  SpeculativeStep step;
+  auto draft_start = std::chrono::high_resolution_clock::now();
+  std::vector<int> draft;
+  {
+    ScopedTraceSpan span("Draft", "decode");
+    draft = proposer_->Propose(context, num_draft);
+  }
+  step.draft_time_ms = ElapsedMs(draft_start);
+  if (draft.empty()) {
+    SpeculativeStep single = DecodeSingle(pending_token, next_position);
+    single.draft_time_ms = step.draft_time_ms;
+    return single;
+  }
+  step.num_proposed = static_cast<int>(draft.size());
+
+  // Stage [pending, d1 .. dn] followed by padding at consecutive positions.
+  auto verify_start = std::chrono::high_resolution_clock::now();
+  TfLiteTensor* tokens = verify_runner_->input_tensor("tokens");
+  TfLiteTensor* input_pos = verify_runner_->input_tensor("input_pos");
+  std::memset(tokens->data.i32, 0, tokens->bytes);
+  tokens->data.i32[0] = pending_token;
+  for (size_t i = 0; i < draft.size(); ++i) {
+    tokens->data.i32[i + 1] = draft[i];
+  }
+  for (int i = 0; i < verify_width_; ++i) {
+    input_pos->data.i32[i] = next_position + i;
+  }
+  {
+    ScopedTraceSpan span("Verify_Invoke", "decode");
+    MINIMAL_CHECK(verify_runner_->Invoke() == kTfLiteOk);
+  }
+  step.verify_time_ms = ElapsedMs(verify_start);
+
+  // Row i holds the target distribution for the token after input i.
+  auto sampling_start = std::chrono::high_resolution_clock::now();
+  const TfLiteTensor* logits = verify_runner_->output_tensor("logits");
+  const int vocab_size = Sampler::VocabSize(logits);
+  for (size_t i = 0; i <= draft.size(); ++i) {
+    int token = sampler_(Sampler::LogitsRow(logits, i), vocab_size);
+    step.tokens.push_back(token);
+    if (i == draft.size() || token != draft[i]) {
+      break;
+    }
+    ++step.num_accepted;
+  }
+  step.sampling_time_ms = ElapsedMs(sampling_start);
+  return step;
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,166 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_SPECULATIVE_DECODER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_SPECULATIVE_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace ai_edge_torch::examples {
+
+// Picks the next token from one row of logits of length `vocab_size`.
+using TokenSampler = std::function<int(const float* logits, int vocab_size)>;
+
+// Source of speculative continuation tokens.
+//
+// `context` is every token of the sequence so far. Its last element is the
+// pending token: it has been generated but not yet fed to the target model.
+// Implementations return up to `max_tokens` guesses for what follows it.
+class DraftProposer {
+ public:
+  virtual ~DraftProposer() = default;
+  virtual std::vector<int> Propose(const std::vector<int>& context,
+                                   int max_tokens) = 0;
+};
+
+// Proposes tokens by running a small draft model autoregressively.
+//
+// The draft keeps its own external KV cache. `tokens_` mirrors which token
+// sits at each position of that cache, so after a rejection the draft only
+// re-feeds the positions that diverge from the accepted context. Stale
+// entries beyond the rollback point need no clearing: the causal mask hides
+// every position past `input_pos`, and they are overwritten when reached.
+class DraftModelProposer : public DraftProposer {
+ public:
+  // `prefilled_tokens` are the tokens already written into the draft KV cache
+  // by its prefill signature (positions 0..N-1).
+  DraftModelProposer(tflite::SignatureRunner* decode_runner,
+                     std::vector<int> prefilled_tokens, int kv_cache_max_size,
+                     TokenSampler sampler);
+
+  std::vector<int> Propose(const std::vector<int>& context,
+                           int max_tokens) override;
+
+  // Number of draft decode invocations so far.
+  int num_invocations() const { return num_invocations_; }
+
+ private:
+  // Feeds `token` at position `tokens_.size()` and returns the logits row.
+  const float* Feed(int token);
+
+  tflite::SignatureRunner* decode_runner_;
+  TfLiteTensor* input_;
+  TfLiteTensor* input_pos_;
+  std::vector<int> tokens_;
+  const int kv_cache_max_size_;
+  TokenSampler sampler_;
+  int num_invocations_ = 0;
+};
+
+// Proposes tokens by looking the recent suffix up in the sequence itself.
+//
+// Summarisation and code-editing outputs often copy long spans of the prompt.
+// The proposer hashes every n-gram of the context (prompt plus generated
+// tokens) for n in [min_ngram, max_ngram], remembering where each one last
+// occurred. To propose, it matches the longest suffix of the context that
+// occurred earlier and returns the tokens that followed that occurrence. The
+// index grows incrementally, so each call only hashes the newly committed
+// tokens. No second model is needed.
+class PromptLookupProposer : public DraftProposer {
+ public:
+  PromptLookupProposer(int min_ngram, int max_ngram);
+
+  std::vector<int> Propose(const std::vector<int>& context,
+                           int max_tokens) override;
+
+  // Number of Propose() calls that found a match.
+  int num_hits() const { return num_hits_; }
+
+ private:
+  static uint64_t HashNgram(const int* tokens, int n);
+
+  // Indexes every n-gram ending before the last context token.
+  void Extend(const std::vector<int>& context);
+
+  const int min_ngram_;
+  const int max_ngram_;
+  // One index per n-gram size: hash -> index of the n-gram's last token in
+  // the most recent occurrence.
+  std::vector<absl::flat_hash_map<uint64_t, int>> index_;
+  size_t indexed_ = 0;
+  int num_hits_ = 0;
+};
+
+// Result of one speculative round.
+struct SpeculativeStep {
+  // Tokens committed this round: the accepted draft prefix followed by the
+  // target's own correction (or bonus) token. Never empty.
+  std::vector<int> tokens;
+  int num_proposed = 0;
+  int num_accepted = 0;
+  double draft_time_ms = 0.0;
+  double verify_time_ms = 0.0;
+  double sampling_time_ms = 0.0;
+};
+
+// Drives draft-then-verify decoding against the target model.
+//
+// Verification runs the pending token plus the draft through a multi-token
+// signature that outputs logits for every position ([1, T, vocab]). Draft
+// token i is accepted when the target, sampling from its own distribution at
+// that position, picks the same token. The first mismatch is replaced by the
+// target's sample and the round ends, so every committed token is a sample of
+// the target model and output quality matches plain decoding.
+//
+// Rejected positions are rolled back logically: the caller only advances its
+// position by `tokens.size()`, and the stale KV entries written by the verify
+// pass are masked out and later overwritten.
+class SpeculativeDecoder {
+ public:
+  SpeculativeDecoder(tflite::SignatureRunner* decode_runner,
+                     tflite::SignatureRunner* verify_runner,
+                     DraftProposer* proposer, TokenSampler sampler,
+                     int num_draft_tokens, int kv_cache_max_size);
+
+  // Runs one round. `context.back()` is the pending token at `next_position`.
+  // At most `max_new_tokens` tokens are committed. Falls back to a single
+  // plain decode step when the verify window would not fit in the KV cache.
+  SpeculativeStep Step(const std::vector<int>& context, int next_position,
+                       int max_new_tokens);
+
+  // Number of tokens the verify signature processes per invocation.
+  int verify_width() const { return verify_width_; }
+
+ private:
+  SpeculativeStep DecodeSingle(int token, int position);
+
+  tflite::SignatureRunner* decode_runner_;
+  tflite::SignatureRunner* verify_runner_;
+  DraftProposer* proposer_;
+  TokenSampler sampler_;
+  const int num_draft_tokens_;
+  const int kv_cache_max_size_;
+  int verify_width_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_SPECULATIVE_DECODER_H_
@@ -0,0 +1,320 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/stall_accounting.h"
+
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Parses the "total=" value of the "some" or "full" line of a PSI file:
+//   some avg10=0.00 avg60=0.00 avg300=0.00 total=12345
+int64_t ParsePsiTotal(std::string_view text, std::string_view kind) {
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    std::string_view line = text.substr(pos, end - pos);
+    if (line.size() > kind.size() && line.compare(0, kind.size(), kind) == 0) {
+      size_t total = line.find("total=");
+      return total == std::string_view::npos ? -1
+                                             : ParseInt(line.substr(total + 6));
+    }
+    pos = end + 1;
+  }
+  return -1;
+}
+
+double DiffMs(int64_t start, int64_t end, double unit_ms) {
+  return (start < 0 || end < 0) ? -1.0 : (end - start) * unit_ms;
+}
+
+// Opens `name` in the cgroup directory, or an unopened file if there is none.
+ProcFile OpenPressure(const std::string& cgroup_dir, const char* name) {
+  return cgroup_dir.empty() ? ProcFile() : ProcFile(cgroup_dir + "/" + name);
+}
+
+}  // namespace
+
+double StallDelta::io_wait_ms() const {
+  if (blkio_delay_ms >= 0) {
+    return blkio_delay_ms;
+  }
+  return std::max(0.0, io_some_ms);
+}
+
+const char* StallDelta::DominantCause(double min_fraction) const {
+  const double reclaim = memory_some_ms;
+  const double io = io_wait_ms();
+  const double cpu = run_delay_ms;
+  const double largest = std::max({reclaim, io, cpu});
+  if (wall_ms <= 0 || largest < min_fraction * wall_ms) {
+    return "none";
+  }
+  if (largest == reclaim) {
+    return "reclaim";
+  }
+  return largest == io ? "io" : "cpu";
+}
+
+StallAccounting::StallAccounting()
+    : process_stat_("/proc/self/stat") {
+  const std::string cgroup_dir = CurrentCgroupDir();
+  memory_pressure_ = OpenPressure(cgroup_dir, "memory.pressure");
+  io_pressure_ = OpenPressure(cgroup_dir, "io.pressure");
+  cpu_pressure_ = OpenPressure(cgroup_dir, "cpu.pressure");
+  psi_from_cgroup_ = memory_pressure_.is_open() &&
+                     !memory_pressure_.Read().empty();
+  if (!psi_from_cgroup_) {
+    memory_pressure_ = ProcFile("/proc/pressure/memory");
+    io_pressure_ = ProcFile("/proc/pressure/io");
+    cpu_pressure_ = ProcFile("/proc/pressure/cpu");
+    // Kernels booted with psi=0 have the files but fail every read.
+    if (memory_pressure_.Read().empty()) {
+      memory_pressure_ = ProcFile();
+    }
+  }
+
+  // Since 5.14 delay accounting is off unless kernel.task_delayacct is set;
+  // older kernels have no switch and account whenever it is compiled in.
+  std::string delayacct;
+  has_delayacct_ =
+      !ReadFileToString("/proc/sys/kernel/task_delayacct", &delayacct) ||
+      ParseInt(delayacct, 0) != 0;
+
+  const long ticks = sysconf(_SC_CLK_TCK);
+  if (ticks > 0) {
+    ticks_per_second_ = ticks;
+  }
+  RefreshThreads();
+}
+
+void StallAccounting::RefreshThreads() {
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return;
+  }
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+      continue;
+    }
+    const int tid = std::atoi(entry->d_name);
+    if (threads_.count(tid) > 0) {
+      continue;
+    }
+    const std::string task = std::string("/proc/self/task/") + entry->d_name;
+    ThreadFiles& files = threads_[tid];
+    files.schedstat = ProcFile(task + "/schedstat");
+    files.stat = ProcFile(task + "/stat");
+  }
+  closedir(dir);
+}
+
+StallSnapshot StallAccounting::Snapshot() {
+  StallSnapshot snapshot;
+  if (memory_pressure_.is_open()) {
+    std::string_view memory = memory_pressure_.Read();
+    snapshot.memory_some_us = ParsePsiTotal(memory, "some");
+    snapshot.memory_full_us = ParsePsiTotal(memory, "full");
+    std::string_view io = io_pressure_.Read();
+    snapshot.io_some_us = ParsePsiTotal(io, "some");
+    snapshot.io_full_us = ParsePsiTotal(io, "full");
+    snapshot.cpu_some_us = ParsePsiTotal(cpu_pressure_.Read(), "some");
+  }
+
+  RefreshThreads();
+  int64_t run_delay_ns = 0;
+  int64_t blkio_ticks = 0;
+  bool have_schedstat = false;
+  for (auto& [tid, files] : threads_) {
+    // schedstat: <on-cpu ns> <run-queue wait ns> <timeslices>. A thread
+    // that has exited keeps the values of its last successful read.
+    std::string_view schedstat = files.schedstat.Read();
+    size_t space = schedstat.find(' ');
+    if (space != std::string_view::npos) {
+      files.run_delay_ns = ParseInt(schedstat.substr(space + 1), 0);
+      have_schedstat = true;
+    }
+    std::string_view stat = files.stat.Read();
+    if (!stat.empty()) {
+      files.blkio_ticks = ParseStatField(stat, 42, 0);
+    }
+    run_delay_ns += files.run_delay_ns;
+    blkio_ticks += files.blkio_ticks;
+  }
+  if (have_schedstat) {
+    snapshot.run_delay_ns = run_delay_ns;
+  }
+  if (has_delayacct_) {
+    snapshot.blkio_delay_ns = blkio_ticks * (1000000000ll / ticks_per_second_);
+  }
+
+  std::string_view stat = process_stat_.Read();
+  snapshot.minor_faults = ParseStatField(stat, 10);
+  snapshot.major_faults = ParseStatField(stat, 12);
+  snapshot.time_ns = NowNs();
+  return snapshot;
+}
+
+StallDelta StallAccounting::Diff(const StallSnapshot& start,
+                                 const StallSnapshot& end) {
+  StallDelta delta;
+  delta.wall_ms = (end.time_ns - start.time_ns) / 1e6;
+  delta.memory_some_ms = DiffMs(start.memory_some_us, end.memory_some_us, 1e-3);
+  delta.memory_full_ms = DiffMs(start.memory_full_us, end.memory_full_us, 1e-3);
+  delta.io_some_ms = DiffMs(start.io_some_us, end.io_some_us, 1e-3);
+  delta.io_full_ms = DiffMs(start.io_full_us, end.io_full_us, 1e-3);
+  delta.cpu_some_ms = DiffMs(start.cpu_some_us, end.cpu_some_us, 1e-3);
+  delta.run_delay_ms = DiffMs(start.run_delay_ns, end.run_delay_ns, 1e-6);
+  delta.blkio_delay_ms = DiffMs(start.blkio_delay_ns, end.blkio_delay_ns, 1e-6);
+  if (start.minor_faults >= 0 && end.minor_faults >= 0) {
+    delta.minor_faults = end.minor_faults - start.minor_faults;
+  }
+  if (start.major_faults >= 0 && end.major_faults >= 0) {
+    delta.major_faults = end.major_faults - start.major_faults;
+  }
+  return delta;
+}
+
+void StallAccounting::Begin(int index) {
+  step_index_ = index;
+  step_start_ = Snapshot();
+  in_step_ = true;
+}
+
+void StallAccounting::End() {
+  if (!in_step_) {
+    return;
+  }
+  in_step_ = false;
+  steps_.push_back({step_index_, Diff(step_start_, Snapshot())});
+}
+
+void StallAccounting::PrintSummary(std::ostream& out, int top_n) const {
+  out << "\n=== Stall Accounting (" << steps_.size() << " decode steps) ===\n";
+  if (steps_.empty()) {
+    return;
+  }
+  out << "PSI source: "
+      << (!has_psi() ? "unavailable"
+                     : (psi_from_cgroup_ ? "cgroup" : "system-wide"))
+      << ", block I/O delay: "
+      << (has_delayacct_ ? "delay accounting"
+                         : "PSI io (kernel.task_delayacct=0)")
+      << "\n";
+
+  StallDelta total;
+  total.memory_some_ms = total.memory_full_ms = total.io_some_ms = 0;
+  total.cpu_some_ms = total.run_delay_ms = total.blkio_delay_ms = 0;
+  total.minor_faults = total.major_faults = 0;
+  int causes[4] = {};  // none, reclaim, io, cpu
+  for (const Step& step : steps_) {
+    const StallDelta& d = step.delta;
+    total.wall_ms += d.wall_ms;
+    total.memory_some_ms += std::max(0.0, d.memory_some_ms);
+    total.memory_full_ms += std::max(0.0, d.memory_full_ms);
+    total.io_some_ms += std::max(0.0, d.io_some_ms);
+    total.cpu_some_ms += std::max(0.0, d.cpu_some_ms);
+    total.run_delay_ms += std::max(0.0, d.run_delay_ms);
+    total.blkio_delay_ms += std::max(0.0, d.blkio_delay_ms);
+    total.minor_faults += std::max<int64_t>(0, d.minor_faults);
+    total.major_faults += std::max<int64_t>(0, d.major_faults);
+    const std::string_view cause = d.DominantCause();
+    ++causes[cause == "reclaim" ? 1 : cause == "io" ? 2 : cause == "cpu" ? 3 : 0];
+  }
+  if (!has_delayacct_) {
+    total.blkio_delay_ms = -1;
+  }
+
+  const double n = static_cast<double>(steps_.size());
+  out << "Average step wall time: " << total.wall_ms / n << " ms\n"
+      << "Memory stall (PSI some/full): " << total.memory_some_ms << " / "
+      << total.memory_full_ms << " ms\n"
+      << "I/O stall (PSI some): " << total.io_some_ms << " ms\n"
+      << "CPU stall (PSI some): " << total.cpu_some_ms << " ms\n"
+      << "Run-queue delay (all threads): " << total.run_delay_ms << " ms\n"
+      << "Block I/O wait: " << total.io_wait_ms() << " ms\n"
+      << "Major faults: " << total.major_faults << " ("
+      << total.major_faults / n << " per step)\n"
+      << "Minor faults: " << total.minor_faults << " ("
+      << total.minor_faults / n << " per step)\n"
+      << "Steps dominated by reclaim / io / cpu / none: " << causes[1] << " / "
+      << causes[2] << " / " << causes[3] << " / " << causes[0] << "\n";
+
+  // The slowest steps, with the stall that explains them.
+  std::vector<const Step*> sorted;
+  for (const Step& step : steps_) {
+    sorted.push_back(&step);
+  }
+  const size_t shown = std::min<size_t>(sorted.size(), std::max(0, top_n));
+  std::partial_sort(sorted.begin(), sorted.begin() + shown, sorted.end(),
+                    [](const Step* a, const Step* b) {
+                      return a->delta.wall_ms > b->delta.wall_ms;
+                    });
+  if (shown > 0) {
+    out << "Slowest steps:\n";
+  }
+  for (size_t i = 0; i < shown; ++i) {
+    const StallDelta& d = sorted[i]->delta;
+    out << "  step " << sorted[i]->index << ": " << d.wall_ms << " ms, memory "
+        << d.memory_some_ms << " ms, io " << d.io_wait_ms() << " ms, run delay "
+        << d.run_delay_ms << " ms, major faults " << d.major_faults << " -> "
+        << d.DominantCause() << "\n";
+  }
+}
+
+bool StallAccounting::WriteCsv(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    return false;
+  }
+  out << "step,wall_ms,memory_some_ms,memory_full_ms,io_some_ms,io_full_ms,"
+         "cpu_some_ms,run_delay_ms,blkio_delay_ms,minor_faults,major_faults,"
+         "cause\n";
+  for (const Step& step : steps_) {
+    const StallDelta& d = step.delta;
+    out << step.index << "," << d.wall_ms << "," << d.memory_some_ms << ","
+        << d.memory_full_ms << "," << d.io_some_ms << "," << d.io_full_ms << ","
+        << d.cpu_some_ms << "," << d.run_delay_ms << "," << d.blkio_delay_ms
+        << "," << d.minor_faults << "," << d.major_faults << ","
+        << d.DominantCause() << "\n";
+  }
+  return out.good();
+}
+
+}  // namespace ai_edge_torch::examples
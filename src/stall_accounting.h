@@ -0,0 +1,138 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_STALL_ACCOUNTING_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_STALL_ACCOUNTING_H_
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+// Cumulative stall counters at one point in time. Values are -1 when the
+// source is unavailable (no PSI, no cgroup v2, delay accounting disabled).
+struct StallSnapshot {
+  uint64_t time_ns = 0;  // CLOCK_MONOTONIC.
+  // Pressure Stall Information "total=" values in microseconds. The cgroup
+  // values cover this process's cgroup, the system values the whole machine.
+  int64_t memory_some_us = -1;
+  int64_t memory_full_us = -1;
+  int64_t io_some_us = -1;
+  int64_t io_full_us = -1;
+  int64_t cpu_some_us = -1;
+  // Summed over every thread of this process.
+  int64_t run_delay_ns = -1;    // Runnable but waiting for a CPU (schedstat).
+  int64_t blkio_delay_ns = -1;  // Waiting for block I/O (delay accounting).
+  int64_t minor_faults = -1;
+  int64_t major_faults = -1;
+};
+
+// Difference of two snapshots, in milliseconds. A field is negative when
+// either snapshot lacked it.
+struct StallDelta {
+  double wall_ms = 0;
+  double memory_some_ms = -1;
+  double memory_full_ms = -1;
+  double io_some_ms = -1;
+  double io_full_ms = -1;
+  double cpu_some_ms = -1;
+  double run_delay_ms = -1;
+  double blkio_delay_ms = -1;
+  int64_t minor_faults = -1;
+  int64_t major_faults = -1;
+
+  // Time this process spent blocked on block I/O: delay accounting when it
+  // is enabled, otherwise the PSI io "some" time.
+  double io_wait_ms() const;
+  // The largest stall source: "reclaim", "io", "cpu" or "none" if none of
+  // them covers at least `min_fraction` of the wall time.
+  const char* DominantCause(double min_fraction = 0.1) const;
+};
+
+// Reads PSI, per-thread scheduler delay and block I/O delay, and fault
+// counters; optionally records them for every decode step.
+//
+// The PSI files of the current cgroup (memory.pressure, io.pressure,
+// cpu.pressure) are preferred over /proc/pressure so that stalls caused by
+// the cgroup limit in run_cgroup.sh are not diluted by the rest of the
+// machine. All files stay open and are re-read with pread(). Thread
+// directories are rescanned on each snapshot because the delegate starts its
+// workers after the interpreter is built; threads that have exited keep
+// their last reading.
+class StallAccounting {
+ public:
+  StallAccounting();
+
+  StallAccounting(const StallAccounting&) = delete;
+  StallAccounting& operator=(const StallAccounting&) = delete;
+
+  // Whether any PSI file could be opened.
+  bool has_psi() const { return memory_pressure_.is_open(); }
+  bool psi_from_cgroup() const { return psi_from_cgroup_; }
+  // Whether delay accounting reports any block I/O delay source at all.
+  bool has_delayacct() const { return has_delayacct_; }
+
+  StallSnapshot Snapshot();
+  static StallDelta Diff(const StallSnapshot& start, const StallSnapshot& end);
+
+  // Per-step recording. End() without a matching Begin() is ignored.
+  void Begin(int index);
+  void End();
+
+  struct Step {
+    int index = 0;
+    StallDelta delta;
+  };
+  const std::vector<Step>& steps() const { return steps_; }
+
+  // Totals over the recorded steps and the steps that stalled the most,
+  // each attributed to reclaim, I/O or CPU contention.
+  void PrintSummary(std::ostream& out, int top_n = 5) const;
+  // One row per recorded step. Returns false on I/O error.
+  bool WriteCsv(const std::string& path) const;
+
+ private:
+  struct ThreadFiles {
+    ProcFile schedstat;
+    ProcFile stat;
+    int64_t run_delay_ns = 0;
+    int64_t blkio_ticks = 0;
+  };
+
+  void RefreshThreads();
+
+  ProcFile memory_pressure_;
+  ProcFile io_pressure_;
+  ProcFile cpu_pressure_;
+  bool psi_from_cgroup_ = false;
+  bool has_delayacct_ = false;
+  ProcFile process_stat_;
+  std::map<int, ThreadFiles> threads_;
+  long ticks_per_second_ = 100;
+
+  bool in_step_ = false;
+  int step_index_ = 0;
+  StallSnapshot step_start_;
+  std::vector<Step> steps_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_STALL_ACCOUNTING_H_
@@ -0,0 +1,190 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/task_graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/trace_writer.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+constexpr char kMainLane[] = "main";
+
+double Ms(TaskGraph::Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}  // namespace
+
+TaskGraph::TaskGraph(int num_workers) {
+  for (int i = 0; i < std::max(1, num_workers); ++i) {
+    workers_.emplace_back(&TaskGraph::WorkerLoop, this, i);
+  }
+}
+
+TaskGraph::~TaskGraph() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+int TaskGraph::Add(std::string name, std::function<void()> fn,
+                   std::vector<int> deps) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int id = static_cast<int>(tasks_.size());
+  Task& task = tasks_.emplace_back();
+  task.name = std::move(name);
+  task.fn = std::move(fn);
+  for (int dep : deps) {
+    if (dep >= 0 && dep < id && !tasks_[dep].done) {
+      tasks_[dep].dependents.push_back(id);
+      ++task.pending_deps;
+    }
+  }
+  if (task.pending_deps == 0) {
+    ready_.push_back(id);
+    changed_.notify_all();
+  }
+  return id;
+}
+
+void TaskGraph::Wait(int id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (id < 0 || id >= static_cast<int>(tasks_.size()) || tasks_[id].done) {
+    return;
+  }
+  Clock::time_point start = Clock::now();
+  changed_.wait(lock, [&] { return tasks_[id].done; });
+  intervals_.push_back({kMainLane, "wait:" + tasks_[id].name,
+                        IntervalKind::kWait, start, Clock::now()});
+}
+
+void TaskGraph::RecordStage(std::string name, Clock::time_point start,
+                            Clock::time_point end) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  intervals_.push_back(
+      {kMainLane, std::move(name), IntervalKind::kStage, start, end});
+}
+
+void TaskGraph::WorkerLoop(int worker) {
+  const std::string lane = "worker-" + std::to_string(worker);
+  if (TraceWriter* writer = TraceWriter::Get()) {
+    writer->NameThread("pipeline " + lane);
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [&] { return stopping_ || !ready_.empty(); });
+    if (ready_.empty()) {
+      return;
+    }
+    const int id = ready_.front();
+    ready_.pop_front();
+    // tasks_ may grow while the task runs, so nothing refers into it then.
+    std::function<void()> fn = std::move(tasks_[id].fn);
+    std::string name = tasks_[id].name;
+    lock.unlock();
+    Clock::time_point start = Clock::now();
+    {
+      ScopedTraceSpan span(name, "pipeline");
+      fn();
+    }
+    Clock::time_point end = Clock::now();
+    lock.lock();
+    intervals_.push_back(
+        {lane, std::move(name), IntervalKind::kTask, start, end});
+    tasks_[id].done = true;
+    for (int dependent : tasks_[id].dependents) {
+      if (--tasks_[dependent].pending_deps == 0) {
+        ready_.push_back(dependent);
+      }
+    }
+    changed_.notify_all();
+  }
+}
+
+void TaskGraph::PrintOccupancy(std::ostream& out) const {
+  std::vector<Interval> intervals;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    intervals = intervals_;
+  }
+  if (intervals.empty()) {
+    return;
+  }
+  std::sort(intervals.begin(), intervals.end(),
+            [](const Interval& a, const Interval& b) {
+              return a.start < b.start;
+            });
+  const Clock::time_point origin = intervals.front().start;
+  Clock::time_point last = origin;
+  struct LaneTotals {
+    double busy_ms = 0.0;
+    double blocked_ms = 0.0;
+  };
+  std::map<std::string, LaneTotals> lanes;
+  double busy_ms = 0.0;
+  for (const Interval& interval : intervals) {
+    last = std::max(last, interval.end);
+    double ms = Ms(interval.end - interval.start);
+    if (interval.kind == IntervalKind::kWait) {
+      lanes[interval.lane].blocked_ms += ms;
+    } else {
+      lanes[interval.lane].busy_ms += ms;
+      busy_ms += ms;
+    }
+  }
+  const double wall_ms = std::max(Ms(last - origin), 1e-9);
+
+  out << std::fixed << std::setprecision(1);
+  out << "[PIPELINE] Stage occupancy over " << wall_ms << " ms\n";
+  out << "  " << std::left << std::setw(10) << "lane" << std::right
+      << std::setw(12) << "busy ms" << std::setw(9) << "busy %"
+      << std::setw(13) << "blocked ms" << "\n";
+  for (const auto& [lane, totals] : lanes) {
+    out << "  " << std::left << std::setw(10) << lane << std::right
+        << std::setw(12) << totals.busy_ms << std::setw(8)
+        << 100.0 * totals.busy_ms / wall_ms << "%" << std::setw(13)
+        << totals.blocked_ms << "\n";
+  }
+  out << std::setprecision(2) << "[PIPELINE] Parallelism (busy / wall): "
+      << busy_ms / wall_ms << "\n";
+  out << std::setprecision(1) << "[PIPELINE] Timeline (start ms, length ms):\n";
+  for (const Interval& interval : intervals) {
+    out << "  " << std::setw(9) << Ms(interval.start - origin)
+        << std::setw(10) << Ms(interval.end - interval.start) << "  "
+        << std::left << std::setw(10) << interval.lane << interval.name
+        << std::right << "\n";
+  }
+  out << std::defaultfloat;
+}
+
+}  // namespace ai_edge_torch::examples
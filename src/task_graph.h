@@ -0,0 +1,97 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TASK_GRAPH_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TASK_GRAPH_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// Runs a small dependency graph of tasks on helper threads, next to work the
+// calling thread does itself, and records when every piece ran.
+//
+// A task starts on a free worker once all of its dependencies have finished.
+// The calling thread reports its own stages with RecordStage() and joins the
+// graph with Wait(); the time it spends blocked there is the serialization
+// left in the pipeline. PrintOccupancy() lays every lane out on one timeline.
+class TaskGraph {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Workers start immediately and inherit the caller's CPU affinity.
+  explicit TaskGraph(int num_workers);
+  // Lets queued tasks finish, then stops the workers.
+  ~TaskGraph();
+
+  TaskGraph(const TaskGraph&) = delete;
+  TaskGraph& operator=(const TaskGraph&) = delete;
+
+  // `deps` are ids returned by earlier Add() calls. Returns the task id.
+  int Add(std::string name, std::function<void()> fn,
+          std::vector<int> deps = {});
+
+  // Blocks until task `id` has finished.
+  void Wait(int id);
+
+  // Records work done on the calling thread between `start` and `end`.
+  void RecordStage(std::string name, Clock::time_point start,
+                   Clock::time_point end);
+
+  // Busy and blocked time per lane, the ratio of busy time to wall time, and
+  // the timeline of every stage, task and wait.
+  void PrintOccupancy(std::ostream& out) const;
+
+ private:
+  struct Task {
+    std::string name;
+    std::function<void()> fn;
+    int pending_deps = 0;
+    std::vector<int> dependents;
+    bool done = false;
+  };
+
+  enum class IntervalKind { kStage, kTask, kWait };
+
+  struct Interval {
+    std::string lane;
+    std::string name;
+    IntervalKind kind;
+    Clock::time_point start;
+    Clock::time_point end;
+  };
+
+  void WorkerLoop(int worker);
+
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<Task> tasks_;
+  std::deque<int> ready_;
+  std::vector<Interval> intervals_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TASK_GRAPH_H_
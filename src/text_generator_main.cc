@@ -1,10 +1,12 @@
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
 #include <fstream>
+#include <iomanip>
 #include <ios>
 #include <iterator>
 #include <limits>
@@ -26,6 +28,7 @@
 #include <stdexcept>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
 #ifndef __NR_perf_event_open
 #define __NR_perf_event_open 241  // Syscall number for aarch64
 #endif
@@ -34,8 +37,35 @@
 // AI EDGE TORCH
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
+#include "absl/flags/reflection.h"
 #include "absl/strings/match.h"
+#include "ai_edge_torch/generative/examples/cpp/batch_scheduler.h"
+#include "ai_edge_torch/generative/examples/cpp/beam_search.h"
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+#include "ai_edge_torch/generative/examples/cpp/energy_meter.h"
+#include "ai_edge_torch/generative/examples/cpp/execution_plan.h"
+#include "ai_edge_torch/generative/examples/cpp/execution_plan_capture.h"
+#include "ai_edge_torch/generative/examples/cpp/hw_counters.h"
+#include "ai_edge_torch/generative/examples/cpp/instrumentation.h"
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+#include "ai_edge_torch/generative/examples/cpp/latency_mode.h"
+#include "ai_edge_torch/generative/examples/cpp/latency_histogram.h"
+#include "ai_edge_torch/generative/examples/cpp/memory_pressure.h"
+#include "ai_edge_torch/generative/examples/cpp/memory_sampler.h"
+#include "ai_edge_torch/generative/examples/cpp/numa_placement.h"
+#include "ai_edge_torch/generative/examples/cpp/op_profiler.h"
+#include "ai_edge_torch/generative/examples/cpp/request_scheduler.h"
+#include "ai_edge_torch/generative/examples/cpp/results_writer.h"
+#include "ai_edge_torch/generative/examples/cpp/sampler.h"
+#include "ai_edge_torch/generative/examples/cpp/speculative_decoder.h"
+#include "ai_edge_torch/generative/examples/cpp/stall_accounting.h"
+#include "ai_edge_torch/generative/examples/cpp/task_graph.h"
+#include "ai_edge_torch/generative/examples/cpp/thermal_governor.h"
+#include "ai_edge_torch/generative/examples/cpp/token_streamer.h"
+#include "ai_edge_torch/generative/examples/cpp/trace_writer.h"
+#include "ai_edge_torch/generative/examples/cpp/tuning_cache.h"
 #include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "ai_edge_torch/generative/examples/cpp/weight_prefetcher.h"
 #include "src/sentencepiece_processor.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
 #include "tensorflow/lite/experimental/genai/genai_ops.h"
@@ -59,15 +89,216 @@ ABSL_FLAG(std::string, start_token, "",
 ABSL_FLAG(std::string, stop_token, "",
           "Optional stop token that stops the decoding loop if encountered.");
 ABSL_FLAG(int, num_threads, 4, "Number of threads to use. Defaults to 4.");
+ABSL_FLAG(int, prefill_num_threads, 0,
+          "Threads for prefill; 0 uses --num_threads. A different decode count builds a second interpreter.");
+ABSL_FLAG(int, decode_num_threads, 0, "Threads for decode; 0 uses --num_threads.");
+ABSL_FLAG(bool, autotune_threads, false,
+          "Times every candidate thread count for prefill and decode on the first run and caches the "
+          "fastest per model and CPU set in --tuning_cache. Explicit per-phase flags still win.");
+ABSL_FLAG(std::string, tuning_cache, "",
+          "File holding auto-tuned settings and the --autotune device profile; defaults to "
+          "<tflite_model>.tuning. Profile settings apply to flags left at their defaults.");
+ABSL_FLAG(int, autotune_reps, 3, "Timed invocations per candidate when auto-tuning.");
+ABSL_FLAG(bool, autotune, false,
+          "Benchmarks core set, thread count, weight cache, prefill signature and prefetch depth "
+          "over --autotune_prompts, saves the fastest combination to the device profile and exits.");
+ABSL_FLAG(std::string, autotune_prompts, "",
+          "Prompt file (one per line, or the prompt/ <tokens>,\"text\" format) for --autotune; "
+          "defaults to --prompt.");
+ABSL_FLAG(int, autotune_decode_steps, 16, "Decode steps timed per prompt by --autotune.");
+ABSL_FLAG(std::string, prefill_signature, "",
+          "Prefill signature to use; empty picks the smallest one that fits the prompt.");
+ABSL_FLAG(int, prefetch_depth, 0,
+          "If > 0, madvise(WILLNEED) the mmap'd weights of the node this many steps ahead.");
+ABSL_FLAG(std::string, thread_placement, "none",
+          "Core placement on big.LITTLE CPUs: 'none', 'performance' (interpreter workers on the big "
+          "cores, detokenizer and sampler threads on the little cores) or 'efficiency'.");
+ABSL_FLAG(std::string, numa_policy, "none",
+          "NUMA placement on multi-socket hosts: 'none', 'bind' (interpreter threads and all "
+          "allocations on --numa_node) or 'interleave' (model, arena and KV cache pages spread over "
+          "every node).");
+ABSL_FLAG(int, numa_node, -1,
+          "Node for --numa_policy=bind; -1 uses the node of the first compute CPU.");
+ABSL_FLAG(bool, numa_replicate_weights, false,
+          "With --numa_policy, reads the model into a private copy placed by the policy instead of "
+          "mapping the shared page cache, when the nodes have twice the model size free.");
 ABSL_FLAG(std::string, weight_cache_path, "",
           "Path for XNNPACK weight caching, e.g., /tmp/model.xnnpack_cache.");
 ABSL_FLAG(std::string, lora_path, "", "Optional path to a LoRA artifact.");
+ABSL_FLAG(std::string, draft_model, "",
+          "Optional small tflite model sharing the tokenizer. Enables speculative decoding.");
+ABSL_FLAG(std::string, draft_weight_cache_path, "",
+          "Path for XNNPACK weight caching of the draft model.");
+ABSL_FLAG(int, num_draft_tokens, 4,
+          "Number of tokens the draft proposes per speculative round.");
+ABSL_FLAG(bool, prompt_lookup, false,
+          "Speculative decoding that drafts by matching n-grams of the prompt and output.");
+ABSL_FLAG(int, prompt_lookup_min_ngram, 1, "Shortest suffix n-gram used for prompt lookup.");
+ABSL_FLAG(int, prompt_lookup_max_ngram, 3, "Longest suffix n-gram used for prompt lookup.");
+ABSL_FLAG(std::string, batch_prompts_file, "",
+          "File with one prompt per line. Generates them all with batched decoding.");
+ABSL_FLAG(std::string, decode_batch_signature, "decode_batch",
+          "Decode signature with a batch dimension used by --batch_prompts_file.");
+ABSL_FLAG(std::string, serve_requests_file, "",
+          "Serves the requests in this file, one '<class>\\t<arrival ms>\\t<prompt>' per line with "
+          "class 'interactive' or 'background', time-slicing them on one interpreter.");
+ABSL_FLAG(int, serve_max_sessions, 4,
+          "Sessions of each priority or higher that hold a KV cache at once in serving mode.");
+ABSL_FLAG(int, serve_prefill_chunk, 64,
+          "Prompt tokens prefilled per scheduling step in serving mode; 0 uses the largest prefill "
+          "signature.");
+ABSL_FLAG(int, serve_quantum_tokens, 4,
+          "Steps a session runs before an equal-priority session gets its turn in serving mode.");
+ABSL_FLAG(double, serve_interactive_ttft_ms, 500.0, "Time-to-first-token deadline of interactive requests.");
+ABSL_FLAG(double, serve_interactive_token_ms, 150.0, "Inter-token deadline of interactive requests.");
+ABSL_FLAG(bool, memory_pressure, false,
+          "Watches the cgroup memory limit, memory.events and a PSI trigger and degrades in stages "
+          "(shrink caches, drop idle arenas, stop prefetching, cap context, refuse requests).");
+ABSL_FLAG(double, memory_pressure_ratio, 0.8,
+          "Fraction of the cgroup memory limit at which --memory_pressure enters its first stage.");
+ABSL_FLAG(int, memory_pressure_token_cap, 32,
+          "Tokens a generation may still add once --memory_pressure caps the context.");
+ABSL_FLAG(int, beam_width, 0,
+          "If > 0, decode with beam search (or n-best sampling) over this many beams.");
+ABSL_FLAG(int, num_return_sequences, 1, "Number of hypotheses printed in beam mode.");
+ABSL_FLAG(std::string, beam_mode, "beam", "'beam' for beam search, 'sample' for n-best sampling.");
+ABSL_FLAG(float, length_penalty, 1.0f,
+          "Hypotheses are ranked by log_prob / length^length_penalty.");
+ABSL_FLAG(std::string, latency_mode, "off",
+          "Comma-separated settings held on the inference threads while decoding: fifo or rr "
+          "(SCHED_FIFO/SCHED_RR), nice, uclamp (util_min), freq (cpufreq floor) and dma "
+          "(/dev/cpu_dma_latency). Everything is restored after decoding and at exit.");
+ABSL_FLAG(int, latency_rt_priority, 10, "Real-time priority for --latency_mode=fifo or rr.");
+ABSL_FLAG(int, latency_nice, -10, "Nice value for --latency_mode=nice.");
+ABSL_FLAG(int, latency_uclamp_min, 1024, "Utilization clamp minimum (0-1024) for --latency_mode=uclamp.");
+ABSL_FLAG(int64_t, latency_min_freq_khz, -1,
+          "Frequency floor for --latency_mode=freq; -1 holds each policy at scaling_max_freq.");
+ABSL_FLAG(int, latency_ab_block, 0,
+          "Measurement mode: alternates blocks of this many decode steps without and with "
+          "--latency_mode and reports the jitter of each. 0 (default) holds latency mode for the "
+          "whole decode.");
+ABSL_FLAG(double, thermal_target_c, 0.0,
+          "If > 0, holds this CPU temperature during decode by capping frequency, migrating to the "
+          "efficiency cluster and pacing tokens, before the hardware throttles.");
+ABSL_FLAG(std::string, thermal_zones, "",
+          "Comma-separated thermal zone types watched by --thermal_target_c; empty picks CPU zones.");
+ABSL_FLAG(bool, pipelined_setup, false,
+          "Loads the tokenizer and encodes the prompt on a helper thread while the model loads and "
+          "the interpreter is built, and prints the stage occupancy of the run.");
+ABSL_FLAG(bool, async_detokenize, true,
+          "Detokenize and print output on a writer thread instead of the decode loop.");
+ABSL_FLAG(std::string, trace_out, "",
+          "If set, writes a Chrome trace (JSON) of the whole run to this path.");
+ABSL_FLAG(bool, op_profile, false, "Profile per-operator latency of the prefill and decode subgraphs.");
+ABSL_FLAG(std::string, op_profile_csv, "", "If set with --op_profile, writes per-node latency as CSV.");
+ABSL_FLAG(int, op_profile_top, 20, "Number of slowest nodes listed per phase by --op_profile.");
+ABSL_FLAG(std::string, dump_execution_plan, "",
+          "If set, writes every subgraph's execution plan and tensor layout to <path>.json and "
+          "<path>.bin after the runners are prepared, then exits without generating.");
+ABSL_FLAG(std::string, memory_samples_out, "",
+          "If set, samples RSS, page faults and cgroup memory in-process and writes them as CSV.");
+ABSL_FLAG(int, memory_sample_interval_us, 500, "Sampling interval of --memory_samples_out.");
+ABSL_FLAG(bool, stall_accounting, false,
+          "Attributes each decode step's stall time to reclaim, I/O or CPU contention (PSI, schedstat).");
+ABSL_FLAG(std::string, stall_csv, "", "If set, writes the per-step stall accounting as CSV.");
+ABSL_FLAG(bool, hw_counters, false,
+          "Reports grouped hardware counters per phase: IPC, cache/TLB MPKI and memory bandwidth.");
+ABSL_FLAG(bool, energy, false,
+          "Reads RAPL, hwmon or battery energy and reports joules per prefill and decode token, "
+          "by thread count and CPU frequency.");
+ABSL_FLAG(std::string, sysfs_root, "/sys",
+          "Root of the sysfs tree used by --energy and --thermal_target_c; tests can use a fake one.");
+ABSL_FLAG(double, peak_bandwidth_gbps, 0.0,
+          "Peak memory bandwidth for --hw_counters; 0 measures it at startup.");
+ABSL_FLAG(std::string, metrics_json, "",
+          "If set, writes decoding latency percentiles and histograms as JSON to this path.");
+ABSL_FLAG(std::string, results_json, "",
+          "If set, writes every phase, decoding and environment metric of the run as JSON "
+          "(compare runs with evaluation/compare_results.py).");
 
 namespace
 {
 
     using ai_edge_torch::examples::AlignedAllocator;
+    using ai_edge_torch::examples::BatchedDecodeScheduler;
+    using ai_edge_torch::examples::BatchSession;
+    using ai_edge_torch::examples::BatchedBeamBackend;
+    using ai_edge_torch::examples::BeamDecodeBackend;
+    using ai_edge_torch::examples::BeamSearch;
+    using ai_edge_torch::examples::BeamSearchOptions;
+    using ai_edge_torch::examples::ClassifyBound;
+    using ai_edge_torch::examples::Hypothesis;
+    using ai_edge_torch::examples::Instrumentation;
+    using ai_edge_torch::examples::JsonWriter;
+    using ai_edge_torch::examples::LatencyGuard;
+    using ai_edge_torch::examples::LatencyHistogram;
+    using ai_edge_torch::examples::LatencyOptions;
+    using ai_edge_torch::examples::ScopedTraceSpan;
+    using ai_edge_torch::examples::SharedPrefixBeamBackend;
+    using ai_edge_torch::examples::CaptureExecutionPlan;
+    using ai_edge_torch::examples::CollectRunEnvironment;
+    using ai_edge_torch::examples::DiscoverNumaTopology;
+    using ai_edge_torch::examples::FormatPageNodes;
+    using ai_edge_torch::examples::NumaBuffer;
+    using ai_edge_torch::examples::NumaNode;
+    using ai_edge_torch::examples::NumaPolicy;
+    using ai_edge_torch::examples::NumaPolicyName;
+    using ai_edge_torch::examples::NumaTopology;
+    using ai_edge_torch::examples::ParseNumaPolicy;
+    using ai_edge_torch::examples::SamplePageNodes;
+    using ai_edge_torch::examples::SetMemoryPolicy;
+    using ai_edge_torch::examples::CpuFreqReader;
+    using ai_edge_torch::examples::CpuTopology;
+    using ai_edge_torch::examples::DiscoverCpuTopology;
+    using ai_edge_torch::examples::FormatCpuList;
+    using ai_edge_torch::examples::GetThreadAffinity;
+    using ai_edge_torch::examples::ListThreadIds;
     using ai_edge_torch::examples::LoRA;
+    using ai_edge_torch::examples::MeasurePeakReadBandwidth;
+    using ai_edge_torch::examples::MemoryPressureController;
+    using ai_edge_torch::examples::MemoryPressureOptions;
+    using ai_edge_torch::examples::MemorySampler;
+    using ai_edge_torch::examples::WriteExecutionPlanBinary;
+    using ai_edge_torch::examples::WriteExecutionPlanJson;
+    using ai_edge_torch::examples::OpProfiler;
+    using ai_edge_torch::examples::ParseLatencyModes;
+    using ai_edge_torch::examples::ParseThreadPlacement;
+    using ai_edge_torch::examples::PlacementPlan;
+    using ai_edge_torch::examples::PlanThreadPlacement;
+    using ai_edge_torch::examples::PressureStage;
+    using ai_edge_torch::examples::PromptLookupProposer;
+    using ai_edge_torch::examples::RequestClass;
+    using ai_edge_torch::examples::RequestScheduler;
+    using ai_edge_torch::examples::ResultsWriter;
+    using ai_edge_torch::examples::ServingRequest;
+    using ai_edge_torch::examples::ServingSession;
+    using ai_edge_torch::examples::SessionBackend;
+    using ai_edge_torch::examples::DraftModelProposer;
+    using ai_edge_torch::examples::DraftProposer;
+    using ai_edge_torch::examples::EnergyMeter;
+    using ai_edge_torch::examples::ExecutionPlan;
+    using ai_edge_torch::examples::GenerationRequest;
+    using ai_edge_torch::examples::HardwareCounters;
+    using ai_edge_torch::examples::KVCache;
+    using ai_edge_torch::examples::Sampler;
+    using ai_edge_torch::examples::SpeculativeDecoder;
+    using ai_edge_torch::examples::SpeculativeStep;
+    using ai_edge_torch::examples::ThermalGovernor;
+    using ai_edge_torch::examples::ThermalOptions;
+    using ai_edge_torch::examples::StallAccounting;
+    using ai_edge_torch::examples::StallDelta;
+    using ai_edge_torch::examples::StallSnapshot;
+    using ai_edge_torch::examples::TaskGraph;
+    using ai_edge_torch::examples::ScopedThreadAffinity;
+    using ai_edge_torch::examples::SetThreadAffinity;
+    using ai_edge_torch::examples::ThreadPlacement;
+    using ai_edge_torch::examples::ThreadPlacementName;
+    using ai_edge_torch::examples::TokenStreamer;
+    using ai_edge_torch::examples::ThreadCountCandidates;
+    using ai_edge_torch::examples::TraceWriter;
+    using ai_edge_torch::examples::TuningCache;
+    using ai_edge_torch::examples::TuningKey;
+    using ai_edge_torch::examples::WeightPrefetcher;
 
     // Performance metrics structure to store all relevant timing data
     struct PerfStats {
@@ -79,10 +310,21 @@ namespace
         double system_time_sec;
         double cpu_time_sec;  // user + system
         
-        // I/O time (from multiple sources)
+        // I/O time (block I/O delay accounting, or PSI io when it is off)
         double io_wait_time_ms;
         double io_bytes_read;
         double io_bytes_written;
+
+        // Stalls (PSI memory, run-queue delay of all threads) and faults
+        double memory_stall_ms;
+        double run_delay_ms;
+        int64_t major_faults;
+
+        // Grouped hardware counters (valid only with --hw_counters)
+        HardwareCounters::Stats hw;
+
+        // Machine energy over the phase (valid only with --energy)
+        EnergyMeter::Stats energy;
         
         // Per-core metrics (if available)
         std::vector<double> core_user_times;
@@ -94,6 +336,7 @@ namespace
         
         PerfStats() : wall_time_ms(0), user_time_sec(0), system_time_sec(0), 
                     cpu_time_sec(0), io_wait_time_ms(0), io_bytes_read(0), io_bytes_written(0),
+                    memory_stall_ms(0), run_delay_ms(0), major_faults(0),
                     process_cpu_time_sec(0) {}
     };
 
@@ -107,6 +350,70 @@ namespace
         return ts.tv_sec + (ts.tv_nsec / 1.0e9);
     }
 
+    void WriteDoubleArray(JsonWriter* json, const std::string& key, const std::vector<double>& values) {
+        json->Key(key);
+        json->BeginArray();
+        for (double value : values) {
+            json->Number(value);
+        }
+        json->EndArray();
+    }
+
+    // Every PerfStats field, under the same names as the struct
+    void WritePerfStatsJson(const PerfStats& stats, JsonWriter* json) {
+        json->BeginObject();
+        json->Field("wall_time_ms", stats.wall_time_ms);
+        json->Field("user_time_sec", stats.user_time_sec);
+        json->Field("system_time_sec", stats.system_time_sec);
+        json->Field("cpu_time_sec", stats.cpu_time_sec);
+        json->Field("process_cpu_time_sec", stats.process_cpu_time_sec);
+        json->Field("io_wait_time_ms", stats.io_wait_time_ms);
+        json->Field("io_bytes_read", stats.io_bytes_read);
+        json->Field("io_bytes_written", stats.io_bytes_written);
+        json->Field("memory_stall_ms", stats.memory_stall_ms);
+        json->Field("run_delay_ms", stats.run_delay_ms);
+        json->Field("major_faults", stats.major_faults);
+        WriteDoubleArray(json, "core_user_times", stats.core_user_times);
+        WriteDoubleArray(json, "core_system_times", stats.core_system_times);
+        WriteDoubleArray(json, "core_cpu_times", stats.core_cpu_times);
+        if (stats.hw.valid) {
+            // Unavailable counters (-1) become null
+            auto optional = [&](const char* key, double value) {
+                json->Key(key);
+                if (value >= 0) {
+                    json->Number(value);
+                } else {
+                    json->Null();
+                }
+            };
+            json->Key("hw");
+            json->BeginObject();
+            for (int event = 0; event < HardwareCounters::kNumEvents; ++event) {
+                optional(HardwareCounters::EventName(static_cast<HardwareCounters::Event>(event)),
+                         stats.hw.counts[event]);
+            }
+            json->Field("coverage", stats.hw.coverage);
+            optional("ipc", stats.hw.ipc);
+            optional("backend_stall_fraction", stats.hw.backend_stall_fraction);
+            optional("llc_mpki", stats.hw.llc_mpki);
+            optional("llc_miss_ratio", stats.hw.llc_miss_ratio);
+            optional("l1d_mpki", stats.hw.l1d_mpki);
+            optional("dtlb_mpki", stats.hw.dtlb_mpki);
+            optional("bus_accesses_pki", stats.hw.bus_accesses_pki);
+            optional("memory_bytes", stats.hw.memory_bytes);
+            optional("achieved_gbps", stats.hw.achieved_gbps);
+            json->EndObject();
+        }
+        if (stats.energy.valid) {
+            json->Key("energy");
+            json->BeginObject();
+            json->Field("joules", stats.energy.joules);
+            json->Field("average_watts", stats.energy.average_watts);
+            json->EndObject();
+        }
+        json->EndObject();
+    }
+
     // Function to detect which cores the process is actually running on
     std::vector<int> detect_active_cores() {
         std::vector<int> cores;
@@ -205,6 +512,21 @@ namespace
             
             // For I/O stats
             std::unordered_map<std::string, IOStats> phase_start_io;
+
+            // For stall time (PSI, schedstat, delay accounting) and faults
+            StallAccounting stall_accounting;
+            std::unordered_map<std::string, StallSnapshot> phase_start_stall;
+
+            // For grouped hardware counters, opened once by the caller
+            const HardwareCounters* hw_counters = nullptr;
+            std::unordered_map<std::string, HardwareCounters::Snapshot> phase_start_hw;
+
+            // For machine energy, read at the same points as the counters
+            EnergyMeter* energy_meter = nullptr;
+            std::unordered_map<std::string, EnergyMeter::Snapshot> phase_start_energy;
+
+            // Main-thread stages are reported to the setup pipeline, if any
+            TaskGraph* task_graph = nullptr;
             
             // For per-core CPU times from /proc/stat
             std::unordered_map<std::string, std::vector<std::pair<double, double>>> phase_start_core_times;
@@ -213,10 +535,6 @@ namespace
             struct CoreEventFds {
                 std::vector<int> user_time_fds;
                 std::vector<int> system_time_fds;
-                std::vector<int> io_wait_fds;
-                std::vector<int> cpu_cycles_fds;      // Add this missing field
-                std::vector<int> cpu_instructions_fds; // Add this missing field
-                std::vector<int> cpu_ref_cycles_fds;   // Add this missing field
             };
             
             std::unordered_map<std::string, CoreEventFds> phase_core_fds;
@@ -276,80 +594,6 @@ namespace
                 return fd;
             }
             
-            // Setup I/O wait counter
-            int setup_io_wait_counter(int core_id) {
-                struct perf_event_attr pe;
-                memset(&pe, 0, sizeof(struct perf_event_attr));
-                pe.type = PERF_TYPE_SOFTWARE;
-                pe.size = sizeof(struct perf_event_attr);
-                
-                // Block I/O delay tracking
-                pe.config = PERF_COUNT_SW_CPU_MIGRATIONS;  // As a proxy for I/O waits
-                pe.disabled = 1;
-                pe.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-                
-                int fd = perf_event_open(&pe, getpid(), core_id, -1, 0);
-                if (fd == -1) {
-                    std::cerr << "Warning: Failed to open I/O wait perf event for core " 
-                                << core_id << ": " << strerror(errno) << std::endl;
-                }
-                return fd;
-            }
-
-            // Setup CPU cycles counter for a specific core
-            int setup_cpu_cycles_counter(int core_id) {
-                struct perf_event_attr pe;
-                memset(&pe, 0, sizeof(struct perf_event_attr));
-                pe.type = PERF_TYPE_HARDWARE;
-                pe.size = sizeof(struct perf_event_attr);
-                pe.config = PERF_COUNT_HW_CPU_CYCLES;
-                pe.disabled = 1;
-                pe.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-                
-                int fd = perf_event_open(&pe, getpid(), core_id, -1, 0);
-                if (fd == -1) {
-                    std::cerr << "Warning: Failed to open CPU cycles perf event for core " 
-                            << core_id << ": " << strerror(errno) << std::endl;
-                }
-                return fd;
-            }
-
-            // Setup CPU instructions counter for a specific core
-            int setup_cpu_instructions_counter(int core_id) {
-                struct perf_event_attr pe;
-                memset(&pe, 0, sizeof(struct perf_event_attr));
-                pe.type = PERF_TYPE_HARDWARE;
-                pe.size = sizeof(struct perf_event_attr);
-                pe.config = PERF_COUNT_HW_INSTRUCTIONS;
-                pe.disabled = 1;
-                pe.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-                
-                int fd = perf_event_open(&pe, getpid(), core_id, -1, 0);
-                if (fd == -1) {
-                    std::cerr << "Warning: Failed to open CPU instructions perf event for core " 
-                            << core_id << ": " << strerror(errno) << std::endl;
-                }
-                return fd;
-            }
-
-            // Setup CPU reference cycles counter for a specific core
-            int setup_cpu_ref_cycles_counter(int core_id) {
-                struct perf_event_attr pe;
-                memset(&pe, 0, sizeof(struct perf_event_attr));
-                pe.type = PERF_TYPE_HARDWARE;
-                pe.size = sizeof(struct perf_event_attr);
-                pe.config = PERF_COUNT_HW_REF_CPU_CYCLES;
-                pe.disabled = 1;
-                pe.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-                
-                int fd = perf_event_open(&pe, getpid(), core_id, -1, 0);
-                if (fd == -1) {
-                    std::cerr << "Warning: Failed to open CPU reference cycles perf event for core " 
-                            << core_id << ": " << strerror(errno) << std::endl;
-                }
-                return fd;
-            }
-            
             // Get system I/O wait percentage
             double get_system_io_wait() {
                 std::ifstream stat_file("/proc/stat");
@@ -390,6 +634,20 @@ namespace
                 }
                 std::cout << std::endl;
             }
+
+            // Counters must outlive the monitor; null disables them
+            void set_hardware_counters(const HardwareCounters* counters) {
+                hw_counters = counters;
+            }
+
+            // Meter must outlive the monitor; null disables it
+            void set_energy_meter(EnergyMeter* meter) {
+                energy_meter = meter;
+            }
+
+            void set_task_graph(TaskGraph* graph) {
+                task_graph = graph;
+            }
             
             // Start monitoring a phase
             void start_phase(const std::string& phase_name) {
@@ -403,6 +661,7 @@ namespace
                 
                 // Record I/O stats
                 phase_start_io[phase_name] = get_io_stats();
+                phase_start_stall[phase_name] = stall_accounting.Snapshot();
                 
                 // Add timespec measurements for CPU time
                 struct timespec process_ts;
@@ -441,10 +700,6 @@ namespace
                 CoreEventFds core_fds;
                 core_fds.user_time_fds.resize(monitored_cores.size(), -1);
                 core_fds.system_time_fds.resize(monitored_cores.size(), -1);
-                core_fds.io_wait_fds.resize(monitored_cores.size(), -1);
-                core_fds.cpu_cycles_fds.resize(monitored_cores.size(), -1);
-                core_fds.cpu_instructions_fds.resize(monitored_cores.size(), -1);
-                core_fds.cpu_ref_cycles_fds.resize(monitored_cores.size(), -1);
                 
                 for (size_t i = 0; i < monitored_cores.size(); ++i) {
                     int core_id = monitored_cores[i];
@@ -462,42 +717,43 @@ namespace
                         ioctl(core_fds.system_time_fds[i], PERF_EVENT_IOC_RESET, 0);
                         ioctl(core_fds.system_time_fds[i], PERF_EVENT_IOC_ENABLE, 0);
                     }
-                    
-                    // Setup I/O wait counters
-                    core_fds.io_wait_fds[i] = setup_io_wait_counter(core_id);
-                    if (core_fds.io_wait_fds[i] != -1) {
-                        ioctl(core_fds.io_wait_fds[i], PERF_EVENT_IOC_RESET, 0);
-                        ioctl(core_fds.io_wait_fds[i], PERF_EVENT_IOC_ENABLE, 0);
-                    }
-                    
-                    // Setup CPU cycles counter
-                    // core_fds.cpu_cycles_fds[i] = setup_cpu_cycles_counter(core_id);
-                    // if (core_fds.cpu_cycles_fds[i] != -1) {
-                    //     ioctl(core_fds.cpu_cycles_fds[i], PERF_EVENT_IOC_RESET, 0);
-                    //     ioctl(core_fds.cpu_cycles_fds[i], PERF_EVENT_IOC_ENABLE, 0);
-                    // }
-                    
-                    // Setup CPU instructions counter
-                    core_fds.cpu_instructions_fds[i] = setup_cpu_instructions_counter(core_id);
-                    if (core_fds.cpu_instructions_fds[i] != -1) {
-                        ioctl(core_fds.cpu_instructions_fds[i], PERF_EVENT_IOC_RESET, 0);
-                        ioctl(core_fds.cpu_instructions_fds[i], PERF_EVENT_IOC_ENABLE, 0);
-                    }
-                    
-                    // Setup CPU reference cycles counter
-                    // core_fds.cpu_ref_cycles_fds[i] = setup_cpu_ref_cycles_counter(core_id);
-                    // if (core_fds.cpu_ref_cycles_fds[i] != -1) {
-                    //     ioctl(core_fds.cpu_ref_cycles_fds[i], PERF_EVENT_IOC_RESET, 0);
-                    //     ioctl(core_fds.cpu_ref_cycles_fds[i], PERF_EVENT_IOC_ENABLE, 0);
-                    // }
+
                 }
                 
                 phase_core_fds[phase_name] = core_fds;
+
+                // Read last so the setup above is not counted
+                if (hw_counters) {
+                    hw_counters->Read(&phase_start_hw[phase_name]);
+                }
+                if (energy_meter) {
+                    energy_meter->Read(&phase_start_energy[phase_name]);
+                }
             }
             
             // End monitoring a phase and return statistics
             PerfStats end_phase(const std::string& phase_name) {
                 PerfStats stats;
+
+                // Read first so the bookkeeping below is not counted
+                auto hw_it = phase_start_hw.find(phase_name);
+                if (hw_counters && hw_it != phase_start_hw.end()) {
+                    HardwareCounters::Snapshot hw_end;
+                    hw_counters->Read(&hw_end);
+                    double wall_ms = 0.0;
+                    auto start_it = phase_start_times.find(phase_name);
+                    if (start_it != phase_start_times.end()) {
+                        wall_ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start_it->second).count();
+                    }
+                    stats.hw = hw_counters->Diff(hw_it->second, hw_end, wall_ms);
+                    phase_start_hw.erase(hw_it);
+                }
+                auto energy_it = phase_start_energy.find(phase_name);
+                if (energy_meter && energy_it != phase_start_energy.end()) {
+                    stats.energy = energy_meter->Diff(energy_it->second, energy_meter->Read());
+                    phase_start_energy.erase(energy_it);
+                }
                 
                 // Check if the phase exists in all required maps
                 auto time_it = phase_start_times.find(phase_name);
@@ -516,6 +772,9 @@ namespace
                     auto end_time = std::chrono::steady_clock::now();
                     stats.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                         end_time - time_it->second).count();
+                    if (task_graph) {
+                        task_graph->RecordStage(phase_name, time_it->second, end_time);
+                    }
                     
                     // Clean up
                     phase_start_times.erase(time_it);
@@ -548,25 +807,20 @@ namespace
                     stats.io_bytes_read = end_io.bytes_read - io_it->second.bytes_read;
                     stats.io_bytes_written = end_io.bytes_written - io_it->second.bytes_written;
                     
-                    // Estimate I/O wait time based on I/O volume and throughput
-                    uint64_t total_io_bytes = stats.io_bytes_read + stats.io_bytes_written;
-                    uint64_t total_io_ops = (end_io.read_ops - io_it->second.read_ops) + 
-                                            (end_io.write_ops - io_it->second.write_ops);
-                    
-                    // A simple heuristic: if there was I/O activity, estimate wait time
-                    if (total_io_bytes > 0) {
-                        double io_throughput = 100.0 * 1024 * 1024; // Assume 100 MB/s
-                        stats.io_wait_time_ms = (total_io_bytes / io_throughput) * 1000.0;
-                        
-                        // Don't let I/O wait exceed wall time
-                        if (stats.wall_time_ms > 0) {
-                            stats.io_wait_time_ms = std::min(stats.io_wait_time_ms, stats.wall_time_ms * 0.9);
-                        }
-                    }
-                    
                     // Clean up
                     phase_start_io.erase(io_it);
                 }
+
+                // Measured stall time replaces any estimate from I/O volume
+                auto stall_it = phase_start_stall.find(phase_name);
+                if (stall_it != phase_start_stall.end()) {
+                    StallDelta stall = StallAccounting::Diff(stall_it->second, stall_accounting.Snapshot());
+                    stats.io_wait_time_ms = stall.io_wait_ms();
+                    stats.memory_stall_ms = std::max(0.0, stall.memory_some_ms);
+                    stats.run_delay_ms = std::max(0.0, stall.run_delay_ms);
+                    stats.major_faults = std::max<int64_t>(0, stall.major_faults);
+                    phase_start_stall.erase(stall_it);
+                }
                 
                 if (process_time_it != phase_start_process_time.end()) {
                     struct timespec end_process_ts;
@@ -660,55 +914,6 @@ namespace
                         if (i < stats.core_cpu_times.size()) {
                             stats.core_cpu_times[i] = stats.core_user_times[i] + stats.core_system_times[i];
                         }
-                        
-                        // Read and disable I/O wait counter
-                        if (core_fds.io_wait_fds[i] != -1) {
-                            uint64_t count;
-                            if (read(core_fds.io_wait_fds[i], &count, sizeof(count)) == sizeof(count)) {
-                                ioctl(core_fds.io_wait_fds[i], PERF_EVENT_IOC_DISABLE, 0);
-                                // Each CPU migration contributes to I/O wait time estimate
-                                if (count > 0) {
-                                    stats.io_wait_time_ms += count * 10.0;  // Estimate 10ms per migration
-                                }
-                            }
-                            close(core_fds.io_wait_fds[i]);
-                        }
-                        
-                        // Read CPU cycles counter
-                        if (core_fds.cpu_cycles_fds[i] != -1) {
-                            struct read_format rf;
-                            if (read(core_fds.cpu_cycles_fds[i], &rf, sizeof(rf)) == sizeof(rf)) {
-                                ioctl(core_fds.cpu_cycles_fds[i], PERF_EVENT_IOC_DISABLE, 0);
-                                
-                                // Scaling factor calculation
-                                if (rf.time_enabled > 0) {
-                                    double scaling_factor = (double)rf.time_running / rf.time_enabled;
-                                    
-                                    if (scaling_factor < 1.0 && i < stats.core_cpu_times.size()) {
-                                        stats.core_cpu_times[i] = stats.core_cpu_times[i] * scaling_factor;
-                                    }
-                                }
-                            }
-                            close(core_fds.cpu_cycles_fds[i]);
-                        }
-                        
-                        // Read CPU instructions counter
-                        if (core_fds.cpu_instructions_fds[i] != -1) {
-                            struct read_format rf;
-                            if (read(core_fds.cpu_instructions_fds[i], &rf, sizeof(rf)) == sizeof(rf)) {
-                                ioctl(core_fds.cpu_instructions_fds[i], PERF_EVENT_IOC_DISABLE, 0);
-                            }
-                            close(core_fds.cpu_instructions_fds[i]);
-                        }
-                        
-                        // Read CPU reference cycles counter
-                        if (core_fds.cpu_ref_cycles_fds[i] != -1) {
-                            struct read_format rf;
-                            if (read(core_fds.cpu_ref_cycles_fds[i], &rf, sizeof(rf)) == sizeof(rf)) {
-                                ioctl(core_fds.cpu_ref_cycles_fds[i], PERF_EVENT_IOC_DISABLE, 0);
-                            }
-                            close(core_fds.cpu_ref_cycles_fds[i]);
-                        }
                     }
                     
                     // Clean up
@@ -733,6 +938,28 @@ namespace
                 }
                 phase_stats[phase].push_back(stats);
             }
+
+            // Reference for the achieved-bandwidth lines; 0 omits them
+            void set_peak_bandwidth_gbps(double gbps) {
+                peak_bandwidth_gbps = gbps;
+            }
+
+            // {"<phase>": [PerfStats, ...], ...} plus the bandwidth reference
+            void WriteJson(JsonWriter* json) const {
+                std::map<std::string, std::vector<PerfStats>> ordered(phase_stats.begin(), phase_stats.end());
+                json->BeginObject();
+                for (const auto& [phase, stats_vec] : ordered) {
+                    json->Key(phase);
+                    json->BeginArray();
+                    for (const PerfStats& stats : stats_vec) {
+                        WritePerfStatsJson(stats, json);
+                    }
+                    json->EndArray();
+                }
+                json->EndObject();
+            }
+
+            double peak_bandwidth() const { return peak_bandwidth_gbps; }
         
             void PrintStats() const {
                 for (const auto& [phase, stats_vec] : phase_stats) {
@@ -749,6 +976,9 @@ namespace
                         double avg_system_time = 0;
                         double avg_cpu_time = 0;
                         double avg_io_wait_time = 0;
+                        double avg_memory_stall = 0;
+                        double avg_run_delay = 0;
+                        double avg_major_faults = 0;
                         double avg_io_bytes_read = 0;
                         double avg_io_bytes_written = 0;
                         
@@ -758,6 +988,9 @@ namespace
                             avg_system_time += stats.system_time_sec;
                             avg_cpu_time += stats.cpu_time_sec;
                             avg_io_wait_time += stats.io_wait_time_ms;
+                            avg_memory_stall += stats.memory_stall_ms;
+                            avg_run_delay += stats.run_delay_ms;
+                            avg_major_faults += stats.major_faults;
                             avg_io_bytes_read += stats.io_bytes_read;
                             avg_io_bytes_written += stats.io_bytes_written;
                         }
@@ -768,6 +1001,9 @@ namespace
                         avg_system_time /= count;
                         avg_cpu_time /= count;
                         avg_io_wait_time /= count;
+                        avg_memory_stall /= count;
+                        avg_run_delay /= count;
+                        avg_major_faults /= count;
                         avg_io_bytes_read /= count;
                         avg_io_bytes_written /= count;
         
@@ -777,6 +1013,9 @@ namespace
                                 << "Average system time: " << avg_system_time << " sec\n"
                                 << "Average CPU time (user+system): " << avg_cpu_time << " sec\n"
                                 << "Average I/O wait time: " << avg_io_wait_time << " ms\n"
+                                << "Average memory stall time: " << avg_memory_stall << " ms\n"
+                                << "Average run-queue delay: " << avg_run_delay << " ms\n"
+                                << "Average major faults: " << avg_major_faults << "\n"
                                 << "Average I/O bytes read: " << avg_io_bytes_read / (1024.0 * 1024.0) << " MB\n"
                                 << "Average I/O bytes written: " << avg_io_bytes_written / (1024.0 * 1024.0) << " MB\n"
                                 << "CPU utilization: " << (avg_cpu_time * 1000 * 100) / avg_wall_time << "%\n";
@@ -801,9 +1040,20 @@ namespace
                         << prefix << "Total CPU time (user+system): " << stats.cpu_time_sec << " sec\n"
                         << prefix << "Process CPU time (timespec): " << stats.process_cpu_time_sec << " sec\n"
                         << prefix << "I/O wait time: " << stats.io_wait_time_ms << " ms\n"
+                        << prefix << "Memory stall time: " << stats.memory_stall_ms << " ms\n"
+                        << prefix << "Run-queue delay: " << stats.run_delay_ms << " ms\n"
+                        << prefix << "Major faults: " << stats.major_faults << "\n"
                         << prefix << "I/O bytes read: " << stats.io_bytes_read / (1024.0 * 1024.0) << " MB\n"
                         << prefix << "I/O bytes written: " << stats.io_bytes_written / (1024.0 * 1024.0) << " MB\n"
                         << prefix << "CPU utilization: " << (stats.cpu_time_sec * 1000 * 100) / stats.wall_time_ms << "%\n";
+
+                if (stats.hw.valid) {
+                    PrintHardwareCounters(stats.hw, prefix);
+                }
+                if (stats.energy.valid) {
+                    std::cout << prefix << "Energy: " << stats.energy.joules << " J ("
+                              << stats.energy.average_watts << " W average)\n";
+                }
                         
                 // Print per-core stats if available
                 if (!stats.core_user_times.empty()) {
@@ -817,7 +1067,44 @@ namespace
                 }
             }
         
+            void PrintHardwareCounters(const HardwareCounters::Stats& hw, const std::string& prefix) const {
+                std::cout << prefix << "Hardware counters (" << 100.0 * hw.coverage << "% counted, rest scaled):\n";
+                if (hw.ipc >= 0) {
+                    std::cout << prefix << "  IPC: " << hw.ipc << "\n";
+                }
+                if (hw.backend_stall_fraction >= 0) {
+                    std::cout << prefix << "  Backend stall cycles: " << 100.0 * hw.backend_stall_fraction << "%\n";
+                }
+                if (hw.llc_mpki >= 0) {
+                    std::cout << prefix << "  LLC MPKI: " << hw.llc_mpki;
+                    if (hw.llc_miss_ratio >= 0) {
+                        std::cout << " (" << 100.0 * hw.llc_miss_ratio << "% of LLC loads)";
+                    }
+                    std::cout << "\n";
+                }
+                if (hw.l1d_mpki >= 0) {
+                    std::cout << prefix << "  L1D MPKI: " << hw.l1d_mpki << "\n";
+                }
+                if (hw.dtlb_mpki >= 0) {
+                    std::cout << prefix << "  dTLB MPKI: " << hw.dtlb_mpki << "\n";
+                }
+                if (hw.bus_accesses_pki >= 0) {
+                    std::cout << prefix << "  Bus accesses per 1K instructions: " << hw.bus_accesses_pki << "\n";
+                }
+                if (hw.achieved_gbps >= 0) {
+                    std::cout << prefix << "  Memory traffic: " << hw.memory_bytes / (1024.0 * 1024.0) << " MB, "
+                              << hw.achieved_gbps << " GB/s";
+                    if (peak_bandwidth_gbps > 0) {
+                        std::cout << " (" << 100.0 * hw.achieved_gbps / peak_bandwidth_gbps << "% of "
+                                  << peak_bandwidth_gbps << " GB/s peak)";
+                    }
+                    std::cout << "\n";
+                }
+                std::cout << prefix << "  Bound: " << ClassifyBound(hw, peak_bandwidth_gbps) << "\n";
+            }
+        
             std::unordered_map<std::string, std::vector<PerfStats>> phase_stats;
+            double peak_bandwidth_gbps = 0.0;
         };
 
     // Helper to calculate wall-to-cpu time ratio
@@ -834,7 +1121,8 @@ namespace
     public:
         explicit ScopeTimer(const std::string &name)
             : name_(name),
-              start_(std::chrono::high_resolution_clock::now()) {}
+              start_(std::chrono::high_resolution_clock::now()),
+              span_(name, "phase") {}
 
         ~ScopeTimer()
         {
@@ -842,11 +1130,16 @@ namespace
             auto duration_ms =
                 std::chrono::duration_cast<std::chrono::milliseconds>(end - start_).count();
             std::cout << "\n[INFO] " << name_ << " took " << duration_ms << " ms\n";
+            if (TraceWriter *trace_writer = TraceWriter::Get())
+            {
+                trace_writer->SampleMemoryCounters();
+            }
         }
 
     private:
         std::string name_;
         std::chrono::high_resolution_clock::time_point start_;
+        ScopedTraceSpan span_;
     };
 
     // --------------------------------------------------------------------------
@@ -865,8 +1158,10 @@ namespace
         //   - token_start: time point before inference/sampling starts for a token
         //   - inference_time_ms: how many ms were spent in model inference
         //   - sampling_time_ms : how many ms were spent in sampling the next token
+        //   - num_tokens       : tokens committed by this step (>1 for speculative rounds)
         void RecordTimes(const std::chrono::high_resolution_clock::time_point &token_start,
-                         double inference_time_ms, double sampling_time_ms)
+                         double inference_time_ms, double sampling_time_ms,
+                         int num_tokens = 1)
         {
             auto token_end = std::chrono::high_resolution_clock::now();
             double decoding_time_ms =
@@ -888,7 +1183,64 @@ namespace
             total_decoding_time_ms_ += decoding_time_ms;
 
             // Track total tokens
-            ++token_count_;
+            token_count_ += num_tokens;
+            ++step_count_;
+
+            // Per-step latency distributions
+            inference_histogram_.Record(inference_time_ms);
+            sampling_histogram_.Record(sampling_time_ms);
+            step_histogram_.Record(decoding_time_ms);
+            if (!segment_.empty())
+            {
+                segment_histograms_[segment_].Record(decoding_time_ms);
+            }
+        }
+
+        // Steps recorded from now on also count towards segment `label`, so a
+        // run that switches a setting during decode can compare both halves
+        void SetSegment(const std::string &label)
+        {
+            segment_ = label;
+        }
+
+        // Record one prefill invocation
+        //   - bucket_size: sequence length of the prefill signature used
+        //   - prefill_time_ms: latency of that invocation
+        void RecordPrefill(int bucket_size, double prefill_time_ms)
+        {
+            prefill_histograms_[bucket_size].Record(prefill_time_ms);
+        }
+
+        // Record the machine energy of prefilling `num_tokens` prompt tokens
+        void RecordPrefillEnergy(const EnergyMeter::Stats &energy, int num_tokens)
+        {
+            prefill_energy_.Add(energy, num_tokens);
+        }
+
+        // Record the machine energy of one decode step that committed
+        // `num_tokens`, under `config` (thread count and CPU frequency). The
+        // current segment, if any, is part of the configuration.
+        void RecordEnergy(const std::string &config, const EnergyMeter::Stats &energy, int num_tokens = 1)
+        {
+            decode_energy_[segment_.empty() ? config : config + ", " + segment_].Add(energy, num_tokens);
+        }
+
+        // Record a thermal governor decision taken before decode step `step`
+        void RecordThermal(const ThermalGovernor::Decision &decision)
+        {
+            thermal_decisions_.push_back(decision);
+        }
+
+        // Record the outcome of one speculative round
+        //   - num_proposed : draft tokens sent to verification
+        //   - num_accepted : draft tokens the target agreed with
+        //   - draft_time_ms: time spent producing the draft
+        void RecordSpeculation(int num_proposed, int num_accepted, double draft_time_ms)
+        {
+            total_proposed_tokens_ += num_proposed;
+            total_accepted_tokens_ += num_accepted;
+            total_draft_time_ms_ += draft_time_ms;
+            speculative_ = true;
         }
 
         // Print out final decoding metrics
@@ -927,248 +1279,260 @@ namespace
                       << "(" << avg_sampling_speed << " token/s )\n";
             std::cout << "[METRICS] Average Decoding Latency         : " << avg_decoding_time_ms << " ms/tokens"
                       << "(" << avg_decoding_speed << " token/s )\n";
-        }
-
-    private:
-        // Decode start time
-        std::chrono::high_resolution_clock::time_point decode_start_;
-
-        // Time to first token
-        double time_to_first_token_ms_ = 0.0;
-        bool first_token_recorded_ = false;
-
-        // Accumulators
-        double total_inference_time_ms_ = 0.0;
-        double total_sampling_time_ms_ = 0.0;
-        double total_decoding_time_ms_ = 0.0;
-        int token_count_ = 0;
-    };
-
-    // --------------------------------------------------------------------------
-    // A class that provides various sampling methods (Greedy, Top-K, Top-P, etc.)
-    // --------------------------------------------------------------------------
-    class Sampler
-    {
-    public:
-        // ------------------------
-        // Greedy Sampler
-        // ------------------------
-        static int GreedySampler(const TfLiteTensor *logits)
-        {
-            float max_value = -std::numeric_limits<float>::infinity();
-            int max_index = 0;
-            int vocab_size = logits->dims->data[2];
 
-            for (int i = 0; i < vocab_size; ++i)
+            if (speculative_)
             {
-                if (logits->data.f[i] > max_value)
-                {
-                    max_value = logits->data.f[i];
-                    max_index = i;
-                }
+                double acceptance_rate = (total_proposed_tokens_ > 0)
+                                             ? static_cast<double>(total_accepted_tokens_) / total_proposed_tokens_
+                                             : 0.0;
+                double tokens_per_step = (step_count_ > 0)
+                                             ? static_cast<double>(token_count_) / step_count_
+                                             : 0.0;
+                std::cout << "\n[METRICS] Speculative Rounds               : " << step_count_ << "\n";
+                std::cout << "[METRICS] Draft Tokens Proposed / Accepted : " << total_proposed_tokens_
+                          << " / " << total_accepted_tokens_ << "\n";
+                std::cout << "[METRICS] Draft Acceptance Rate            : " << acceptance_rate * 100.0 << " %\n";
+                std::cout << "[METRICS] Tokens per Target Invocation     : " << tokens_per_step << "\n";
+                std::cout << "[METRICS] Total Draft Latency              : " << total_draft_time_ms_ << " ms\n";
+                std::cout << "[METRICS] Effective Decoding Speed         : " << avg_decoding_speed << " token/s\n";
             }
-            return max_index;
-        }
-
-        // ------------------------
-        // Top-K Sampler
-        // ------------------------
-        static int TopKSampler(const TfLiteTensor *logits, int k)
-        {
-            int vocab_size = logits->dims->data[2];
-            std::vector<std::pair<float, int>> sorted_logits;
-            sorted_logits.reserve(vocab_size);
 
-            for (int i = 0; i < vocab_size; ++i)
+            if (step_histogram_.count() > 0)
             {
-                sorted_logits.emplace_back(logits->data.f[i], i);
+                std::cout << "\n[METRICS] Latency percentiles (p50 / p90 / p99 / max, jitter)\n";
+                PrintPercentiles("Inference per Step", inference_histogram_);
+                PrintPercentiles("Sampling per Step", sampling_histogram_);
+                PrintPercentiles("Decoding per Step", step_histogram_);
+                std::cout << "[METRICS] Slowest Decode Steps             :";
+                for (const auto &[index, value_ms] : step_histogram_.Slowest())
+                {
+                    std::cout << " #" << index << " (" << value_ms << " ms)";
+                }
+                std::cout << "\n";
             }
-
-            // Partial sort to get the top k elements
-            if (k < vocab_size)
+            for (const auto &[label, histogram] : segment_histograms_)
             {
-                std::partial_sort(sorted_logits.begin(), sorted_logits.begin() + k, sorted_logits.end(),
-                                  std::greater<std::pair<float, int>>());
-                sorted_logits.resize(k);
+                PrintPercentiles("Decoding per Step (" + label + ")", histogram);
             }
-            else
+            for (const auto &[bucket_size, histogram] : prefill_histograms_)
             {
-                // If k >= vocab_size, no need to cut
-                std::sort(sorted_logits.begin(), sorted_logits.end(), std::greater<std::pair<float, int>>());
+                PrintPercentiles("Prefill (bucket " + std::to_string(bucket_size) + ")", histogram);
             }
 
-            // Compute normalized probabilities
-            float sum_probs = 0.0f;
-            for (auto &pair : sorted_logits)
+            if (!thermal_decisions_.empty())
             {
-                sum_probs += std::exp(pair.first);
+                std::cout << "\n[METRICS] Thermal Decisions                : " << thermal_decisions_.size() << "\n";
+                for (const ThermalGovernor::Decision &decision : thermal_decisions_)
+                {
+                    std::cout << "[METRICS]   step " << decision.step << " at " << decision.celsius << " C, level "
+                              << decision.from_level << " -> " << decision.to_level << ": " << decision.action
+                              << "\n";
+                }
             }
-            std::vector<float> probabilities;
-            probabilities.reserve(sorted_logits.size());
-            for (auto &pair : sorted_logits)
+
+            if (prefill_energy_.tokens > 0 || !decode_energy_.empty())
             {
-                probabilities.push_back(std::exp(pair.first) / sum_probs);
+                std::cout << "\n[METRICS] Energy (mJ/token, tokens/J, average W)\n";
+                if (prefill_energy_.tokens > 0)
+                {
+                    PrintEnergy("Prefill", prefill_energy_);
+                }
+                for (const auto &[config, totals] : decode_energy_)
+                {
+                    PrintEnergy("Decode (" + config + ")", totals);
+                }
             }
-
-            // Multinomial sampling
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::discrete_distribution<> dist(probabilities.begin(), probabilities.end());
-
-            return sorted_logits[dist(gen)].second;
         }
 
-        // ------------------------
-        // Top-P (Nucleus) Sampler
-        // ------------------------
-        static int TopPSampler(const TfLiteTensor *logits, float p)
+        // Write percentiles and summary numbers as JSON. Returns false on I/O error.
+        bool WriteJson(const std::string &path) const
         {
-            int vocab_size = logits->dims->data[2];
-            std::vector<std::pair<float, int>> sorted_logits;
-            sorted_logits.reserve(vocab_size);
-
-            for (int i = 0; i < vocab_size; ++i)
+            std::ofstream out(path);
+            if (!out.is_open())
             {
-                sorted_logits.emplace_back(logits->data.f[i], i);
+                return false;
             }
+            JsonWriter json(&out);
+            WriteJson(&json);
+            out << "\n";
+            return out.good();
+        }
 
-            // Sort descending by logit value
-            std::sort(sorted_logits.begin(), sorted_logits.end(),
-                      std::greater<std::pair<float, int>>());
-
-            // Apply softmax to get probabilities
-            std::vector<float> probabilities(vocab_size);
-            float sum_exp = 0.0f;
-            for (int i = 0; i < vocab_size; ++i)
+        void WriteJson(JsonWriter *json_writer) const
+        {
+            JsonWriter &json = *json_writer;
+            json.BeginObject();
+            json.Field("generated_tokens", token_count_);
+            json.Field("decode_steps", step_count_);
+            json.Field("time_to_first_token_ms", time_to_first_token_ms_);
+            json.Field("total_inference_ms", total_inference_time_ms_);
+            json.Field("total_sampling_ms", total_sampling_time_ms_);
+            json.Field("total_decoding_ms", total_decoding_time_ms_);
+            json.Field("decoding_tokens_per_sec",
+                       total_decoding_time_ms_ > 0 ? token_count_ / (total_decoding_time_ms_ / 1000) : 0.0);
+            json.Key("inference");
+            inference_histogram_.WriteJson(&json);
+            json.Key("sampling");
+            sampling_histogram_.WriteJson(&json);
+            json.Key("decode_step");
+            step_histogram_.WriteJson(&json);
+            json.Key("prefill");
+            json.BeginObject();
+            for (const auto &[bucket_size, histogram] : prefill_histograms_)
             {
-                float val = std::exp(sorted_logits[i].first);
-                probabilities[i] = val;
-                sum_exp += val;
+                json.Key(std::to_string(bucket_size));
+                histogram.WriteJson(&json);
             }
-            for (int i = 0; i < vocab_size; ++i)
+            json.EndObject();
+            if (!segment_histograms_.empty())
             {
-                probabilities[i] /= sum_exp;
+                json.Key("segments");
+                json.BeginObject();
+                for (const auto &[label, histogram] : segment_histograms_)
+                {
+                    json.Key(label);
+                    histogram.WriteJson(&json);
+                }
+                json.EndObject();
             }
-
-            // Find the cutoff index where cumulative probability exceeds p
-            float cumulative_prob = 0.0f;
-            int cutoff_index = vocab_size - 1;
-            for (int i = 0; i < vocab_size; ++i)
+            if (!thermal_decisions_.empty())
             {
-                cumulative_prob += probabilities[i];
-                if (cumulative_prob > p)
+                json.Key("thermal_decisions");
+                json.BeginArray();
+                for (const ThermalGovernor::Decision &decision : thermal_decisions_)
                 {
-                    cutoff_index = i;
-                    break;
+                    json.BeginObject();
+                    json.Field("step", decision.step);
+                    json.Field("time_ms", decision.time_ms);
+                    json.Field("celsius", decision.celsius);
+                    json.Field("slope_c_per_s", decision.slope);
+                    json.Field("freq_khz", decision.freq_khz);
+                    json.Field("from_level", decision.from_level);
+                    json.Field("to_level", decision.to_level);
+                    json.Field("action", decision.action);
+                    json.EndObject();
                 }
+                json.EndArray();
             }
-
-            // Resize vectors to [0..cutoff_index]
-            float new_sum = 0.0f;
-            for (int i = 0; i <= cutoff_index; ++i)
+            if (prefill_energy_.tokens > 0 || !decode_energy_.empty())
             {
-                new_sum += probabilities[i];
+                json.Key("energy");
+                json.BeginObject();
+                json.Key("prefill");
+                prefill_energy_.WriteJson(&json);
+                json.Key("decode");
+                json.BeginObject();
+                for (const auto &[config, totals] : decode_energy_)
+                {
+                    json.Key(config);
+                    totals.WriteJson(&json);
+                }
+                json.EndObject();
+                json.EndObject();
             }
-            for (int i = 0; i <= cutoff_index; ++i)
+            if (speculative_)
             {
-                probabilities[i] /= new_sum;
+                json.Key("speculative");
+                json.BeginObject();
+                json.Field("proposed_tokens", total_proposed_tokens_);
+                json.Field("accepted_tokens", total_accepted_tokens_);
+                json.Field("draft_ms", total_draft_time_ms_);
+                json.EndObject();
             }
-
-            probabilities.resize(cutoff_index + 1);
-            sorted_logits.resize(cutoff_index + 1);
-
-            // Multinomial sampling
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::discrete_distribution<> dist(probabilities.begin(), probabilities.end());
-            return sorted_logits[dist(gen)].second;
+            json.EndObject();
         }
 
-        // ------------------------
-        // Temperature + Top-K + Top-P Sampler
-        // ------------------------
-        static int TemperatureTopKTopPSampler(const TfLiteTensor *logits,
-                                              float temperature, int k, float p)
+    private:
+        struct EnergyTotals
         {
-            int vocab_size = logits->dims->data[2];
-            std::vector<std::pair<float, int>> sorted_logits;
-            sorted_logits.reserve(vocab_size);
-
-            // 1) Apply Temperature
-            std::vector<float> scaled_logits(vocab_size);
-            for (int i = 0; i < vocab_size; ++i)
-            {
-                scaled_logits[i] = logits->data.f[i] / temperature;
-            }
-
-            // 2) Softmax over scaled logits
-            float max_logit = *std::max_element(scaled_logits.begin(), scaled_logits.end());
-            float sum_exp = 0.0f;
-            for (int i = 0; i < vocab_size; ++i)
-            {
-                scaled_logits[i] = std::exp(scaled_logits[i] - max_logit);
-                sum_exp += scaled_logits[i];
-            }
-            for (int i = 0; i < vocab_size; ++i)
-            {
-                scaled_logits[i] /= sum_exp;
-                // Keep index-value pairs for sorting
-                sorted_logits.emplace_back(scaled_logits[i], i);
-            }
+            int tokens = 0;
+            double joules = 0.0;
+            double ms = 0.0;
 
-            // 3) Sort descending by probability
-            std::sort(sorted_logits.begin(), sorted_logits.end(),
-                      std::greater<std::pair<float, int>>());
-
-            // 4) Top-K filter
-            int top_k = std::min(k, vocab_size);
-            sorted_logits.resize(top_k);
-
-            // 5) Top-P filter within top-k
-            float cumulative_prob = 0.0f;
-            int cutoff_index = top_k - 1;
-            for (int i = 0; i < top_k; ++i)
+            void Add(const EnergyMeter::Stats &energy, int num_tokens)
             {
-                cumulative_prob += sorted_logits[i].first;
-                if (cumulative_prob > p)
+                if (energy.valid)
                 {
-                    cutoff_index = i;
-                    break;
+                    tokens += num_tokens;
+                    joules += energy.joules;
+                    ms += energy.wall_ms;
                 }
             }
-            sorted_logits.resize(cutoff_index + 1);
 
-            // 6) Renormalize final probabilities
-            float new_sum = 0.0f;
-            for (auto &pair : sorted_logits)
+            void WriteJson(JsonWriter *json) const
             {
-                new_sum += pair.first;
+                json->BeginObject();
+                json->Field("tokens", tokens);
+                json->Field("joules", joules);
+                json->Field("joules_per_token", tokens > 0 ? joules / tokens : 0.0);
+                json->Field("tokens_per_joule", joules > 0 ? tokens / joules : 0.0);
+                json->Field("average_watts", ms > 0 ? joules / (ms / 1000) : 0.0);
+                json->EndObject();
             }
+        };
 
-            std::vector<float> final_probs;
-            final_probs.reserve(sorted_logits.size());
-            for (auto &pair : sorted_logits)
-            {
-                final_probs.push_back(pair.first / new_sum);
-            }
+        static void PrintEnergy(const std::string &label, const EnergyTotals &totals)
+        {
+            std::cout << "[METRICS] " << std::left << std::setw(31) << label << std::right << ": "
+                      << (totals.tokens > 0 ? 1000 * totals.joules / totals.tokens : 0.0) << " mJ/token, "
+                      << (totals.joules > 0 ? totals.tokens / totals.joules : 0.0) << " tokens/J, "
+                      << (totals.ms > 0 ? totals.joules / (totals.ms / 1000) : 0.0) << " W over "
+                      << totals.tokens << " tokens\n";
+        }
 
-            // 7) Multinomial sampling
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::discrete_distribution<> dist(final_probs.begin(), final_probs.end());
-            return sorted_logits[dist(gen)].second;
+        static void PrintPercentiles(const std::string &label, const LatencyHistogram &histogram)
+        {
+            std::cout << "[METRICS] " << std::left << std::setw(31) << label << std::right << ": "
+                      << histogram.Percentile(50) << " / " << histogram.Percentile(90) << " / "
+                      << histogram.Percentile(99) << " / " << histogram.max_ms() << " ms, jitter "
+                      << histogram.jitter_ms() << " ms\n";
         }
+
+        // Decode start time
+        std::chrono::high_resolution_clock::time_point decode_start_;
+
+        // Time to first token
+        double time_to_first_token_ms_ = 0.0;
+        bool first_token_recorded_ = false;
+
+        // Accumulators
+        double total_inference_time_ms_ = 0.0;
+        double total_sampling_time_ms_ = 0.0;
+        double total_decoding_time_ms_ = 0.0;
+        int token_count_ = 0;
+        int step_count_ = 0;
+
+        // Speculative decoding
+        bool speculative_ = false;
+        int total_proposed_tokens_ = 0;
+        int total_accepted_tokens_ = 0;
+        double total_draft_time_ms_ = 0.0;
+
+        // Latency distributions
+        LatencyHistogram inference_histogram_;
+        LatencyHistogram sampling_histogram_;
+        LatencyHistogram step_histogram_;
+        std::map<int, LatencyHistogram> prefill_histograms_;
+        std::string segment_;
+        std::map<std::string, LatencyHistogram> segment_histograms_;
+
+        // Thermal governor decisions, with --thermal_target_c
+        std::vector<ThermalGovernor::Decision> thermal_decisions_;
+
+        // Energy, with --energy
+        EnergyTotals prefill_energy_;
+        std::map<std::string, EnergyTotals> decode_energy_;
     };
 
     // --------------------------------------------------------------------------
     // Utility for applying XNNPACK weight caching
     // --------------------------------------------------------------------------
-    void ApplyXNNPACKWeightCaching(tflite::Interpreter *interpreter)
+    void ApplyXNNPACKWeightCaching(tflite::Interpreter *interpreter, int num_threads,
+                                   const std::string &weight_cache_path)
     {
         auto delegate_options = TfLiteXNNPackDelegateOptionsDefault();
-        std::string weight_cache_path = absl::GetFlag(FLAGS_weight_cache_path);
         delegate_options.weight_cache_file_path = weight_cache_path.c_str();
-        delegate_options.num_threads = absl::GetFlag(FLAGS_num_threads);
+        delegate_options.num_threads = num_threads;
         delegate_options.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING;
         delegate_options.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_LATEST_OPERATORS;
 
@@ -1182,45 +1546,84 @@ namespace
     // --------------------------------------------------------------------------
     // Loads the TFLite model
     // --------------------------------------------------------------------------
-    std::unique_ptr<tflite::FlatBufferModel> LoadModel()
+    std::unique_ptr<tflite::FlatBufferModel> LoadModel(const std::string &model_path)
     {
         std::unique_ptr<tflite::FlatBufferModel> model =
-            tflite::FlatBufferModel::BuildFromFile(absl::GetFlag(FLAGS_tflite_model).c_str());
+            tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
         MINIMAL_CHECK(model != nullptr);
         return model;
     }
 
     // --------------------------------------------------------------------------
-    // Builds a TFLite interpreter from the model and applies XNNPACK if requested
+    // Reads the model into memory placed by the NUMA policy, if the nodes have
+    // room for it and for the arena, packed weights and KV cache that follow;
+    // nullptr falls back to the shared mapping
     // --------------------------------------------------------------------------
-    std::unique_ptr<tflite::Interpreter>
-    BuildInterpreter(tflite::FlatBufferModel *model, int num_threads)
+    std::unique_ptr<NumaBuffer> LoadModelReplica(const std::string &model_path, NumaPolicy policy,
+                                                 const std::vector<int> &nodes, const NumaTopology &topology)
     {
-        tflite::ops::builtin::BuiltinOpResolver resolver;
-        // Register GenAI custom ops
-        tflite::ops::custom::GenAIOpsRegisterer(&resolver);
-
-        tflite::InterpreterBuilder builder(*model, resolver);
-        MINIMAL_CHECK(builder.SetNumThreads(num_threads) == kTfLiteOk);
-
-        std::unique_ptr<tflite::Interpreter> interpreter;
-        builder(&interpreter);
-        MINIMAL_CHECK(interpreter != nullptr);
-
-        if (!absl::GetFlag(FLAGS_weight_cache_path).empty())
+        struct stat st;
+        if (stat(model_path.c_str(), &st) != 0)
         {
-            ApplyXNNPACKWeightCaching(interpreter.get());
+            return nullptr;
         }
-        return interpreter;
+        int64_t free_bytes = 0;
+        for (int id : nodes)
+        {
+            const NumaNode *node = topology.Find(id);
+            if (node != nullptr && node->free_bytes > 0)
+            {
+                free_bytes += node->free_bytes;
+            }
+        }
+        if (free_bytes < 2 * static_cast<int64_t>(st.st_size))
+        {
+            std::cerr << "Warning: " << free_bytes / (1024 * 1024) << " MiB free on node(s) "
+                      << FormatCpuList(nodes) << " is not enough to replicate a "
+                      << st.st_size / (1024 * 1024) << " MiB model; mapping it instead." << std::endl;
+            return nullptr;
+        }
+        std::string error;
+        std::unique_ptr<NumaBuffer> replica = NumaBuffer::FromFile(model_path, policy, nodes, &error);
+        if (replica == nullptr)
+        {
+            std::cerr << "Warning: failed to replicate the model (" << error << "); mapping it instead." << std::endl;
+        }
+        return replica;
+    }
+
+    // --------------------------------------------------------------------------
+    // Builds a TFLite interpreter from the model and applies XNNPACK if requested
+    // --------------------------------------------------------------------------
+    std::unique_ptr<tflite::Interpreter>
+    BuildInterpreter(tflite::FlatBufferModel *model, int num_threads,
+                     const std::string &weight_cache_path)
+    {
+        tflite::ops::builtin::BuiltinOpResolver resolver;
+        // Register GenAI custom ops
+        tflite::ops::custom::GenAIOpsRegisterer(&resolver);
+
+        tflite::InterpreterBuilder builder(*model, resolver);
+        MINIMAL_CHECK(builder.SetNumThreads(num_threads) == kTfLiteOk);
+
+        std::unique_ptr<tflite::Interpreter> interpreter;
+        builder(&interpreter);
+        MINIMAL_CHECK(interpreter != nullptr);
+
+        if (!weight_cache_path.empty())
+        {
+            ApplyXNNPACKWeightCaching(interpreter.get(), num_threads, weight_cache_path);
+        }
+        return interpreter;
     }
 
     // --------------------------------------------------------------------------
     // Constructs KV cache input structures for decode, based on the decode signature
     // --------------------------------------------------------------------------
     std::map<std::string, std::vector<float, AlignedAllocator<float>>>
-    BuildKVCache(tflite::Interpreter *interpreter)
+    BuildKVCache(tflite::Interpreter *interpreter, const std::string &signature_key = "decode")
     {
-        tflite::SignatureRunner *runner = interpreter->GetSignatureRunner("decode");
+        tflite::SignatureRunner *runner = interpreter->GetSignatureRunner(signature_key.c_str());
         if (runner == nullptr)
         {
             return {};
@@ -1268,6 +1671,55 @@ namespace
         MINIMAL_CHECK(runner->AllocateTensors() == kTfLiteOk);
     }
 
+    // --------------------------------------------------------------------------
+    // Returns the KV cache pages past `position` to the kernel. The layout is
+    // position-major, so the tail of every buffer holds the unused positions;
+    // they fault back in as zero pages when generation reaches them.
+    // --------------------------------------------------------------------------
+    size_t ReleaseKVCacheTail(KVCache &kv_cache, int position, int kv_cache_max_size)
+    {
+        const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+        size_t released = 0;
+        for (auto &[name, cache] : kv_cache)
+        {
+            const size_t floats_per_position = cache.size() / kv_cache_max_size;
+            const uintptr_t begin =
+                reinterpret_cast<uintptr_t>(cache.data() + (position + 1) * floats_per_position);
+            const uintptr_t end = reinterpret_cast<uintptr_t>(cache.data() + cache.size());
+            const uintptr_t aligned_begin = (begin + page_size - 1) & ~(page_size - 1);
+            const uintptr_t aligned_end = end & ~(page_size - 1);
+            if (aligned_end > aligned_begin &&
+                madvise(reinterpret_cast<void *>(aligned_begin), aligned_end - aligned_begin,
+                        MADV_DONTNEED) == 0)
+            {
+                released += aligned_end - aligned_begin;
+            }
+        }
+        return released;
+    }
+
+    // --------------------------------------------------------------------------
+    // Frees the activation arenas of every signature but `keep_signature`.
+    // PrepareRunner() allocates them again before a released runner is used.
+    // --------------------------------------------------------------------------
+    int ReleaseIdleArenas(tflite::Interpreter *interpreter, const std::string &keep_signature)
+    {
+        int released = 0;
+        for (const std::string *key : interpreter->signature_keys())
+        {
+            if (*key == keep_signature)
+            {
+                continue;
+            }
+            int index = interpreter->GetSubgraphIndexFromSignature(key->c_str());
+            if (index >= 0 && interpreter->subgraph(index)->ReleaseNonPersistentMemory() == kTfLiteOk)
+            {
+                ++released;
+            }
+        }
+        return released;
+    }
+
     // --------------------------------------------------------------------------
     // Finds the appropriate "prefill" runner for the given number of tokens.
     // If LoRA is used, it defers to LoRA's specialized runner selection.
@@ -1276,12 +1728,28 @@ namespace
         tflite::Interpreter *interpreter,
         std::size_t num_input_tokens,
         std::map<std::string, std::vector<float, AlignedAllocator<float>>> &kv_cache,
-        const ai_edge_torch::examples::LoRA *lora)
+        const ai_edge_torch::examples::LoRA *lora,
+        const std::string &signature_key = "")
     {
         tflite::SignatureRunner *runner = nullptr;
         int best_seq_size = -1;
         int delta = std::numeric_limits<int>::max();
 
+        // An explicitly chosen signature is used if it holds the prompt
+        if (!signature_key.empty() && lora == nullptr)
+        {
+            runner = interpreter->GetSignatureRunner(signature_key.c_str());
+            TfLiteTensor *input_pos = runner ? runner->input_tensor("input_pos") : nullptr;
+            if (input_pos != nullptr && num_input_tokens <= static_cast<size_t>(input_pos->dims->data[0]))
+            {
+                PrepareRunner(runner, kv_cache);
+                return runner;
+            }
+            std::cerr << "Warning: prefill signature '" << signature_key << "' is missing or shorter than "
+                      << num_input_tokens << " tokens; using the smallest one that fits." << std::endl;
+            runner = nullptr;
+        }
+
         for (const std::string *key : interpreter->signature_keys())
         {
             if (!absl::StrContains(*key, "prefill") || absl::StrContains(*key, "lora"))
@@ -1336,6 +1804,118 @@ namespace
         return runner;
     }
 
+    // --------------------------------------------------------------------------
+    // Median wall time in ms of `reps` Invoke() calls after one warm-up call
+    // --------------------------------------------------------------------------
+    double TimeInvokes(tflite::SignatureRunner *runner, int reps)
+    {
+        MINIMAL_CHECK(runner->Invoke() == kTfLiteOk);
+        std::vector<double> times_ms;
+        for (int i = 0; i < std::max(1, reps); ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            MINIMAL_CHECK(runner->Invoke() == kTfLiteOk);
+            times_ms.push_back(std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+        }
+        std::sort(times_ms.begin(), times_ms.end());
+        return times_ms[times_ms.size() / 2];
+    }
+
+    // --------------------------------------------------------------------------
+    // Builds an interpreter per candidate thread count and times the prefill
+    // bucket for `num_input_tokens` and one decode step on each. The KV cache
+    // is bound to every candidate and cleared afterwards.
+    // --------------------------------------------------------------------------
+    struct ThreadTuning
+    {
+        int prefill_threads = 0;
+        int decode_threads = 0;
+    };
+
+    template <typename BuildFn>
+    ThreadTuning AutotuneThreadCounts(
+        const BuildFn &build_interpreter,
+        std::map<std::string, std::vector<float, AlignedAllocator<float>>> &kv_cache,
+        std::size_t num_input_tokens, const std::vector<int> &candidates, int reps)
+    {
+        ThreadTuning best;
+        double best_prefill_ms = std::numeric_limits<double>::max();
+        double best_decode_ms = std::numeric_limits<double>::max();
+        std::cout << "[INFO] Auto-tuning thread counts:\n";
+        for (int threads : candidates)
+        {
+            std::unique_ptr<tflite::Interpreter> candidate = build_interpreter(threads);
+            tflite::SignatureRunner *prefill = GetPrefillRunner(candidate.get(), num_input_tokens, kv_cache, nullptr);
+            tflite::SignatureRunner *decode = GetDecodeRunner(candidate.get(), kv_cache, nullptr);
+            double prefill_ms = TimeInvokes(prefill, reps);
+            double decode_ms = TimeInvokes(decode, reps);
+            std::cout << "  " << threads << " threads: prefill " << prefill_ms << " ms, decode step "
+                      << decode_ms << " ms\n";
+            if (prefill_ms < best_prefill_ms)
+            {
+                best_prefill_ms = prefill_ms;
+                best.prefill_threads = threads;
+            }
+            if (decode_ms < best_decode_ms)
+            {
+                best_decode_ms = decode_ms;
+                best.decode_threads = threads;
+            }
+        }
+        for (auto &[name, buffer] : kv_cache)
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+        }
+        return best;
+    }
+
+    // --------------------------------------------------------------------------
+    // Finds a multi-token signature that outputs logits for every position, used
+    // to verify speculative drafts. Picks the narrowest one covering num_tokens.
+    // Returns nullptr if the model has none (e.g. prefill exported without logits).
+    // --------------------------------------------------------------------------
+    tflite::SignatureRunner *GetVerifyRunner(
+        tflite::Interpreter *interpreter,
+        std::size_t num_tokens,
+        std::map<std::string, std::vector<float, AlignedAllocator<float>>> &kv_cache)
+    {
+        tflite::SignatureRunner *runner = nullptr;
+        int delta = std::numeric_limits<int>::max();
+
+        for (const std::string *key : interpreter->signature_keys())
+        {
+            if (*key == "decode" || absl::StrContains(*key, "lora"))
+            {
+                continue;
+            }
+            tflite::SignatureRunner *candidate = interpreter->GetSignatureRunner(key->c_str());
+            const std::vector<const char *> &outputs = candidate->output_names();
+            bool has_logits = std::any_of(outputs.begin(), outputs.end(),
+                                          [](const char *name)
+                                          { return std::strcmp(name, "logits") == 0; });
+            TfLiteTensor *input_pos = candidate->input_tensor("input_pos");
+            if (!has_logits || input_pos == nullptr)
+            {
+                continue;
+            }
+            int seq_size = input_pos->dims->data[0];
+            if (num_tokens <= static_cast<size_t>(seq_size) &&
+                seq_size - static_cast<int>(num_tokens) < delta)
+            {
+                runner = candidate;
+                delta = seq_size - static_cast<int>(num_tokens);
+            }
+        }
+
+        if (runner != nullptr)
+        {
+            PrepareRunner(runner, kv_cache);
+        }
+        return runner;
+    }
+
     // --------------------------------------------------------------------------
     // Loads the SentencePiece model from file
     // --------------------------------------------------------------------------
@@ -1350,6 +1930,449 @@ namespace
         return processor;
     }
 
+    // --------------------------------------------------------------------------
+    // Reads one prompt per line. Lines in the prompt/ set format (<tokens>,"text")
+    // are unwrapped to their quoted text.
+    // --------------------------------------------------------------------------
+    std::vector<std::string> LoadBatchPrompts(const std::string &path)
+    {
+        std::vector<std::string> prompts;
+        std::ifstream input(path);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            size_t comma = line.find(",\"");
+            if (comma != std::string::npos && line.size() > comma + 2 && line.back() == '"' &&
+                std::all_of(line.begin(), line.begin() + comma, ::isdigit))
+            {
+                line = line.substr(comma + 2, line.size() - comma - 3);
+            }
+            if (!line.empty())
+            {
+                prompts.push_back(line);
+            }
+        }
+        return prompts;
+    }
+
+    // --------------------------------------------------------------------------
+    // Generates every prompt of --batch_prompts_file through the batched decode
+    // signature. Prompts are prefilled one at a time into the batch-1 KV cache
+    // and copied into a free slot of the batched cache.
+    // --------------------------------------------------------------------------
+    int RunBatchedGeneration(tflite::Interpreter *interpreter,
+                             sentencepiece::SentencePieceProcessor *sp_processor,
+                             KVCache &scratch_kv_cache,
+                             const std::string &start_token, int stop_token_id)
+    {
+        std::string signature_key = absl::GetFlag(FLAGS_decode_batch_signature);
+        tflite::SignatureRunner *decode_runner = interpreter->GetSignatureRunner(signature_key.c_str());
+        if (decode_runner == nullptr || !BatchedDecodeScheduler::IsBatchedDecodeSignature(decode_runner))
+        {
+            std::cerr << "Error: signature '" << signature_key
+                      << "' must take tokens [B, 1] and per-row input_pos [B] with B > 1." << std::endl;
+            return 1;
+        }
+        KVCache batch_kv_cache = BuildKVCache(interpreter, signature_key);
+        MINIMAL_CHECK(!batch_kv_cache.empty());
+        PrepareRunner(decode_runner, batch_kv_cache);
+
+        auto prefill = [&](const std::vector<int> &prompt_tokens)
+        {
+            tflite::SignatureRunner *prefill_runner = GetPrefillRunner(
+                interpreter, prompt_tokens.size() - 1, scratch_kv_cache, nullptr);
+            TfLiteTensor *prefill_input = prefill_runner->input_tensor("tokens");
+            TfLiteTensor *prefill_input_pos = prefill_runner->input_tensor("input_pos");
+            int prefill_seq_size = std::min<int>(prompt_tokens.size(), prefill_input->dims->data[1]);
+            std::memset(prefill_input->data.i32, 0, prefill_input->bytes);
+            std::memset(prefill_input_pos->data.i32, 0, prefill_input_pos->bytes);
+            for (int i = 0; i < prefill_seq_size - 1; ++i)
+            {
+                prefill_input->data.i32[i] = prompt_tokens[i];
+                prefill_input_pos->data.i32[i] = i;
+            }
+            ScopedTraceSpan span("Prefill_Invoke", "prefill");
+            MINIMAL_CHECK(prefill_runner->Invoke() == kTfLiteOk);
+            return prefill_seq_size - 1;
+        };
+
+        BatchedDecodeScheduler scheduler(
+            decode_runner, &batch_kv_cache, &scratch_kv_cache, prefill,
+            [](const float *logits, int vocab_size)
+            { return Sampler::TemperatureTopKTopPSampler(logits, vocab_size, 0.9f, 85, 0.9f); },
+            stop_token_id);
+
+        std::vector<std::string> prompts = LoadBatchPrompts(absl::GetFlag(FLAGS_batch_prompts_file));
+        MINIMAL_CHECK(!prompts.empty());
+        int max_new_tokens = (absl::GetFlag(FLAGS_max_decode_steps) == -1)
+                                 ? std::numeric_limits<int>::max()
+                                 : absl::GetFlag(FLAGS_max_decode_steps);
+        for (size_t i = 0; i < prompts.size(); ++i)
+        {
+            GenerationRequest request;
+            request.id = static_cast<int>(i);
+            request.max_new_tokens = max_new_tokens;
+            MINIMAL_CHECK(sp_processor->Encode(prompts[i], &request.prompt_tokens).ok());
+            if (!start_token.empty())
+            {
+                request.prompt_tokens.insert(request.prompt_tokens.begin(), sp_processor->PieceToId(start_token));
+            }
+            scheduler.Submit(std::move(request));
+        }
+        std::cout << "[INFO] Batched decoding " << prompts.size() << " prompts with batch size "
+                  << scheduler.batch_size() << "\n";
+
+        scheduler.Run([&](const BatchSession &session)
+                      {
+            std::string text;
+            MINIMAL_CHECK(sp_processor->Decode(session.output_tokens, &text).ok());
+            std::cout << "\n[Request " << session.request_id << "] "
+                      << session.output_tokens.size() << " tokens, TTFT "
+                      << session.time_to_first_token_ms << " ms\n"
+                      << text << "\n" << std::flush; });
+
+        const BatchedDecodeScheduler::Stats &batch_stats = scheduler.stats();
+        double decode_time_ms = batch_stats.total_invoke_time_ms + batch_stats.total_sampling_time_ms;
+        double avg_active = (batch_stats.num_steps > 0)
+                                ? static_cast<double>(batch_stats.active_slot_steps) / batch_stats.num_steps
+                                : 0.0;
+        std::cout << "\n\n================================\n";
+        std::cout << "[INFO] Batched decoding completed\n";
+        std::cout << "[METRICS] Completed Requests               : " << batch_stats.num_completed << "\n";
+        std::cout << "[METRICS] Total Number of Generated Tokens : " << batch_stats.num_tokens << " tokens\n";
+        std::cout << "[METRICS] Batched Decode Steps             : " << batch_stats.num_steps << "\n";
+        std::cout << "[METRICS] Average Active Slots             : " << avg_active << " / "
+                  << scheduler.batch_size() << "\n";
+        std::cout << "[METRICS] Total Prefill Latency            : " << batch_stats.total_prefill_time_ms << " ms\n";
+        std::cout << "[METRICS] Total Inference Latency          : " << batch_stats.total_invoke_time_ms << " ms\n";
+        std::cout << "[METRICS] Total Sampling Latency           : " << batch_stats.total_sampling_time_ms << " ms\n";
+        if (batch_stats.num_steps > 0 && decode_time_ms > 0)
+        {
+            std::cout << "[METRICS] Average Step Latency             : "
+                      << decode_time_ms / batch_stats.num_steps << " ms/step\n";
+            std::cout << "[METRICS] Aggregate Decoding Speed         : "
+                      << batch_stats.num_tokens / (decode_time_ms / 1000) << " token/s\n";
+        }
+        std::cout << "[METRICS] End-to-End Throughput            : "
+                  << batch_stats.num_tokens / (batch_stats.total_time_ms / 1000) << " token/s\n";
+        return 0;
+    }
+
+    // --------------------------------------------------------------------------
+    // SessionBackend over the interpreter's prefill and decode signatures.
+    // Binding a session points the KV cache tensors at its buffers.
+    // --------------------------------------------------------------------------
+    class InterpreterSessionBackend : public SessionBackend
+    {
+    public:
+        explicit InterpreterSessionBackend(tflite::Interpreter *interpreter)
+            : interpreter_(interpreter), decode_runner_(interpreter->GetSignatureRunner("decode"))
+        {
+            MINIMAL_CHECK(decode_runner_ != nullptr);
+            kv_cache_max_size_ = decode_runner_->input_tensor("kv_cache_k_0")->dims->data[1];
+            for (const std::string *key : interpreter->signature_keys())
+            {
+                if (absl::StrContains(*key, "prefill") && !absl::StrContains(*key, "lora"))
+                {
+                    TfLiteTensor *input_pos = interpreter->GetSignatureRunner(key->c_str())->input_tensor("input_pos");
+                    max_prefill_tokens_ = std::max(max_prefill_tokens_, input_pos->dims->data[0]);
+                }
+            }
+        }
+
+        KVCache NewKVCache() override { return BuildKVCache(interpreter_); }
+
+        void Bind(KVCache *kv_cache) override
+        {
+            kv_cache_ = kv_cache;
+            PrepareRunner(decode_runner_, *kv_cache_);
+        }
+
+        int max_prefill_tokens() const override { return max_prefill_tokens_; }
+        int kv_cache_max_size() const override { return kv_cache_max_size_; }
+
+        void Prefill(const int *tokens, int count, int start_position) override
+        {
+            tflite::SignatureRunner *runner = GetPrefillRunner(interpreter_, count, *kv_cache_, nullptr);
+            TfLiteTensor *input = runner->input_tensor("tokens");
+            TfLiteTensor *input_pos = runner->input_tensor("input_pos");
+            const int seq_size = input->dims->data[1];
+            // Padding goes to the positions after the chunk, which later
+            // tokens overwrite before anything attends to them. Position 0,
+            // the usual padding, already holds this session's prompt.
+            for (int i = 0; i < seq_size; ++i)
+            {
+                input->data.i32[i] = i < count ? tokens[i] : 0;
+                input_pos->data.i32[i] = std::min(start_position + i, kv_cache_max_size_ - 1);
+            }
+            ScopedTraceSpan span("Prefill_Invoke", "prefill");
+            MINIMAL_CHECK(runner->Invoke() == kTfLiteOk);
+        }
+
+        const float *Decode(int token, int position, int *vocab_size) override
+        {
+            decode_runner_->input_tensor("tokens")->data.i32[0] = token;
+            decode_runner_->input_tensor("input_pos")->data.i32[0] = position;
+            {
+                ScopedTraceSpan span("Decode_Invoke", "decode");
+                MINIMAL_CHECK(decode_runner_->Invoke() == kTfLiteOk);
+            }
+            const TfLiteTensor *logits = decode_runner_->output_tensor("logits");
+            *vocab_size = Sampler::VocabSize(logits);
+            return Sampler::LogitsRow(logits, 0);
+        }
+
+    private:
+        tflite::Interpreter *interpreter_;
+        tflite::SignatureRunner *decode_runner_;
+        KVCache *kv_cache_ = nullptr;
+        int kv_cache_max_size_ = 0;
+        int max_prefill_tokens_ = 0;
+    };
+
+    // --------------------------------------------------------------------------
+    // Serves the requests of --serve_requests_file on one interpreter.
+    // Interactive requests preempt background ones at token boundaries and
+    // long prompts are prefilled in chunks between other sessions' tokens.
+    // --------------------------------------------------------------------------
+    int RunServing(tflite::Interpreter *interpreter,
+                   sentencepiece::SentencePieceProcessor *sp_processor,
+                   const std::string &start_token, int stop_token_id,
+                   MemoryPressureController *memory_pressure,
+                   const MemoryPressureController::StageAction &apply_pressure_stage)
+    {
+        std::vector<RequestClass> classes = {
+            {"interactive", 1, absl::GetFlag(FLAGS_serve_interactive_ttft_ms),
+             absl::GetFlag(FLAGS_serve_interactive_token_ms)},
+            {"background", 0, 0.0, 0.0}};
+        InterpreterSessionBackend backend(interpreter);
+        RequestScheduler::Options options;
+        options.max_sessions = absl::GetFlag(FLAGS_serve_max_sessions);
+        options.prefill_chunk = absl::GetFlag(FLAGS_serve_prefill_chunk);
+        options.quantum_tokens = absl::GetFlag(FLAGS_serve_quantum_tokens);
+        RequestScheduler scheduler(
+            &backend, classes,
+            [](const float *logits, int vocab_size)
+            { return Sampler::TemperatureTopKTopPSampler(logits, vocab_size, 0.9f, 85, 0.9f); },
+            stop_token_id, options);
+
+        const std::string path = absl::GetFlag(FLAGS_serve_requests_file);
+        std::ifstream input(path);
+        if (!input.is_open())
+        {
+            std::cerr << "Error: cannot open --serve_requests_file " << path << std::endl;
+            return 1;
+        }
+        int max_new_tokens = (absl::GetFlag(FLAGS_max_decode_steps) == -1)
+                                 ? std::numeric_limits<int>::max()
+                                 : absl::GetFlag(FLAGS_max_decode_steps);
+        std::string line;
+        int num_requests = 0;
+        for (int line_number = 1; std::getline(input, line); ++line_number)
+        {
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+            size_t first_tab = line.find('\t');
+            size_t second_tab = first_tab == std::string::npos ? first_tab : line.find('\t', first_tab + 1);
+            if (second_tab == std::string::npos)
+            {
+                std::cerr << "Error: " << path << ":" << line_number
+                          << ": expected '<class>\\t<arrival ms>\\t<prompt>'." << std::endl;
+                return 1;
+            }
+            ServingRequest request;
+            const std::string class_name = line.substr(0, first_tab);
+            auto it = std::find_if(classes.begin(), classes.end(),
+                                   [&](const RequestClass &c) { return c.name == class_name; });
+            if (it == classes.end())
+            {
+                std::cerr << "Error: " << path << ":" << line_number << ": unknown class '" << class_name
+                          << "'; use interactive or background." << std::endl;
+                return 1;
+            }
+            request.id = num_requests;
+            request.class_index = static_cast<int>(it - classes.begin());
+            request.arrival_ms = std::atof(line.substr(first_tab + 1, second_tab - first_tab - 1).c_str());
+            request.max_new_tokens = max_new_tokens;
+            MINIMAL_CHECK(sp_processor->Encode(line.substr(second_tab + 1), &request.prompt_tokens).ok());
+            if (!start_token.empty())
+            {
+                request.prompt_tokens.insert(request.prompt_tokens.begin(), sp_processor->PieceToId(start_token));
+            }
+            if (request.prompt_tokens.empty() ||
+                static_cast<int>(request.prompt_tokens.size()) >= backend.kv_cache_max_size())
+            {
+                std::cerr << "Warning: skipping " << path << ":" << line_number << ", whose prompt of "
+                          << request.prompt_tokens.size() << " tokens does not fit the KV cache." << std::endl;
+                continue;
+            }
+            scheduler.Submit(std::move(request));
+            ++num_requests;
+        }
+        MINIMAL_CHECK(num_requests > 0);
+        std::cout << "[INFO] Serving " << num_requests << " requests, up to " << options.max_sessions
+                  << " sessions per class\n";
+
+        // Pressure stages are applied between steps, on top of the shared ones
+        if (memory_pressure)
+        {
+            scheduler.SetStepHook([&]()
+                                  { memory_pressure->Poll([&](PressureStage stage, bool entering)
+                                                          {
+                apply_pressure_stage(stage, entering);
+                if (stage == PressureStage::kShrinkCaches && entering)
+                {
+                    size_t released = scheduler.ReleaseIdleCaches();
+                    std::cerr << "[MEMORY] Freed " << released / (1024.0 * 1024.0)
+                              << " MiB of spare session caches" << std::endl;
+                }
+                else if (stage == PressureStage::kCapContext)
+                {
+                    scheduler.CapNewTokens(entering ? absl::GetFlag(FLAGS_memory_pressure_token_cap) : -1);
+                }
+                else if (stage == PressureStage::kRefuseSessions)
+                {
+                    scheduler.SetAccepting(!entering);
+                } }); });
+        }
+
+        scheduler.Run([&](const ServingSession &session)
+                      {
+            std::string text;
+            MINIMAL_CHECK(sp_processor->Decode(session.output_tokens, &text).ok());
+            std::cout << "\n[Request " << session.request_id << ", " << classes[session.class_index].name << "] "
+                      << session.output_tokens.size() << " tokens, TTFT "
+                      << session.first_token_ms - session.arrival_ms << " ms, preempted "
+                      << session.preemptions << " times\n"
+                      << text << "\n" << std::flush; });
+
+        std::cout << "\n\n================================\n";
+        scheduler.PrintReport(std::cout);
+        return 0;
+    }
+
+    // --------------------------------------------------------------------------
+    // Beam search / n-best sampling after prefill. Beams go through the batched
+    // decode signature when it has room for all of them; otherwise they share
+    // the prefilled cache and swap their private suffixes in turn.
+    // --------------------------------------------------------------------------
+    int RunBeamSearch(tflite::Interpreter *interpreter,
+                      sentencepiece::SentencePieceProcessor *sp_processor,
+                      tflite::SignatureRunner *decode_runner, KVCache &kv_cache,
+                      int pending_token, int start_position, int max_new_tokens,
+                      int stop_token_id)
+    {
+        BeamSearchOptions options;
+        options.num_beams = absl::GetFlag(FLAGS_beam_width);
+        options.num_return_sequences = absl::GetFlag(FLAGS_num_return_sequences);
+        options.max_new_tokens = max_new_tokens;
+        options.stop_token_id = stop_token_id;
+        options.length_penalty = absl::GetFlag(FLAGS_length_penalty);
+        options.sample = absl::GetFlag(FLAGS_beam_mode) == "sample";
+        if (!options.sample && absl::GetFlag(FLAGS_beam_mode) != "beam")
+        {
+            std::cerr << "Error: --beam_mode must be 'beam' or 'sample'." << std::endl;
+            return 1;
+        }
+
+        std::unique_ptr<BeamDecodeBackend> backend;
+        KVCache batch_kv_cache;
+        std::string signature_key = absl::GetFlag(FLAGS_decode_batch_signature);
+        tflite::SignatureRunner *batch_runner = interpreter->GetSignatureRunner(signature_key.c_str());
+        if (batch_runner != nullptr && BatchedBeamBackend::IsCompatible(batch_runner) &&
+            batch_runner->input_tensor("tokens")->dims->data[0] >= options.num_beams)
+        {
+            batch_kv_cache = BuildKVCache(interpreter, signature_key);
+            MINIMAL_CHECK(!batch_kv_cache.empty());
+            PrepareRunner(batch_runner, batch_kv_cache);
+            backend = std::make_unique<BatchedBeamBackend>(batch_runner, &batch_kv_cache, kv_cache,
+                                                           start_position);
+            std::cout << "[INFO] Beam search over batched signature '" << signature_key << "'\n";
+        }
+        else
+        {
+            backend = std::make_unique<SharedPrefixBeamBackend>(decode_runner, &kv_cache, start_position,
+                                                                options.num_beams);
+            std::cout << "[INFO] Beam search over the shared-prefix decode signature\n";
+        }
+
+        BeamSearch beam_search(backend.get(), options);
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<Hypothesis> hypotheses = beam_search.Run(pending_token, start_position);
+        double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::high_resolution_clock::now() - start)
+                                .count();
+
+        for (size_t i = 0; i < hypotheses.size(); ++i)
+        {
+            std::string text;
+            MINIMAL_CHECK(sp_processor->Decode(hypotheses[i].tokens, &text).ok());
+            std::cout << "\n[" << i << "] score " << hypotheses[i].score << ", log_prob "
+                      << hypotheses[i].log_prob << ", " << hypotheses[i].tokens.size() << " tokens\n"
+                      << text << "\n";
+        }
+        std::cout << "\n\n================================\n";
+        std::cout << "[INFO] Beam search completed (" << absl::GetFlag(FLAGS_beam_mode) << ", "
+                  << options.num_beams << " beams)\n";
+        std::cout << "[METRICS] Beam Steps                       : " << beam_search.num_steps() << "\n";
+        std::cout << "[METRICS] Copied KV Positions              : " << beam_search.num_copied_positions() << "\n";
+        std::cout << "[METRICS] Total Beam Search Latency        : " << elapsed_ms << " ms\n";
+        if (beam_search.num_steps() > 0)
+        {
+            std::cout << "[METRICS] Average Step Latency             : "
+                      << elapsed_ms / beam_search.num_steps() << " ms/step\n";
+        }
+        return 0;
+    }
+
+    // --------------------------------------------------------------------------
+    // Writes the installed trace, if any, to --trace_out
+    // --------------------------------------------------------------------------
+    void WriteTrace(TraceWriter *trace_writer)
+    {
+        if (trace_writer == nullptr)
+        {
+            return;
+        }
+        TraceWriter::Install(nullptr);
+        std::string path = absl::GetFlag(FLAGS_trace_out);
+        if (trace_writer->WriteJson(path))
+        {
+            std::cout << "[INFO] Wrote " << trace_writer->num_events() << " trace events to " << path << "\n";
+        }
+        else
+        {
+            std::cerr << "Warning: failed to write trace to " << path << std::endl;
+        }
+    }
+
+    // --------------------------------------------------------------------------
+    // Prints the per-operator hotspot table and writes --op_profile_csv
+    // --------------------------------------------------------------------------
+    void ReportOpProfile(tflite::Interpreter *interpreter, OpProfiler *op_profiler)
+    {
+        if (op_profiler == nullptr)
+        {
+            return;
+        }
+        interpreter->SetProfiler(nullptr);
+        op_profiler->PrintReport(std::cout, absl::GetFlag(FLAGS_op_profile_top));
+        std::string csv_path = absl::GetFlag(FLAGS_op_profile_csv);
+        if (!csv_path.empty())
+        {
+            if (op_profiler->WriteCsv(csv_path))
+            {
+                std::cout << "[INFO] Wrote operator profile to " << csv_path << "\n";
+            }
+            else
+            {
+                std::cerr << "Warning: failed to write operator profile to " << csv_path << std::endl;
+            }
+        }
+    }
+
     // RUSAGE
     struct RUsageRecord {
         rusage start;
@@ -1377,21 +2400,401 @@ namespace
         }
     }
 
-    void uploadTensorsForAllSubgraphs(tflite::Interpreter* interpreter) {
-        if (!interpreter) {
-            std::cerr << "Invalid interpreter pointer\n";
-            return;
+    // One object per decode step with the rusage deltas PrintRUsageRecords shows
+    void WriteRUsageRecordsJson(const std::vector<RUsageRecord>& records, JsonWriter* json) {
+        json->BeginArray();
+        for (const RUsageRecord& record : records) {
+            json->BeginObject();
+            json->Field("user_time_sec", toSeconds(record.end.ru_utime) - toSeconds(record.start.ru_utime));
+            json->Field("system_time_sec", toSeconds(record.end.ru_stime) - toSeconds(record.start.ru_stime));
+            json->Field("minor_faults", static_cast<int64_t>(record.end.ru_minflt - record.start.ru_minflt));
+            json->Field("major_faults", static_cast<int64_t>(record.end.ru_majflt - record.start.ru_majflt));
+            json->Field("voluntary_switches", static_cast<int64_t>(record.end.ru_nvcsw - record.start.ru_nvcsw));
+            json->Field("involuntary_switches", static_cast<int64_t>(record.end.ru_nivcsw - record.start.ru_nivcsw));
+            json->EndObject();
         }
-    
-        // Get the number of subgraphs
-        size_t num_subgraphs = interpreter->subgraphs_size();
-        std::cout << "Processing " << num_subgraphs << " subgraphs\n";
-    
-        // Keep track of total tensors touched across all subgraphs
-        size_t total_tensors_touched = 0;
-    
-        // Process each subgraph
-        for (size_t subgraph_idx = 0; subgraph_idx < num_subgraphs; ++subgraph_idx) {
+        json->EndArray();
+    }
+
+    // Flags defined in this file, as given on the command line or defaulted
+    void WriteFlagsJson(JsonWriter* json) {
+        std::map<std::string, std::string> values;
+        for (const auto& [name, flag] : absl::GetAllFlags()) {
+            if (absl::EndsWith(flag->Filename(), "text_generator_main.cc")) {
+                values[std::string(name)] = flag->CurrentValue();
+            }
+        }
+        json->BeginObject();
+        for (const auto& [name, value] : values) {
+            json->Field(name, value);
+        }
+        json->EndObject();
+    }
+
+    // --------------------------------------------------------------------------
+    // Device profile written by --autotune. Its settings are applied to the
+    // flags not named on the command line, so explicit flags take precedence
+    // even when they repeat the default.
+    // --------------------------------------------------------------------------
+    const char *const kDeviceProfileFlags[] = {"num_threads", "thread_placement", "weight_cache_path",
+                                               "prefill_signature", "prefetch_depth"};
+
+    std::string TuningCachePath()
+    {
+        std::string path = absl::GetFlag(FLAGS_tuning_cache);
+        return path.empty() ? absl::GetFlag(FLAGS_tflite_model) + ".tuning" : path;
+    }
+
+    // Flag names as they appear in argv ("--name", "-name=value", "--noname"),
+    // recorded before absl::ParseCommandLine consumes them
+    std::vector<std::string> explicit_flags;
+
+    void RecordExplicitFlags(int argc, char *argv[])
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--")
+            {
+                break;
+            }
+            if (arg.size() < 2 || arg[0] != '-')
+            {
+                continue;
+            }
+            arg = arg.substr(arg[1] == '-' ? 2 : 1);
+            arg = arg.substr(0, arg.find('='));
+            explicit_flags.push_back(arg);
+            if (arg.rfind("no", 0) == 0)
+            {
+                explicit_flags.push_back(arg.substr(2));  // --noname of a bool flag
+            }
+        }
+    }
+
+    bool IsFlagExplicit(const char *name)
+    {
+        return std::find(explicit_flags.begin(), explicit_flags.end(), name) != explicit_flags.end();
+    }
+
+    void ApplyDeviceProfile(const TuningCache::Section &profile)
+    {
+        std::string applied;
+        for (const char *name : kDeviceProfileFlags)
+        {
+            auto it = profile.find(name);
+            if (it == profile.end() || IsFlagExplicit(name))
+            {
+                continue;
+            }
+            std::string error;
+            if (absl::FindCommandLineFlag(name)->ParseFrom(it->second, &error))
+            {
+                applied += " " + std::string(name) + "=" + it->second;
+            }
+            else
+            {
+                std::cerr << "Warning: ignoring device profile value " << name << "=" << it->second << ": "
+                          << error << std::endl;
+            }
+        }
+        if (!applied.empty())
+        {
+            std::cout << "[INFO] Device profile:" << applied << "\n";
+        }
+    }
+
+    // --------------------------------------------------------------------------
+    // One point of the --autotune search and its timing over the prompt set
+    // --------------------------------------------------------------------------
+    struct AutotuneConfig
+    {
+        ThreadPlacement placement = ThreadPlacement::kNone;
+        int num_threads = 1;
+        std::string weight_cache_path;
+        std::string prefill_signature;  // Empty: smallest one that fits.
+        int prefetch_depth = 0;
+    };
+
+    struct AutotuneResult
+    {
+        double prefill_ms = 0.0;
+        double decode_ms = 0.0;
+        int prefill_tokens = 0;
+        int decode_tokens = 0;
+
+        double total_ms() const { return prefill_ms + decode_ms; }
+    };
+
+    std::ostream &operator<<(std::ostream &out, const AutotuneConfig &config)
+    {
+        return out << "cores=" << ThreadPlacementName(config.placement) << " threads=" << config.num_threads
+                   << " weight_cache=" << (config.weight_cache_path.empty() ? "off" : "on")
+                   << " prefill=" << (config.prefill_signature.empty() ? "best-fit" : config.prefill_signature)
+                   << " prefetch=" << config.prefetch_depth;
+    }
+
+    // Prefill signatures and their sequence length, LoRA variants excluded
+    std::vector<std::pair<std::string, int>> ListPrefillSignatures(tflite::Interpreter *interpreter)
+    {
+        std::vector<std::pair<std::string, int>> signatures;
+        for (const std::string *key : interpreter->signature_keys())
+        {
+            if (absl::StrContains(*key, "prefill") && !absl::StrContains(*key, "lora"))
+            {
+                TfLiteTensor *input_pos = interpreter->GetSignatureRunner(key->c_str())->input_tensor("input_pos");
+                signatures.emplace_back(*key, input_pos->dims->data[0]);
+            }
+        }
+        return signatures;
+    }
+
+    // Interpreter and KV cache for the settings that need a rebuild (core
+    // set, threads, weight cache); the other settings reuse it.
+    class AutotuneSession
+    {
+    public:
+        AutotuneSession(tflite::FlatBufferModel *model, const CpuTopology &topology)
+            : model_(model), topology_(topology) {}
+
+        AutotuneResult Run(const AutotuneConfig &config, const std::vector<std::vector<int>> &prompts,
+                           int decode_steps)
+        {
+            std::vector<int> cpus = PlanThreadPlacement(topology_, config.placement).compute_cpus;
+            // Workers created inside this scope inherit the core set.
+            ScopedThreadAffinity compute(cpus);
+            if (!interpreter_ || config.placement != built_.placement || config.num_threads != built_.num_threads ||
+                config.weight_cache_path != built_.weight_cache_path)
+            {
+                prefetcher_.reset();
+                interpreter_.reset();
+                interpreter_ = BuildInterpreter(model_, config.num_threads, config.weight_cache_path);
+                kv_cache_ = BuildKVCache(interpreter_.get());
+                prefetcher_ = std::make_unique<WeightPrefetcher>(interpreter_.get(), config.prefetch_depth);
+                built_ = config;
+            }
+            prefetcher_->set_depth(config.prefetch_depth);
+            if (config.prefetch_depth > 0)
+            {
+                interpreter_->SetProfiler(prefetcher_.get());
+            }
+            // The first prompt runs once untimed to fault in weights and arenas.
+            RunPrompt(config, prompts.front(), decode_steps);
+            AutotuneResult result;
+            for (const std::vector<int> &prompt_tokens : prompts)
+            {
+                AutotuneResult one = RunPrompt(config, prompt_tokens, decode_steps);
+                result.prefill_ms += one.prefill_ms;
+                result.decode_ms += one.decode_ms;
+                result.prefill_tokens += one.prefill_tokens;
+                result.decode_tokens += one.decode_tokens;
+            }
+            interpreter_->SetProfiler(nullptr);
+            return result;
+        }
+
+        tflite::Interpreter *interpreter() const { return interpreter_.get(); }
+        // Of the last interpreter built; delegation does not depend on the settings tried.
+        const WeightPrefetcher &prefetcher() const { return *prefetcher_; }
+
+    private:
+        AutotuneResult RunPrompt(const AutotuneConfig &config, const std::vector<int> &prompt_tokens,
+                                 int decode_steps)
+        {
+            for (auto &[name, buffer] : kv_cache_)
+            {
+                std::fill(buffer.begin(), buffer.end(), 0.0f);
+            }
+            tflite::SignatureRunner *prefill_runner = GetPrefillRunner(
+                interpreter_.get(), prompt_tokens.size() - 1, kv_cache_, nullptr, config.prefill_signature);
+            tflite::SignatureRunner *decode_runner = GetDecodeRunner(interpreter_.get(), kv_cache_, nullptr);
+            TfLiteTensor *prefill_input = prefill_runner->input_tensor("tokens");
+            TfLiteTensor *prefill_input_pos = prefill_runner->input_tensor("input_pos");
+            TfLiteTensor *decode_input = decode_runner->input_tensor("tokens");
+            TfLiteTensor *decode_input_pos = decode_runner->input_tensor("input_pos");
+            int kv_cache_max_size = decode_runner->input_tensor("kv_cache_k_0")->dims->data[1];
+
+            AutotuneResult result;
+            int prefill_seq_size = std::min<int>(prompt_tokens.size(), prefill_input->dims->data[1]);
+            std::memset(prefill_input->data.i32, 0, prefill_input->bytes);
+            std::memset(prefill_input_pos->data.i32, 0, prefill_input_pos->bytes);
+            for (int i = 0; i < prefill_seq_size - 1; ++i)
+            {
+                prefill_input->data.i32[i] = prompt_tokens[i];
+                prefill_input_pos->data.i32[i] = i;
+            }
+            auto start = std::chrono::steady_clock::now();
+            MINIMAL_CHECK(prefill_runner->Invoke() == kTfLiteOk);
+            result.prefill_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                    .count();
+            result.prefill_tokens = prefill_seq_size - 1;
+
+            // Decode time does not depend on the token values, so the last
+            // prompt token is fed back instead of sampling.
+            int steps = std::min(decode_steps, kv_cache_max_size - prefill_seq_size);
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < steps; ++i)
+            {
+                decode_input->data.i32[0] = prompt_tokens[prefill_seq_size - 1];
+                decode_input_pos->data.i32[0] = prefill_seq_size - 1 + i;
+                MINIMAL_CHECK(decode_runner->Invoke() == kTfLiteOk);
+            }
+            result.decode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                   .count();
+            result.decode_tokens = std::max(0, steps);
+            return result;
+        }
+
+        tflite::FlatBufferModel *model_;
+        const CpuTopology &topology_;
+        std::unique_ptr<tflite::Interpreter> interpreter_;
+        KVCache kv_cache_;
+        std::unique_ptr<WeightPrefetcher> prefetcher_;
+        AutotuneConfig built_;
+    };
+
+    // --------------------------------------------------------------------------
+    // --autotune: tunes one setting at a time (core set, threads, weight cache,
+    // prefill signature, prefetch depth), keeping the best value of each before
+    // moving on, and stores the winner in the device profile. Settings given
+    // on the command line are not searched.
+    // --------------------------------------------------------------------------
+    int RunAutotune(tflite::FlatBufferModel *model, sentencepiece::SentencePieceProcessor *sp_processor,
+                    const CpuTopology &topology, TuningCache *profile, const std::string &profile_key)
+    {
+        std::vector<std::string> prompt_texts = {absl::GetFlag(FLAGS_prompt)};
+        if (!absl::GetFlag(FLAGS_autotune_prompts).empty())
+        {
+            prompt_texts = LoadBatchPrompts(absl::GetFlag(FLAGS_autotune_prompts));
+        }
+        std::vector<std::vector<int>> prompts;
+        size_t longest = 0;
+        for (const std::string &text : prompt_texts)
+        {
+            std::vector<int> tokens;
+            sp_processor->Encode(text, &tokens);
+            if (!absl::GetFlag(FLAGS_start_token).empty())
+            {
+                tokens.insert(tokens.begin(), sp_processor->PieceToId(absl::GetFlag(FLAGS_start_token)));
+            }
+            if (tokens.size() >= 2)
+            {
+                longest = std::max(longest, tokens.size() - 1);
+                prompts.push_back(std::move(tokens));
+            }
+        }
+        if (prompts.empty())
+        {
+            std::cerr << "Error: --autotune needs at least one prompt of two or more tokens." << std::endl;
+            return 1;
+        }
+        const int decode_steps = absl::GetFlag(FLAGS_autotune_decode_steps);
+
+        AutotuneConfig best;
+        ParseThreadPlacement(absl::GetFlag(FLAGS_thread_placement), &best.placement);
+        best.num_threads = absl::GetFlag(FLAGS_num_threads);
+        best.weight_cache_path = absl::GetFlag(FLAGS_weight_cache_path);
+        best.prefill_signature = absl::GetFlag(FLAGS_prefill_signature);
+        best.prefetch_depth = absl::GetFlag(FLAGS_prefetch_depth);
+
+        AutotuneSession session(model, topology);
+        AutotuneResult best_result = session.Run(best, prompts, decode_steps);
+        auto report = [&](const AutotuneConfig &config, const AutotuneResult &result)
+        {
+            std::cout << "[AUTOTUNE] " << config << ": prefill "
+                      << result.prefill_tokens * 1000.0 / std::max(result.prefill_ms, 1e-9) << " tok/s, decode "
+                      << result.decode_tokens * 1000.0 / std::max(result.decode_ms, 1e-9) << " tok/s, total "
+                      << result.total_ms() << " ms\n";
+        };
+        report(best, best_result);
+        auto try_values = [&](const char *flag, auto field, const auto &values)
+        {
+            if (IsFlagExplicit(flag))
+            {
+                return;
+            }
+            for (const auto &value : values)
+            {
+                AutotuneConfig candidate = best;
+                candidate.*field = value;
+                if (candidate.*field == best.*field)
+                {
+                    continue;
+                }
+                AutotuneResult result = session.Run(candidate, prompts, decode_steps);
+                report(candidate, result);
+                if (result.total_ms() < best_result.total_ms())
+                {
+                    best = candidate;
+                    best_result = result;
+                }
+            }
+        };
+
+        if (topology.heterogeneous())
+        {
+            try_values("thread_placement", &AutotuneConfig::placement,
+                       std::vector<ThreadPlacement>{ThreadPlacement::kPerformance, ThreadPlacement::kEfficiency});
+        }
+        std::vector<int> cpus = PlanThreadPlacement(topology, best.placement).compute_cpus;
+        if (cpus.empty())
+        {
+            cpus = topology.all_cpus();
+        }
+        try_values("num_threads", &AutotuneConfig::num_threads,
+                   ThreadCountCandidates(static_cast<int>(cpus.size())));
+        try_values("weight_cache_path", &AutotuneConfig::weight_cache_path,
+                   std::vector<std::string>{absl::GetFlag(FLAGS_tflite_model) + ".xnnpack_cache"});
+        std::vector<std::string> signatures;
+        for (const auto &[name, seq_size] : ListPrefillSignatures(session.interpreter()))
+        {
+            if (static_cast<size_t>(seq_size) >= longest)
+            {
+                signatures.push_back(name);
+            }
+        }
+        try_values("prefill_signature", &AutotuneConfig::prefill_signature, signatures);
+        if (session.prefetcher().weight_bytes() == 0)
+        {
+            std::cout << "[AUTOTUNE] Skipping prefetch_depth: no mmap'd weights outside the "
+                      << session.prefetcher().delegated_nodes() << " delegated nodes, keeping "
+                      << best.prefetch_depth << "\n";
+        }
+        else
+        {
+            try_values("prefetch_depth", &AutotuneConfig::prefetch_depth, std::vector<int>{1, 4, 16});
+        }
+
+        std::cout << "[AUTOTUNE] Best: " << best << "\n";
+        profile->Set(profile_key, "thread_placement", ThreadPlacementName(best.placement));
+        profile->Set(profile_key, "num_threads", best.num_threads);
+        profile->Set(profile_key, "weight_cache_path", best.weight_cache_path);
+        profile->Set(profile_key, "prefill_signature", best.prefill_signature);
+        profile->Set(profile_key, "prefetch_depth", best.prefetch_depth);
+        if (!profile->Save())
+        {
+            std::cerr << "Error: failed to write device profile " << profile->path() << std::endl;
+            return 1;
+        }
+        std::cout << "[INFO] Saved device profile to " << profile->path() << "\n";
+        return 0;
+    }
+
+    void uploadTensorsForAllSubgraphs(tflite::Interpreter* interpreter) {
+        if (!interpreter) {
+            std::cerr << "Invalid interpreter pointer\n";
+            return;
+        }
+    
+        // Get the number of subgraphs
+        size_t num_subgraphs = interpreter->subgraphs_size();
+        std::cout << "Processing " << num_subgraphs << " subgraphs\n";
+    
+        // Keep track of total tensors touched across all subgraphs
+        size_t total_tensors_touched = 0;
+    
+        // Process each subgraph
+        for (size_t subgraph_idx = 0; subgraph_idx < num_subgraphs; ++subgraph_idx) {
             const tflite::Subgraph& subgraph = (subgraph_idx == 0) ?
                 interpreter->primary_subgraph() :
                 *interpreter->subgraph(subgraph_idx);
@@ -1446,10 +2849,30 @@ namespace
 int main(int argc, char *argv[])
 {
     // 0. Parse flags
+    RecordExplicitFlags(argc, argv);
     absl::ParseCommandLine(argc, argv);
     std::cout << "[INFO] Preparing Required Components\n";
 
+    // 0-0. Settings from an earlier --autotune run on this model, host and
+    // CPU set, keyed before any placement narrows the affinity mask
+    const std::string profile_key = TuningKey(absl::GetFlag(FLAGS_tflite_model), GetThreadAffinity(0));
+    TuningCache device_profile(TuningCachePath());
+    if (device_profile.Load() && !absl::GetFlag(FLAGS_autotune) && device_profile.Find(profile_key))
+    {
+        ApplyDeviceProfile(*device_profile.Find(profile_key));
+    }
+
+    // 0-0a. Optional timeline trace of the whole run
+    std::unique_ptr<TraceWriter> trace_writer;
+    if (!absl::GetFlag(FLAGS_trace_out).empty())
+    {
+        trace_writer = std::make_unique<TraceWriter>();
+        trace_writer->NameThread("main");
+        TraceWriter::Install(trace_writer.get());
+    }
+
     // Global variables
+    std::unique_ptr<NumaBuffer> model_replica;  // Outlives the model built on it.
     std::unique_ptr<tflite::FlatBufferModel> model;
     std::unique_ptr<tflite::Interpreter> interpreter;
     std::unique_ptr<sentencepiece::SentencePieceProcessor> sp_processor;
@@ -1473,39 +2896,339 @@ int main(int argc, char *argv[])
     PerformanceMetrics metrics;
     PerfStats stats;
 
+    // 0-1a. Topology-aware placement. The main thread runs every Invoke()
+    // and creates the interpreter's worker pool, so pinning it here places
+    // the workers too; auxiliary threads are started under the other mask.
+    ThreadPlacement thread_placement;
+    if (!ParseThreadPlacement(absl::GetFlag(FLAGS_thread_placement), &thread_placement))
+    {
+        std::cerr << "Error: --thread_placement must be 'none', 'performance' or 'efficiency'." << std::endl;
+        return 1;
+    }
+    CpuTopology cpu_topology = DiscoverCpuTopology();
+    cpu_topology.Print(std::cout);
+    PlacementPlan placement = PlanThreadPlacement(cpu_topology, thread_placement);
+    if (thread_placement != ThreadPlacement::kNone)
+    {
+        if (!SetThreadAffinity(0, placement.compute_cpus))
+        {
+            std::cerr << "Warning: failed to pin the interpreter to cpus "
+                      << FormatCpuList(placement.compute_cpus) << ": " << strerror(errno) << std::endl;
+        }
+        std::cout << "[INFO] Thread placement '" << ThreadPlacementName(thread_placement)
+                  << "': compute on cpus " << FormatCpuList(placement.compute_cpus)
+                  << ", auxiliary threads on cpus " << FormatCpuList(placement.auxiliary_cpus) << "\n";
+        if (!cpu_topology.heterogeneous())
+        {
+            std::cout << "[INFO] No core clusters found; placement only keeps threads inside the affinity mask\n";
+        }
+        if (absl::GetFlag(FLAGS_num_threads) > static_cast<int>(placement.compute_cpus.size()))
+        {
+            std::cerr << "Warning: --num_threads=" << absl::GetFlag(FLAGS_num_threads) << " exceeds the "
+                      << placement.compute_cpus.size() << " compute cores; workers will share cores." << std::endl;
+        }
+    }
+
+    // 0-1b. NUMA placement. The memory policy is set on the main thread before
+    // the model, arena, packed weights and KV cache are allocated; worker
+    // threads inherit it along with the affinity mask.
+    NumaPolicy numa_policy;
+    if (!ParseNumaPolicy(absl::GetFlag(FLAGS_numa_policy), &numa_policy))
+    {
+        std::cerr << "Error: --numa_policy must be 'none', 'bind' or 'interleave'." << std::endl;
+        return 1;
+    }
+    NumaTopology numa_topology = DiscoverNumaTopology();
+    std::vector<int> numa_nodes;
+    if (numa_policy != NumaPolicy::kNone)
+    {
+        numa_topology.Print(std::cout);
+        if (!numa_topology.multi_node())
+        {
+            std::cerr << "Warning: only one NUMA node; ignoring --numa_policy." << std::endl;
+            numa_policy = NumaPolicy::kNone;
+        }
+    }
+    if (numa_policy == NumaPolicy::kBind)
+    {
+        std::vector<int> candidates = placement.compute_cpus.empty() ? GetThreadAffinity(0) : placement.compute_cpus;
+        int node = absl::GetFlag(FLAGS_numa_node);
+        if (node < 0 && !candidates.empty())
+        {
+            node = numa_topology.NodeOfCpu(candidates.front());
+        }
+        const NumaNode *bound = numa_topology.Find(node);
+        if (bound == nullptr || bound->cpus.empty())
+        {
+            std::cerr << "Error: NUMA node " << node << " has no memory or no CPUs in the affinity mask." << std::endl;
+            return 1;
+        }
+        std::vector<int> node_cpus;
+        std::set_intersection(candidates.begin(), candidates.end(), bound->cpus.begin(), bound->cpus.end(),
+                              std::back_inserter(node_cpus));
+        if (node_cpus.empty())
+        {
+            std::cerr << "Warning: no compute cpus on node " << node << "; using all of its cpus." << std::endl;
+            node_cpus = bound->cpus;
+        }
+        placement.compute_cpus = node_cpus;
+        if (!SetThreadAffinity(0, placement.compute_cpus))
+        {
+            std::cerr << "Warning: failed to pin the interpreter to node " << node << ": " << strerror(errno) << std::endl;
+        }
+        if (absl::GetFlag(FLAGS_num_threads) > static_cast<int>(node_cpus.size()))
+        {
+            std::cerr << "Warning: --num_threads=" << absl::GetFlag(FLAGS_num_threads) << " exceeds the "
+                      << node_cpus.size() << " cpus of node " << node << "; workers will share cores." << std::endl;
+        }
+        numa_nodes = {node};
+    }
+    else if (numa_policy == NumaPolicy::kInterleave)
+    {
+        numa_nodes = numa_topology.node_ids();
+    }
+    if (numa_policy != NumaPolicy::kNone)
+    {
+        if (!SetMemoryPolicy(numa_policy, numa_nodes))
+        {
+            std::cerr << "Warning: set_mempolicy failed: " << strerror(errno) << std::endl;
+        }
+        std::cout << "[INFO] NUMA policy '" << NumaPolicyName(numa_policy) << "' on node(s) "
+                  << FormatCpuList(numa_nodes);
+        if (numa_policy == NumaPolicy::kBind)
+        {
+            std::cout << ", compute on cpus " << FormatCpuList(placement.compute_cpus);
+        }
+        std::cout << "\n";
+    }
+    else if (absl::GetFlag(FLAGS_numa_replicate_weights))
+    {
+        std::cerr << "Warning: --numa_replicate_weights needs --numa_policy; ignoring it." << std::endl;
+    }
+
+    // 0-1c. Latency mode settings, engaged only around the decode loop
+    LatencyOptions latency_options;
+    std::string latency_error;
+    if (!ParseLatencyModes(absl::GetFlag(FLAGS_latency_mode), &latency_options, &latency_error))
+    {
+        std::cerr << "Error: unknown --latency_mode entry '" << latency_error
+                  << "'; use fifo, rr, nice, uclamp, freq, dma or off." << std::endl;
+        return 1;
+    }
+    latency_options.rt_priority = absl::GetFlag(FLAGS_latency_rt_priority);
+    latency_options.nice = absl::GetFlag(FLAGS_latency_nice);
+    latency_options.uclamp_min = absl::GetFlag(FLAGS_latency_uclamp_min);
+    if (latency_options.min_freq_khz != 0)
+    {
+        latency_options.min_freq_khz = absl::GetFlag(FLAGS_latency_min_freq_khz);
+    }
+    const bool latency_mode = latency_options.policy != LatencyOptions::Policy::kDefault ||
+                              latency_options.set_nice || latency_options.set_uclamp_min ||
+                              latency_options.min_freq_khz != 0 || latency_options.hold_dma_latency;
+
+    // 0-1d. Optional memory sampler thread, tagged with the current
+    // phase/token. Started before the counter groups below are opened, so
+    // their inherited counters do not count the sampler's own wakeups.
+    std::unique_ptr<MemorySampler> memory_sampler;
+    int memory_phase_load = -1, memory_phase_build = -1, memory_phase_setup = -1;
+    int memory_phase_prefill = -1, memory_phase_decode = -1;
+    if (!absl::GetFlag(FLAGS_memory_samples_out).empty())
+    {
+        memory_sampler = std::make_unique<MemorySampler>(absl::GetFlag(FLAGS_memory_sample_interval_us));
+        memory_phase_load = memory_sampler->RegisterPhase("load_model");
+        memory_phase_build = memory_sampler->RegisterPhase("build_interpreter");
+        memory_phase_setup = memory_sampler->RegisterPhase("setup");
+        memory_phase_prefill = memory_sampler->RegisterPhase("prefill");
+        memory_phase_decode = memory_sampler->RegisterPhase("decode");
+        ScopedThreadAffinity auxiliary(placement.auxiliary_cpus);
+        memory_sampler->Start();
+    }
+    auto mark_memory_phase = [&](int phase, int token = -1)
+    {
+        if (memory_sampler)
+        {
+            memory_sampler->SetPhase(phase, token);
+        }
+    };
+
+    // Per-step counters are opened once here, before the delegate creates its
+    // worker threads, so that the counter group is inherited by them.
+    Instrumentation instrumentation;
+    const int decode_token_phase = instrumentation.RegisterPhase("Decode_Token");
+    const int decode_round_phase = instrumentation.RegisterPhase("Decode_Round");
+
+    // Grouped hardware counters follow the same rule; the bandwidth probe
+    // runs before the model is mapped so it does not evict it.
+    std::unique_ptr<HardwareCounters> hw_counters;
+    if (absl::GetFlag(FLAGS_hw_counters))
+    {
+        hw_counters = std::make_unique<HardwareCounters>();
+        perf_monitor.set_hardware_counters(hw_counters.get());
+        double peak_gbps = absl::GetFlag(FLAGS_peak_bandwidth_gbps);
+        if (peak_gbps <= 0)
+        {
+            peak_gbps = MeasurePeakReadBandwidth(absl::GetFlag(FLAGS_num_threads));
+            std::cout << "[INFO] Measured peak read bandwidth: " << peak_gbps << " GB/s\n";
+        }
+        metrics.set_peak_bandwidth_gbps(peak_gbps);
+    }
+
+    // Energy counters; phases and decode tokens are charged from them
+    std::unique_ptr<EnergyMeter> energy_meter;
+    if (absl::GetFlag(FLAGS_energy))
+    {
+        energy_meter = std::make_unique<EnergyMeter>(absl::GetFlag(FLAGS_sysfs_root));
+        if (energy_meter->available())
+        {
+            std::cout << "[ENERGY] Reading " << energy_meter->Describe() << "\n";
+            perf_monitor.set_energy_meter(energy_meter.get());
+        }
+        else
+        {
+            std::cerr << "Warning: --energy found no readable RAPL, hwmon or battery counters under "
+                      << absl::GetFlag(FLAGS_sysfs_root) << "; disabled." << std::endl;
+            energy_meter.reset();
+        }
+    }
+
     // Add some code to get I/O stats from /proc for better I/O measurement
     double proc_io_wait_start = 0.0;
 
     // 0-2. Variable for CPU time only
     rusage usage_start, usage_end;
 
+    // 0-3. Optional setup pipeline: the tokenizer is loaded and the prompt
+    // encoded on a helper thread while steps 1-5 run here
+    auto prepare_prompt = [&]()
+    {
+        prompt = absl::GetFlag(FLAGS_prompt);
+        MINIMAL_CHECK(sp_processor->Encode(prompt, &prompt_tokens).ok());
+
+        start_token = absl::GetFlag(FLAGS_start_token);
+        if (!start_token.empty())
+        {
+            prompt_tokens.insert(prompt_tokens.begin(), sp_processor->PieceToId(start_token));
+        }
+
+        stop_token = absl::GetFlag(FLAGS_stop_token);
+        if (!stop_token.empty())
+        {
+            stop_token_id = sp_processor->PieceToId(stop_token);
+        }
+    };
+    std::unique_ptr<TaskGraph> setup_graph;
+    int load_tokenizer_task = -1, prepare_prompt_task = -1;
+    // Decode time inside Invoke() and between consecutive Invoke() calls,
+    // which is the part of the loop that still runs serially
+    double decode_invoke_ms = 0.0, decode_gap_ms = 0.0;
+    if (absl::GetFlag(FLAGS_pipelined_setup))
+    {
+        ScopedThreadAffinity auxiliary(placement.auxiliary_cpus);
+        setup_graph = std::make_unique<TaskGraph>(1);
+        perf_monitor.set_task_graph(setup_graph.get());
+        load_tokenizer_task = setup_graph->Add("Load_SentencePiece", [&]()
+                                               { sp_processor = LoadSentencePieceProcessor(); });
+        prepare_prompt_task = setup_graph->Add("Prepare_Prompt", prepare_prompt, {load_tokenizer_task});
+    }
+
     // 1. Load Model
+    mark_memory_phase(memory_phase_load);
     {
         ScopeTimer timer("Model Loading");
         getrusage(RUSAGE_SELF, &usage_start);
         perf_monitor.start_phase("Model_Loading");
-        model = LoadModel();
+        if (numa_policy != NumaPolicy::kNone && absl::GetFlag(FLAGS_numa_replicate_weights))
+        {
+            model_replica = LoadModelReplica(absl::GetFlag(FLAGS_tflite_model), numa_policy, numa_nodes, numa_topology);
+        }
+        if (model_replica)
+        {
+            model = tflite::FlatBufferModel::BuildFromBuffer(model_replica->data(), model_replica->size());
+            MINIMAL_CHECK(model != nullptr);
+        }
+        else
+        {
+            model = LoadModel(absl::GetFlag(FLAGS_tflite_model));
+        }
         stats = perf_monitor.end_phase("Model_Loading");
         getrusage(RUSAGE_SELF, &usage_end);
     }
     PrintRUsage(usage_start, usage_end, "Model Loading");
     metrics.RecordStats("Model_Loading", stats);
 
-    // 2. Build Interpreter
+    // 1-1. --autotune benchmarks settings on the loaded model and exits
+    if (absl::GetFlag(FLAGS_autotune))
     {
-        ScopeTimer timer("Interpreter Building");
-        getrusage(RUSAGE_SELF, &usage_start);
-        perf_monitor.start_phase("Build_Interperter");
-        interpreter = BuildInterpreter(model.get(), absl::GetFlag(FLAGS_num_threads));
-        stats = perf_monitor.end_phase("Build_Interperter");
-        getrusage(RUSAGE_SELF, &usage_end);
+        if (setup_graph)
+        {
+            setup_graph->Wait(load_tokenizer_task);
+        }
+        else
+        {
+            sp_processor = LoadSentencePieceProcessor();
+        }
+        return RunAutotune(model.get(), sp_processor.get(), cpu_topology, &device_profile, profile_key);
     }
-    PrintRUsage(usage_start, usage_end, "Interpreter Building");
-    metrics.RecordStats("Build_Interpreter", stats);
 
-    // Tensor upload before prefill
+    // 2. Build Interpreter. Prefill and decode may use different thread
+    // counts; decode then gets its own interpreter in step 7.
+    const int default_threads = absl::GetFlag(FLAGS_num_threads);
+    int prefill_threads = absl::GetFlag(FLAGS_prefill_num_threads) > 0
+                              ? absl::GetFlag(FLAGS_prefill_num_threads)
+                              : default_threads;
+    int decode_threads = absl::GetFlag(FLAGS_decode_num_threads) > 0
+                             ? absl::GetFlag(FLAGS_decode_num_threads)
+                             : default_threads;
+    int built_threads = prefill_threads;
+    // Worker threads of every interpreter built, for placement and latency mode
+    std::vector<pid_t> interpreter_worker_tids;
+    auto build_interpreter = [&](int num_threads)
     {
-        ScopeTimer timer("Tensor Uploading");
+        std::vector<pid_t> threads_before = ListThreadIds();
+        std::unique_ptr<tflite::Interpreter> built =
+            BuildInterpreter(model.get(), num_threads, absl::GetFlag(FLAGS_weight_cache_path));
+        std::vector<pid_t> new_tids;
+        for (pid_t tid : ListThreadIds())
+        {
+            if (!std::binary_search(threads_before.begin(), threads_before.end(), tid))
+            {
+                new_tids.push_back(tid);
+            }
+        }
+        interpreter_worker_tids.insert(interpreter_worker_tids.end(), new_tids.begin(), new_tids.end());
+        if (!placement.compute_cpus.empty())
+        {
+            // Workers inherit the mask already; pin them explicitly anyway so a
+            // pool created from another thread cannot escape the compute cores.
+            int pinned = 0;
+            for (pid_t tid : new_tids)
+            {
+                if (SetThreadAffinity(tid, placement.compute_cpus))
+                {
+                    ++pinned;
+                }
+            }
+            std::cout << "[INFO] Pinned " << pinned << " interpreter worker threads to cpus "
+                      << FormatCpuList(placement.compute_cpus) << "\n";
+        }
+        return built;
+    };
+    mark_memory_phase(memory_phase_build);
+    {
+        ScopeTimer timer("Interpreter Building");
+        getrusage(RUSAGE_SELF, &usage_start);
+        perf_monitor.start_phase("Build_Interperter");
+        interpreter = build_interpreter(prefill_threads);
+        stats = perf_monitor.end_phase("Build_Interperter");
+        getrusage(RUSAGE_SELF, &usage_end);
+    }
+    PrintRUsage(usage_start, usage_end, "Interpreter Building");
+    metrics.RecordStats("Build_Interpreter", stats);
+
+    // Tensor upload before prefill
+    mark_memory_phase(memory_phase_setup);
+    {
+        ScopeTimer timer("Tensor Uploading");
         getrusage(RUSAGE_SELF, &usage_start);
         perf_monitor.start_phase("Upload_Tensor");
 
@@ -1519,17 +3242,20 @@ int main(int argc, char *argv[])
     metrics.RecordStats("Upload_Tensor", stats);
 
 
-    // 3. Load SentencePiece
+    // 3. Load SentencePiece, unless the setup pipeline does it
+    if (!setup_graph)
     {
-        ScopeTimer timer("SentencePiece Loading");
-        getrusage(RUSAGE_SELF, &usage_start);
-        perf_monitor.start_phase("Load_SentencePiece");
-        sp_processor = LoadSentencePieceProcessor();
-        stats = perf_monitor.end_phase("Load_SentencePiece");
-        getrusage(RUSAGE_SELF, &usage_end);
+        {
+            ScopeTimer timer("SentencePiece Loading");
+            getrusage(RUSAGE_SELF, &usage_start);
+            perf_monitor.start_phase("Load_SentencePiece");
+            sp_processor = LoadSentencePieceProcessor();
+            stats = perf_monitor.end_phase("Load_SentencePiece");
+            getrusage(RUSAGE_SELF, &usage_end);
+        }
+        PrintRUsage(usage_start, usage_end, "Sentence Piece Loading");
+        metrics.RecordStats("Load_SentencePiece", stats);
     }
-    PrintRUsage(usage_start, usage_end, "Sentence Piece Loading");
-    metrics.RecordStats("Load_SentencePiece", stats);
 
     // 4. Build KV Cache
     {
@@ -1544,6 +3270,27 @@ int main(int argc, char *argv[])
     PrintRUsage(usage_start, usage_end, "KV Cache Building");
     metrics.RecordStats("Build_KVCache", stats);
 
+    // 4-1. Where the policy actually put the weights and the KV cache; pages
+    // another process faulted into the page cache stay on their node
+    if (numa_policy != NumaPolicy::kNone)
+    {
+        const tflite::Allocation *allocation = model->allocation();
+        if (allocation != nullptr)
+        {
+            std::cout << "[NUMA] Model weights (" << (model_replica ? "private copy" : "shared mapping") << "): "
+                      << FormatPageNodes(SamplePageNodes(allocation->base(), allocation->bytes())) << "\n";
+        }
+        std::map<int, size_t> kv_pages;
+        for (const auto &[name, buffer] : kv_cache)
+        {
+            for (const auto &[node, pages] : SamplePageNodes(buffer.data(), buffer.size() * sizeof(float), 256))
+            {
+                kv_pages[node] += pages;
+            }
+        }
+        std::cout << "[NUMA] KV cache: " << FormatPageNodes(kv_pages) << "\n";
+    }
+
     // 5. Optionally load LoRA
     // {
     //     ScopeTimer timer("LoRA Loading");
@@ -1554,32 +3301,86 @@ int main(int argc, char *argv[])
     //     }
     // }
 
-    // 6. Prepare Input Prompt
+    // 6. Prepare Input Prompt, or join the setup pipeline that did it
+    if (setup_graph)
+    {
+        setup_graph->Wait(prepare_prompt_task);
+    }
+    else
     {
-        ScopeTimer timer("Input Prompt Preparation");
-        getrusage(RUSAGE_SELF, &usage_start);
-        perf_monitor.start_phase("Prepare_Prompt");
-        prompt = absl::GetFlag(FLAGS_prompt);
-        MINIMAL_CHECK(sp_processor->Encode(prompt, &prompt_tokens).ok());
-
-        start_token = absl::GetFlag(FLAGS_start_token);
-        if (!start_token.empty())
         {
-            prompt_tokens.insert(prompt_tokens.begin(), sp_processor->PieceToId(start_token));
+            ScopeTimer timer("Input Prompt Preparation");
+            getrusage(RUSAGE_SELF, &usage_start);
+            perf_monitor.start_phase("Prepare_Prompt");
+            prepare_prompt();
+            stats = perf_monitor.end_phase("Prepare_Prompt");
+            getrusage(RUSAGE_SELF, &usage_end);
         }
+        PrintRUsage(usage_start, usage_end, "Input Prompt Preparation");
+        metrics.RecordStats("Prepare_Prompt", stats);
+    }
 
-        stop_token = absl::GetFlag(FLAGS_stop_token);
-        if (!stop_token.empty())
+    // 6-1. Per-phase thread counts from the tuning cache, measured on the
+    // first run for this model and CPU set
+    if (absl::GetFlag(FLAGS_autotune_threads))
+    {
+        const std::string cache_path = TuningCachePath();
+        std::vector<int> cpus = GetThreadAffinity(0);
+        const std::string key = TuningKey(absl::GetFlag(FLAGS_tflite_model), cpus);
+        TuningCache cache(cache_path);
+        cache.Load();
+        int tuned_prefill = cache.GetInt(key, "prefill_threads", 0);
+        int tuned_decode = cache.GetInt(key, "decode_threads", 0);
+        if (tuned_prefill > 0 && tuned_decode > 0)
         {
-            stop_token_id = sp_processor->PieceToId(stop_token);
+            std::cout << "[INFO] Using tuned thread counts from " << cache_path << "\n";
+        }
+        else
+        {
+            ScopeTimer timer("Thread Count Auto-tuning");
+            std::size_t num_input_tokens = prompt_tokens.empty() ? 0 : prompt_tokens.size() - 1;
+            ThreadTuning tuning = AutotuneThreadCounts(
+                build_interpreter, kv_cache, num_input_tokens,
+                ThreadCountCandidates(static_cast<int>(cpus.size())), absl::GetFlag(FLAGS_autotune_reps));
+            tuned_prefill = tuning.prefill_threads;
+            tuned_decode = tuning.decode_threads;
+            cache.Set(key, "prefill_threads", tuned_prefill);
+            cache.Set(key, "decode_threads", tuned_decode);
+            if (cache.Save())
+            {
+                std::cout << "[INFO] Saved tuned thread counts to " << cache_path << "\n";
+            }
+            else
+            {
+                std::cerr << "Warning: failed to write tuning cache " << cache_path << std::endl;
+            }
+        }
+        // Explicit per-phase flags override the tuned values.
+        if (absl::GetFlag(FLAGS_prefill_num_threads) <= 0)
+        {
+            prefill_threads = tuned_prefill;
+        }
+        if (absl::GetFlag(FLAGS_decode_num_threads) <= 0)
+        {
+            decode_threads = tuned_decode;
+        }
+        std::cout << "[INFO] Thread counts: prefill " << prefill_threads << ", decode " << decode_threads << "\n";
+        if (built_threads != prefill_threads)
+        {
+            interpreter = build_interpreter(prefill_threads);
+            built_threads = prefill_threads;
         }
-        stats = perf_monitor.end_phase("Prepare_Prompt");
-        getrusage(RUSAGE_SELF, &usage_end);
     }
-    PrintRUsage(usage_start, usage_end, "Input Prompt Preparation");
-    metrics.RecordStats("Prepare_Prompt", stats);
 
-    // 7. Prepare Signature Runners
+    // 7. Prepare Signature Runners. A decode thread count different from
+    // prefill's gets a second interpreter over the same KV cache buffers.
+    std::unique_ptr<tflite::Interpreter> decode_interpreter;
+    if (decode_threads != built_threads && absl::GetFlag(FLAGS_op_profile))
+    {
+        std::cerr << "Warning: --op_profile profiles a single interpreter; decode uses "
+                  << built_threads << " threads." << std::endl;
+        decode_threads = built_threads;
+    }
     tflite::SignatureRunner *prefill_runner = nullptr;
     tflite::SignatureRunner *decode_runner = nullptr;
     {
@@ -1590,12 +3391,23 @@ int main(int argc, char *argv[])
             (prompt_tokens.size() > 0) ? (prompt_tokens.size() - 1) : 0;
             // std::cout << "HELLO";
         prefill_runner = GetPrefillRunner(
-            interpreter.get(), effective_prefill_token_size, kv_cache, nullptr);
+            interpreter.get(), effective_prefill_token_size, kv_cache, nullptr,
+            absl::GetFlag(FLAGS_prefill_signature));
         // std::cout << "HELLO2";
         MINIMAL_CHECK(prefill_runner != nullptr);
         // std::cout << "HELLO1";
 
-        decode_runner = GetDecodeRunner(interpreter.get(), kv_cache, nullptr);
+        if (decode_threads != built_threads)
+        {
+            if (absl::GetFlag(FLAGS_weight_cache_path).empty())
+            {
+                std::cerr << "Warning: the decode interpreter packs its own copy of the weights; "
+                             "set --weight_cache_path to share them." << std::endl;
+            }
+            decode_interpreter = build_interpreter(decode_threads);
+        }
+        decode_runner = GetDecodeRunner(
+            decode_interpreter ? decode_interpreter.get() : interpreter.get(), kv_cache, nullptr);
         // std::cout << "HELLO4";
         MINIMAL_CHECK(decode_runner != nullptr);
         // std::cout << "HELLO3";
@@ -1605,6 +3417,274 @@ int main(int argc, char *argv[])
     }
     PrintRUsage(usage_start, usage_end, "Signature Runner Preparation");
     metrics.RecordStats("Prepare_Runners", stats);
+
+    // 7-1. Optionally attach the per-operator profiler to every subgraph
+    std::unique_ptr<OpProfiler> op_profiler;
+    if (absl::GetFlag(FLAGS_op_profile))
+    {
+        op_profiler = std::make_unique<OpProfiler>(interpreter.get());
+        op_profiler->SetPhase("prefill");
+        interpreter->SetProfiler(op_profiler.get());
+    }
+
+    // 7-1a. Optional weight prefetcher; it uses the same profiler hook
+    std::vector<std::unique_ptr<WeightPrefetcher>> prefetchers;
+    if (absl::GetFlag(FLAGS_prefetch_depth) > 0)
+    {
+        if (op_profiler)
+        {
+            std::cerr << "Warning: --prefetch_depth is disabled while --op_profile is attached." << std::endl;
+        }
+        else
+        {
+            for (tflite::Interpreter *target : {interpreter.get(), decode_interpreter.get()})
+            {
+                if (target != nullptr)
+                {
+                    prefetchers.push_back(
+                        std::make_unique<WeightPrefetcher>(target, absl::GetFlag(FLAGS_prefetch_depth)));
+                    target->SetProfiler(prefetchers.back().get());
+                }
+            }
+            uint64_t weight_bytes = 0;
+            int delegated_nodes = 0;
+            for (const auto &prefetcher : prefetchers)
+            {
+                weight_bytes += prefetcher->weight_bytes();
+                delegated_nodes += prefetcher->delegated_nodes();
+            }
+            if (weight_bytes == 0 && delegated_nodes > 0)
+            {
+                std::cerr << "Warning: --prefetch_depth has nothing to prefetch: the model runs in "
+                          << delegated_nodes << " delegated partitions, which read packed weight copies."
+                          << std::endl;
+            }
+        }
+    }
+
+    // 7-1b. Optional memory-pressure controller. Its monitor thread picks a
+    // stage; the stages are applied here, between tokens.
+    std::unique_ptr<MemoryPressureController> memory_pressure;
+    const int pressure_kv_size = decode_runner->input_tensor("kv_cache_k_0")->dims->data[1];
+    int pressure_position = 0;
+    int pressure_stop_position = std::numeric_limits<int>::max();
+    // Signature whose arena survives kDropIdleArenas; the prefill arena is
+    // idle once decoding starts, and so is all of `interpreter` when a
+    // separate decode interpreter exists.
+    std::string pressure_keep_signature = decode_interpreter ? "" : "decode";
+    bool pressure_drop_arenas = true;
+    MemoryPressureController::StageAction apply_pressure_stage = [&](PressureStage stage, bool entering)
+    {
+        switch (stage)
+        {
+        case PressureStage::kShrinkCaches:
+            if (entering)
+            {
+                size_t released = ReleaseKVCacheTail(kv_cache, pressure_position, pressure_kv_size);
+                std::cerr << "[MEMORY] Released " << released / (1024.0 * 1024.0)
+                          << " MiB of KV cache past position " << pressure_position << std::endl;
+            }
+            break;
+        case PressureStage::kDropIdleArenas:
+            if (entering && pressure_drop_arenas)
+            {
+                int released = ReleaseIdleArenas(interpreter.get(), pressure_keep_signature);
+                std::cerr << "[MEMORY] Released the arenas of " << released << " idle signatures" << std::endl;
+            }
+            break;
+        case PressureStage::kLowerPrefetch:
+            for (const auto &prefetcher : prefetchers)
+            {
+                prefetcher->set_depth(entering ? 0 : absl::GetFlag(FLAGS_prefetch_depth));
+            }
+            break;
+        case PressureStage::kCapContext:
+            pressure_stop_position = entering
+                                         ? pressure_position + absl::GetFlag(FLAGS_memory_pressure_token_cap)
+                                         : std::numeric_limits<int>::max();
+            break;
+        default:
+            break;
+        }
+    };
+    if (absl::GetFlag(FLAGS_memory_pressure))
+    {
+        MemoryPressureOptions pressure_options;
+        pressure_options.first_stage_ratio = absl::GetFlag(FLAGS_memory_pressure_ratio);
+        memory_pressure = std::make_unique<MemoryPressureController>(pressure_options);
+        if (memory_pressure->Start())
+        {
+            std::cout << "[MEMORY] Watching " << memory_pressure->description() << "\n";
+        }
+        else
+        {
+            std::cerr << "Warning: --memory_pressure found no cgroup memory limit or PSI trigger; disabled."
+                      << std::endl;
+            memory_pressure.reset();
+        }
+    }
+    // Applies pending stages at `position`; false once the context cap is hit.
+    auto poll_memory_pressure = [&](int position)
+    {
+        if (!memory_pressure)
+        {
+            return true;
+        }
+        pressure_position = position;
+        memory_pressure->Poll(apply_pressure_stage);
+        if (position < pressure_stop_position)
+        {
+            return true;
+        }
+        std::cerr << "\nWarning: generation stopped at position " << position
+                  << ", the context is capped under memory pressure." << std::endl;
+        return false;
+    };
+
+    DecodingMetrics decoding_metrics;
+    std::vector<RUsageRecord> rusageRecords;
+
+    // Reports and files written once generation is done, on every exit path
+    auto finish_run = [&]()
+    {
+        ReportOpProfile(interpreter.get(), op_profiler.get());
+        if (setup_graph)
+        {
+            setup_graph->PrintOccupancy(std::cout);
+            if (decode_invoke_ms > 0.0)
+            {
+                std::cout << "[PIPELINE] Decode: " << decode_invoke_ms << " ms in Invoke(), " << decode_gap_ms
+                          << " ms between invokes ("
+                          << 100.0 * decode_gap_ms / (decode_invoke_ms + decode_gap_ms)
+                          << "% serial host time)\n";
+            }
+        }
+        if (!prefetchers.empty())
+        {
+            interpreter->SetProfiler(nullptr);
+            if (decode_interpreter)
+            {
+                decode_interpreter->SetProfiler(nullptr);
+            }
+            uint64_t advised_bytes = 0, advise_calls = 0;
+            for (const auto &prefetcher : prefetchers)
+            {
+                advised_bytes += prefetcher->advised_bytes();
+                advise_calls += prefetcher->advise_calls();
+            }
+            std::cout << "[INFO] Prefetched " << advised_bytes / (1024.0 * 1024.0) << " MiB of weights in "
+                      << advise_calls << " madvise calls\n";
+        }
+        if (memory_pressure)
+        {
+            memory_pressure->Stop();
+            memory_pressure->PrintSummary(std::cout);
+        }
+        WriteTrace(trace_writer.get());
+        if (!absl::GetFlag(FLAGS_results_json).empty())
+        {
+            const std::string path = absl::GetFlag(FLAGS_results_json);
+            ResultsWriter results(path, CollectRunEnvironment());
+            JsonWriter *json = results.json();
+            json->Key("run");
+            json->BeginObject();
+            json->Field("model", absl::GetFlag(FLAGS_tflite_model));
+            json->Field("num_threads", absl::GetFlag(FLAGS_num_threads));
+            json->Field("prefill_threads", built_threads);
+            json->Field("decode_threads", decode_threads);
+            json->Field("prompt_tokens", static_cast<int64_t>(prompt_tokens.size()));
+            json->Field("peak_bandwidth_gbps", metrics.peak_bandwidth());
+            json->Key("flags");
+            WriteFlagsJson(json);
+            json->EndObject();
+            json->Key("phases");
+            metrics.WriteJson(json);
+            json->Key("decoding");
+            decoding_metrics.WriteJson(json);
+            json->Key("decode_steps");
+            WriteRUsageRecordsJson(rusageRecords, json);
+            if (results.Close())
+            {
+                std::cout << "[INFO] Wrote run results to " << path << "\n";
+            }
+            else
+            {
+                std::cerr << "Warning: failed to write " << path << std::endl;
+            }
+        }
+        if (memory_sampler)
+        {
+            memory_sampler->Stop();
+            std::string path = absl::GetFlag(FLAGS_memory_samples_out);
+            if (memory_sampler->WriteCsv(path))
+            {
+                std::cout << "[INFO] Wrote " << memory_sampler->samples().size()
+                          << " memory samples to " << path << "\n";
+            }
+            else
+            {
+                std::cerr << "Warning: failed to write memory samples to " << path << std::endl;
+            }
+        }
+    };
+
+    // 7-2. Execution plan dump mode: structured replacement for the text logs
+    if (!absl::GetFlag(FLAGS_dump_execution_plan).empty())
+    {
+        ExecutionPlan plan = CaptureExecutionPlan(interpreter.get());
+        const std::string prefix = absl::GetFlag(FLAGS_dump_execution_plan);
+        const int decode_subgraph = interpreter->GetSubgraphIndexFromSignature("decode");
+        bool ok = WriteExecutionPlanJson(plan, decode_subgraph, prefix + ".json");
+        ok = WriteExecutionPlanBinary(plan, prefix + ".bin") && ok;
+        if (!ok)
+        {
+            std::cerr << "Warning: failed to write execution plan to " << prefix << ".{json,bin}" << std::endl;
+        }
+        else
+        {
+            size_t num_nodes = 0;
+            for (const auto &subgraph : plan.subgraphs)
+            {
+                num_nodes += subgraph.nodes.size();
+            }
+            std::cout << "[INFO] Wrote execution plan of " << plan.subgraphs.size() << " subgraphs ("
+                      << num_nodes << " nodes) to " << prefix << ".{json,bin}\n";
+        }
+        finish_run();
+        return ok ? 0 : 1;
+    }
+
+    // 7-2a. Serving a request file replaces the single-prompt flow
+    if (!absl::GetFlag(FLAGS_serve_requests_file).empty())
+    {
+        if (op_profiler)
+        {
+            op_profiler->SetPhase("serving");
+        }
+        mark_memory_phase(memory_phase_decode);
+        // Serving prefills and decodes on `interpreter` throughout
+        pressure_keep_signature = "decode";
+        int status = RunServing(interpreter.get(), sp_processor.get(), start_token, stop_token_id,
+                                memory_pressure.get(), apply_pressure_stage);
+        metrics.PrintStats();
+        finish_run();
+        return status;
+    }
+
+    // 7-3. Batched generation of a prompt file replaces the single-prompt flow
+    if (!absl::GetFlag(FLAGS_batch_prompts_file).empty())
+    {
+        if (op_profiler)
+        {
+            op_profiler->SetPhase("batched");
+        }
+        mark_memory_phase(memory_phase_decode);
+        int status = RunBatchedGeneration(interpreter.get(), sp_processor.get(), kv_cache,
+                                          start_token, stop_token_id);
+        metrics.PrintStats();
+        finish_run();
+        return status;
+    }
     
     // 8. Access Tensors
     TfLiteTensor *prefill_input = prefill_runner->input_tensor("tokens");
@@ -1617,6 +3697,7 @@ int main(int argc, char *argv[])
     int kv_cache_max_size = kv_cache_k_0->dims->data[1];
     
     // 9. Prefill Stage
+    mark_memory_phase(memory_phase_prefill);
     {
         ScopeTimer timer("Prefill Stage");
         getrusage(RUSAGE_SELF, &usage_start);
@@ -1636,22 +3717,174 @@ int main(int argc, char *argv[])
 
         
         // Execute the prefill runner
-        MINIMAL_CHECK(prefill_runner->Invoke() == kTfLiteOk);
+        {
+            ScopedTraceSpan span("Prefill_Invoke", "prefill");
+            auto prefill_start = std::chrono::high_resolution_clock::now();
+            MINIMAL_CHECK(prefill_runner->Invoke() == kTfLiteOk);
+            decoding_metrics.RecordPrefill(
+                max_seq_size, std::chrono::duration<double, std::milli>(
+                                  std::chrono::high_resolution_clock::now() - prefill_start)
+                                  .count());
+        }
         stats = perf_monitor.end_phase("Prefill");
         getrusage(RUSAGE_SELF, &usage_end);
+        if (prefill_seq_size > 1)
+        {
+            decoding_metrics.RecordPrefillEnergy(stats.energy, prefill_seq_size - 1);
+        }
     }
     PrintRUsage(usage_start, usage_end, "Prefill Stage");
     metrics.RecordStats("Prefill", stats);
 
+    // 9-0. Beam search / n-best sampling replaces the single-path decode
+    if (absl::GetFlag(FLAGS_beam_width) > 0)
+    {
+        if (op_profiler)
+        {
+            op_profiler->SetPhase("beam");
+        }
+        mark_memory_phase(memory_phase_decode);
+        int prefill_seq_size = std::min<int>(prompt_tokens.size(), max_seq_size);
+        int max_new_tokens = kv_cache_max_size - prefill_seq_size;
+        if (absl::GetFlag(FLAGS_max_decode_steps) != -1)
+        {
+            max_new_tokens = std::min(max_new_tokens, absl::GetFlag(FLAGS_max_decode_steps));
+        }
+        int status = RunBeamSearch(interpreter.get(), sp_processor.get(), decode_runner, kv_cache,
+                                   prompt_tokens[prefill_seq_size - 1], prefill_seq_size - 1,
+                                   max_new_tokens, stop_token_id);
+        metrics.PrintStats();
+        finish_run();
+        return status;
+    }
+
+    // 9-1. Optionally prepare a draft source for speculative decoding
+    std::unique_ptr<tflite::FlatBufferModel> draft_model;
+    std::unique_ptr<tflite::Interpreter> draft_interpreter;
+    std::map<std::string, std::vector<float, AlignedAllocator<float>>> draft_kv_cache;
+    std::unique_ptr<DraftProposer> draft_proposer;
+    std::unique_ptr<SpeculativeDecoder> speculative_decoder;
+    if (!absl::GetFlag(FLAGS_draft_model).empty() || absl::GetFlag(FLAGS_prompt_lookup))
+    {
+        ScopeTimer timer("Speculative Decoding Preparation");
+        getrusage(RUSAGE_SELF, &usage_start);
+        perf_monitor.start_phase("Prepare_Draft");
+
+        int num_draft_tokens = absl::GetFlag(FLAGS_num_draft_tokens);
+        MINIMAL_CHECK(num_draft_tokens > 0);
+        tflite::SignatureRunner *verify_runner =
+            GetVerifyRunner(interpreter.get(), num_draft_tokens + 1, kv_cache);
+        if (verify_runner == nullptr)
+        {
+            std::cerr << "Warning: model has no multi-token signature with a logits output. "
+                      << "Speculative decoding disabled." << std::endl;
+        }
+        else if (absl::GetFlag(FLAGS_draft_model).empty())
+        {
+            // Self-speculation: drafts come from earlier spans of the sequence
+            draft_proposer = std::make_unique<PromptLookupProposer>(
+                absl::GetFlag(FLAGS_prompt_lookup_min_ngram),
+                absl::GetFlag(FLAGS_prompt_lookup_max_ngram));
+        }
+        else
+        {
+            if (absl::GetFlag(FLAGS_prompt_lookup))
+            {
+                std::cerr << "Warning: --prompt_lookup ignored because --draft_model is set." << std::endl;
+            }
+            draft_model = LoadModel(absl::GetFlag(FLAGS_draft_model));
+            draft_interpreter = BuildInterpreter(draft_model.get(), absl::GetFlag(FLAGS_num_threads),
+                                                 absl::GetFlag(FLAGS_draft_weight_cache_path));
+            draft_kv_cache = BuildKVCache(draft_interpreter.get());
+            MINIMAL_CHECK(!draft_kv_cache.empty());
+
+            int prefill_seq_size = std::min<int>(prompt_tokens.size(), max_seq_size);
+            tflite::SignatureRunner *draft_prefill_runner = GetPrefillRunner(
+                draft_interpreter.get(), prefill_seq_size - 1, draft_kv_cache, nullptr);
+            tflite::SignatureRunner *draft_decode_runner =
+                GetDecodeRunner(draft_interpreter.get(), draft_kv_cache, nullptr);
+            // Draft and target must share a vocabulary for proposals to be meaningful
+            MINIMAL_CHECK(Sampler::VocabSize(draft_decode_runner->output_tensor("logits")) ==
+                          Sampler::VocabSize(decode_runner->output_tensor("logits")));
+
+            // Prefill the draft with the same prompt prefix as the target
+            TfLiteTensor *draft_prefill_input = draft_prefill_runner->input_tensor("tokens");
+            TfLiteTensor *draft_prefill_input_pos = draft_prefill_runner->input_tensor("input_pos");
+            std::memset(draft_prefill_input->data.i32, 0, draft_prefill_input->bytes);
+            std::memset(draft_prefill_input_pos->data.i32, 0, draft_prefill_input_pos->bytes);
+            for (int i = 0; i < prefill_seq_size - 1; ++i)
+            {
+                draft_prefill_input->data.i32[i] = prompt_tokens[i];
+                draft_prefill_input_pos->data.i32[i] = i;
+            }
+            MINIMAL_CHECK(draft_prefill_runner->Invoke() == kTfLiteOk);
+
+            // The draft guesses greedily: its most likely token is the one the
+            // target is most likely to sample as well.
+            int draft_kv_cache_max_size =
+                draft_decode_runner->input_tensor("kv_cache_k_0")->dims->data[1];
+            draft_proposer = std::make_unique<DraftModelProposer>(
+                draft_decode_runner,
+                std::vector<int>(prompt_tokens.begin(), prompt_tokens.begin() + prefill_seq_size - 1),
+                draft_kv_cache_max_size,
+                [](const float *logits, int vocab_size)
+                { return Sampler::GreedySampler(logits, vocab_size); });
+        }
+
+        if (draft_proposer)
+        {
+            speculative_decoder = std::make_unique<SpeculativeDecoder>(
+                decode_runner, verify_runner, draft_proposer.get(),
+                [](const float *logits, int vocab_size)
+                { return Sampler::TemperatureTopKTopPSampler(logits, vocab_size, 0.9f, 85, 0.9f); },
+                num_draft_tokens, kv_cache_max_size);
+            // Verify runs a prefill-shaped signature every round
+            pressure_drop_arenas = false;
+            std::cout << "[INFO] Speculative decoding enabled: " << num_draft_tokens
+                      << " draft tokens, verify width " << speculative_decoder->verify_width() << "\n";
+        }
+
+        stats = perf_monitor.end_phase("Prepare_Draft");
+        getrusage(RUSAGE_SELF, &usage_end);
+        PrintRUsage(usage_start, usage_end, "Speculative Decoding Preparation");
+        metrics.RecordStats("Prepare_Draft", stats);
+    }
+
     // 10. Decoding Stage with separate metrics for inference and sampling
     std::cout << "\nPrompt:\n"
               << prompt << "\n\nOutput Text:\n";
 
+    if (op_profiler)
+    {
+        op_profiler->SetPhase("decode");
+    }
+    mark_memory_phase(memory_phase_decode, 0);
+
+    // Per-step stall attribution, opened after the delegate threads exist
+    std::unique_ptr<StallAccounting> stall_accounting;
+    if (absl::GetFlag(FLAGS_stall_accounting) || !absl::GetFlag(FLAGS_stall_csv).empty())
+    {
+        stall_accounting = std::make_unique<StallAccounting>();
+    }
+    auto end_stall_step = [&]()
+    {
+        if (!stall_accounting)
+        {
+            return;
+        }
+        stall_accounting->End();
+        if (trace_writer && !stall_accounting->steps().empty())
+        {
+            const StallDelta &stall = stall_accounting->steps().back().delta;
+            trace_writer->AddCounter("Stall_ms", {{"memory", std::max(0.0, stall.memory_some_ms)},
+                                                  {"io", stall.io_wait_ms()},
+                                                  {"run_delay", std::max(0.0, stall.run_delay_ms)}});
+        }
+    };
+
     // Metrics object
-    DecodingMetrics decoding_metrics;
+    perf_monitor.start_phase("Decode");
     decoding_metrics.StartDecoding();
-    std::vector<PerfStats> decode_stats_vec;
-    std::vector<RUsageRecord> rusageRecords;
     struct RUsageRecord decode_record;
     //rusage decode_start, decode_end;
     {
@@ -1669,68 +3902,365 @@ int main(int argc, char *argv[])
         int next_token = prompt_tokens[prefill_seq_size - 1];
         int next_position = prefill_seq_size - 1;
 
-        // Decoding loop
-        for (int i = 0; i < decode_steps; ++i)
+        // Output pipeline: by default only a queue push stays on the decode
+        // path; detokenization and the terminal write happen on the streamer
+        // thread.
+        std::unique_ptr<TokenStreamer> token_streamer;
+        if (absl::GetFlag(FLAGS_async_detokenize))
         {
-            // Start time for this token
-            auto token_start = std::chrono::high_resolution_clock::now();
-            getrusage(RUSAGE_SELF, &decode_record.start);
-            perf_monitor.start_phase("Decode_Token_" + std::to_string(i));
-
-            // -----------------------
-            // 1) Model Inference
-            // -----------------------
-            auto inference_start = std::chrono::high_resolution_clock::now();
-
-            decode_input->data.i32[0] = next_token;
-            decode_input_pos->data.i32[0] = next_position;
-            MINIMAL_CHECK(decode_runner->Invoke() == kTfLiteOk);
-
-            auto inference_end = std::chrono::high_resolution_clock::now();
-            double inference_time_ms =
-                std::chrono::duration<double, std::milli>(inference_end - inference_start).count();
-
-            // -----------------------
-            // 2) Token Sampling
-            // -----------------------
-            auto sampling_start = std::chrono::high_resolution_clock::now();
-            next_token = Sampler::TemperatureTopKTopPSampler(
-                decode_runner->output_tensor("logits"), 0.9f, 85, 0.9f);
-            auto sampling_end = std::chrono::high_resolution_clock::now();
-            double sampling_time_ms =
-                std::chrono::duration<double, std::milli>(sampling_end - sampling_start).count();
+            ScopedThreadAffinity auxiliary(placement.auxiliary_cpus);
+            token_streamer = std::make_unique<TokenStreamer>(sp_processor.get(), &std::cout);
+        }
+        // Latency mode covers the main thread and the interpreter workers. With
+        // A/B blocks it is switched at block boundaries so both settings see
+        // the same stretch of the generation.
+        std::vector<pid_t> inference_tids = {static_cast<pid_t>(syscall(SYS_gettid))};
+        {
+            std::vector<pid_t> live_tids = ListThreadIds();
+            for (pid_t tid : interpreter_worker_tids)
+            {
+                if (std::binary_search(live_tids.begin(), live_tids.end(), tid))
+                {
+                    inference_tids.push_back(tid);
+                }
+            }
+        }
+        std::unique_ptr<LatencyGuard> latency_guard;
+        const int latency_ab_block = absl::GetFlag(FLAGS_latency_ab_block);
+        if (latency_mode)
+        {
+            latency_guard = std::make_unique<LatencyGuard>(latency_options);
+            latency_guard->SetThreads(inference_tids);
+            latency_guard->SetCpus(placement.compute_cpus.empty() ? GetThreadAffinity(0) : placement.compute_cpus);
+        }
+        bool latency_block = false;
+        auto update_latency_mode = [&](int step)
+        {
+            if (!latency_guard)
+            {
+                return;
+            }
+            const bool want = latency_ab_block <= 0 || (step / latency_ab_block) % 2 == 1;
+            if (step > 0 && want == latency_block)
+            {
+                return;
+            }
+            latency_block = want;
+            if (want)
+            {
+                latency_guard->Engage();
+            }
+            else
+            {
+                latency_guard->Release();
+            }
+            if (latency_ab_block > 0)
+            {
+                decoding_metrics.SetSegment(want ? "latency mode" : "default");
+            }
+        };
 
-            next_position++;
+        // Thermal governor over the same threads; the XNNPACK pool is sized
+        // when the delegate is built, so it steps frequency, cluster and pace
+        // instead of the thread count
+        std::unique_ptr<ThermalGovernor> thermal_governor;
+        if (absl::GetFlag(FLAGS_thermal_target_c) > 0)
+        {
+            ThermalOptions thermal_options;
+            thermal_options.sysfs_root = absl::GetFlag(FLAGS_sysfs_root);
+            thermal_options.target_celsius = absl::GetFlag(FLAGS_thermal_target_c);
+            thermal_options.zones = absl::GetFlag(FLAGS_thermal_zones);
+            thermal_governor = std::make_unique<ThermalGovernor>(thermal_options);
+            const std::vector<int> compute_cpus =
+                placement.compute_cpus.empty() ? GetThreadAffinity(0) : placement.compute_cpus;
+            // Migration only helps onto a slower cluster; on a homogeneous CPU
+            // efficiency_cpus() is every CPU and would undo --numa_policy=bind
+            const std::vector<int> migration_cpus =
+                cpu_topology.heterogeneous() ? cpu_topology.efficiency_cpus() : std::vector<int>{};
+            if (thermal_governor->Start(compute_cpus, migration_cpus))
+            {
+                thermal_governor->SetThreads(inference_tids);
+                std::cout << "[THERMAL] Holding " << thermal_options.target_celsius << " C with "
+                          << thermal_governor->description() << "\n";
+            }
+            else
+            {
+                std::cerr << "Warning: --thermal_target_c found no readable thermal zone under "
+                          << thermal_options.sysfs_root << "; disabled." << std::endl;
+                thermal_governor.reset();
+            }
+        }
+        auto govern_thermal = [&](int step)
+        {
+            if (!thermal_governor)
+            {
+                return;
+            }
+            if (const ThermalGovernor::Decision *decision = thermal_governor->Step(step))
+            {
+                decoding_metrics.RecordThermal(*decision);
+            }
+        };
 
-            // Check stop token
-            if (next_token == stop_token_id)
+        // Per-step energy, charged to the decode thread count and the
+        // compute CPUs' frequency at the end of the step
+        std::unique_ptr<CpuFreqReader> decode_freq;
+        EnergyMeter::Snapshot step_energy_start, step_energy_end;
+        if (energy_meter)
+        {
+            decode_freq = std::make_unique<CpuFreqReader>(
+                placement.compute_cpus.empty() ? GetThreadAffinity(0) : placement.compute_cpus,
+                absl::GetFlag(FLAGS_sysfs_root) + "/devices/system/cpu");
+        }
+        auto begin_step_energy = [&]()
+        {
+            if (energy_meter)
             {
-                break;
+                energy_meter->Read(&step_energy_start);
+            }
+        };
+        auto end_step_energy = [&](int num_tokens)
+        {
+            if (!energy_meter)
+            {
+                return;
             }
+            energy_meter->Read(&step_energy_end);
+            std::string config = std::to_string(decode_threads) + " threads";
+            const int64_t khz = decode_freq->AverageKhz();
+            if (khz > 0)
+            {
+                // Rounded so that governor jitter does not split configurations
+                config += " @ " + std::to_string((khz + 50000) / 100000 * 100) + " MHz";
+            }
+            decoding_metrics.RecordEnergy(config, energy_meter->Diff(step_energy_start, step_energy_end),
+                                          num_tokens);
+        };
 
-            // Decode the single token to text
-            std::vector<int> single_token_vec = {next_token};
+        auto emit_token = [&](int token)
+        {
+            if (token_streamer)
+            {
+                token_streamer->Push(token);
+                return;
+            }
+            ScopedTraceSpan span("Detokenize", "output");
+            std::vector<int> single_token_vec = {token};
             std::string single_decoded_text;
             MINIMAL_CHECK(sp_processor->Decode(single_token_vec, &single_decoded_text).ok());
             std::cout << single_decoded_text << std::flush;
+        };
+
+        if (speculative_decoder)
+        {
+            // Speculative loop: each round commits one or more tokens
+            std::vector<int> context(prompt_tokens.begin(), prompt_tokens.begin() + prefill_seq_size);
+            int generated = 0;
+            bool stopped = false;
+            for (int round = 0; !stopped && generated < decode_steps; ++round)
+            {
+                if (!poll_memory_pressure(next_position))
+                {
+                    break;
+                }
+                update_latency_mode(round);
+                // Pacing sleeps and sysfs reads stay out of the step time
+                govern_thermal(round);
+                // Snapshotted outside the timed step: the reads walk /proc/self/task
+                if (stall_accounting)
+                {
+                    stall_accounting->Begin(round);
+                }
+                begin_step_energy();
+                auto token_start = std::chrono::high_resolution_clock::now();
+                getrusage(RUSAGE_SELF, &decode_record.start);
+                instrumentation.Begin(decode_round_phase, round);
+                if (memory_sampler)
+                {
+                    memory_sampler->SetToken(generated);
+                }
+
+                SpeculativeStep step =
+                    speculative_decoder->Step(context, next_position, decode_steps - generated);
+
+                int committed = 0;
+                for (int token : step.tokens)
+                {
+                    next_position++;
+                    generated++;
+                    if (token == stop_token_id)
+                    {
+                        stopped = true;
+                        break;
+                    }
+                    context.push_back(token);
+                    ++committed;
+                    emit_token(token);
+                }
 
-            // End perf recording
-            PerfStats token_stats = perf_monitor.end_phase("Decode_Token_" + std::to_string(i));
-            decode_stats_vec.push_back(token_stats);
-            metrics.RecordStats("Decode_Token", token_stats);
-            // Record metrics for this token
-            decoding_metrics.RecordTimes(token_start, inference_time_ms, sampling_time_ms);
-            getrusage(RUSAGE_SELF, &decode_record.end);
-            rusageRecords.push_back(decode_record);
+                instrumentation.End();
+                decoding_metrics.RecordSpeculation(step.num_proposed, step.num_accepted, step.draft_time_ms);
+                if (committed > 0)
+                {
+                    decoding_metrics.RecordTimes(token_start, step.verify_time_ms,
+                                                 step.sampling_time_ms, committed);
+                    end_step_energy(committed);
+                }
+                end_stall_step();
+                // Sampled outside the timed step
+                if (trace_writer)
+                {
+                    trace_writer->SampleMemoryCounters();
+                }
+                getrusage(RUSAGE_SELF, &decode_record.end);
+                rusageRecords.push_back(decode_record);
+            }
+        }
+        else
+        {
+            // Decoding loop
+            std::chrono::high_resolution_clock::time_point last_inference_end;
+            for (int i = 0; i < decode_steps; ++i)
+            {
+                if (!poll_memory_pressure(next_position))
+                {
+                    break;
+                }
+                // Start time for this token
+                update_latency_mode(i);
+                // Pacing sleeps and sysfs reads stay out of the step time
+                govern_thermal(i);
+                // Snapshotted outside the timed step: the reads walk /proc/self/task
+                if (stall_accounting)
+                {
+                    stall_accounting->Begin(i);
+                }
+                begin_step_energy();
+                auto token_start = std::chrono::high_resolution_clock::now();
+                getrusage(RUSAGE_SELF, &decode_record.start);
+                instrumentation.Begin(decode_token_phase, i);
+                if (memory_sampler)
+                {
+                    memory_sampler->SetToken(i);
+                }
+
+                // -----------------------
+                // 1) Model Inference
+                // -----------------------
+                auto inference_start = std::chrono::high_resolution_clock::now();
+
+                {
+                    ScopedTraceSpan span("Decode_Invoke", "decode");
+                    decode_input->data.i32[0] = next_token;
+                    decode_input_pos->data.i32[0] = next_position;
+                    MINIMAL_CHECK(decode_runner->Invoke() == kTfLiteOk);
+                }
+
+                auto inference_end = std::chrono::high_resolution_clock::now();
+                double inference_time_ms =
+                    std::chrono::duration<double, std::milli>(inference_end - inference_start).count();
+                decode_invoke_ms += inference_time_ms;
+                if (i > 0)
+                {
+                    decode_gap_ms +=
+                        std::chrono::duration<double, std::milli>(inference_start - last_inference_end).count();
+                }
+                last_inference_end = inference_end;
+
+                // -----------------------
+                // 2) Token Sampling
+                // -----------------------
+                auto sampling_start = std::chrono::high_resolution_clock::now();
+                {
+                    ScopedTraceSpan span("Sample", "decode");
+                    next_token = Sampler::TemperatureTopKTopPSampler(
+                        decode_runner->output_tensor("logits"), 0.9f, 85, 0.9f);
+                }
+                auto sampling_end = std::chrono::high_resolution_clock::now();
+                double sampling_time_ms =
+                    std::chrono::duration<double, std::milli>(sampling_end - sampling_start).count();
+
+                next_position++;
+
+                // Check stop token
+                if (next_token == stop_token_id)
+                {
+                    break;
+                }
+
+                // Hand the token to the output pipeline
+                emit_token(next_token);
+
+                // End perf recording
+                instrumentation.End();
+                // Record metrics for this token
+                decoding_metrics.RecordTimes(token_start, inference_time_ms, sampling_time_ms);
+                end_step_energy(1);
+                end_stall_step();
+                // Sampled outside the timed step
+                if (trace_writer)
+                {
+                    trace_writer->SampleMemoryCounters();
+                }
+                getrusage(RUSAGE_SELF, &decode_record.end);
+                rusageRecords.push_back(decode_record);
+            }
+        }
+
+        // Let the writer catch up so the metrics print after the output text
+        if (token_streamer)
+        {
+            token_streamer->Finish();
+        }
+        if (latency_guard)
+        {
+            latency_guard->Release();
+            latency_guard->PrintSummary(std::cout);
+        }
+        if (thermal_governor)
+        {
+            thermal_governor->Release();
+            thermal_governor->PrintSummary(std::cout);
         }
     }
+    stats = perf_monitor.end_phase("Decode");
+    metrics.RecordStats("Decode", stats);
 
     // 11. Print decoding metrics (inference vs. sampling)
     decoding_metrics.PrintMetrics();
+    if (!absl::GetFlag(FLAGS_metrics_json).empty())
+    {
+        if (decoding_metrics.WriteJson(absl::GetFlag(FLAGS_metrics_json)))
+        {
+            std::cout << "[INFO] Wrote decoding metrics to " << absl::GetFlag(FLAGS_metrics_json) << "\n";
+        }
+        else
+        {
+            std::cerr << "Warning: failed to write " << absl::GetFlag(FLAGS_metrics_json) << std::endl;
+        }
+    }
     // 12. Print Perf results
     metrics.PrintStats();
+    instrumentation.PrintSummary(std::cout);
+    if (stall_accounting)
+    {
+        stall_accounting->PrintSummary(std::cout);
+        std::string stall_csv = absl::GetFlag(FLAGS_stall_csv);
+        if (!stall_csv.empty())
+        {
+            if (stall_accounting->WriteCsv(stall_csv))
+            {
+                std::cout << "[INFO] Wrote per-step stall accounting to " << stall_csv << "\n";
+            }
+            else
+            {
+                std::cerr << "Warning: failed to write " << stall_csv << std::endl;
+            }
+        }
+    }
     // 13. Print RUsage results
     PrintRUsageRecords(rusageRecords);
+    finish_run();
 
     return 0;
 }
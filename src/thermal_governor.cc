@@ -0,0 +1,350 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/thermal_governor.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// Frequency caps between the maximum and half of it.
+constexpr int kNumCaps = 5;
+// Each pacing level stretches the step interval by this fraction.
+constexpr double kPaceStep = 0.15;
+constexpr int kNumPaceLevels = 6;
+// A frequency this far below the cap means the hardware is throttling.
+constexpr double kThrottledFraction = 0.85;
+// Shortest interval the temperature slope is measured over.
+constexpr double kMinSlopeInterval_s = 0.1;
+
+double Ms(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+std::string FormatMhz(int64_t khz) {
+  return std::to_string((khz + 500) / 1000) + " MHz";
+}
+
+bool MatchesZone(const std::string& type, const std::string& filter) {
+  std::string_view rest = filter;
+  while (!rest.empty()) {
+    const size_t comma = rest.find(',');
+    const std::string_view item = rest.substr(0, comma);
+    if (!item.empty() && type.find(item) != std::string::npos) {
+      return true;
+    }
+    rest = comma == std::string_view::npos ? "" : rest.substr(comma + 1);
+  }
+  return false;
+}
+
+}  // namespace
+
+ThermalGovernor::ThermalGovernor(ThermalOptions options)
+    : options_(std::move(options)) {}
+
+ThermalGovernor::~ThermalGovernor() { Release(); }
+
+bool ThermalGovernor::Start(const std::vector<int>& compute_cpus,
+                            const std::vector<int>& efficiency_cpus) {
+  // Thermal zones, CPU-like ones unless a filter is given.
+  const std::string thermal = options_.sysfs_root + "/class/thermal";
+  std::vector<std::pair<std::string, std::string>> all_zones;
+  if (DIR* dir = opendir(thermal.c_str())) {
+    while (struct dirent* entry = readdir(dir)) {
+      const std::string name = entry->d_name;
+      if (name.rfind("thermal_zone", 0) == 0 &&
+          ReadSysfsInt(thermal + "/" + name + "/temp") != -1) {
+        all_zones.emplace_back(thermal + "/" + name + "/temp",
+                               ReadSysfsValue(thermal + "/" + name + "/type"));
+      }
+    }
+    closedir(dir);
+  }
+  std::sort(all_zones.begin(), all_zones.end());
+  const std::string filter = options_.zones.empty()
+                                 ? "cpu,soc,pkg,cluster,big,little"
+                                 : options_.zones;
+  std::string zone_names;
+  for (int pass = 0; pass < 2 && zones_.empty(); ++pass) {
+    for (const auto& [path, type] : all_zones) {
+      // Without an explicit filter, fall back to every zone.
+      if (pass == 0 ? MatchesZone(type, filter) : options_.zones.empty()) {
+        zones_.emplace_back(path);
+        zone_names += (zone_names.empty() ? "" : ", ") + type;
+      }
+    }
+  }
+  if (zones_.empty()) {
+    return false;
+  }
+  description_ = "zones " + zone_names;
+
+  // Writable scaling_max_freq of every cpufreq policy of the compute CPUs.
+  // The saved values are also restored from the exit and signal paths while
+  // a cap is written.
+  const std::string cpu_root = options_.sysfs_root + "/devices/system/cpu";
+  int64_t max_khz = -1, min_khz = -1;
+  for (const std::string& dir : CpuFreqPolicyDirs(compute_cpus, cpu_root)) {
+    const int64_t policy_max = ReadSysfsInt(dir + "/cpuinfo_max_freq");
+    const int64_t policy_min = ReadSysfsInt(dir + "/cpuinfo_min_freq");
+    SysfsOverride limit;
+    if (policy_max <= 0 || !limit.Open(dir + "/scaling_max_freq") ||
+        access(limit.path().c_str(), W_OK) != 0) {
+      continue;
+    }
+    caps_.push_back({std::move(limit), std::max<int64_t>(0, policy_min),
+                     policy_max});
+    max_khz = std::max(max_khz, policy_max);
+    min_khz = std::max(min_khz, policy_min);
+  }
+  if (!caps_.empty()) {
+    const int64_t floor_khz = std::max(min_khz, max_khz / 2);
+    cap_khz_.push_back(max_khz);
+    for (int i = 1; i <= kNumCaps; ++i) {
+      cap_khz_.push_back(max_khz - (max_khz - floor_khz) * i / kNumCaps);
+    }
+    description_ += ", " + std::to_string(kNumCaps) + " frequency caps down to " +
+                    FormatMhz(floor_khz);
+  }
+  freq_ = std::make_unique<CpuFreqReader>(compute_cpus, cpu_root);
+
+  // Ladder: frequency caps, then migration, then pacing.
+  int next_level = cap_khz_.empty() ? 1 : kNumCaps + 1;
+  std::vector<int> sorted_compute = compute_cpus;
+  std::sort(sorted_compute.begin(), sorted_compute.end());
+  if (!efficiency_cpus.empty() && efficiency_cpus != sorted_compute) {
+    efficiency_cpus_ = efficiency_cpus;
+    migrate_level_ = next_level++;
+    description_ += ", migration to " + FormatCpuList(efficiency_cpus_);
+  }
+  pace_level_ = next_level;
+  max_level_ = pace_level_ + kNumPaceLevels - 1;
+  description_ += ", pacing";
+  level_ms_.assign(max_level_ + 1, 0.0);
+  start_ = last_change_ = Clock::now();
+  return true;
+}
+
+double ThermalGovernor::ReadCelsius() {
+  int64_t hottest = INT64_MIN;
+  for (ProcFile& zone : zones_) {
+    hottest = std::max(hottest, ParseInt(zone.Read(), INT64_MIN));
+  }
+  // Zones report millidegrees.
+  return hottest == INT64_MIN ? celsius_ : hottest / 1000.0;
+}
+
+void ThermalGovernor::WriteCaps(int64_t khz) {
+  for (FrequencyCap& cap : caps_) {
+    const int64_t value = std::clamp(khz, cap.min_khz, cap.max_khz);
+    if (!cap.limit.Write(std::to_string(value)) && !cap_warned_) {
+      cap_warned_ = true;
+      std::cerr << "Warning: thermal governor cannot write " << cap.limit.path()
+                << ": "
+                << std::strerror(errno) << std::endl;
+    }
+  }
+}
+
+std::string ThermalGovernor::ApplyLevel(int level) {
+  std::string action;
+  auto add = [&](const std::string& what) {
+    action += (action.empty() ? "" : ", ") + what;
+  };
+  if (!cap_khz_.empty()) {
+    const int from = std::min(level_, kNumCaps);
+    const int to = std::min(level, kNumCaps);
+    if (from != to) {
+      WriteCaps(cap_khz_[to]);
+      add(to == 0 ? "uncap frequency" : "cap frequency at " + FormatMhz(cap_khz_[to]));
+    }
+  }
+  const bool migrate = migrate_level_ >= 0 && level >= migrate_level_;
+  if (migrate != migrated_) {
+    if (migrate) {
+      saved_affinity_.clear();
+      for (pid_t tid : tids_) {
+        saved_affinity_.push_back(GetThreadAffinity(tid));
+        SetThreadAffinity(tid, efficiency_cpus_);
+      }
+      add("migrate to CPUs " + FormatCpuList(efficiency_cpus_));
+    } else {
+      for (size_t i = 0; i < tids_.size() && i < saved_affinity_.size(); ++i) {
+        SetThreadAffinity(tids_[i], saved_affinity_[i]);
+      }
+      add("migrate back");
+    }
+    migrated_ = migrate;
+  }
+  const int from_pace = level_ >= pace_level_ ? level_ - pace_level_ + 1 : 0;
+  const int to_pace = level >= pace_level_ ? level - pace_level_ + 1 : 0;
+  if (from_pace != to_pace) {
+    add(to_pace == 0 ? "stop pacing"
+                     : "pace steps +" + std::to_string(static_cast<int>(
+                                            to_pace * kPaceStep * 100 + 0.5)) +
+                           "%");
+  }
+  return action;
+}
+
+const ThermalGovernor::Decision* ThermalGovernor::Step(int step) {
+  if (zones_.empty()) {
+    return nullptr;
+  }
+  Clock::time_point now = Clock::now();
+
+  // Pacing stretches the interval between steps; unpaced intervals set the
+  // baseline it stretches.
+  if (has_step_) {
+    const double interval_ms = Ms(now - last_step_);
+    if (level_ >= pace_level_) {
+      const double min_ms =
+          base_step_ms_ * (1.0 + kPaceStep * (level_ - pace_level_ + 1));
+      if (interval_ms < min_ms) {
+        std::this_thread::sleep_for(
+            std::chrono::duration<double, std::milli>(min_ms - interval_ms));
+        paced_ms_ += min_ms - interval_ms;
+        now = Clock::now();
+      }
+    } else {
+      base_step_ms_ = base_step_ms_ == 0.0
+                          ? interval_ms
+                          : 0.9 * base_step_ms_ + 0.1 * interval_ms;
+    }
+  }
+  has_step_ = true;
+  last_step_ = now;
+
+  if (!has_sample_) {
+    celsius_ = ReadCelsius();
+    last_sample_ = now;
+    has_sample_ = true;
+  } else {
+    const double elapsed_s =
+        std::chrono::duration<double>(now - last_sample_).count();
+    if (elapsed_s >= kMinSlopeInterval_s) {
+      const double celsius = ReadCelsius();
+      slope_ = 0.7 * slope_ + 0.3 * (celsius - celsius_) / elapsed_s;
+      celsius_ = celsius;
+      last_sample_ = now;
+    }
+  }
+  peak_celsius_ = std::max(peak_celsius_, celsius_);
+
+  if (now - last_change_ < std::chrono::milliseconds(options_.interval_ms)) {
+    return nullptr;
+  }
+  const int64_t freq_khz = freq_ ? freq_->AverageKhz() : -1;
+  const int64_t cap_khz =
+      cap_khz_.empty() ? -1 : cap_khz_[std::min(level_, kNumCaps)];
+  const double relax_below =
+      options_.target_celsius - options_.hysteresis_celsius;
+  const bool throttled = freq_khz > 0 && cap_khz > 0 && !migrated_ &&
+                         freq_khz < kThrottledFraction * cap_khz &&
+                         celsius_ >= relax_below;
+  const double predicted =
+      celsius_ + std::max(0.0, slope_) * options_.horizon_s;
+
+  int to = level_;
+  if ((predicted >= options_.target_celsius || throttled) &&
+      level_ < max_level_) {
+    to = level_ + 1;
+  } else if (level_ > 0 && celsius_ < relax_below &&
+             predicted < relax_below &&
+             now - last_change_ >=
+                 std::chrono::milliseconds(options_.cooldown_ms)) {
+    to = level_ - 1;
+  }
+  if (to == level_) {
+    return nullptr;
+  }
+
+  std::string action = ApplyLevel(to);
+  if (throttled) {
+    action += " (throttled to " + FormatMhz(freq_khz) + ")";
+  }
+  level_ms_[level_] += Ms(now - last_change_);
+  decisions_.push_back({Ms(now - start_), step, celsius_, slope_, freq_khz,
+                        level_, to, action});
+  std::cerr << std::fixed << std::setprecision(1) << "[THERMAL] Level "
+            << level_ << " -> " << to << " at " << celsius_ << " C ("
+            << (slope_ >= 0 ? "+" : "") << slope_ << " C/s): " << action
+            << std::defaultfloat << std::endl;
+  level_ = to;
+  last_change_ = now;
+  return &decisions_.back();
+}
+
+void ThermalGovernor::Release() {
+  if (zones_.empty()) {
+    return;
+  }
+  level_ms_[level_] += Ms(Clock::now() - last_change_);
+  last_change_ = Clock::now();
+  for (FrequencyCap& cap : caps_) {
+    cap.limit.Restore();
+  }
+  if (migrated_) {
+    for (size_t i = 0; i < tids_.size() && i < saved_affinity_.size(); ++i) {
+      SetThreadAffinity(tids_[i], saved_affinity_[i]);
+    }
+    migrated_ = false;
+  }
+  level_ = 0;
+  has_step_ = false;
+}
+
+void ThermalGovernor::PrintSummary(std::ostream& out) const {
+  out << std::fixed << std::setprecision(1);
+  out << "[THERMAL] Peak " << peak_celsius_ << " C (target "
+      << options_.target_celsius << " C), " << decisions_.size()
+      << " decisions, " << paced_ms_ << " ms paced; time at level";
+  for (size_t level = 0; level < level_ms_.size(); ++level) {
+    if (level_ms_[level] > 0.0) {
+      out << " " << level << ": " << level_ms_[level] << " ms";
+    }
+  }
+  out << "\n";
+  for (const Decision& decision : decisions_) {
+    out << "  " << std::setw(10) << decision.time_ms << " ms  step "
+        << std::setw(5) << decision.step << "  " << decision.celsius << " C  "
+        << decision.from_level << " -> " << decision.to_level << "  "
+        << decision.action << "\n";
+  }
+  out << std::defaultfloat;
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,157 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_THERMAL_GOVERNOR_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_THERMAL_GOVERNOR_H_
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+#include "ai_edge_torch/generative/examples/cpp/proc_reader.h"
+
+namespace ai_edge_torch::examples {
+
+struct ThermalOptions {
+  // Normally /sys; tests can point it at a fake tree.
+  std::string sysfs_root = "/sys";
+  // Temperature to hold, and how far below it the governor relaxes again.
+  double target_celsius = 70.0;
+  double hysteresis_celsius = 3.0;
+  // The temperature is extrapolated this far ahead along its recent slope,
+  // so the governor acts before the target is reached.
+  double horizon_s = 2.0;
+  // Comma-separated substrings of thermal zone types to watch; empty watches
+  // CPU-like zones ("cpu", "soc", "pkg", "cluster", "big", "little"), or
+  // every zone if none matches.
+  std::string zones;
+  // Minimum time between level changes; relaxing waits `cooldown_ms`.
+  int interval_ms = 500;
+  int cooldown_ms = 3000;
+};
+
+// Holds a target temperature during sustained generation by stepping down a
+// ladder of levels before the hardware throttles:
+//
+//   1. Lower the compute CPUs' scaling_max_freq in up to five steps.
+//   2. Move the inference threads from the performance to the efficiency
+//      cluster (heterogeneous CPUs only).
+//   3. Pace tokens: stretch the step interval by 15% per level, up to 90%.
+//
+// Levels whose knob is unavailable (no writable cpufreq, one cluster) are
+// left out. Step() is called at every token boundary; it reads the watched
+// zones and the compute CPUs' frequency, moves at most one level per
+// `interval_ms`, and sleeps as much as pacing requires. A frequency well
+// below the current cap counts as throttling and moves down right away.
+// Caps and affinity are restored by Release() and the destructor; caps, which
+// outlive the process, also on exit() and SIGINT, SIGTERM and SIGHUP.
+class ThermalGovernor {
+ public:
+  struct Decision {
+    double time_ms;
+    int step;
+    double celsius;
+    double slope;      // C/s.
+    int64_t freq_khz;  // Mean compute-CPU frequency, -1 without cpufreq.
+    int from_level;
+    int to_level;
+    std::string action;
+  };
+
+  explicit ThermalGovernor(ThermalOptions options);
+  ~ThermalGovernor();
+
+  ThermalGovernor(const ThermalGovernor&) = delete;
+  ThermalGovernor& operator=(const ThermalGovernor&) = delete;
+
+  // Finds the zones and cpufreq policies of `compute_cpus`; migration goes to
+  // `efficiency_cpus` if they differ, and is left out if they are empty (pass
+  // an empty set on homogeneous CPUs). Returns false if no zone can be read.
+  bool Start(const std::vector<int>& compute_cpus,
+             const std::vector<int>& efficiency_cpus);
+  // Threads moved by the migration level.
+  void SetThreads(std::vector<pid_t> tids) { tids_ = std::move(tids); }
+
+  // Call once per token. Returns the decision taken, or null.
+  const Decision* Step(int step);
+  // Undoes every knob; Step() can resume afterwards.
+  void Release();
+
+  int level() const { return level_; }
+  int max_level() const { return max_level_; }
+  // e.g. "zones cpu-thermal, 5 frequency caps, migration to 0-3, pacing".
+  const std::string& description() const { return description_; }
+  const std::vector<Decision>& decisions() const { return decisions_; }
+
+  // Peak temperature, time in each level and the decisions taken.
+  void PrintSummary(std::ostream& out) const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct FrequencyCap {
+    SysfsOverride limit;  // scaling_max_freq.
+    int64_t min_khz;      // cpuinfo limits of the policy.
+    int64_t max_khz;
+  };
+
+  double ReadCelsius();
+  std::string ApplyLevel(int level);
+  void WriteCaps(int64_t khz);
+
+  ThermalOptions options_;
+  std::string description_;
+  std::vector<ProcFile> zones_;
+  std::unique_ptr<CpuFreqReader> freq_;
+  std::vector<FrequencyCap> caps_;
+  // Descending; [0] is the uncapped maximum.
+  std::vector<int64_t> cap_khz_;
+  std::vector<int> efficiency_cpus_;
+  std::vector<pid_t> tids_;
+  std::vector<std::vector<int>> saved_affinity_;
+
+  int level_ = 0;
+  int max_level_ = 0;
+  int migrate_level_ = -1;
+  int pace_level_ = -1;
+  bool migrated_ = false;
+  bool cap_warned_ = false;
+
+  Clock::time_point start_;
+  Clock::time_point last_change_;
+  Clock::time_point last_sample_;
+  Clock::time_point last_step_;
+  bool has_sample_ = false;
+  bool has_step_ = false;
+  double celsius_ = 0.0;
+  double slope_ = 0.0;
+  double peak_celsius_ = 0.0;
+  // Unpaced step interval, for pacing.
+  double base_step_ms_ = 0.0;
+  double paced_ms_ = 0.0;
+  std::vector<double> level_ms_;
+  std::vector<Decision> decisions_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_THERMAL_GOVERNOR_H_
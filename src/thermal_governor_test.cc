@@ -0,0 +1,210 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Drives ThermalGovernor through its whole ladder on a fake sysfs tree: a
+// CPU thermal zone and one cpufreq policy shared by cpu0 and cpu1.
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+#include "ai_edge_torch/generative/examples/cpp/fake_sysfs.h"
+#include "ai_edge_torch/generative/examples/cpp/thermal_governor.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+constexpr char kTemp[] = "class/thermal/thermal_zone0/temp";
+constexpr char kPolicy[] = "devices/system/cpu/cpufreq/policy0";
+constexpr char kCap[] = "devices/system/cpu/cpufreq/policy0/scaling_max_freq";
+
+bool Contains(const std::string& text, const std::string& part) {
+  return text.find(part) != std::string::npos;
+}
+
+// Sets the zone and steps once the governor will have re-read it.
+const ThermalGovernor::Decision* StepAt(FakeSysfs& sysfs,
+                                        ThermalGovernor& governor,
+                                        int millicelsius, int step) {
+  sysfs.Write(kTemp, millicelsius);
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  return governor.Step(step);
+}
+
+void TestLadder() {
+  FakeSysfs sysfs;
+  sysfs.Write("class/thermal/thermal_zone0/type", "cpu-thermal");
+  sysfs.Write(kTemp, 50000);
+  // An unrelated zone that must not be watched.
+  sysfs.Write("class/thermal/thermal_zone1/type", "battery");
+  sysfs.Write("class/thermal/thermal_zone1/temp", 99000);
+  sysfs.Write(std::string(kPolicy) + "/cpuinfo_max_freq", 2000000);
+  sysfs.Write(std::string(kPolicy) + "/cpuinfo_min_freq", 500000);
+  sysfs.Write(kCap, 2000000);
+  sysfs.Symlink("../cpufreq/policy0", "devices/system/cpu/cpu0/cpufreq");
+  sysfs.Symlink("../cpufreq/policy0", "devices/system/cpu/cpu1/cpufreq");
+
+  const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+  const std::vector<int> affinity = GetThreadAffinity(tid);
+  const std::vector<int> efficiency = {affinity.front()};
+
+  ThermalOptions options;
+  options.sysfs_root = sysfs.root();
+  options.target_celsius = 70.0;
+  options.hysteresis_celsius = 3.0;
+  options.horizon_s = 0.0;
+  options.interval_ms = 0;
+  options.cooldown_ms = 0;
+  ThermalGovernor governor(options);
+  // A compute set different from the efficiency set enables migration.
+  SYSFS_EXPECT(governor.Start({0, 1}, efficiency));
+  governor.SetThreads({tid});
+  SYSFS_EXPECT(Contains(governor.description(), "zones cpu-thermal,"));
+  // Five caps, migration, six pacing levels.
+  SYSFS_EXPECT(governor.max_level() == 12);
+
+  // Below the target nothing moves.
+  SYSFS_EXPECT(StepAt(sysfs, governor, 50000, 0) == nullptr);
+  SYSFS_EXPECT(governor.level() == 0);
+
+  // Above it, one level per step: caps from 1800 down to 1000 MHz...
+  int step = 1;
+  const ThermalGovernor::Decision* decision =
+      StepAt(sysfs, governor, 80000, step++);
+  SYSFS_EXPECT(decision != nullptr && decision->to_level == 1);
+  SYSFS_EXPECT(sysfs.Read(kCap) == "1800000");
+  for (int level = 2; level <= 5; ++level) {
+    decision = governor.Step(step++);
+    SYSFS_EXPECT(decision != nullptr && decision->to_level == level);
+  }
+  SYSFS_EXPECT(sysfs.Read(kCap) == "1000000");
+
+  // ...then migration to the efficiency CPUs...
+  decision = governor.Step(step++);
+  SYSFS_EXPECT(decision != nullptr && decision->to_level == 6 &&
+               Contains(decision->action, "migrate to CPUs"));
+  SYSFS_EXPECT(GetThreadAffinity(tid) == efficiency);
+  SYSFS_EXPECT(sysfs.Read(kCap) == "1000000");
+
+  // ...then pacing, 15% per level up to the top of the ladder.
+  decision = governor.Step(step++);
+  SYSFS_EXPECT(decision != nullptr && decision->to_level == 7 &&
+               Contains(decision->action, "pace steps +15%"));
+  for (int level = 8; level <= 12; ++level) {
+    decision = governor.Step(step++);
+    SYSFS_EXPECT(decision != nullptr && decision->to_level == level);
+  }
+  SYSFS_EXPECT(decision != nullptr &&
+               Contains(decision->action, "pace steps +90%"));
+  SYSFS_EXPECT(governor.Step(step++) == nullptr);
+  SYSFS_EXPECT(governor.level() == 12);
+
+  // Inside the hysteresis band it holds; below it, it relaxes one level.
+  SYSFS_EXPECT(StepAt(sysfs, governor, 68000, step++) == nullptr);
+  SYSFS_EXPECT(governor.level() == 12);
+  decision = StepAt(sysfs, governor, 60000, step++);
+  SYSFS_EXPECT(decision != nullptr && decision->from_level == 12 &&
+               decision->to_level == 11);
+
+  // Relax through migration and the caps.
+  while (governor.level() > 4) {
+    decision = StepAt(sysfs, governor, 60000, step++);
+    if (!SYSFS_EXPECT(decision != nullptr)) {
+      break;
+    }
+    if (decision->to_level == 5) {
+      SYSFS_EXPECT(Contains(decision->action, "migrate back"));
+      SYSFS_EXPECT(GetThreadAffinity(tid) == affinity);
+    }
+  }
+  SYSFS_EXPECT(sysfs.Read(kCap) == "1200000");
+
+  // Release() puts the original cap back and resets the ladder.
+  governor.Release();
+  SYSFS_EXPECT(sysfs.Read(kCap) == "2000000");
+  SYSFS_EXPECT(governor.level() == 0);
+  SYSFS_EXPECT(GetThreadAffinity(tid) == affinity);
+}
+
+void TestReleaseRestoresAffinity() {
+  FakeSysfs sysfs;
+  sysfs.Write("class/thermal/thermal_zone0/type", "soc-thermal");
+  sysfs.Write(kTemp, 90000);
+
+  const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+  const std::vector<int> affinity = GetThreadAffinity(tid);
+
+  ThermalOptions options;
+  options.sysfs_root = sysfs.root();
+  options.horizon_s = 0.0;
+  options.interval_ms = 0;
+  ThermalGovernor governor(options);
+  // Without cpufreq the ladder starts at migration.
+  SYSFS_EXPECT(governor.Start({0, 1}, {affinity.front()}));
+  governor.SetThreads({tid});
+  SYSFS_EXPECT(governor.max_level() == 7);
+  const ThermalGovernor::Decision* decision = governor.Step(0);
+  SYSFS_EXPECT(decision != nullptr &&
+               Contains(decision->action, "migrate to CPUs"));
+  governor.Release();
+  SYSFS_EXPECT(GetThreadAffinity(tid) == affinity);
+}
+
+void TestNoMigrationWithoutEfficiencyCpus() {
+  FakeSysfs sysfs;
+  sysfs.Write("class/thermal/thermal_zone0/type", "x86_pkg_temp");
+  sysfs.Write(kTemp, 50000);
+
+  ThermalOptions options;
+  options.sysfs_root = sysfs.root();
+  ThermalGovernor governor(options);
+  SYSFS_EXPECT(governor.Start({0, 1}, {}));
+  // Pacing only.
+  SYSFS_EXPECT(governor.max_level() == 6);
+  SYSFS_EXPECT(!Contains(governor.description(), "migration"));
+}
+
+void TestNoZones() {
+  FakeSysfs sysfs;
+  sysfs.Write("class/thermal/thermal_zone0/type", "cpu-thermal");
+  ThermalOptions options;
+  options.sysfs_root = sysfs.root();
+  ThermalGovernor governor(options);
+  SYSFS_EXPECT(!governor.Start({0}, {}));
+}
+
+}  // namespace
+}  // namespace ai_edge_torch::examples
+
+int main() {
+  using namespace ai_edge_torch::examples;  // NOLINT
+  TestLadder();
+  TestReleaseRestoresAffinity();
+  TestNoMigrationWithoutEfficiencyCpus();
+  TestNoZones();
+  if (ExpectationFailures() != 0) {
+    std::cerr << ExpectationFailures() << " expectation(s) failed"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "PASSED" << std::endl;
+  return 0;
+}
@@ -0,0 +1,195 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/token_streamer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/trace_writer.h"
+#include "ai_edge_torch/generative/examples/cpp/utils.h"
+#include "src/sentencepiece_processor.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+// True if `text` ends in the middle of a UTF-8 sequence, or in U+FFFD, which
+// SentencePiece emits for byte-fallback pieces that do not form a character
+// yet.
+bool EndsIncomplete(const std::string& text) {
+  static constexpr char kReplacement[] = "\xEF\xBF\xBD";
+  if (text.size() >= 3 && text.compare(text.size() - 3, 3, kReplacement) == 0) {
+    return true;
+  }
+  // Walk back over continuation bytes to the lead byte of the last character.
+  size_t continuation = 0;
+  size_t i = text.size();
+  while (i > 0 && continuation < 4) {
+    unsigned char c = static_cast<unsigned char>(text[i - 1]);
+    if ((c & 0xC0) != 0x80) {
+      size_t length = (c & 0x80) == 0x00   ? 1
+                      : (c & 0xE0) == 0xC0 ? 2
+                      : (c & 0xF0) == 0xE0 ? 3
+                      : (c & 0xF8) == 0xF0 ? 4
+                                           : 1;
+      return continuation + 1 < length;
+    }
+    ++continuation;
+    --i;
+  }
+  return false;
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+// ------------------------
+// SpscTokenQueue
+// ------------------------
+SpscTokenQueue::SpscTokenQueue(size_t capacity)
+    : buffer_(RoundUpToPowerOfTwo(capacity > 0 ? capacity : 1)),
+      mask_(buffer_.size() - 1) {}
+
+bool SpscTokenQueue::TryPush(int token) {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) == buffer_.size()) {
+    return false;
+  }
+  buffer_[tail & mask_] = token;
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool SpscTokenQueue::TryPop(int* token) {
+  const size_t head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *token = buffer_[head & mask_];
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+// ------------------------
+// IncrementalDetokenizer
+// ------------------------
+IncrementalDetokenizer::IncrementalDetokenizer(
+    const sentencepiece::SentencePieceProcessor* sp_processor)
+    : sp_processor_(sp_processor) {}
+
+std::string IncrementalDetokenizer::Decode(size_t begin, size_t end) const {
+  std::string text;
+  if (begin < end) {
+    std::vector<int> window(tokens_.begin() + begin, tokens_.begin() + end);
+    MINIMAL_CHECK(sp_processor_->Decode(window, &text).ok());
+  }
+  return text;
+}
+
+std::string IncrementalDetokenizer::Push(int token) {
+  tokens_.push_back(token);
+  std::string prefix_text = Decode(prefix_offset_, read_offset_);
+  std::string new_text = Decode(prefix_offset_, tokens_.size());
+  if (new_text.size() <= prefix_text.size() || EndsIncomplete(new_text)) {
+    return "";
+  }
+  prefix_offset_ = read_offset_;
+  read_offset_ = tokens_.size();
+  return new_text.substr(prefix_text.size());
+}
+
+std::string IncrementalDetokenizer::Flush() {
+  if (read_offset_ == tokens_.size()) {
+    return "";
+  }
+  std::string prefix_text = Decode(prefix_offset_, read_offset_);
+  std::string new_text = Decode(prefix_offset_, tokens_.size());
+  prefix_offset_ = read_offset_ = tokens_.size();
+  return new_text.size() > prefix_text.size()
+             ? new_text.substr(prefix_text.size())
+             : "";
+}
+
+// ------------------------
+// TokenStreamer
+// ------------------------
+TokenStreamer::TokenStreamer(
+    const sentencepiece::SentencePieceProcessor* sp_processor,
+    std::ostream* out, size_t queue_capacity)
+    : detokenizer_(sp_processor),
+      out_(out),
+      queue_(queue_capacity),
+      writer_(&TokenStreamer::Run, this) {}
+
+TokenStreamer::~TokenStreamer() { Finish(); }
+
+void TokenStreamer::Push(int token) {
+  while (!queue_.TryPush(token)) {
+    ++num_full_waits_;
+    std::this_thread::yield();
+  }
+}
+
+void TokenStreamer::Finish() {
+  if (!writer_.joinable()) {
+    return;
+  }
+  done_.store(true, std::memory_order_release);
+  writer_.join();
+}
+
+void TokenStreamer::Run() {
+  if (TraceWriter* trace_writer = TraceWriter::Get()) {
+    trace_writer->NameThread("detokenizer");
+  }
+  auto write = [this](const std::string& text) {
+    if (!text.empty()) {
+      *out_ << text << std::flush;
+    }
+  };
+  while (true) {
+    int token;
+    if (queue_.TryPop(&token)) {
+      ScopedTraceSpan span("Detokenize", "output");
+      write(detokenizer_.Push(token));
+      continue;
+    }
+    if (done_.load(std::memory_order_acquire)) {
+      // Tokens pushed before Finish() are visible now; drain them and stop.
+      while (queue_.TryPop(&token)) {
+        write(detokenizer_.Push(token));
+      }
+      break;
+    }
+    // Tokens arrive every few milliseconds at best. Sleeping instead of
+    // spinning keeps this thread off the cores the delegate is using.
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  write(detokenizer_.Flush());
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,113 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TOKEN_STREAMER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TOKEN_STREAMER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/sentencepiece_processor.h"
+
+namespace ai_edge_torch::examples {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+class SpscTokenQueue {
+ public:
+  // `capacity` is rounded up to a power of two.
+  explicit SpscTokenQueue(size_t capacity);
+
+  // Producer side. Returns false if the queue is full.
+  bool TryPush(int token);
+  // Consumer side. Returns false if the queue is empty.
+  bool TryPop(int* token);
+
+ private:
+  std::vector<int> buffer_;
+  size_t mask_;
+  // Head and tail live on separate cache lines so the two threads do not
+  // bounce one line between cores on every token.
+  alignas(64) std::atomic<size_t> head_{0};  // Next slot to pop.
+  alignas(64) std::atomic<size_t> tail_{0};  // Next slot to push.
+};
+
+// Turns a growing token stream into text without splitting characters.
+//
+// Decoding tokens one at a time drops the word-boundary space SentencePiece
+// attaches to a piece and breaks characters that are spread over several
+// byte-fallback tokens. Instead, a short window of recent tokens is decoded
+// and only the text past what was already emitted is returned. Text ending in
+// an incomplete UTF-8 sequence (or the replacement character SentencePiece
+// substitutes for one) is held back until the following tokens complete it.
+class IncrementalDetokenizer {
+ public:
+  explicit IncrementalDetokenizer(
+      const sentencepiece::SentencePieceProcessor* sp_processor);
+
+  // Appends `token` and returns any text that is now safe to print.
+  std::string Push(int token);
+  // Returns whatever was held back, even if it is not valid UTF-8.
+  std::string Flush();
+
+ private:
+  std::string Decode(size_t begin, size_t end) const;
+
+  const sentencepiece::SentencePieceProcessor* sp_processor_;
+  std::vector<int> tokens_;
+  // tokens_[prefix_offset_, read_offset_) were decoded and emitted; they are
+  // re-decoded with new tokens only to get spacing right.
+  size_t prefix_offset_ = 0;
+  size_t read_offset_ = 0;
+};
+
+// Detokenizes and writes generated tokens on a background thread so that the
+// decode loop only pays for one queue push per token.
+class TokenStreamer {
+ public:
+  TokenStreamer(const sentencepiece::SentencePieceProcessor* sp_processor,
+                std::ostream* out, size_t queue_capacity = 4096);
+  ~TokenStreamer();
+
+  TokenStreamer(const TokenStreamer&) = delete;
+  TokenStreamer& operator=(const TokenStreamer&) = delete;
+
+  // Called from the decode thread. Only spins if the writer falls a whole
+  // queue behind.
+  void Push(int token);
+
+  // Waits until every pushed token has been written and stops the thread.
+  void Finish();
+
+  // Number of times Push() found the queue full.
+  size_t num_full_waits() const { return num_full_waits_; }
+
+ private:
+  void Run();
+
+  IncrementalDetokenizer detokenizer_;
+  std::ostream* out_;
+  SpscTokenQueue queue_;
+  std::atomic<bool> done_{false};
+  size_t num_full_waits_ = 0;
+  std::thread writer_;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TOKEN_STREAMER_H_
@@ -0,0 +1,151 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/trace_writer.h"
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/json_writer.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+std::atomic<TraceWriter*> g_trace_writer{nullptr};
+
+int CurrentTid() {
+  thread_local const int tid = static_cast<int>(syscall(SYS_gettid));
+  return tid;
+}
+
+// Resident set size in bytes, from the second field of /proc/self/statm.
+double ReadRssBytes() {
+  FILE* file = std::fopen("/proc/self/statm", "r");
+  if (file == nullptr) {
+    return 0.0;
+  }
+  unsigned long size = 0, resident = 0;
+  int matched = std::fscanf(file, "%lu %lu", &size, &resident);
+  std::fclose(file);
+  return matched == 2 ? static_cast<double>(resident) * sysconf(_SC_PAGESIZE)
+                      : 0.0;
+}
+
+}  // namespace
+
+TraceWriter::TraceWriter()
+    : origin_(std::chrono::steady_clock::now()), pid_(getpid()) {}
+
+void TraceWriter::Install(TraceWriter* writer) {
+  g_trace_writer.store(writer, std::memory_order_release);
+}
+
+TraceWriter* TraceWriter::Get() {
+  return g_trace_writer.load(std::memory_order_acquire);
+}
+
+double TraceWriter::NowUs() const {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - origin_)
+      .count();
+}
+
+void TraceWriter::Add(Event event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back(std::move(event));
+}
+
+void TraceWriter::AddSpan(std::string name, const char* category,
+                          double start_us, double end_us) {
+  Add({'X', std::move(name), category, CurrentTid(), start_us,
+       end_us - start_us, {}, {}});
+}
+
+void TraceWriter::AddCounter(
+    const char* name, std::vector<std::pair<const char*, double>> values) {
+  Add({'C', name, "counter", CurrentTid(), NowUs(), 0.0, std::move(values),
+       {}});
+}
+
+void TraceWriter::NameThread(std::string name) {
+  Add({'M', "thread_name", "__metadata", CurrentTid(), 0.0, 0.0, {},
+       std::move(name)});
+}
+
+void TraceWriter::SampleMemoryCounters() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  AddCounter("rss_mb", {{"rss", ReadRssBytes() / (1024.0 * 1024.0)}});
+  AddCounter("major_faults",
+             {{"major_faults", static_cast<double>(usage.ru_majflt)}});
+}
+
+size_t TraceWriter::num_events() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return events_.size();
+}
+
+bool TraceWriter::WriteJson(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  JsonWriter json(&out);
+  json.BeginObject();
+  json.Field("displayTimeUnit", "ms");
+  json.Key("traceEvents");
+  json.BeginArray();
+  for (const Event& event : events_) {
+    json.BeginObject();
+    json.Field("name", event.name);
+    json.Field("cat", event.category);
+    json.Field("ph", std::string(1, event.phase));
+    json.Field("pid", pid_);
+    json.Field("tid", event.tid);
+    json.Field("ts", event.ts_us);
+    if (event.phase == 'X') {
+      json.Field("dur", event.dur_us);
+    }
+    if (event.phase == 'C' || event.phase == 'M') {
+      json.Key("args");
+      json.BeginObject();
+      if (event.phase == 'M') {
+        json.Field("name", event.thread_name);
+      }
+      for (const auto& [key, value] : event.values) {
+        json.Field(key, value);
+      }
+      json.EndObject();
+    }
+    json.EndObject();
+  }
+  json.EndArray();
+  json.EndObject();
+  out << "\n";
+  return out.good();
+}
+
+}  // namespace ai_edge_torch::examples
@@ -0,0 +1,112 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TRACE_WRITER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TRACE_WRITER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// Records a timeline of spans and counter values and writes it in the Chrome
+// trace event format, which chrome://tracing and ui.perfetto.dev both open.
+//
+// Spans may be recorded from any thread. A writer becomes the process-wide
+// target with Install(); while none is installed, ScopedTraceSpan and the
+// static helpers cost one pointer check.
+class TraceWriter {
+ public:
+  TraceWriter();
+
+  // Makes `writer` (may be null) the target of ScopedTraceSpan.
+  static void Install(TraceWriter* writer);
+  static TraceWriter* Get();
+
+  // Microseconds since this writer was created.
+  double NowUs() const;
+
+  // Records a complete span on the calling thread.
+  void AddSpan(std::string name, const char* category, double start_us,
+               double end_us);
+  // Records counter values at the current time. Each name is one track.
+  void AddCounter(const char* name,
+                  std::vector<std::pair<const char*, double>> values);
+  // Labels the calling thread in the trace viewer.
+  void NameThread(std::string name);
+
+  // Adds RSS and cumulative major-fault counter samples for this process.
+  void SampleMemoryCounters();
+
+  // Writes the trace as JSON. Returns false on I/O error.
+  bool WriteJson(const std::string& path) const;
+
+  size_t num_events() const;
+
+ private:
+  struct Event {
+    char phase;  // 'X' span, 'C' counter, 'M' metadata.
+    std::string name;
+    const char* category;
+    int tid;
+    double ts_us;
+    double dur_us;
+    std::vector<std::pair<const char*, double>> values;
+    std::string thread_name;
+  };
+
+  void Add(Event event);
+
+  const std::chrono::steady_clock::time_point origin_;
+  const int pid_;
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+};
+
+// Records the enclosing scope as a span on the installed TraceWriter.
+class ScopedTraceSpan {
+ public:
+  explicit ScopedTraceSpan(std::string name, const char* category = "app")
+      : writer_(TraceWriter::Get()) {
+    if (writer_ != nullptr) {
+      name_ = std::move(name);
+      category_ = category;
+      start_us_ = writer_->NowUs();
+    }
+  }
+  ~ScopedTraceSpan() {
+    if (writer_ != nullptr) {
+      writer_->AddSpan(std::move(name_), category_, start_us_,
+                       writer_->NowUs());
+    }
+  }
+
+  ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+  ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+ private:
+  TraceWriter* writer_;
+  std::string name_;
+  const char* category_ = nullptr;
+  double start_us_ = 0.0;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TRACE_WRITER_H_
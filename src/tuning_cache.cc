@@ -0,0 +1,133 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/tuning_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ai_edge_torch/generative/examples/cpp/cpu_topology.h"
+
+namespace ai_edge_torch::examples {
+namespace {
+
+std::string Trim(const std::string& text) {
+  size_t begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+}  // namespace
+
+bool TuningCache::Load() {
+  sections_.clear();
+  std::ifstream in(path_);
+  if (!in.is_open()) {
+    return false;
+  }
+  std::string line;
+  std::string key;
+  while (std::getline(in, line)) {
+    line = Trim(line);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    if (line.front() == '[' && line.back() == ']') {
+      key = line.substr(1, line.size() - 2);
+      sections_[key];
+      continue;
+    }
+    size_t equals = line.find('=');
+    if (equals == std::string::npos || key.empty()) {
+      continue;
+    }
+    sections_[key][Trim(line.substr(0, equals))] =
+        Trim(line.substr(equals + 1));
+  }
+  return !in.bad();
+}
+
+bool TuningCache::Save() const {
+  std::ofstream out(path_);
+  if (!out.is_open()) {
+    return false;
+  }
+  out << "# Written by text_generator_main auto-tuning; safe to delete.\n";
+  for (const auto& [key, section] : sections_) {
+    out << "\n[" << key << "]\n";
+    for (const auto& [name, value] : section) {
+      out << name << " = " << value << "\n";
+    }
+  }
+  return out.good();
+}
+
+const TuningCache::Section* TuningCache::Find(const std::string& key) const {
+  auto it = sections_.find(key);
+  return it == sections_.end() ? nullptr : &it->second;
+}
+
+void TuningCache::Set(const std::string& key, const std::string& name,
+                      const std::string& value) {
+  sections_[key][name] = value;
+}
+
+int TuningCache::GetInt(const std::string& key, const std::string& name,
+                        int fallback) const {
+  const Section* section = Find(key);
+  if (section == nullptr) {
+    return fallback;
+  }
+  auto it = section->find(name);
+  if (it == section->end()) {
+    return fallback;
+  }
+  char* end = nullptr;
+  long value = std::strtol(it->second.c_str(), &end, 10);
+  return end == it->second.c_str() ? fallback : static_cast<int>(value);
+}
+
+std::string TuningKey(const std::string& model_path,
+                      const std::vector<int>& cpus) {
+  std::string name = model_path.substr(model_path.find_last_of('/') + 1);
+  struct stat st;
+  if (stat(model_path.c_str(), &st) == 0) {
+    name += ":" + std::to_string(static_cast<long long>(st.st_size));
+  }
+  char hostname[256] = {};
+  gethostname(hostname, sizeof(hostname) - 1);
+  return name + "@" + hostname + "/cpus=" + FormatCpuList(cpus);
+}
+
+std::vector<int> ThreadCountCandidates(int max_threads) {
+  std::vector<int> candidates;
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    candidates.push_back(threads);
+  }
+  candidates.push_back(std::max(1, max_threads));
+  return candidates;
+}
+
+}  // namespace ai_edge_torch::examples
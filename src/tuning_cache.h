@@ -0,0 +1,78 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TUNING_CACHE_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TUNING_CACHE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ai_edge_torch::examples {
+
+// Settings measured by an auto-tuning run, persisted so that later runs on
+// the same machine and model skip the measurement.
+//
+// The file is plain text with one section per key:
+//
+//   [llama_q8_ekv1024.tflite:3221225472@rubikpi/cpus=0-7]
+//   prefill_threads = 4
+//   decode_threads = 2
+//
+// Lines starting with '#' are comments. Sections and names are kept in
+// sorted order when saved.
+class TuningCache {
+ public:
+  using Section = std::map<std::string, std::string>;
+
+  explicit TuningCache(std::string path) : path_(std::move(path)) {}
+
+  const std::string& path() const { return path_; }
+
+  // Returns false if the file does not exist or cannot be read; the cache is
+  // then empty.
+  bool Load();
+  // Returns false on I/O error.
+  bool Save() const;
+
+  // Null if `key` has no section.
+  const Section* Find(const std::string& key) const;
+  void Set(const std::string& key, const std::string& name,
+           const std::string& value);
+  void Set(const std::string& key, const std::string& name, int value) {
+    Set(key, name, std::to_string(value));
+  }
+
+  // Integer setting, or `fallback` if the section or name is missing.
+  int GetInt(const std::string& key, const std::string& name,
+             int fallback) const;
+
+ private:
+  std::string path_;
+  std::map<std::string, Section> sections_;
+};
+
+// Identifies a model file and the machine and CPU set it runs on, so a
+// setting tuned on one board or core set is not reused on another.
+std::string TuningKey(const std::string& model_path,
+                      const std::vector<int>& cpus);
+
+// 1, 2, 4, ... up to and including `max_threads`.
+std::vector<int> ThreadCountCandidates(int max_threads);
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_TUNING_CACHE_H_
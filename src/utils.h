@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_UTILS_H_
 
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -62,6 +63,10 @@ class AlignedAllocator {
   void deallocate(T* ptr, std::size_t n) { free(ptr); }
 };
 
+// External KV cache buffers keyed by signature input name (kv_cache_k_0, ...).
+using KVCache =
+    std::map<std::string, std::vector<float, AlignedAllocator<float>>>;
+
 // An example implementation of LoRA adapters manager for TFLite interpreter.
 // The class loads an adapter from a flatbuffers files and provides helper
 // methods for finding the right signature and setting the appropriate input
@@ -0,0 +1,119 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ai_edge_torch/generative/examples/cpp/weight_prefetcher.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace ai_edge_torch::examples {
+
+WeightPrefetcher::WeightPrefetcher(tflite::Interpreter* interpreter, int depth)
+    : depth_(std::max(0, depth)) {
+  const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  for (size_t s = 0; s < interpreter->subgraphs_size(); ++s) {
+    tflite::Subgraph* subgraph = interpreter->subgraph(static_cast<int>(s));
+    SubgraphSteps& out = subgraphs_.emplace_back();
+    out.step_of.assign(subgraph->nodes_size(), -1);
+    for (int node_index : subgraph->execution_plan()) {
+      const auto* node_and_reg = subgraph->node_and_registration(node_index);
+      if (node_and_reg == nullptr) {
+        continue;
+      }
+      out.step_of[node_index] = static_cast<int>(out.steps.size());
+      Ranges& ranges = out.steps.emplace_back();
+      // A delegate kernel (XNNPACK) lists the original weights as inputs but
+      // computes from its own packed copies, so they are not worth reading.
+      if (node_and_reg->first.delegate != nullptr) {
+        ++delegated_nodes_;
+        continue;
+      }
+      const TfLiteIntArray* inputs = node_and_reg->first.inputs;
+      for (int i = 0; inputs != nullptr && i < inputs->size; ++i) {
+        if (inputs->data[i] < 0) {
+          continue;
+        }
+        const TfLiteTensor* tensor = subgraph->tensor(inputs->data[i]);
+        if (tensor->allocation_type != kTfLiteMmapRo ||
+            tensor->data.raw == nullptr || tensor->bytes == 0) {
+          continue;
+        }
+        weight_bytes_ += tensor->bytes;
+        uintptr_t begin = reinterpret_cast<uintptr_t>(tensor->data.raw);
+        ranges.push_back({begin & ~(page - 1),
+                          (begin + tensor->bytes + page - 1) & ~(page - 1)});
+      }
+      // Merge overlapping ranges so each page is advised once per node.
+      std::sort(ranges.begin(), ranges.end());
+      Ranges merged;
+      for (const auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().second) {
+          merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+          merged.push_back(range);
+        }
+      }
+      ranges.swap(merged);
+    }
+  }
+}
+
+uint32_t WeightPrefetcher::BeginEvent(const char* tag, EventType event_type,
+                                      int64_t event_metadata1,
+                                      int64_t event_metadata2) {
+  // For node invocations metadata1 is the node index and metadata2 the
+  // subgraph index.
+  if (depth_ == 0 || event_type != EventType::OPERATOR_INVOKE_EVENT ||
+      event_metadata2 < 0 ||
+      event_metadata2 >= static_cast<int64_t>(subgraphs_.size())) {
+    return 0;
+  }
+  const SubgraphSteps& subgraph = subgraphs_[event_metadata2];
+  if (event_metadata1 < 0 ||
+      event_metadata1 >= static_cast<int64_t>(subgraph.step_of.size()) ||
+      subgraph.step_of[event_metadata1] < 0) {
+    return 0;
+  }
+  const int num_steps = static_cast<int>(subgraph.steps.size());
+  const int step = subgraph.step_of[event_metadata1];
+  // The first node also covers the window the previous pass could not
+  // reach, e.g. on the first invocation.
+  const int first = step == 0 ? 1 : depth_;
+  for (int ahead = first; ahead <= depth_; ++ahead) {
+    Advise(subgraph.steps[(step + ahead) % num_steps]);
+  }
+  return 0;
+}
+
+void WeightPrefetcher::Advise(const Ranges& ranges) {
+  for (const auto& [begin, end] : ranges) {
+    if (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED) ==
+        0) {
+      advised_bytes_ += end - begin;
+      ++advise_calls_;
+    }
+  }
+}
+
+}  // namespace ai_edge_torch::examples
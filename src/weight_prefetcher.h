@@ -0,0 +1,79 @@
+/* Copyright 2025 The AI Edge Torch Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_WEIGHT_PREFETCHER_H_
+#define THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_WEIGHT_PREFETCHER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace ai_edge_torch::examples {
+
+// Reads mmap'd weights ahead of the node that uses them.
+//
+// Attach with interpreter->SetProfiler(). When node i of a subgraph starts,
+// the read-only mmap'd inputs of node i + depth are passed to
+// madvise(MADV_WILLNEED), so the kernel pages them in while nodes i..i+depth-1
+// run. The window wraps around the end of the execution plan, so the first
+// nodes of the next decode step are read during the tail of this one. The
+// plan and tensor addresses are captured once at construction, after
+// delegates have been applied. Delegated partitions are skipped: XNNPACK
+// computes from packed copies of the weights (in memory or in its weight
+// cache), not from the model mapping, so under full delegation there is
+// nothing left to prefetch.
+class WeightPrefetcher : public tflite::Profiler {
+ public:
+  WeightPrefetcher(tflite::Interpreter* interpreter, int depth);
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+  void EndEvent(uint32_t event_handle) override {}
+
+  int depth() const { return depth_; }
+  // 0 turns prefetching off without removing the profiler.
+  void set_depth(int depth) { depth_ = depth > 0 ? depth : 0; }
+  // Mmap'd weight bytes read by the non-delegated nodes, counted per use.
+  uint64_t weight_bytes() const { return weight_bytes_; }
+  int delegated_nodes() const { return delegated_nodes_; }
+  uint64_t advised_bytes() const { return advised_bytes_; }
+  uint64_t advise_calls() const { return advise_calls_; }
+
+ private:
+  // Page-aligned [begin, end) ranges.
+  using Ranges = std::vector<std::pair<uintptr_t, uintptr_t>>;
+
+  struct SubgraphSteps {
+    std::vector<Ranges> steps;    // In execution order.
+    std::vector<int> step_of;     // Node index to step, -1 if not planned.
+  };
+
+  void Advise(const Ranges& ranges);
+
+  int depth_;
+  std::vector<SubgraphSteps> subgraphs_;
+  uint64_t weight_bytes_ = 0;
+  int delegated_nodes_ = 0;
+  uint64_t advised_bytes_ = 0;
+  uint64_t advise_calls_ = 0;
+};
+
+}  // namespace ai_edge_torch::examples
+
+#endif  // THIRD_PARTY_PY_AI_EDGE_TORCH_GENERATIVE_EXAMPLES_CPP_WEIGHT_PREFETCHER_H_